@@ -24,6 +24,12 @@ isc.getCipher(password_to_encrypt);
 whose size should not be bigger than size of unsigned long int.
 
 "password_to_encrypt" can be up to 32 characters long. Same conditions apply.
+
+Isaac rnd(seed_values, count);
+rnd.getNumber();
+
+returns a reproducible stream of 32 bit random numbers for up to 256 seed
+values.
 ------------------------------------------------------------------------------
 */
 
@@ -131,6 +137,25 @@ public:
         isaac(&ctxM);
     }
 
+    // stream of random numbers, the same seed values give the same numbers
+    Isaac(const unsigned long* seed, int count)
+    {
+        for (int i=0; i<256; ++i)
+            ctxM.randrsl[i] = (i < count) ? (seed[i] & 0xffffffff) : 0;
+        randinit(&ctxM);
+    }
+
+    // returns a number between 0 and 0xffffffff
+    unsigned long getNumber()
+    {
+        if (!ctxM.randcnt)
+        {
+            isaac(&ctxM);
+            ctxM.randcnt = 256;
+        }
+        return ctxM.randrsl[--ctxM.randcnt];
+    }
+
     wxString getCipher(const wxString& pwd)
     {
         wxString result;
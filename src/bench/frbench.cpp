@@ -0,0 +1,474 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// frbench: headless micro-benchmarks for hot paths of FlameRobin.  It links
+// the application sources, but never creates any window.  Every benchmark
+// runs a fixed workload and writes one line of JSON with its throughput to
+// stdout, so results of different builds can be compared with a script.
+// Run "frbench --help" for the options.
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/cmdline.h>
+#include <wx/init.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <ibpp.h>
+
+#include "core/CodeTemplateProcessor.h"
+#include "core/FRDecimal.h"
+#include "core/FRInt128.h"
+#include "core/StringUtils.h"
+#include "frversion.h"
+#include "gui/controls/DataGridRows.h"
+#include "metadata/database.h"
+#include "metadata/server.h"
+#include "sql/MultiStatement.h"
+#include "sql/SqlTokenizer.h"
+
+class Benchmark
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+    std::string nameM;
+    Clock::time_point startM;
+public:
+    Benchmark(const std::string& name)
+        : nameM(name), startM(Clock::now())
+    {
+    }
+
+    // prints the result: <items> processed items, <bytes> processed bytes
+    void report(unsigned long long items, unsigned long long bytes = 0)
+    {
+        double seconds = std::chrono::duration<double>(
+            Clock::now() - startM).count();
+        if (seconds <= 0)
+            seconds = 1e-9;
+        printf("{\"benchmark\":\"%s\",\"items\":%llu,\"bytes\":%llu,"
+            "\"seconds\":%.6f,\"items_per_second\":%.1f,"
+            "\"mb_per_second\":%.3f}\n", nameM.c_str(), items, bytes,
+            seconds, items / seconds, bytes / seconds / 1048576.0);
+        fflush(stdout);
+    }
+
+    static void skipped(const std::string& name, const std::string& reason)
+    {
+        // the reason may be a multi-line error message
+        std::string escaped;
+        for (std::string::const_iterator it = reason.begin();
+            it != reason.end(); ++it)
+        {
+            if (*it == '"' || *it == '\\')
+                escaped += '\\';
+            if (*it == '\n')
+                escaped += "\\n";
+            else if (*it != '\r')
+                escaped += *it;
+        }
+        printf("{\"benchmark\":\"%s\",\"skipped\":\"%s\"}\n", name.c_str(),
+            escaped.c_str());
+        fflush(stdout);
+    }
+};
+
+// a script with a typical mix of DDL, DML, comments, strings, quoted
+// identifiers and a SET TERM block, repeated until it has <size> chars
+static wxString createScript(size_t size)
+{
+    const wxString part(
+        "/* customers of the sample application */\n"
+        "CREATE TABLE \"Customer\" (\n"
+        "    ID INTEGER NOT NULL PRIMARY KEY,\n"
+        "    NAME VARCHAR(60) CHARACTER SET UTF8 COLLATE UNICODE_CI,\n"
+        "    BALANCE NUMERIC(18,4) DEFAULT 0 -- current balance\n"
+        ");\n"
+        "INSERT INTO \"Customer\" (ID, NAME, BALANCE)\n"
+        "    VALUES (1, 'O''Brien & Sons', 1234.5678);\n"
+        "SELECT c.ID, c.NAME, SUM(o.AMOUNT) AS TOTAL FROM \"Customer\" c\n"
+        "    LEFT JOIN ORDERS o ON o.CUSTOMER_ID = c.ID\n"
+        "    WHERE c.BALANCE > 100 AND o.ORDER_DATE >= DATE '2020-01-01'\n"
+        "    GROUP BY 1, 2 HAVING COUNT(*) > 1 ORDER BY 3 DESC;\n"
+        "SET TERM ^ ;\n"
+        "CREATE OR ALTER PROCEDURE GET_BALANCE (ID INTEGER)\n"
+        "RETURNS (BALANCE NUMERIC(18,4))\n"
+        "AS\n"
+        "BEGIN\n"
+        "    SELECT BALANCE FROM \"Customer\" WHERE ID = :ID\n"
+        "        INTO :BALANCE;\n"
+        "    IF (BALANCE IS NULL) THEN BALANCE = 0; -- no such customer\n"
+        "    SUSPEND;\n"
+        "END^\n"
+        "SET TERM ; ^\n"
+        "COMMIT;\n");
+
+    wxString script;
+    script.reserve(size + part.length());
+    while (script.length() < size)
+        script += part;
+    return script;
+}
+
+static void benchTokenizer(const wxString& script)
+{
+    Benchmark b("sql.tokenize");
+    SqlTokenizer tokenizer(script);
+    unsigned long long tokens = 0;
+    while (tokenizer.getCurrentToken() != tkEOF)
+    {
+        ++tokens;
+        if (!tokenizer.nextToken())
+            break;
+    }
+    b.report(tokens, script.length() * sizeof(wxChar));
+}
+
+static void benchMultiStatement(const wxString& script)
+{
+    Benchmark b("sql.split_statements");
+    MultiStatement ms(script);
+    unsigned long long statements = 0;
+    while (true)
+    {
+        SingleStatement ss = ms.getNextStatement();
+        if (!ss.isValid())
+            break;
+        wxString newTerminator;
+        if (ss.isSetTermStatement(newTerminator) && !newTerminator.empty())
+            ms.setTerminator(newTerminator);
+        ++statements;
+    }
+    b.report(statements, script.length() * sizeof(wxChar));
+}
+
+// distinct values to convert, so that not every conversion is the same
+static std::vector<wxString> createDecimalStrings(size_t count)
+{
+    std::vector<wxString> values;
+    for (size_t i = 0; i < count; ++i)
+    {
+        values.push_back(wxString::Format("%s%u.%04u",
+            (i % 3 == 0) ? "-" : "", unsigned(i * 7919 % 100000000),
+            unsigned(i * 104729 % 10000)));
+    }
+    return values;
+}
+
+static void benchDec34(size_t count)
+{
+    std::vector<wxString> strings(createDecimalStrings(1000));
+    std::vector<dec34_t> values(strings.size());
+    wxString errMsg;
+
+    // every value is parsed at least once, they are formatted below
+    size_t parseCount = std::max(count / 10, strings.size());
+    Benchmark parse("decimal.dec34_parse");
+    for (size_t i = 0; i < parseCount; ++i)
+    {
+        size_t ix = i % strings.size();
+        if (!StringToDec34DPD(strings[ix], &values[ix], errMsg))
+        {
+            Benchmark::skipped("decimal.dec34_parse", wx2std(errMsg));
+            return;
+        }
+    }
+    parse.report(parseCount);
+
+    Benchmark format("decimal.dec34_format");
+    unsigned long long chars = 0;
+    for (size_t i = 0; i < count; ++i)
+        chars += Dec34DPDToString(values[i % values.size()]).length();
+    format.report(count, chars * sizeof(wxChar));
+}
+
+static void benchInt128(size_t count)
+{
+    std::vector<wxString> strings(createDecimalStrings(1000));
+    std::vector<int128_t> values(strings.size());
+    wxString errMsg;
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        // the integral part only
+        if (!StringToInt128(strings[i].BeforeFirst('.'), &values[i], errMsg))
+        {
+            Benchmark::skipped("decimal.int128_format", wx2std(errMsg));
+            return;
+        }
+    }
+
+    Benchmark format("decimal.int128_format");
+    unsigned long long chars = 0;
+    for (size_t i = 0; i < count; ++i)
+        chars += Int128ToString(values[i % values.size()]).length();
+    format.report(count, chars * sizeof(wxChar));
+}
+
+// rows are generated by the server, so any database (even an empty one
+// created for the benchmark) can be used
+static const char* fetchSql =
+    "EXECUTE BLOCK (N INTEGER = ?)\n"
+    "RETURNS (ID INTEGER, NAME VARCHAR(40), AMOUNT NUMERIC(18,4),\n"
+    "    CREATED TIMESTAMP)\n"
+    "AS\n"
+    "BEGIN\n"
+    "    ID = 0;\n"
+    "    CREATED = CURRENT_TIMESTAMP;\n"
+    "    WHILE (ID < N) DO\n"
+    "    BEGIN\n"
+    "        ID = ID + 1;\n"
+    "        NAME = 'row ' || ID;\n"
+    "        AMOUNT = ID / 7.0;\n"
+    "        SUSPEND;\n"
+    "    END\n"
+    "END";
+
+static void benchFetch(const wxString& server, const wxString& database,
+    const wxString& user, const wxString& password, size_t count)
+{
+    if (database.empty())
+    {
+        Benchmark::skipped("ibpp.fetch", "no database given");
+        return;
+    }
+    try
+    {
+        IBPP::Database db = IBPP::DatabaseFactory(wx2std(server),
+            wx2std(database), wx2std(user), wx2std(password), "", "UTF8",
+            "");
+        db->Connect();
+        IBPP::Transaction tr = IBPP::TransactionFactory(db, IBPP::amRead);
+        tr->Start();
+        IBPP::Statement st = IBPP::StatementFactory(db, tr);
+        st->Prepare(fetchSql);
+        st->Set(1, int32_t(count));
+
+        Benchmark b("ibpp.fetch");
+        st->Execute();
+        unsigned long long rows = 0, bytes = 0;
+        int32_t id;
+        std::string name;
+        double amount;
+        IBPP::Timestamp created;
+        while (st->Fetch())
+        {
+            st->Get(1, id);
+            st->Get(2, name);
+            st->Get(3, amount);
+            st->Get(4, created);
+            ++rows;
+            bytes += sizeof(id) + name.length() + sizeof(amount)
+                + sizeof(created);
+        }
+        b.report(rows, bytes);
+        tr->Commit();
+        db->Disconnect();
+    }
+    catch (IBPP::Exception& e)
+    {
+        Benchmark::skipped("ibpp.fetch", e.what());
+    }
+}
+
+// the same rows as benchFetch(), but stored in and formatted by the
+// row buffers of the data grid
+static void benchGrid(const wxString& server, const wxString& database,
+    const wxString& user, const wxString& password, size_t count)
+{
+    if (database.empty())
+    {
+        Benchmark::skipped("grid.add_row", "no database given");
+        return;
+    }
+    try
+    {
+        ServerPtr srv(new Server());
+        srv->setHostname(server);
+        DatabasePtr db(srv->addDatabase());
+        db->setPath(database);
+        db->setUsername(user);
+        db->setConnectionCharset("UTF8");
+        db->connect(password);
+
+        IBPP::Transaction tr = IBPP::TransactionFactory(
+            db->getIBPPDatabase(), IBPP::amRead);
+        tr->Start();
+        IBPP::Statement st = IBPP::StatementFactory(db->getIBPPDatabase(),
+            tr);
+        st->Prepare(fetchSql);
+        st->Set(1, int32_t(count));
+
+        DataGridRows rows(db.get());
+        Benchmark add("grid.add_row");
+        st->Execute();
+        rows.initialize(st);
+        while (st->Fetch())
+            rows.addRow(st);
+        add.report(rows.getRowCount());
+        tr->Commit();
+
+        Benchmark format("grid.get_as_string");
+        unsigned long long values = 0, chars = 0;
+        for (unsigned row = 0; row < rows.getRowCount(); ++row)
+        {
+            for (unsigned col = 0; col < rows.getRowFieldCount(); ++col)
+            {
+                chars += rows.getFieldValue(row, col).length();
+                ++values;
+            }
+        }
+        format.report(values, chars * sizeof(wxChar));
+
+        rows.clear();
+        db->disconnect();
+    }
+    // both IBPP::Exception and FRError
+    catch (std::exception& e)
+    {
+        Benchmark::skipped("grid.add_row", e.what());
+    }
+}
+
+// a template like the code generation templates: variables, conditions
+// and string functions around plain text, no metadata object
+static void benchTemplate(size_t count)
+{
+    const wxString part(
+        "{%--:generated code for one table%}"
+        "{%setvar:table:customer_orders%}"
+        "{%setvar:generator:gen_{%getvar:table%}_id%}"
+        "/* {%uppercase:{%getvar:table%}%} */\n"
+        "CREATE TABLE {%getvar:table%} (\n"
+        "    ID INTEGER NOT NULL,\n"
+        "{%ifeq:{%getvar:table%}:customer_orders:"
+        "    CUSTOMER_ID INTEGER NOT NULL,\n%}"
+        "    NOTE VARCHAR(200)\n"
+        ");\n"
+        "CREATE SEQUENCE {%uppercase:{%getvar:generator%}%};\n"
+        "{%if:{%not:false%}:"
+        "GRANT ALL ON {%getvar:table%} TO {%lowercase:PUBLIC%};\n%}"
+        "-- {%substr:{%getvar:table%}:0:8%}\n");
+
+    CodeTemplateProcessor tp(0, 0);
+    Benchmark b("template.process");
+    unsigned long long chars = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        wxString text;
+        tp.processTemplateText(text, part, 0);
+        chars += text.length();
+    }
+    b.report(count, chars * sizeof(wxChar));
+}
+
+static bool isSelected(const wxString& filter, const wxString& name)
+{
+    return name.StartsWith(filter);
+}
+
+int main(int argc, char** argv)
+{
+    wxInitializer initializer(argc, argv);
+    if (!initializer.IsOk())
+    {
+        fprintf(stderr, "Failed to initialize wxWidgets.\n");
+        return 1;
+    }
+
+    wxCmdLineParser parser(argc, argv);
+    parser.AddSwitch("h", "help", "Show this help", wxCMD_LINE_OPTION_HELP);
+    parser.AddOption("s", "scale",
+        "Scale all workloads by this factor (default 1.0)",
+        wxCMD_LINE_VAL_DOUBLE);
+    parser.AddOption("b", "benchmark",
+        "Only run benchmarks whose name starts with this",
+        wxCMD_LINE_VAL_STRING);
+    parser.AddOption("", "server", "Server for the fetch and grid benchmarks, "
+        "empty for an embedded connection", wxCMD_LINE_VAL_STRING);
+    parser.AddOption("d", "database",
+        "Database for the fetch and grid benchmarks", wxCMD_LINE_VAL_STRING);
+    parser.AddOption("u", "user", "User name (default: $ISC_USER)",
+        wxCMD_LINE_VAL_STRING);
+    parser.AddOption("p", "password", "Password (default: $ISC_PASSWORD)",
+        wxCMD_LINE_VAL_STRING);
+    if (parser.Parse() != 0)
+        return 1;
+
+    double scale = 1.0;
+    parser.Found("scale", &scale);
+    wxString filter, server, database, user, password;
+    parser.Found("benchmark", &filter);
+    parser.Found("server", &server);
+    parser.Found("database", &database);
+    if (!parser.Found("user", &user))
+        wxGetEnv("ISC_USER", &user);
+    if (!parser.Found("password", &password))
+        wxGetEnv("ISC_PASSWORD", &password);
+
+#ifdef FR_GIT_HASH
+    printf("{\"frbench\":\"%d.%d.%d\",\"git\":\"%s\"}\n", FR_VERSION_MAJOR,
+        FR_VERSION_MINOR, FR_VERSION_RLS, FR_GIT_HASH);
+#else
+    printf("{\"frbench\":\"%d.%d.%d\"}\n", FR_VERSION_MAJOR,
+        FR_VERSION_MINOR, FR_VERSION_RLS);
+#endif
+
+    if (isSelected(filter, "sql.tokenize")
+        || isSelected(filter, "sql.split_statements"))
+    {
+        wxString script(createScript(size_t(50 * 1048576 * scale)));
+        if (isSelected(filter, "sql.tokenize"))
+            benchTokenizer(script);
+        if (isSelected(filter, "sql.split_statements"))
+            benchMultiStatement(script);
+    }
+    if (isSelected(filter, "decimal.dec34_parse")
+        || isSelected(filter, "decimal.dec34_format"))
+    {
+        benchDec34(size_t(10000000 * scale));
+    }
+    if (isSelected(filter, "decimal.int128_format"))
+        benchInt128(size_t(10000000 * scale));
+    if (isSelected(filter, "ibpp.fetch"))
+        benchFetch(server, database, user, password, size_t(1000000 * scale));
+    if (isSelected(filter, "grid.add_row")
+        || isSelected(filter, "grid.get_as_string"))
+    {
+        benchGrid(server, database, user, password, size_t(1000000 * scale));
+    }
+    if (isSelected(filter, "template.process"))
+        benchTemplate(size_t(100000 * scale));
+    return 0;
+}
@@ -30,6 +30,7 @@
     #include "wx/wx.h"
 #endif
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -277,38 +278,42 @@ wxString wrapText(const wxString& text, size_t maxWidth, size_t indent)
     return wrappedText;
 }
 
-
-wxString IBPPtype2string(Database* db, IBPP::SDT t, int subtype, int size,
-    int scale)
+void appendHex(std::string& dest, const char* data, size_t size,
+    bool upperCase)
 {
-    if (scale > 0)
-        return wxString::Format("NUMERIC(%d,%d)", size == 4 ? 9 : 18, scale);
-    if (t == IBPP::sdString)
+    static const char upperDigits[] = "0123456789ABCDEF";
+    static const char lowerDigits[] = "0123456789abcdef";
+    const char* digits = upperCase ? upperDigits : lowerDigits;
+
+    size_t pos = dest.size();
+    dest.resize(pos + 2 * size);
+    for (size_t i = 0; i < size; ++i)
     {
-        int bpc = db->getCharsetById(subtype)->getBytesPerChar();
-        if (subtype == 1) // charset OCTETS
-            return wxString::Format("OCTETS(%d)", bpc ? size / bpc : size);
-        return wxString::Format("STRING(%d)", bpc ? size / bpc : size);
+        unsigned char c = data[i];
+        dest[pos++] = digits[c >> 4];
+        dest[pos++] = digits[c & 0x0F];
     }
-    switch (t)
+}
+
+void appendHexDump(std::string& dest, const char* data, size_t size,
+    unsigned& lineBytes)
+{
+    // 32 bytes take 64 digits, 4 spaces and the line break
+    dest.reserve(dest.size() + size * 69 / 32 + 8);
+    while (size > 0)
     {
-    case IBPP::sdArray:     return "ARRAY";
-    case IBPP::sdBlob:      return wxString::Format("BLOB SUB_TYPE %d", subtype);
-    case IBPP::sdDate:      return "DATE";
-    case IBPP::sdTime:      return "TIME";
-    case IBPP::sdTimestamp: return "TIMESTAMP";
-    case IBPP::sdSmallint:  return "SMALLINT";
-    case IBPP::sdInteger:   return "INTEGER";
-    case IBPP::sdLargeint:  return "BIGINT";
-    case IBPP::sdFloat:     return "FLOAT";
-    case IBPP::sdDouble:    return "DOUBLE PRECISION";
-    case IBPP::sdBoolean:   return "BOOLEAN";
-    case IBPP::sdTimeTz:    return "TIME WITH TIMEZONE";
-    case IBPP::sdTimestampTz: return "TIMESTAMP WITH TIMEZONE";
-    case IBPP::sdInt128:    return "INT128";
-    case IBPP::sdDec16:     return "DECFLOAT(16)";
-    case IBPP::sdDec34:     return "DECFLOAT(34)";
-    default:                return "UNKNOWN";
+        // up to the end of the current group of 8 bytes
+        size_t count = std::min(size, size_t(8 - lineBytes % 8));
+        appendHex(dest, data, count);
+        data += count;
+        size -= count;
+        lineBytes += count;
+        if (lineBytes % 8 == 0)
+            dest += ' ';
+        if (lineBytes == 32)
+        {
+            dest += '\n';
+            lineBytes = 0;
+        }
     }
 }
-
@@ -63,6 +63,13 @@ wxString loadEntireFile(const wxFileName& filename);
 wxString wrapText(const wxString& text, size_t maxWidth, size_t indent);
 
 
-wxString IBPPtype2string(Database* db, IBPP::SDT t, int subtype, int size, int scale);
+//! appends two hexadecimal digits per byte of <data> to <dest>
+void appendHex(std::string& dest, const char* data, size_t size,
+    bool upperCase = true);
+//! appends the hex dump used for binary BLOBs: groups of 8 bytes followed
+//  by a space, 32 bytes per line. <lineBytes> is the number of bytes
+//  already in the current line, it is updated for consecutive calls.
+void appendHexDump(std::string& dest, const char* data, size_t size,
+    unsigned& lineBytes);
 
 #endif // FR_STRINGUTILS_H
@@ -0,0 +1,149 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <utility>
+
+#include "engine/BlobPreviewLoader.h"
+#include "engine/BlobReader.h"
+
+BlobPreviewLoader::BlobPreviewLoader(NotifyFunction notify)
+    : notifyM(notify), busyM(false), stopM(false), notifiedM(false)
+{
+}
+
+BlobPreviewLoader::~BlobPreviewLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        stopM = true;
+        requestsM.clear();
+    }
+    wakeM.notify_all();
+    if (threadM.joinable())
+        threadM.join();
+}
+
+void BlobPreviewLoader::request(unsigned row, unsigned col, IBPP::Blob blob,
+    int maxBytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        if (stopM)
+            return;
+        // already read, but not yet taken
+        for (std::vector<Preview>::const_iterator it = previewsM.begin();
+            it != previewsM.end(); ++it)
+        {
+            if ((*it).row == row && (*it).col == col)
+                return;
+        }
+        for (std::deque<Request>::iterator it = requestsM.begin();
+            it != requestsM.end(); ++it)
+        {
+            if ((*it).row == row && (*it).col == col)
+            {
+                requestsM.erase(it);
+                break;
+            }
+        }
+        // requests for rows scrolled out of view long ago are dropped,
+        // they will be requested again when needed
+        if (requestsM.size() >= MaxPendingRequests)
+            requestsM.pop_front();
+        Request r = { row, col, blob, maxBytes };
+        requestsM.push_back(r);
+        // the worker thread is only started when it is needed
+        if (!threadM.joinable())
+            threadM = std::thread(&BlobPreviewLoader::run, this);
+    }
+    wakeM.notify_one();
+}
+
+void BlobPreviewLoader::takePreviews(std::vector<Preview>& previews)
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    notifiedM = false;
+    previews.swap(previewsM);
+    previewsM.clear();
+}
+
+void BlobPreviewLoader::cancel()
+{
+    std::unique_lock<std::mutex> lock(mutexM);
+    requestsM.clear();
+    idleM.wait(lock, [this] { return !busyM; });
+    previewsM.clear();
+    notifiedM = false;
+}
+
+void BlobPreviewLoader::run()
+{
+    std::unique_lock<std::mutex> lock(mutexM);
+    while (true)
+    {
+        wakeM.wait(lock, [this] { return stopM || !requestsM.empty(); });
+        if (stopM)
+            break;
+        Preview p = { requestsM.back().row, requestsM.back().col,
+            requestsM.back().blob, std::string(), false, false };
+        int maxBytes = requestsM.back().maxBytes;
+        requestsM.pop_back();
+        busyM = true;
+        lock.unlock();
+
+        try
+        {
+            BlobReader reader(p.blob);
+            reader.read(p.data, maxBytes);
+            p.complete = reader.isEof();
+        }
+        catch (...)
+        {
+            p.error = true;
+        }
+
+        lock.lock();
+        busyM = false;
+        // the blob reference moves on to the thread taking the previews
+        previewsM.push_back(std::move(p));
+        idleM.notify_all();
+        // only notify once until the previews have been taken, the
+        // receiver can process many of them at once
+        bool notify = !notifiedM.exchange(true);
+        if (notify && notifyM)
+        {
+            lock.unlock();
+            notifyM();
+            lock.lock();
+        }
+    }
+}
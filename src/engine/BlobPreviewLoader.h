@@ -0,0 +1,97 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_BLOBPREVIEWLOADER_H
+#define FR_BLOBPREVIEWLOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ibpp.h>
+
+// Reads the beginning of blobs on a worker thread, so that showing blob
+// contents in the data grid doesn't block the GUI.  Requests are served
+// newest first, because the rows the user currently looks at are the ones
+// requested last.  The notify function is called from the worker thread
+// once new previews are available; the caller collects them with
+// takePreviews() from its own thread.
+// The blob objects are shared with the caller: no blob that has been
+// requested may be used by the caller before cancel() has returned.
+class BlobPreviewLoader
+{
+public:
+    struct Preview
+    {
+        unsigned row;
+        unsigned col;
+        IBPP::Blob blob;
+        std::string data;
+        bool complete;
+        bool error;
+    };
+    typedef std::function<void()> NotifyFunction;
+
+private:
+    struct Request
+    {
+        unsigned row;
+        unsigned col;
+        IBPP::Blob blob;
+        int maxBytes;
+    };
+
+    NotifyFunction notifyM;
+    std::thread threadM;
+    std::mutex mutexM;
+    std::condition_variable wakeM;
+    std::condition_variable idleM;
+    std::deque<Request> requestsM;
+    std::vector<Preview> previewsM;
+    bool busyM;
+    bool stopM;
+    std::atomic<bool> notifiedM;
+
+    enum { MaxPendingRequests = 256 };
+
+    void run();
+public:
+    BlobPreviewLoader(NotifyFunction notify);
+    ~BlobPreviewLoader();
+
+    // queues a request, or moves a pending one for the same cell to the
+    // front of the queue
+    void request(unsigned row, unsigned col, IBPP::Blob blob, int maxBytes);
+    // moves all previews read since the last call into previews
+    void takePreviews(std::vector<Preview>& previews);
+    // drops all queued requests and previews, waits until the blob that
+    // is currently read has been closed
+    void cancel();
+};
+
+#endif // FR_BLOBPREVIEWLOADER_H
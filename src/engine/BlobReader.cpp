@@ -0,0 +1,100 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+
+#include "engine/BlobReader.h"
+
+BlobReader::BlobReader(IBPP::Blob blob)
+    : blobM(blob), sizeM(0), bytesReadM(0), eofM(false)
+{
+    // start from the beginning, even if the blob has been read before
+    blobM->Close();
+    blobM->Open();
+    blobM->Info(&sizeM, 0, 0);
+}
+
+BlobReader::~BlobReader()
+{
+    try
+    {
+        blobM->Close();
+    }
+    catch (IBPP::Exception&)
+    {
+    }
+}
+
+int BlobReader::getSize() const
+{
+    return sizeM;
+}
+
+int BlobReader::getBytesRead() const
+{
+    return bytesReadM;
+}
+
+bool BlobReader::isEof() const
+{
+    return eofM || bytesReadM >= sizeM;
+}
+
+int BlobReader::read(std::string& data, int maxBytes,
+    const std::atomic<bool>* canceled)
+{
+    if (isEof() || maxBytes <= 0)
+        return 0;
+
+    // the blob size is known, so the data needs to grow only once
+    int toRead = std::min(maxBytes, sizeM - bytesReadM);
+    size_t start = data.size();
+    data.resize(start + toRead);
+
+    int total = 0;
+    while (total < toRead && !(canceled && *canceled))
+    {
+        // a buffer larger than the segment returns one whole segment of a
+        // segmented blob, or fills the buffer from a stream blob
+        int size = blobM->Read(&data[start + total],
+            std::min(toRead - total, int(MaxSegmentSize)));
+        if (size < 1)
+        {
+            eofM = true;
+            break;
+        }
+        total += size;
+        bytesReadM += size;
+    }
+    data.resize(start + total);
+    return total;
+}
@@ -0,0 +1,62 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_BLOBREADER_H
+#define FR_BLOBREADER_H
+
+#include <atomic>
+#include <string>
+
+#include <ibpp.h>
+
+// Reads the contents of a blob with the largest segment size the client
+// library supports, instead of many small reads.  Reading can be limited
+// to a number of bytes and continued later, which allows to show large
+// blobs page by page.  The blob stays open until the reader is destroyed.
+// The number of bytes read can be queried from other threads while read()
+// is running on a worker thread.
+class BlobReader
+{
+private:
+    IBPP::Blob blobM;
+    int sizeM;
+    std::atomic<int> bytesReadM;
+    bool eofM;
+
+public:
+    enum { MaxSegmentSize = 64 * 1024 - 1 };
+
+    BlobReader(IBPP::Blob blob);
+    ~BlobReader();
+
+    int getSize() const;
+    int getBytesRead() const;
+    bool isEof() const;
+
+    // appends at most maxBytes bytes to data and returns the number of bytes
+    // appended, stops early when canceled is set
+    int read(std::string& data, int maxBytes,
+        const std::atomic<bool>* canceled = 0);
+};
+
+#endif // FR_BLOBREADER_H
@@ -0,0 +1,183 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+#include <exception>
+
+#include "core/StringUtils.h"
+#include "engine/EventListener.h"
+#include "metadata/ConnectionPool.h"
+
+EventListener::EventListener(std::shared_ptr<ConnectionPool> pool,
+        NotifyFunction notify)
+    : poolM(pool), notifyM(notify), stopM(false), notifiedM(false),
+        deliveriesM(0), eventNamesChangedM(false)
+{
+}
+
+EventListener::~EventListener()
+{
+    stop();
+    std::vector<Delivery> dropped;
+    takeDeliveries(dropped);
+}
+
+void EventListener::listen(const std::vector<std::string>& eventNames)
+{
+    // the worker thread may have ended because of an error
+    if (threadM.joinable() && stopM)
+        threadM.join();
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        eventNamesM = eventNames;
+        eventNamesChangedM = true;
+    }
+    if (!threadM.joinable())
+    {
+        stopM = false;
+        threadM = std::thread(&EventListener::run, this);
+    }
+}
+
+void EventListener::stop()
+{
+    stopM = true;
+    if (threadM.joinable())
+        threadM.join();
+}
+
+bool EventListener::isRunning() const
+{
+    return threadM.joinable() && !stopM;
+}
+
+void EventListener::takeDeliveries(std::vector<Delivery>& deliveries)
+{
+    notifiedM = false;
+    Node* node = deliveriesM.exchange(0);
+    size_t first = deliveries.size();
+    while (node)
+    {
+        deliveries.push_back(node->delivery);
+        Node* next = node->next;
+        delete node;
+        node = next;
+    }
+    std::reverse(deliveries.begin() + first, deliveries.end());
+}
+
+std::string EventListener::takeError()
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    std::string error;
+    error.swap(errorM);
+    return error;
+}
+
+void EventListener::notify()
+{
+    // only notify once until the deliveries have been taken, the receiver
+    // processes all of them at once
+    if (!notifiedM.exchange(true) && notifyM)
+        notifyM();
+}
+
+void EventListener::ibppEventHandler(IBPP::Events WXUNUSED(events),
+    const std::string& name, int count)
+{
+    Node* node = new Node;
+    node->delivery.name = name;
+    node->delivery.count = count;
+    node->next = deliveriesM.load();
+    while (!deliveriesM.compare_exchange_weak(node->next, node))
+        ;
+    notify();
+}
+
+void EventListener::run()
+{
+    try
+    {
+        // held until the listener stops
+        PooledConnection connection(poolM, true);
+        IBPP::Events events = IBPP::EventsFactory(connection.get());
+        while (!stopM)
+        {
+            std::vector<std::string> eventNames;
+            bool changed = false;
+            {
+                std::lock_guard<std::mutex> lock(mutexM);
+                if (eventNamesChangedM)
+                {
+                    eventNames.swap(eventNamesM);
+                    eventNamesChangedM = false;
+                    changed = true;
+                }
+            }
+            if (changed)
+            {
+                events->Clear();
+                for (std::vector<std::string>::const_iterator it =
+                    eventNames.begin(); it != eventNames.end(); ++it)
+                {
+                    events->Add(*it, this);
+                }
+            }
+            // the timeout only bounds the reaction to stop() and listen()
+            if (events->Wait(100))
+                events->Dispatch();
+        }
+        events->Clear();
+    }
+    catch (std::exception& e)
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        errorM = e.what();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        errorM = wx2std(_("Unknown error"));
+    }
+
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        failed = !errorM.empty();
+    }
+    if (failed)
+    {
+        stopM = true;
+        notifiedM = false;
+        notify();
+    }
+}
@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_EVENTLISTENER_H
+#define FR_EVENTLISTENER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ibpp.h>
+
+class ConnectionPool;
+
+// Waits for database events on a worker thread, on an attachment borrowed
+// from the connection pool for as long as the listener runs.  Events are
+// dispatched as soon as Firebird delivers them and requeued immediately,
+// the deliveries are collected in a lock-free list that the caller drains
+// with takeDeliveries() from its own thread.  The notify function is
+// called from the worker thread once new deliveries (or an error) are
+// available, at most once until they have been taken.
+class EventListener: public IBPP::EventInterface
+{
+public:
+    struct Delivery
+    {
+        std::string name;
+        int count;
+    };
+    typedef std::function<void()> NotifyFunction;
+
+private:
+    struct Node
+    {
+        Delivery delivery;
+        Node* next;
+    };
+
+    std::shared_ptr<ConnectionPool> poolM;
+    NotifyFunction notifyM;
+    std::thread threadM;
+    std::atomic<bool> stopM;
+    std::atomic<bool> notifiedM;
+    // newest delivery first, pushed by the worker thread only
+    std::atomic<Node*> deliveriesM;
+
+    // guards the members below
+    std::mutex mutexM;
+    std::vector<std::string> eventNamesM;
+    bool eventNamesChangedM;
+    std::string errorM;
+
+    void run();
+    void notify();
+    virtual void ibppEventHandler(IBPP::Events events,
+        const std::string& name, int count);
+public:
+    EventListener(std::shared_ptr<ConnectionPool> pool,
+        NotifyFunction notify);
+    ~EventListener();
+
+    // starts listening, or changes the monitored events while running
+    void listen(const std::vector<std::string>& eventNames);
+    // stops the worker thread and returns the attachment to the pool
+    void stop();
+    bool isRunning() const;
+
+    // appends the deliveries since the last call, oldest first
+    void takeDeliveries(std::vector<Delivery>& deliveries);
+    // returns the error that stopped the worker thread, if any
+    std::string takeError();
+};
+
+#endif // FR_EVENTLISTENER_H
@@ -0,0 +1,333 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/tokenzr.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "core/StringUtils.h"
+#include "engine/ExplainedPlan.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/database.h"
+
+PlanNode::PlanNode(Kind nodeKind, const wxString& nodeText)
+    : kind(nodeKind), text(nodeText), estimatedRows(-1),
+        largeNaturalScan(false)
+{
+}
+
+// reads the quoted identifier at pos, doubled quotes are part of the name
+static bool readIdentifier(const wxString& text, size_t& pos, wxString& name)
+{
+    if (pos >= text.length() || text[pos] != '"')
+        return false;
+    name.clear();
+    for (++pos; pos < text.length(); ++pos)
+    {
+        if (text[pos] != '"')
+            name += text[pos];
+        else if (pos + 1 < text.length() && text[pos + 1] == '"')
+            name += text[++pos];
+        else
+        {
+            ++pos;
+            return true;
+        }
+    }
+    return false;
+}
+
+// reads the object name and alias at the start of text into node, returns
+// the rest of the text
+static wxString readObjectName(const wxString& text, PlanNode& node)
+{
+    size_t pos = 0;
+    wxString name;
+    // the name may be qualified by its schema, only the last part is kept
+    while (readIdentifier(text, pos, name))
+    {
+        node.objectName = name;
+        if (pos >= text.length() || text[pos] != '.')
+            break;
+        ++pos;
+    }
+    // aliases of nested views and derived tables are separated by spaces
+    if (text.Mid(pos, 4) == " as ")
+    {
+        pos += 3;
+        while (text.Mid(pos, 2) == " \"")
+        {
+            ++pos;
+            if (!readIdentifier(text, pos, name))
+                break;
+            if (!node.alias.empty())
+                node.alias += " ";
+            node.alias += name;
+        }
+    }
+    return text.Mid(pos);
+}
+
+static PlanNode createNode(const wxString& text)
+{
+    wxString rest;
+    if (text.StartsWith("Table ", &rest))
+    {
+        PlanNode node(PlanNode::pnTableAccess, text);
+        if (readObjectName(rest, node).StartsWith(" Full Scan"))
+            node.kind = PlanNode::pnNaturalScan;
+        return node;
+    }
+    if (text.StartsWith("Index ", &rest))
+    {
+        PlanNode node(PlanNode::pnIndexScan, text);
+        readObjectName(rest, node);
+        return node;
+    }
+    if (text.StartsWith("Procedure ", &rest))
+    {
+        PlanNode node(PlanNode::pnProcedure, text);
+        readObjectName(rest, node);
+        return node;
+    }
+    if (text.Contains("Join"))
+        return PlanNode(PlanNode::pnJoin, text);
+    if (text.StartsWith("Sort"))
+        return PlanNode(PlanNode::pnSort, text);
+    if (text.StartsWith("Aggregate") || text.StartsWith("Window"))
+        return PlanNode(PlanNode::pnAggregate, text);
+    if (text.StartsWith("Filter"))
+        return PlanNode(PlanNode::pnFilter, text);
+    return PlanNode(PlanNode::pnOther, text);
+}
+
+ExplainedPlan::ExplainedPlan(const wxString& text)
+    : textM(text)
+{
+    parse();
+}
+
+void ExplainedPlan::parse()
+{
+    // statements start in the first column, their operations follow on
+    // lines "-> Operation" indented by four spaces per level, other lines
+    // continue the operation above
+    std::vector<std::pair<size_t, PlanNode*> > parents;
+    wxStringTokenizer tokenizer(textM, "\r\n", wxTOKEN_STRTOK);
+    while (tokenizer.HasMoreTokens())
+    {
+        wxString line(tokenizer.GetNextToken());
+        line.Trim(true);
+        size_t indent = 0;
+        while (indent < line.length() && line[indent] == ' ')
+            ++indent;
+        if (indent == line.length())
+            continue;
+
+        wxString text(line.Mid(indent));
+        if (indent == 0)
+        {
+            rootsM.push_back(PlanNode(PlanNode::pnStatement, text));
+            parents.assign(1, std::make_pair(indent, &rootsM.back()));
+            continue;
+        }
+        wxString operation;
+        if (!text.StartsWith("-> ", &operation))
+        {
+            if (!parents.empty())
+                parents.back().second->text += "\n" + text;
+            continue;
+        }
+
+        while (!parents.empty() && parents.back().first >= indent)
+            parents.pop_back();
+        std::vector<PlanNode>& siblings =
+            parents.empty() ? rootsM : parents.back().second->children;
+        siblings.push_back(createNode(operation));
+        parents.push_back(std::make_pair(indent, &siblings.back()));
+    }
+}
+
+const wxString& ExplainedPlan::getText() const
+{
+    return textM;
+}
+
+const std::vector<PlanNode>& ExplainedPlan::getRoots() const
+{
+    return rootsM;
+}
+
+struct PlanStatistics
+{
+    // estimated from the most selective index of the table
+    std::map<wxString, double> tableRows;
+    std::map<wxString, double> indexSelectivity;
+    std::map<wxString, wxString> indexTable;
+
+    double getTableRows(const wxString& table) const
+    {
+        std::map<wxString, double>::const_iterator it = tableRows.find(table);
+        return (it == tableRows.end()) ? -1 : (*it).second;
+    }
+};
+
+static void collectTables(const std::vector<PlanNode>& nodes,
+    std::set<wxString>& tables)
+{
+    for (std::vector<PlanNode>::const_iterator it = nodes.begin();
+        it != nodes.end(); ++it)
+    {
+        if ((*it).kind == PlanNode::pnNaturalScan
+            || (*it).kind == PlanNode::pnTableAccess)
+        {
+            tables.insert((*it).objectName);
+        }
+        collectTables((*it).children, tables);
+    }
+}
+
+static void estimateRows(PlanNode& node, const PlanStatistics& stats,
+    double largeTableRows)
+{
+    for (std::vector<PlanNode>::iterator it = node.children.begin();
+        it != node.children.end(); ++it)
+    {
+        estimateRows(*it, stats, largeTableRows);
+    }
+
+    if (node.kind == PlanNode::pnNaturalScan)
+    {
+        node.estimatedRows = stats.getTableRows(node.objectName);
+        node.largeNaturalScan = node.estimatedRows >= largeTableRows;
+    }
+    else if (node.kind == PlanNode::pnIndexScan)
+    {
+        std::map<wxString, wxString>::const_iterator table =
+            stats.indexTable.find(node.objectName);
+        double rows = (table == stats.indexTable.end()) ? -1
+            : stats.getTableRows((*table).second);
+        std::map<wxString, double>::const_iterator selectivity =
+            stats.indexSelectivity.find(node.objectName);
+
+        if (node.text.Contains(" Unique Scan"))
+            node.estimatedRows = 1;
+        else if (node.text.Contains("(full match)") && rows >= 0
+                && selectivity != stats.indexSelectivity.end())
+        {
+            node.estimatedRows = std::max(1.0, rows * (*selectivity).second);
+        }
+        else if (node.text.EndsWith(" Full Scan"))
+            node.estimatedRows = rows;
+    }
+    else if (node.kind == PlanNode::pnTableAccess
+        || node.text.StartsWith("Bitmap"))
+    {
+        // records found through the index bitmaps: the union of "Bitmap Or"
+        // adds up, the others read at most the smallest estimate
+        bool sum = node.text.StartsWith("Bitmap Or");
+        double rows = -1;
+        for (std::vector<PlanNode>::iterator it = node.children.begin();
+            it != node.children.end(); ++it)
+        {
+            double childRows = (*it).estimatedRows;
+            if (childRows < 0 && sum)
+            {
+                rows = -1;
+                break;
+            }
+            if (childRows < 0)
+                continue;
+            if (rows < 0)
+                rows = childRows;
+            else
+                rows = sum ? rows + childRows : std::min(rows, childRows);
+        }
+        node.estimatedRows = rows;
+    }
+}
+
+void ExplainedPlan::loadEstimates(Database* db, double largeTableRows)
+{
+    std::set<wxString> tables;
+    collectTables(rootsM, tables);
+    if (tables.empty())
+        return;
+
+    MetadataLoader* loader = db->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* converter = db->getCharsetConverter();
+
+    IBPP::Statement& st1 = loader->getStatement(
+        "select i.rdb$index_name, i.rdb$statistics from rdb$indices i "
+        " where i.rdb$relation_name = ? "
+        " and coalesce(i.rdb$index_inactive, 0) = 0"
+    );
+
+    PlanStatistics stats;
+    for (std::set<wxString>::iterator it = tables.begin();
+        it != tables.end(); ++it)
+    {
+        st1->Set(1, wx2std(*it, converter));
+        st1->Execute();
+        double rows = 0;
+        while (st1->Fetch())
+        {
+            std::string s;
+            st1->Get(1, s);
+            wxString index(std2wxIdentifier(s, converter));
+            stats.indexTable[index] = *it;
+
+            // the selectivity is 1 / distinct keys, so unique indices give
+            // the record count, others a lower bound
+            double selectivity = 0;
+            if (!st1->IsNull(2))
+                st1->Get(2, selectivity);
+            if (selectivity > 0)
+            {
+                stats.indexSelectivity[index] = selectivity;
+                rows = std::max(rows, 1 / selectivity);
+            }
+        }
+        if (rows > 0)
+            stats.tableRows[*it] = rows;
+    }
+
+    for (std::vector<PlanNode>::iterator it = rootsM.begin();
+        it != rootsM.end(); ++it)
+    {
+        estimateRows(*it, stats, largeTableRows);
+    }
+}
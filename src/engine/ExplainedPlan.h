@@ -0,0 +1,78 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_EXPLAINEDPLAN_H
+#define FR_EXPLAINEDPLAN_H
+
+#include <wx/string.h>
+
+#include <memory>
+#include <vector>
+
+class Database;
+
+// one operation of an explained plan, with the operations it reads from
+struct PlanNode
+{
+    enum Kind { pnStatement, pnJoin, pnSort, pnAggregate, pnFilter,
+        pnNaturalScan, pnTableAccess, pnIndexScan, pnProcedure, pnOther };
+
+    Kind kind;
+    // may span several lines
+    wxString text;
+    // table, index or procedure
+    wxString objectName;
+    wxString alias;
+    // records the operation reads, negative if unknown
+    double estimatedRows;
+    // natural scan of a table with at least the configured number of rows
+    bool largeNaturalScan;
+    std::vector<PlanNode> children;
+
+    PlanNode(Kind nodeKind, const wxString& nodeText);
+};
+
+// Tree of the indented plan that Firebird 3 and newer return for
+// isc_info_sql_explain_plan.  There is one root for each statement and
+// sub-query.
+class ExplainedPlan
+{
+private:
+    wxString textM;
+    std::vector<PlanNode> rootsM;
+
+    void parse();
+public:
+    ExplainedPlan(const wxString& text);
+
+    const wxString& getText() const;
+    const std::vector<PlanNode>& getRoots() const;
+    // estimates the records read by table and index scans from the index
+    // selectivity in RDB$INDICES.RDB$STATISTICS, natural scans of tables
+    // with at least largeTableRows records are flagged
+    void loadEstimates(Database* db, double largeTableRows);
+};
+
+typedef std::shared_ptr<ExplainedPlan> ExplainedPlanPtr;
+
+#endif // FR_EXPLAINEDPLAN_H
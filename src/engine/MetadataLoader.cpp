@@ -146,6 +146,11 @@ void MetadataLoader::setMaximumConcurrentStatements(unsigned count)
     }
 }
 
+unsigned MetadataLoader::getMaximumConcurrentStatements() const
+{
+    return maxStatementsM;
+}
+
 IBPP::Blob MetadataLoader::createBlob()
 {
     wxASSERT(transactionStarted());
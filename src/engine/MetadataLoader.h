@@ -91,6 +91,8 @@ public:
     // statementsM list, and could possibly consume a lot of the available
     // server ressources!
     void setMaximumConcurrentStatements(unsigned count);
+    // returns the current maximum number of IBPP::Statement objects
+    unsigned getMaximumConcurrentStatements() const;
 
     // Creates an IBPP::Blob object using the database and transaction
     IBPP::Blob createBlob();
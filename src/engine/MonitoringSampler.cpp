@@ -0,0 +1,339 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+#include <exception>
+#include <map>
+
+#include "core/StringUtils.h"
+#include "engine/MonitoringSampler.h"
+#include "metadata/ConnectionPool.h"
+
+static void computeRowDeltas(std::vector<MonitoringRow>& rows,
+    const std::vector<MonitoringRow>& previousRows)
+{
+    std::map<int64_t, const MonitoringCounters*> previous;
+    for (std::vector<MonitoringRow>::const_iterator it = previousRows.begin();
+        it != previousRows.end(); ++it)
+    {
+        previous[(*it).id] = &(*it).totals;
+    }
+
+    for (std::vector<MonitoringRow>::iterator it = rows.begin();
+        it != rows.end(); ++it)
+    {
+        MonitoringCounters& d = (*it).deltas;
+        d = (*it).totals;
+        std::map<int64_t, const MonitoringCounters*>::const_iterator p =
+            previous.find((*it).id);
+        if (p == previous.end())
+            continue;
+        d.reads = std::max<int64_t>(0, d.reads - (*p).second->reads);
+        d.writes = std::max<int64_t>(0, d.writes - (*p).second->writes);
+        d.fetches = std::max<int64_t>(0, d.fetches - (*p).second->fetches);
+        d.marks = std::max<int64_t>(0, d.marks - (*p).second->marks);
+        d.recordReads = std::max<int64_t>(0,
+            d.recordReads - (*p).second->recordReads);
+    }
+}
+
+void MonitoringSnapshot::computeDeltas(const MonitoringSnapshot& previous)
+{
+    intervalSeconds = std::chrono::duration<double>(
+        taken - previous.taken).count();
+    computeRowDeltas(attachments, previous.attachments);
+    computeRowDeltas(transactions, previous.transactions);
+    computeRowDeltas(statements, previous.statements);
+}
+
+// the counters are the last five columns of all monitoring queries
+static const char* countersSelect =
+    ", coalesce(io.MON$PAGE_READS, 0), coalesce(io.MON$PAGE_WRITES, 0)"
+    ", coalesce(io.MON$PAGE_FETCHES, 0), coalesce(io.MON$PAGE_MARKS, 0)"
+    ", coalesce(r.MON$RECORD_SEQ_READS, 0) + coalesce(r.MON$RECORD_IDX_READS, 0)";
+
+static std::string countersJoin(const char* alias)
+{
+    std::string join(" left join MON$IO_STATS io on io.MON$STAT_ID = ");
+    join.append(alias).append(".MON$STAT_ID");
+    join.append(" left join MON$RECORD_STATS r on r.MON$STAT_ID = ");
+    join.append(alias).append(".MON$STAT_ID");
+    return join;
+}
+
+static void getCounters(IBPP::Statement& st, int column,
+    MonitoringCounters& counters)
+{
+    st->Get(column, counters.reads);
+    st->Get(column + 1, counters.writes);
+    st->Get(column + 2, counters.fetches);
+    st->Get(column + 3, counters.marks);
+    st->Get(column + 4, counters.recordReads);
+}
+
+static std::string getString(IBPP::Statement& st, int column)
+{
+    std::string s;
+    if (!st->IsNull(column))
+        st->Get(column, s);
+    return s;
+}
+
+static std::string getTextBlob(IBPP::Statement& st, int column)
+{
+    std::string text;
+    if (st->IsNull(column))
+        return text;
+
+    IBPP::Blob b = IBPP::BlobFactory(st->DatabasePtr(),
+        st->TransactionPtr());
+    st->Get(column, b);
+    b->Open();
+    char buffer[8192];
+    while (true)
+    {
+        int size = b->Read(buffer, sizeof(buffer));
+        if (size <= 0)
+            break;
+        text.append(buffer, size);
+    }
+    b->Close();
+    return text;
+}
+
+MonitoringSampler::MonitoringSampler(std::shared_ptr<ConnectionPool> pool,
+        int intervalMs, NotifyFunction notify)
+    : poolM(pool), notifyM(notify), stopM(false), notifiedM(false),
+        intervalMsM(intervalMs)
+{
+}
+
+MonitoringSampler::~MonitoringSampler()
+{
+    stop();
+}
+
+void MonitoringSampler::start()
+{
+    // the worker thread may have ended because of an error
+    if (threadM.joinable() && !isRunning())
+        threadM.join();
+    if (!threadM.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutexM);
+            stopM = false;
+            errorM.clear();
+        }
+        threadM = std::thread(&MonitoringSampler::run, this);
+    }
+}
+
+void MonitoringSampler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        stopM = true;
+    }
+    wakeupM.notify_all();
+    if (threadM.joinable())
+        threadM.join();
+}
+
+bool MonitoringSampler::isRunning()
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    return threadM.joinable() && !stopM;
+}
+
+void MonitoringSampler::setInterval(int intervalMs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        intervalMsM = intervalMs;
+    }
+    // restart the wait with the new interval
+    wakeupM.notify_all();
+}
+
+std::shared_ptr<const MonitoringSnapshot> MonitoringSampler::takeSnapshot()
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    notifiedM = false;
+    std::shared_ptr<const MonitoringSnapshot> snapshot;
+    snapshot.swap(snapshotM);
+    return snapshot;
+}
+
+std::string MonitoringSampler::takeError()
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    std::string error;
+    error.swap(errorM);
+    return error;
+}
+
+void MonitoringSampler::notify(std::unique_lock<std::mutex>& lock)
+{
+    // only notify once until the snapshot has been taken, the receiver
+    // only shows the newest one anyway
+    if (notifiedM || !notifyM)
+        return;
+    notifiedM = true;
+    lock.unlock();
+    notifyM();
+    lock.lock();
+}
+
+void MonitoringSampler::readSnapshot(IBPP::Database& database,
+    MonitoringSnapshot& snapshot)
+{
+    IBPP::Transaction tr = IBPP::TransactionFactory(database, IBPP::amRead,
+        IBPP::ilConcurrency);
+    tr->Start();
+    snapshot.taken = std::chrono::steady_clock::now();
+
+    IBPP::Statement st = IBPP::StatementFactory(database, tr);
+    st->Prepare(std::string(
+        "select a.MON$ATTACHMENT_ID, a.MON$STATE, a.MON$USER,"
+        " a.MON$REMOTE_ADDRESS, a.MON$REMOTE_PROCESS")
+        + countersSelect + " from MON$ATTACHMENTS a" + countersJoin("a")
+        + " where a.MON$ATTACHMENT_ID <> current_connection");
+    st->Execute();
+    while (st->Fetch())
+    {
+        MonitoringRow row;
+        st->Get(1, row.id);
+        row.attachmentId = row.id;
+        st->Get(2, row.state);
+        row.user = getString(st, 3);
+        row.remoteAddress = getString(st, 4);
+        row.remoteProcess = getString(st, 5);
+        getCounters(st, 6, row.totals);
+        snapshot.attachments.push_back(row);
+    }
+
+    // Firebird 4 returns a NUMERIC(18,1) for milliseconds
+    st->Prepare(std::string(
+        "select t.MON$TRANSACTION_ID, t.MON$ATTACHMENT_ID, t.MON$STATE,"
+        " cast(datediff(millisecond from t.MON$TIMESTAMP"
+        " to current_timestamp) as bigint)")
+        + countersSelect + " from MON$TRANSACTIONS t" + countersJoin("t")
+        + " where t.MON$ATTACHMENT_ID <> current_connection");
+    st->Execute();
+    while (st->Fetch())
+    {
+        MonitoringRow row;
+        st->Get(1, row.id);
+        st->Get(2, row.attachmentId);
+        st->Get(3, row.state);
+        st->Get(4, row.ageMs);
+        getCounters(st, 5, row.totals);
+        snapshot.transactions.push_back(row);
+    }
+
+    st->Prepare(std::string(
+        "select s.MON$STATEMENT_ID, s.MON$ATTACHMENT_ID,"
+        " s.MON$TRANSACTION_ID, s.MON$STATE,"
+        " cast(datediff(millisecond from s.MON$TIMESTAMP"
+        " to current_timestamp) as bigint), s.MON$SQL_TEXT")
+        + countersSelect + " from MON$STATEMENTS s" + countersJoin("s")
+        + " where s.MON$ATTACHMENT_ID <> current_connection"
+        " and s.MON$STATE <> 0");
+    st->Execute();
+    while (st->Fetch())
+    {
+        MonitoringRow row;
+        st->Get(1, row.id);
+        st->Get(2, row.attachmentId);
+        st->Get(3, row.transactionId);
+        st->Get(4, row.state);
+        st->Get(5, row.ageMs);
+        row.sqlText = getTextBlob(st, 6);
+        getCounters(st, 7, row.totals);
+        snapshot.statements.push_back(row);
+    }
+
+    tr->Commit();
+}
+
+void MonitoringSampler::run()
+{
+    std::string error;
+    try
+    {
+        // held until the sampler stops
+        PooledConnection connection(poolM, true);
+        std::shared_ptr<MonitoringSnapshot> previous;
+        std::unique_lock<std::mutex> lock(mutexM);
+        while (!stopM)
+        {
+            lock.unlock();
+            std::shared_ptr<MonitoringSnapshot> snapshot(
+                new MonitoringSnapshot);
+            readSnapshot(connection.get(), *snapshot);
+            if (previous)
+                snapshot->computeDeltas(*previous);
+            previous = snapshot;
+            lock.lock();
+
+            snapshotM = snapshot;
+            notify(lock);
+
+            // wake up early to stop or to apply a new interval
+            while (!stopM)
+            {
+                std::chrono::steady_clock::time_point next = snapshot->taken
+                    + std::chrono::milliseconds(intervalMsM);
+                if (wakeupM.wait_until(lock, next) == std::cv_status::timeout)
+                    break;
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        error = e.what();
+    }
+    catch (...)
+    {
+        error = wx2std(_("Unknown error"));
+    }
+
+    if (!error.empty())
+    {
+        std::unique_lock<std::mutex> lock(mutexM);
+        errorM = error;
+        stopM = true;
+        notifiedM = false;
+        notify(lock);
+    }
+}
@@ -0,0 +1,138 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_MONITORINGSAMPLER_H
+#define FR_MONITORINGSAMPLER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ibpp.h>
+
+class ConnectionPool;
+
+// page and record counters of MON$IO_STATS and MON$RECORD_STATS
+struct MonitoringCounters
+{
+    int64_t reads;
+    int64_t writes;
+    int64_t fetches;
+    int64_t marks;
+    int64_t recordReads;    // sequential and indexed
+
+    MonitoringCounters()
+        : reads(0), writes(0), fetches(0), marks(0), recordReads(0) {}
+};
+
+// one row of MON$ATTACHMENTS, MON$TRANSACTIONS or MON$STATEMENTS, the
+// strings are in the character set of the connection
+struct MonitoringRow
+{
+    int64_t id;
+    int64_t attachmentId;
+    int64_t transactionId;  // statements only
+    int state;              // 0 = idle, 1 = active, 2 = stalled
+    int64_t ageMs;          // since the transaction or statement started
+    std::string user;           // attachments only
+    std::string remoteAddress;  // attachments only
+    std::string remoteProcess;  // attachments only
+    std::string sqlText;        // statements only
+    MonitoringCounters totals;
+    // difference to the previous snapshot, the totals for new rows
+    MonitoringCounters deltas;
+
+    MonitoringRow()
+        : id(0), attachmentId(0), transactionId(0), state(0), ageMs(0) {}
+};
+
+// The contents of the monitoring tables at one point in time, without the
+// attachment that takes the snapshot.  Only active statements are listed.
+struct MonitoringSnapshot
+{
+    std::chrono::steady_clock::time_point taken;
+    // seconds since the previous snapshot, 0 if there is none
+    double intervalSeconds;
+    std::vector<MonitoringRow> attachments;
+    std::vector<MonitoringRow> transactions;
+    std::vector<MonitoringRow> statements;
+
+    MonitoringSnapshot() : intervalSeconds(0) {}
+
+    bool hasDeltas() const { return intervalSeconds > 0; }
+    void computeDeltas(const MonitoringSnapshot& previous);
+};
+
+// Takes snapshots of the monitoring tables on a worker thread, on an
+// attachment borrowed from the connection pool for as long as the sampler
+// runs.  Each snapshot is read in its own transaction, since the server
+// keeps the contents of the MON$ tables stable for a transaction.  The
+// notify function is called from the worker thread when a new snapshot
+// (or an error) is available, at most once until it has been taken.
+class MonitoringSampler
+{
+public:
+    typedef std::function<void()> NotifyFunction;
+
+private:
+    std::shared_ptr<ConnectionPool> poolM;
+    NotifyFunction notifyM;
+    std::thread threadM;
+
+    // guards the members below
+    std::mutex mutexM;
+    std::condition_variable wakeupM;
+    bool stopM;
+    bool notifiedM;
+    int intervalMsM;
+    std::shared_ptr<const MonitoringSnapshot> snapshotM;
+    std::string errorM;
+
+    void run();
+    void readSnapshot(IBPP::Database& database, MonitoringSnapshot& snapshot);
+    void notify(std::unique_lock<std::mutex>& lock);
+public:
+    MonitoringSampler(std::shared_ptr<ConnectionPool> pool, int intervalMs,
+        NotifyFunction notify);
+    ~MonitoringSampler();
+
+    void start();
+    // stops the worker thread and returns the attachment to the pool
+    void stop();
+    bool isRunning();
+    void setInterval(int intervalMs);
+
+    // returns the newest snapshot, or null if there is none since the
+    // last call
+    std::shared_ptr<const MonitoringSnapshot> takeSnapshot();
+    // returns the error that stopped the worker thread, if any
+    std::string takeError();
+};
+
+#endif // FR_MONITORINGSAMPLER_H
@@ -0,0 +1,171 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <chrono>
+#include <exception>
+
+#include "core/StringUtils.h"
+#include "engine/TransactionGapSampler.h"
+#include "metadata/ConnectionPool.h"
+
+TransactionGapSampler::TransactionGapSampler(size_t maxSamples)
+    : Subject(), maxSamplesM(maxSamples), stopM(false)
+{
+}
+
+TransactionGapSampler::~TransactionGapSampler()
+{
+    stop();
+}
+
+void TransactionGapSampler::start(std::shared_ptr<ConnectionPool> pool,
+    int intervalMs, NotifyFunction notify)
+{
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        stopM = false;
+        errorM.clear();
+    }
+    threadM = std::thread(&TransactionGapSampler::run, this, pool,
+        intervalMs, notify);
+}
+
+void TransactionGapSampler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        stopM = true;
+    }
+    wakeupM.notify_all();
+    if (threadM.joinable())
+        threadM.join();
+}
+
+bool TransactionGapSampler::isRunning()
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    return threadM.joinable() && !stopM;
+}
+
+bool TransactionGapSampler::processSamples()
+{
+    std::vector<TransactionGapSample> samples;
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        samples.swap(pendingM);
+        failed = !errorM.empty();
+    }
+    // observers need to know about the error too
+    if (samples.empty() && !failed)
+        return false;
+
+    for (std::vector<TransactionGapSample>::const_iterator it =
+        samples.begin(); it != samples.end(); ++it)
+    {
+        samplesM.push_back(*it);
+    }
+    while (samplesM.size() > maxSamplesM)
+        samplesM.pop_front();
+    notifyObservers();
+    return true;
+}
+
+const std::deque<TransactionGapSample>& TransactionGapSampler::getSamples() const
+{
+    return samplesM;
+}
+
+std::string TransactionGapSampler::takeError()
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    std::string error;
+    error.swap(errorM);
+    return error;
+}
+
+void TransactionGapSampler::run(std::shared_ptr<ConnectionPool> pool,
+    int intervalMs, NotifyFunction notify)
+{
+    std::string error;
+    try
+    {
+        std::unique_lock<std::mutex> lock(mutexM);
+        while (!stopM)
+        {
+            lock.unlock();
+            TransactionGapSample sample;
+            {
+                // between samples the attachment is available for other
+                // background work
+                PooledConnection connection(pool);
+                connection.get()->TransactionInfo(&sample.oldest,
+                    &sample.oldestActive, &sample.oldestSnapshot,
+                    &sample.next);
+            }
+            sample.time = std::time(0);
+            lock.lock();
+
+            bool wasEmpty = pendingM.empty();
+            pendingM.push_back(sample);
+            if (wasEmpty && notify)
+            {
+                lock.unlock();
+                notify();
+                lock.lock();
+            }
+
+            wakeupM.wait_for(lock, std::chrono::milliseconds(intervalMs),
+                [this]() { return stopM; });
+        }
+    }
+    catch (std::exception& e)
+    {
+        error = e.what();
+    }
+    catch (...)
+    {
+        error = wx2std(_("Unknown error"));
+    }
+
+    if (!error.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutexM);
+            errorM = error;
+            stopM = true;
+        }
+        if (notify)
+            notify();
+    }
+}
@@ -0,0 +1,102 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_TRANSACTIONGAPSAMPLER_H
+#define FR_TRANSACTIONGAPSAMPLER_H
+
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/Subject.h"
+
+class ConnectionPool;
+
+// transaction counters of the database header at one point in time
+struct TransactionGapSample
+{
+    std::time_t time;
+    int oldest;
+    int oldestActive;
+    int oldestSnapshot;
+    int next;
+
+    // transactions started after the oldest active one, grows while a
+    // transaction stays open
+    int getActiveGap() const { return next - oldestActive; }
+    // grows while garbage collection is blocked, until the next sweep
+    int getInterestingGap() const { return oldestActive - oldest; }
+};
+
+// Reads the transaction counters of a database at a fixed interval, on a
+// worker thread with an attachment borrowed from the connection pool for
+// each sample, and keeps the most recent samples.  The history is kept
+// while the sampler is stopped, so it spans reconnects.  The notify
+// function is called from the worker thread when new samples are
+// available, the owner then calls processSamples() from the GUI thread,
+// which notifies the observers.
+class TransactionGapSampler: public Subject
+{
+public:
+    typedef std::function<void()> NotifyFunction;
+
+private:
+    size_t maxSamplesM;
+    std::deque<TransactionGapSample> samplesM;
+    std::thread threadM;
+
+    // guards the members below
+    std::mutex mutexM;
+    std::condition_variable wakeupM;
+    bool stopM;
+    std::vector<TransactionGapSample> pendingM;
+    std::string errorM;
+
+    void run(std::shared_ptr<ConnectionPool> pool, int intervalMs,
+        NotifyFunction notify);
+public:
+    TransactionGapSampler(size_t maxSamples);
+    ~TransactionGapSampler();
+
+    void start(std::shared_ptr<ConnectionPool> pool, int intervalMs,
+        NotifyFunction notify);
+    // stops the worker thread and waits for it to finish the current sample
+    void stop();
+    bool isRunning();
+
+    // moves the new samples into the history and notifies the observers,
+    // returns false if there were neither new samples nor an error
+    bool processSamples();
+    // oldest sample first
+    const std::deque<TransactionGapSample>& getSamples() const;
+    // returns the error that stopped the worker thread, if any
+    std::string takeError();
+};
+
+#endif // FR_TRANSACTIONGAPSAMPLER_H
@@ -32,6 +32,7 @@
 #include <set>
 #include <algorithm>
 
+#include "engine/MetadataLoader.h"
 #include "frutils.h"
 #include "gui/AdvancedSearchFrame.h"
 #include "gui/ContextMenuMetadataItemVisitor.h"
@@ -46,6 +47,7 @@
 #include "metadata/parameter.h"
 #include "metadata/procedure.h"
 #include "metadata/root.h"
+#include "metadata/SchemaSearchIndex.h"
 #include "metadata/server.h"
 #include "metadata/table.h"
 #include "metadata/view.h"
@@ -564,6 +566,11 @@ void AdvancedSearchFrame::OnButtonStartClick(wxCommandEvent& WXUNUSED(event))
         pd.initProgress(_("Searching database: ")+db->getName_(),
             database_count, current++, 1);
 
+        // descriptions, fields and DDL come from the search index, objects
+        // that are not indexed yet are loaded in a single transaction
+        MetadataLoaderTransaction tr(db->getMetadataLoader());
+        SchemaSearchIndex& index = db->getSearchIndex();
+
         std::vector<MetadataItem *> colls;
         db->getCollections(colls, false);   // false = not system objects
         for (std::vector<MetadataItem *>::iterator col = colls.begin(); col !=
@@ -592,39 +599,24 @@ void AdvancedSearchFrame::OnButtonStartClick(wxCommandEvent& WXUNUSED(event))
                 if (searchCriteriaM.count(CriteriaItem::ctDescription) > 0)
                 {
                     wxString desc;
-                    if (!(*it)->getDescription(desc))
+                    if (!index.getDescription(*(*it), desc))
                         continue;
                     if (!match(CriteriaItem::ctDescription, desc))
                         continue;
                 }
                 if (searchCriteriaM.count(CriteriaItem::ctDDL) > 0)
                 {
-                    // TODO: add ProgressDialog, and link it up in here
-                    CreateDDLVisitor cdv;
-                    (*it)->acceptVisitor(&cdv);
-                    if (!match(CriteriaItem::ctDDL, cdv.getSql()))
+                    if (!match(CriteriaItem::ctDDL, index.getDDL(*(*it))))
                         continue;
                 }
                 if (searchCriteriaM.count(CriteriaItem::ctField) > 0)
                 {
-                    Relation* r = dynamic_cast<Relation*>(*it);
-                    Procedure* p = dynamic_cast<Procedure*>(*it);
-                    if (r || p)
+                    std::vector<wxString> fields;
+                    if (index.getFields(*(*it), fields)
+                        && std::none_of(fields.begin(), fields.end(),
+                            [this](const wxString& f) { return match(CriteriaItem::ctField, f); }))
                     {
-                        (*it)->ensureChildrenLoaded();
-                        bool found = false;
-                        if (r)
-                        {
-                            found |= std::any_of(r->begin(), r->end(),
-                                                 [this](ColumnPtr i) { return match(CriteriaItem::ctField, i->getName_()); });
-                        }
-                        if (p)
-                        {
-                            found |= std::any_of(p->begin(), p->end(),
-                                                 [this](ParameterPtr i) { return match(CriteriaItem::ctField, i->getName_()); });
-                        }
-                        if (!found)     // object doesn't contain that field
-                            continue;
+                        continue;   // object doesn't contain that field
                     }
                 }
                 // everything criteria is matched -> add to results
@@ -30,11 +30,18 @@
     #include "wx/wx.h"
 #endif
 
+#include <wx/ffile.h>
+#include <wx/filename.h>
 #include <wx/timer.h>
+#include <wx/tokenzr.h>
 #include <wx/wupdlock.h>
 
+#include <algorithm>
+
 #include "config/Config.h"
 #include "core/ArtProvider.h"
+#include "core/StringUtils.h"
+#include "engine/MetadataLoader.h"
 #include "gui/BackupRestoreBaseFrame.h"
 #include "gui/StyleGuide.h"
 #include "gui/controls/DndTextControls.h"
@@ -42,6 +49,166 @@
 #include "metadata/database.h"
 #include "metadata/server.h"
 
+BackupRestoreStatsParser::BackupRestoreStatsParser()
+{
+    clear();
+}
+
+void BackupRestoreStatsParser::clear()
+{
+    columnsM.clear();
+    tablesM.clear();
+    currentTableM = -1;
+    tableStartM = 0;
+    clockM = 0;
+    startMillisM = ::wxGetLocalTimeMillis();
+}
+
+const std::vector<BackupRestoreTableStats>&
+    BackupRestoreStatsParser::getTables() const
+{
+    return tablesM;
+}
+
+int BackupRestoreStatsParser::getCurrentTable() const
+{
+    return currentTableM;
+}
+
+double BackupRestoreStatsParser::getElapsed() const
+{
+    return clockM;
+}
+
+bool BackupRestoreStatsParser::parseHeader(const wxString& text)
+{
+    std::vector<StatsColumn> columns;
+    wxStringTokenizer tokenizer(text, " \t");
+    while (tokenizer.HasMoreTokens())
+    {
+        wxString token(tokenizer.GetNextToken());
+        if (token == "time")
+            columns.push_back(colTime);
+        else if (token == "delta")
+            columns.push_back(colDelta);
+        else if (token == "reads")
+            columns.push_back(colReads);
+        else if (token == "writes")
+            columns.push_back(colWrites);
+        else
+            return false;
+    }
+    if (columns.empty())
+        return false;
+    columnsM = columns;
+    return true;
+}
+
+bool BackupRestoreStatsParser::parseColumns(wxString& text, double& time,
+    double& delta, wxLongLong& reads, wxLongLong& writes)
+{
+    wxString rest(text);
+    for (std::vector<StatsColumn>::const_iterator it = columnsM.begin();
+        it != columnsM.end(); ++it)
+    {
+        rest.Trim(false);
+        wxString token(rest.BeforeFirst(' '));
+        rest.Remove(0, token.length());
+
+        wxLongLong_t value;
+        switch (*it)
+        {
+            case colTime:
+                if (!token.ToCDouble(&time))
+                    return false;
+                break;
+            case colDelta:
+                if (!token.ToCDouble(&delta))
+                    return false;
+                break;
+            case colReads:
+                if (!token.ToLongLong(&value))
+                    return false;
+                reads = value;
+                break;
+            case colWrites:
+                if (!token.ToLongLong(&value))
+                    return false;
+                writes = value;
+                break;
+        }
+    }
+    text = rest.Trim(false);
+    return true;
+}
+
+int BackupRestoreStatsParser::parseLine(const wxString& line)
+{
+    wxString text(line);
+    text.Trim(true).Trim(false);
+    wxString rest;
+    if (text.StartsWith("gbak:", &rest))
+        text = rest.Trim(false);
+    if (text.empty() || parseHeader(text))
+        return -1;
+
+    double time = -1;
+    double delta = -1;
+    wxLongLong reads = 0;
+    wxLongLong writes = 0;
+    if (!columnsM.empty()
+        && !parseColumns(text, time, delta, reads, writes))
+    {
+        time = -1;
+        delta = -1;
+        reads = 0;
+        writes = 0;
+    }
+
+    // use the most precise time information available
+    if (time >= 0)
+        clockM = time;
+    else if (delta >= 0)
+        clockM += delta;
+    else
+        clockM = (::wxGetLocalTimeMillis() - startMillisM).ToDouble() / 1000;
+
+    wxString name;
+    if (text.StartsWith("writing data for table ", &name)
+        || text.StartsWith("restoring data for table ", &name))
+    {
+        name.Trim(true);
+        if (name.length() > 1 && name[0] == '"' && name.Last() == '"')
+            name = name.Mid(1, name.length() - 2);
+        BackupRestoreTableStats stats = { name, 0, 0, 0, 0 };
+        tablesM.push_back(stats);
+        currentTableM = int(tablesM.size() - 1);
+        tableStartM = clockM;
+        return currentTableM;
+    }
+    if (currentTableM < 0)
+        return -1;
+
+    // gbak repeats this message when a verbose interval is set
+    wxString count;
+    if (text.EndsWith(" records written", &count)
+        || text.EndsWith(" records restored", &count))
+    {
+        BackupRestoreTableStats& stats = tablesM[currentTableM];
+        wxLongLong_t rows;
+        if (count.Trim(false).ToLongLong(&rows))
+            stats.rows = rows;
+        stats.elapsed = clockM - tableStartM;
+        stats.reads += reads;
+        stats.writes += writes;
+        return currentTableM;
+    }
+
+    // any other output ends the data of the current table
+    currentTableM = -1;
+    return -1;
+}
+
 BackupRestoreBaseFrame::BackupRestoreBaseFrame(wxWindow* parent,
         DatabasePtr db)
     : ServiceBaseFrame(parent, db)
@@ -132,6 +299,9 @@ void BackupRestoreBaseFrame::doReadConfigSettings(const wxString& prefix)
     boolValue = false;
     config().getValue(prefix + Config::pathSeparator + "static_pagewrite", boolValue);
     checkbox_staticpagewrite->SetValue(boolValue);
+    boolValue = false;
+    config().getValue(prefix + Config::pathSeparator + "statistics_report", boolValue);
+    checkbox_statisticsreport->SetValue(boolValue);
 
     intValue = 0;
     config().getValue(prefix + Config::pathSeparator + "parallel_workers", intValue);
@@ -174,6 +344,8 @@ void BackupRestoreBaseFrame::doWriteConfigSettings(const wxString& prefix) const
         checkbox_staticpageread->GetValue());
     config().setValue(prefix + Config::pathSeparator + "static_pagewrite",
         checkbox_staticpagewrite->GetValue());
+    config().setValue(prefix + Config::pathSeparator + "statistics_report",
+        checkbox_statisticsreport->GetValue());
 
     config().setValue(prefix + Config::pathSeparator + "parallel_workers",
         spinctrl_parallelworkers->GetValue());
@@ -220,6 +392,18 @@ void BackupRestoreBaseFrame::createControls()
     checkbox_staticdelta = new wxCheckBox(panel_controls, wxID_ANY, _("Delta time"));
     checkbox_staticpageread = new wxCheckBox(panel_controls, wxID_ANY, _("Page reads"));
     checkbox_staticpagewrite = new wxCheckBox(panel_controls, wxID_ANY, _("Page writes"));
+    checkbox_statisticsreport = new wxCheckBox(panel_controls, wxID_ANY,
+        _("Save statistics report"));
+    label_statistics = new wxStaticText(panel_controls, wxID_ANY,
+        wxEmptyString);
+
+    listctrl_statistics = new wxListCtrl(this, wxID_ANY, wxDefaultPosition,
+        wxDefaultSize, wxLC_REPORT | wxLC_VRULES | wxBORDER_THEME);
+    listctrl_statistics->InsertColumn(0, _("Table"));
+    listctrl_statistics->InsertColumn(1, _("Rows"), wxLIST_FORMAT_RIGHT);
+    listctrl_statistics->InsertColumn(2, _("Elapsed (s)"), wxLIST_FORMAT_RIGHT);
+    listctrl_statistics->InsertColumn(3, _("Page reads"), wxLIST_FORMAT_RIGHT);
+    listctrl_statistics->InsertColumn(4, _("Page writes"), wxLIST_FORMAT_RIGHT);
 
     spinctrl_parallelworkers = new wxSpinCtrl(panel_controls, ID_spinctrl_parallelworkers);
     spinctrl_parallelworkers->SetRange(0, 32767);
@@ -287,6 +471,15 @@ void BackupRestoreBaseFrame::layoutControls()
             gsizer->Add(checkbox_staticpagewrite, 0, wxEXPAND);
 
             sizerStatic->Add(gsizer, 0, wxEXPAND);
+            sizerStatic->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
+        }
+        {
+            wxBoxSizer* sizer = new wxBoxSizer(wxHORIZONTAL);
+            sizer->Add(checkbox_statisticsreport, 0, wxALIGN_CENTER_VERTICAL);
+            sizer->Add(styleguide().getUnrelatedControlMargin(wxHORIZONTAL), 0);
+            sizer->Add(label_statistics, 1, wxALIGN_CENTER_VERTICAL);
+
+            sizerStatic->Add(sizer, 0, wxEXPAND);
         }
         sizerGeneralOptions->Add(sizerStatic, 0, wxEXPAND);
         sizerGeneralOptions->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
@@ -411,10 +604,187 @@ void BackupRestoreBaseFrame::updateControls()
     checkbox_staticdelta->Enable(!running);
     checkbox_staticpageread->Enable(!running);
     checkbox_staticpagewrite->Enable(!running);
+    checkbox_statisticsreport->Enable(!running);
 
     spinctrl_parallelworkers->Enable(!running);
 }
 
+void BackupRestoreBaseFrame::startStatistics()
+{
+    statsParserM.clear();
+    listctrl_statistics->DeleteAllItems();
+    label_statistics->SetLabel(wxEmptyString);
+    startTimeM = wxDateTime::Now();
+    loadRelationSizes();
+}
+
+void BackupRestoreBaseFrame::loadRelationSizes()
+{
+    relationSizesM.clear();
+    DatabasePtr db = getDatabase();
+    if (!db || !db->isConnected())
+        return;
+
+    wxBusyCursor wait;
+    try
+    {
+        // data pages aren't listed in RDB$PAGES, but the number of pointer
+        // pages of a table grows with the number of its data pages
+        MetadataLoader* loader = db->getMetadataLoader();
+        MetadataLoaderTransaction tr(loader);
+
+        IBPP::Statement st = loader->createStatement(
+            "select r.rdb$relation_name, count(p.rdb$page_number) "
+            "from rdb$relations r "
+            "left join rdb$pages p on p.rdb$relation_id = r.rdb$relation_id "
+            "    and p.rdb$page_type = 4 "
+            "where r.rdb$view_blr is null "
+            "and coalesce(r.rdb$system_flag, 0) = 0 "
+            "group by r.rdb$relation_name");
+        st->Execute();
+        wxMBConv* converter = db->getCharsetConverter();
+        while (st->Fetch())
+        {
+            std::string name;
+            int64_t pages;
+            st->Get(1, name);
+            st->Get(2, pages);
+            relationSizesM[std2wxIdentifier(name, converter)] =
+                double(std::max(pages, int64_t(1)));
+        }
+    }
+    catch (IBPP::Exception&)
+    {
+        // the estimation is optional, so don't bother the user
+        relationSizesM.clear();
+    }
+}
+
+void BackupRestoreBaseFrame::updateStatistics(int firstChanged)
+{
+    const std::vector<BackupRestoreTableStats>& tables =
+        statsParserM.getTables();
+    if (firstChanged >= 0)
+    {
+        wxWindowUpdateLocker freeze(listctrl_statistics);
+        for (size_t i = firstChanged; i < tables.size(); ++i)
+        {
+            const BackupRestoreTableStats& stats = tables[i];
+            long item = long(i);
+            if (item >= listctrl_statistics->GetItemCount())
+                listctrl_statistics->InsertItem(item, stats.name);
+            listctrl_statistics->SetItem(item, 1, stats.rows.ToString());
+            listctrl_statistics->SetItem(item, 2,
+                wxString::Format("%.3f", stats.elapsed));
+            listctrl_statistics->SetItem(item, 3, stats.reads.ToString());
+            listctrl_statistics->SetItem(item, 4, stats.writes.ToString());
+        }
+        listctrl_statistics->EnsureVisible(long(tables.size() - 1));
+    }
+
+    // estimate the remaining time from the time used for the tables done
+    // so far and the relative size of the tables still to be processed
+    double totalSize = 0;
+    for (std::map<wxString, double>::const_iterator it = relationSizesM.begin();
+        it != relationSizesM.end(); ++it)
+    {
+        totalSize += (*it).second;
+    }
+    double doneSize = 0;
+    double doneElapsed = 0;
+    for (size_t i = 0; i < tables.size(); ++i)
+    {
+        if (int(i) == statsParserM.getCurrentTable())
+            continue;
+        std::map<wxString, double>::const_iterator it =
+            relationSizesM.find(tables[i].name);
+        if (it == relationSizesM.end())
+            continue;
+        doneSize += (*it).second;
+        doneElapsed += tables[i].elapsed;
+    }
+
+    wxString label(wxString::Format(_("Tables: %d, elapsed: %s"),
+        int(tables.size()),
+        wxTimeSpan::Seconds(long(statsParserM.getElapsed())).Format()));
+    if (doneSize > 0 && totalSize > doneSize)
+    {
+        long remaining = long(doneElapsed * (totalSize - doneSize) / doneSize);
+        label += wxString::Format(_(", estimated remaining: %s"),
+            wxTimeSpan::Seconds(remaining).Format());
+    }
+    label_statistics->SetLabel(label);
+}
+
+void BackupRestoreBaseFrame::writeStatisticsReport()
+{
+    std::vector<BackupRestoreTableStats> tables(statsParserM.getTables());
+    if (tables.empty())
+        return;
+    // put the tables that took longest first
+    std::stable_sort(tables.begin(), tables.end(),
+        [](const BackupRestoreTableStats& left,
+            const BackupRestoreTableStats& right)
+        { return left.elapsed > right.elapsed; });
+
+    wxString report("table,rows,elapsed_ms,page_reads,page_writes\n");
+    for (std::vector<BackupRestoreTableStats>::const_iterator it =
+        tables.begin(); it != tables.end(); ++it)
+    {
+        // quoted identifiers may contain quotes
+        wxString name((*it).name);
+        name.Replace("\"", "\"\"");
+        report += "\"" + name + "\"," + (*it).rows.ToString() + ","
+            + wxLongLong(wxLongLong_t((*it).elapsed * 1000 + 0.5)).ToString()
+            + ","
+            + (*it).reads.ToString() + "," + (*it).writes.ToString() + "\n";
+    }
+
+    // the backup file path may be a path on the (remote) server, so put
+    // the report into the user directory if the path doesn't exist here
+    wxFileName bkFileName(text_ctrl_filename->GetValue());
+    wxFileName fileName(bkFileName);
+    if (!bkFileName.DirExists())
+        fileName.AssignDir(config().getUserHomePath());
+    fileName.SetName(bkFileName.GetName()
+        + startTimeM.Format("_%Y%m%d_%H%M%S") + "_stats");
+    fileName.SetExt("csv");
+
+    wxFFile f(fileName.GetFullPath(), "w");
+    if (!f.IsOpened() || !f.Write(report))
+    {
+        text_ctrl_log->logErrorMsg(wxString::Format(
+            _("Could not write statistics report %s\n"),
+            fileName.GetFullPath().c_str()));
+        return;
+    }
+    text_ctrl_log->logImportantMsg(wxString::Format(
+        _("Statistics report written to %s\n"),
+        fileName.GetFullPath().c_str()));
+}
+
+void BackupRestoreBaseFrame::threadMsgsReceived(
+    const std::vector<LogMsg>& msgs)
+{
+    int firstChanged = -1;
+    for (std::vector<LogMsg>::const_iterator it = msgs.begin();
+        it != msgs.end(); ++it)
+    {
+        if ((*it).kind != progress_message)
+            continue;
+        int changed = statsParserM.parseLine((*it).text);
+        if (changed >= 0 && (firstChanged < 0 || changed < firstChanged))
+            firstChanged = changed;
+    }
+    updateStatistics(firstChanged);
+}
+
+void BackupRestoreBaseFrame::threadFinished()
+{
+    if (checkbox_statisticsreport->IsChecked())
+        writeStatisticsReport();
+}
+
 //! event handlers
 BEGIN_EVENT_TABLE(BackupRestoreBaseFrame, ServiceBaseFrame)
     EVT_CHECKBOX(BackupRestoreBaseFrame::ID_checkbox_showlog, BackupRestoreBaseFrame::OnVerboseLogChange)
@@ -430,7 +800,7 @@ void BackupRestoreBaseFrame::OnVerboseLogChange(wxCommandEvent& WXUNUSED(event))
     wxWindowUpdateLocker freeze(text_ctrl_log);
 
     text_ctrl_log->ClearAll();
-    updateMessages(0, msgsM.GetCount());
+    updateMessages(0, getMsgCount());
 }
 
 
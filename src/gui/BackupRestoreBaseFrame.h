@@ -26,11 +26,14 @@
 #define BACKUPRESTOREBASEFRAME_H
 
 #include <wx/wx.h>
+#include <wx/listctrl.h>
 #include <wx/spinctrl.h>
 #include <wx/thread.h>
 #include <wx/textctrl.h>
 
+#include <map>
 #include <memory>
+#include <vector>
 
 #include "core/Observer.h"
 #include "gui/ServiceBaseFrame.h"
@@ -40,6 +43,48 @@
 class FileTextControl;
 class LogTextControl;
 
+// statistics of the data of one table, collected from the verbose output
+// of a backup or restore
+struct BackupRestoreTableStats
+{
+    wxString name;
+    wxLongLong rows;
+    double elapsed;     // seconds
+    wxLongLong reads;   // page reads, if reported
+    wxLongLong writes;  // page writes, if reported
+};
+
+// parses the verbose gbak output line by line, the statistics columns
+// (time, delta, reads, writes) are recognized by the header line gbak
+// writes when any of the statistics flags is set
+class BackupRestoreStatsParser
+{
+public:
+    BackupRestoreStatsParser();
+
+    void clear();
+    // returns the index of the table whose statistics changed, or -1
+    int parseLine(const wxString& line);
+
+    const std::vector<BackupRestoreTableStats>& getTables() const;
+    // index of the table that is currently processed, or -1
+    int getCurrentTable() const;
+    // seconds since the start of the operation
+    double getElapsed() const;
+private:
+    enum StatsColumn { colTime, colDelta, colReads, colWrites };
+    std::vector<StatsColumn> columnsM;
+    std::vector<BackupRestoreTableStats> tablesM;
+    int currentTableM;
+    double tableStartM;
+    double clockM;
+    wxLongLong startMillisM;
+
+    bool parseHeader(const wxString& text);
+    bool parseColumns(wxString& text, double& time, double& delta,
+        wxLongLong& reads, wxLongLong& writes);
+};
+
 class BackupRestoreBaseFrame: public ServiceBaseFrame//, public Observer
 {
 public:
@@ -58,8 +103,23 @@ protected:
     virtual void layoutControls();
     virtual void updateControls();
 
+    // resets the statistics and loads the relation sizes used to estimate
+    // the remaining time, to be called when the backup / restore starts
+    void startStatistics();
+
     BackupRestoreBaseFrame(wxWindow* parent, DatabasePtr db);
 private:
+    BackupRestoreStatsParser statsParserM;
+    // relative size of the user tables, used for the time estimation
+    std::map<wxString, double> relationSizesM;
+    wxDateTime startTimeM;
+
+    void loadRelationSizes();
+    void updateStatistics(int firstChanged);
+    void writeStatisticsReport();
+
+    virtual void threadMsgsReceived(const std::vector<LogMsg>& msgs);
+    virtual void threadFinished();
 
 
     // observer stuff
@@ -104,6 +164,10 @@ protected:
 
     wxSpinCtrl* spinctrl_parallelworkers;
 
+    wxCheckBox* checkbox_statisticsreport;
+    wxStaticText* label_statistics;
+    wxListCtrl* listctrl_statistics;
+
 
 private:
     // event handling
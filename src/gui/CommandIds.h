@@ -110,6 +110,7 @@ enum {
     Menu_AddColumn,
     Menu_RestoreIntoNew,
     Menu_MonitorEvents,
+    Menu_MonitorActivity,
     Menu_GetServerVersion,
     Menu_AlterObject,
     Menu_DropDatabase,
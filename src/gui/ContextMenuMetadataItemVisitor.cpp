@@ -100,6 +100,7 @@ void MainObjectMenuMetadataItemVisitor::visitDatabase(Database& database)
     toolsMenu->Append(Cmds::Menu_StartupDatabase, _("Startup database"));
     addSeparator();
     toolsMenu->Append(Cmds::Menu_MonitorEvents, _("&Monitor events"));
+    toolsMenu->Append(Cmds::Menu_MonitorActivity, _("Monitor &activity"));
     toolsMenu->Append(Cmds::Menu_GenerateData, _("&Test data generator"));
 
     menuM->Append(Cmds::Menu_DropDatabase, _("Dr&op database"));
@@ -519,7 +520,7 @@ void MainObjectMenuMetadataItemVisitor::visitCollations(Collations& coolations)
 
 void MainObjectMenuMetadataItemVisitor::visitIndex(Index& index)
 {
-    //menuM->Append(Cmds::Menu_ShowStatisticsValue, _("Show &statistics"));
+    menuM->Append(Cmds::Menu_ShowStatisticsValue, _("Show &statistics"));
     menuM->Append(Cmds::Menu_SetStatisticsValue, _("&Recompute statistics"));
     addSeparator();
     addAlterItem(index);
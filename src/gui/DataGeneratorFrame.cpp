@@ -39,8 +39,13 @@
 #include <wx/txtstrm.h>
 #include <wx/xml/xml.h>
 
-// needed for random
-#include <stdlib.h>
+#include <algorithm>
+#include <climits>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
 
 #include "core/ArtProvider.h"
 #include "core/FRError.h"
@@ -49,16 +54,16 @@
 #include "gui/controls/DBHTreeControl.h"
 #include "gui/DataGeneratorFrame.h"
 #include "gui/ProgressDialog.h"
+#include "Isaac.h"
 #include "metadata/column.h"
 #include "metadata/database.h"
 #include "metadata/domain.h"
 #include "metadata/table.h"
 
 // returns a value between 0 and (maxval-1)
-// I wrote this as I don't know how much is rand from stdlib portable
-int frRandom(double maxval)
+int frRandom(Isaac& random, double maxval)
 {
-    return (int)(maxval*rand()/(RAND_MAX+1.0));
+    return (int)(maxval*random.getNumber()/4294967296.0);
 }
 
 // dd.mm.yyyy
@@ -419,6 +424,13 @@ DataGeneratorFrame::DataGeneratorFrame(wxWindow* parent, Database* db)
     wxBoxSizer* buttonSizer;
     buttonSizer = new wxBoxSizer( wxHORIZONTAL );
 
+    seedLabel = new wxStaticText( outerPanel, wxID_ANY, "Random seed:", wxDefaultPosition, wxDefaultSize, 0 );
+    buttonSizer->Add( seedLabel, 0, wxALIGN_CENTER_VERTICAL|wxTOP|wxBOTTOM|wxLEFT, 5 );
+
+    seedSpin = new wxSpinCtrl( outerPanel, wxID_ANY, wxEmptyString, wxDefaultPosition,
+        wxDefaultSize, wxSP_ARROW_KEYS, 0, INT_MAX, 1);
+    buttonSizer->Add( seedSpin, 0, wxALL|wxALIGN_CENTER_VERTICAL, 5 );
+
     buttonSizer->Add( 0, 0, 1, wxALL, 5 );
 
     saveButton = new wxButton( outerPanel, ID_button_save, "Save settings", wxDefaultPosition, wxDefaultSize, 0 );
@@ -853,6 +865,12 @@ void DataGeneratorFrame::OnLoadButtonClick(wxCommandEvent& WXUNUSED(event))
         }
         if (xmln->GetName() == "table")
             parseTable(xmln, tableRecordsM);
+        if (xmln->GetName() == "seed")
+        {
+            long seed;
+            if (getNodeContent(xmln).ToLong(&seed))
+                seedSpin->SetValue(seed);
+        }
     }
 
     // update the current node
@@ -882,6 +900,8 @@ void DataGeneratorFrame::OnSaveButtonClick(wxCommandEvent& WXUNUSED(event))
     wxXmlDocument doc;
     wxXmlNode* root = new wxXmlNode(wxXML_ELEMENT_NODE, "dgf_root");
     doc.SetRoot(root);
+    dsAddChildNode(root, "seed",
+        wxString::Format("%d", seedSpin->GetValue()));
 
     // save tables
     for (std::map<wxString, int>::iterator it = tableRecordsM.begin();
@@ -1046,9 +1066,87 @@ bool DataGeneratorFrame::sortTables(std::list<Table *>& order)
     return true;
 }
 
+// value for one parameter of the insert statement: values are generated by
+// worker threads, only the GUI thread sets them to the statement
+struct GeneratedValue
+{
+    typedef enum { gvNull, gvString, gvSmallint, gvInteger, gvLargeint,
+        gvFloat, gvDouble, gvDate, gvTime, gvTimestamp } Type;
+    Type type;
+    std::string str;
+    int64_t integer;
+    double number;
+    IBPP::Date date;
+    IBPP::Time time;
+    IBPP::Timestamp timestamp;
+
+    GeneratedValue() : type(gvNull), integer(0), number(0) {}
+    void setToStatement(IBPP::Statement& st, int param) const;
+};
+
+void GeneratedValue::setToStatement(IBPP::Statement& st, int param) const
+{
+    switch (type)
+    {
+        case gvNull:
+            st->SetNull(param);                 break;
+        case gvString:
+            st->Set(param, str);                break;
+        case gvSmallint:
+            st->Set(param, (int16_t)integer);   break;
+        case gvInteger:
+            st->Set(param, (int32_t)integer);   break;
+        case gvLargeint:
+            st->Set(param, integer);            break;
+        case gvFloat:
+            st->Set(param, (float)number);      break;
+        case gvDouble:
+            st->Set(param, number);             break;
+        case gvDate:
+            st->Set(param, date);               break;
+        case gvTime:
+            st->Set(param, time);               break;
+        case gvTimestamp:
+            st->Set(param, timestamp);          break;
+    };
+}
+
+// Generates the values of one column.  Everything that doesn't change from
+// record to record (masks, ranges, values from files or other tables) is
+// prepared once in the constructor, generate() is called by many threads
+// at the same time and must not change the object.
+class ColumnGenerator
+{
+private:
+    bool randomM;
+    int nullPercentM;
+protected:
+    // index of the value to use: random or sequential
+    size_t getIndex(Isaac& random, size_t count, size_t recNo) const
+    {
+        return (randomM ? frRandom(random, count) : recNo % count);
+    }
+    bool isRandom() const { return randomM; }
+    virtual void generateValue(Isaac& random, size_t recNo,
+        GeneratedValue& value) const = 0;
+public:
+    ColumnGenerator(GeneratorSettings* gs)
+        : randomM(gs->randomValues), nullPercentM(gs->nullPercent)
+    {
+    }
+    virtual ~ColumnGenerator() {}
+
+    void generate(Isaac& random, size_t recNo, GeneratedValue& value) const
+    {
+        if (nullPercentM > frRandom(random, 100))
+            value.type = GeneratedValue::gvNull;
+        else
+            generateValue(random, recNo, value);
+    }
+};
+
 // range = comma separated list of values or ranges
-wxString getCharFromRange(const wxString& range, bool rnd, int recNo,
-    int charNo, int chars)
+static wxString getValuesetFromRange(const wxString& range)
 {
     wxString valueset;
     size_t start = 0;
@@ -1074,180 +1172,33 @@ wxString getCharFromRange(const wxString& range, bool rnd, int recNo,
         else
             throw FRError(_("Bad range: section length not 1 or 2: ") + one);
     }
-
-    if (rnd)
-        return valueset.Mid(frRandom(valueset.Length()), 1);
-
-    // sequential: we support stuff like 001,002,003 or AAA,AAB,AAC
-    //             by converting the record counter to number with n-th base
-    //             where n is a number of characters in valueset
-    int base = valueset.Length();
-    int record = recNo;
-    for (int i=0; i<chars-charNo-1; i++)    // get the charNo-th digit
-        record /= base;
-    return valueset.Mid(record % base, 1);
-}
-
-void setFromFile(IBPP::Statement st, int param,
-    GeneratorSettings *gs, int recNo)
-{
-    // load strings from file to vector
-    wxFileInputStream stream(gs->fileName);
-    if (!stream.Ok())
-        throw FRError(_("Cannot open file: ")+gs->fileName);
-    wxTextInputStream text(stream);
-
-    std::vector<wxString> values;
-    while (true)
-    {
-        wxString s = text.ReadLine();
-        if (s.IsEmpty())
-            break;
-        values.push_back(s);
-    }
-    if (values.empty())
-        return;
-
-    // select (random/sequential) string from vector
-    wxString selected;
-    if (gs->randomValues)
-        selected = values[frRandom(values.size())];
-    else
-        selected = values[recNo % values.size()];
-
-    // convert string to datatype
-    int mydate, mytime;
-    IBPP::SDT dt = st->ParameterType(param);
-    if (st->ParameterScale(param))
-        dt = IBPP::sdDouble;
-    switch (dt)
-    {
-        case IBPP::sdBoolean: // Firebird v3
-            st->Set(param, wx2std(selected)); break;
-        case IBPP::sdString:
-            st->Set(param, wx2std(selected));   break;
-        case IBPP::sdSmallint:
-        {
-            long l;
-            if (!selected.ToLong(&l))
-                throw FRError(_("Invalid long (smallint) value: ")+selected);
-            int16_t t = l;
-            st->Set(param, t);
-            break;
-        }
-        case IBPP::sdLargeint:
-        {
-            wxLongLong_t ll;
-            if (!selected.ToLongLong(&ll))
-                throw FRError(_("Invalid long long numeric value: ")+selected);
-            int64_t t = ll;
-            st->Set(param, t);
-            break;
-        }
-        case IBPP::sdInteger:
-        {
-            long l;
-            if (!selected.ToLong(&l))
-                throw FRError(_("Invalid long numeric value: ")+selected);
-            int32_t t = l;
-            st->Set(param, t);
-            break;
-        }
-        case IBPP::sdFloat:
-        {
-            double d;
-            if (!selected.ToDouble(&d))
-                throw FRError(_("Invalid float value: ")+selected);
-            float f = d;
-            st->Set(param, f);
-            break;
-        }
-        case IBPP::sdDouble:
-        {
-            double d;
-            if (!selected.ToDouble(&d))
-                throw FRError(_("Invalid double numeric value: ")+selected);
-            st->Set(param, d);
-            break;
-        }
-        case IBPP::sdTime:
-            str2time(selected, mytime);
-            st->Set(param, IBPP::Time(IBPP::Time::tmNone, mytime, IBPP::Time::TZ_NONE));
-            break;
-        case IBPP::sdDate:
-            str2date(selected, mydate);
-            st->Set(param, IBPP::Date(mydate));
-            break;
-        case IBPP::sdTimestamp:
-        {
-            str2date(selected, mydate);
-            str2time(selected.Mid(11), mytime);
-            int y, mo, d, h, mi, s, t;
-            IBPP::dtoi(mydate, &y, &mo, &d);
-            IBPP::ttoi(mytime, &h, &mi, &s, &t);
-            st->Set(param, IBPP::Timestamp(y, mo, d, IBPP::Time::tmNone, h, mi, s, t, IBPP::Time::TZ_NONE, NULL));
-            break;
-        }
-        case IBPP::sdBlob:
-            throw FRError(_("Blob datatype not supported"));
-        case IBPP::sdArray:
-            throw FRError(_("Array datatype not supported"));
-    };
-}
-
-template<typename T>
-void setFromOther(IBPP::Statement st, int param,
-    GeneratorSettings *gs, size_t recNo)
-{
-    IBPP::Statement st2 =
-        IBPP::StatementFactory(st->DatabasePtr(), st->TransactionPtr());
-
-    wxString sql = "SELECT " + gs->sourceColumn + " FROM "
-        + gs->sourceTable + " WHERE " + gs->sourceColumn
-        + " IS NOT NULL";
-    if (!gs->randomValues)
-        sql += " ORDER BY 1";
-    st2->Prepare(wx2std(sql));
-    st2->Execute();
-    std::vector<T> values;
-    while (st2->Fetch())
-    {
-        T value;
-        st2->Get(1, value);
-        values.push_back(value);
-        if (values.size() > recNo && !gs->randomValues)
-        {
-            st->Set(param, value);
-            return;
-        }
-        if (values.size() > 99 && gs->randomValues)
-            break;
-    }
-    if (values.size() == 0)
-    {
-        if (gs->nullPercent > 0)
-        {
-            st->SetNull(param);
-            return;
-        }
-        else
-            throw FRError(_("No records found in table: ") + gs->sourceTable);
-    }
-
-    if (gs->randomValues)
-        st->Set(param, values[frRandom(values.size())]);
-    else
-        st->Set(param, values[recNo % values.size()]);
+    return valueset;
 }
 
 // format for values:
 // number[value or range(s)]
 // example: 25[az,AZ,09] means: 25 letters or numbers
 // example: 10[a,x,5]       means: 10 chars, each either of 'a', 'x' or '5'
-void DataGeneratorFrame::setString(IBPP::Statement st, int param,
-    GeneratorSettings* gs, int recNo)
+class StringGenerator: public ColumnGenerator
+{
+private:
+    struct Section
+    {
+        long chars;
+        // characters already converted to the database character set
+        std::vector<std::string> valueset;
+    };
+    std::vector<Section> sectionsM;
+protected:
+    virtual void generateValue(Isaac& random, size_t recNo,
+        GeneratedValue& value) const;
+public:
+    StringGenerator(GeneratorSettings* gs, wxMBConv* conv);
+};
+
+StringGenerator::StringGenerator(GeneratorSettings* gs, wxMBConv* conv)
+    : ColumnGenerator(gs)
 {
-    wxString value;
     long chars = 1;
     size_t start = 0;
     while (start < gs->range.Length())
@@ -1257,11 +1208,14 @@ void DataGeneratorFrame::setString(IBPP::Statement st, int param,
             size_t p = gs->range.find("]", start+1);
             if (p == wxString::npos)    // invalid mask
                 throw FRError(_("Invalid mask: missing ]"));
-            for (int i = 0; i < chars; i++)
-            {
-                value += getCharFromRange(gs->range.Mid(start+1,
-                    p-start-1), gs->randomValues, recNo, i, chars);
-            }
+            Section section;
+            section.chars = chars;
+            wxString valueset(getValuesetFromRange(
+                gs->range.Mid(start+1, p-start-1)));
+            for (size_t i = 0; i < valueset.Length(); ++i)
+                section.valueset.push_back(wx2std(valueset.Mid(i, 1), conv));
+            if (!section.valueset.empty())
+                sectionsM.push_back(section);
             start = p+1;
             chars = 1;
         }
@@ -1276,15 +1230,54 @@ void DataGeneratorFrame::setString(IBPP::Statement st, int param,
             start = p;
         }
     }
-    st->Set(param, wx2std(value, databaseM->getCharsetConverter()));
+}
+
+void StringGenerator::generateValue(Isaac& random, size_t recNo,
+    GeneratedValue& value) const
+{
+    value.type = GeneratedValue::gvString;
+    value.str.clear();
+    for (std::vector<Section>::const_iterator it = sectionsM.begin();
+        it != sectionsM.end(); ++it)
+    {
+        size_t base = (*it).valueset.size();
+        for (long charNo = 0; charNo < (*it).chars; charNo++)
+        {
+            if (isRandom())
+            {
+                value.str += (*it).valueset[frRandom(random, base)];
+                continue;
+            }
+            // sequential: we support stuff like 001,002,003 or AAA,AAB,AAC
+            //             by converting the record counter to number with
+            //             n-th base where n is a number of characters in
+            //             valueset
+            size_t record = recNo;
+            for (long i = 0; i < (*it).chars-charNo-1; i++)   // get the charNo-th digit
+                record /= base;
+            value.str += (*it).valueset[record % base];
+        }
+    }
 }
 
 // gs->range = x,x-y,...
-template<typename T>
-void setNumber(IBPP::Statement st, int param, GeneratorSettings* gs, int recNo)
+class NumberGenerator: public ColumnGenerator
+{
+private:
+    GeneratedValue::Type typeM;
+    std::vector< std::pair<long,long> > rangesM;
+    long rangesizeM;
+protected:
+    virtual void generateValue(Isaac& random, size_t recNo,
+        GeneratedValue& value) const;
+public:
+    NumberGenerator(GeneratorSettings* gs, GeneratedValue::Type type);
+};
+
+NumberGenerator::NumberGenerator(GeneratorSettings* gs,
+        GeneratedValue::Type type)
+    : ColumnGenerator(gs), typeM(type), rangesizeM(0)
 {
-    std::vector< std::pair<long,long> > ranges;
-    long rangesize = 0;
     size_t start = 0;
     while (start < gs->range.Length())
     {
@@ -1305,44 +1298,62 @@ void setNumber(IBPP::Statement st, int param, GeneratorSettings* gs, int recNo)
             long l;
             if (!one.ToLong(&l))
                 throw FRError(_("Invalid number: ") + one);
-            ranges.push_back(std::pair<long,long>(l, l));
-            rangesize++;
+            rangesM.push_back(std::pair<long,long>(l, l));
+            rangesizeM++;
         }
         else
         {
             long l1, l2;
             if (!one.Mid(0, p).ToLong(&l1) || !one.Mid(p+1).ToLong(&l2))
                 throw FRError(_("Invalid range: ") + one);
-            ranges.push_back(std::pair<long,long>(l1, l2));
-            rangesize += (l2-l1+1);
+            rangesM.push_back(std::pair<long,long>(l1, l2));
+            rangesizeM += (l2-l1+1);
         }
     }
+}
 
-    long toget = (gs->randomValues ?
-        frRandom(rangesize) : (recNo % rangesize));
+void NumberGenerator::generateValue(Isaac& random, size_t recNo,
+    GeneratedValue& value) const
+{
+    value.type = GeneratedValue::gvNull;
+    if (rangesizeM <= 0)
+        return;
+    long toget = (long)getIndex(random, rangesizeM, recNo);
 
-    for (std::vector< std::pair<long,long> >::iterator it =
-        ranges.begin(); it != ranges.end(); ++it)
+    for (std::vector< std::pair<long,long> >::const_iterator it =
+        rangesM.begin(); it != rangesM.end(); ++it)
     {
         long sz = (*it).second - (*it).first + 1;
         if (sz > toget)
         {
-            st->Set(param, (T)((*it).first + toget));
+            value.type = typeM;
+            value.integer = (*it).first + toget;
+            value.number = (double)value.integer;
             return;
         }
         toget -= sz;
     }
 }
 
-void setDatetime(IBPP::Statement st, int param, GeneratorSettings* gs,
-    int recNo)
+class DatetimeGenerator: public ColumnGenerator
 {
-    std::vector< std::pair<int,int> > dateRanges;
-    std::vector< std::pair<int,int> > timeRanges;
-    int dateRangesize = 0;
-    int timeRangesize = 0;
+private:
+    IBPP::SDT typeM;
+    std::vector< std::pair<int,int> > dateRangesM;
+    std::vector< std::pair<int,int> > timeRangesM;
+    int dateRangesizeM;
+    int timeRangesizeM;
+protected:
+    virtual void generateValue(Isaac& random, size_t recNo,
+        GeneratedValue& value) const;
+public:
+    DatetimeGenerator(GeneratorSettings* gs, IBPP::SDT type);
+};
 
-    IBPP::SDT dt = st->ParameterType(param);
+DatetimeGenerator::DatetimeGenerator(GeneratorSettings* gs, IBPP::SDT type)
+    : ColumnGenerator(gs), typeM(type), dateRangesizeM(0), timeRangesizeM(0)
+{
+    IBPP::SDT dt = typeM;
     size_t start = 0;
     while (start < gs->range.Length())
     {
@@ -1371,13 +1382,13 @@ void setDatetime(IBPP::Statement st, int param, GeneratorSettings* gs,
         {
             if (dt == IBPP::sdDate || dt == IBPP::sdTimestamp)
             {
-                dateRanges.push_back(std::pair<int,int>(date, date));
-                dateRangesize++;
+                dateRangesM.push_back(std::pair<int,int>(date, date));
+                dateRangesizeM++;
             }
             if (dt == IBPP::sdTime || dt == IBPP::sdTimestamp)
             {
-                timeRanges.push_back(std::pair<int,int>(time, time));
-                timeRangesize++;
+                timeRangesM.push_back(std::pair<int,int>(time, time));
+                timeRangesizeM++;
             }
         }
         else    // range, convert second date/time
@@ -1394,33 +1405,30 @@ void setDatetime(IBPP::Statement st, int param, GeneratorSettings* gs,
 
             if (dt == IBPP::sdDate || dt == IBPP::sdTimestamp)
             {
-                dateRanges.push_back(std::pair<int,int>(date, date2));
-                dateRangesize += (date2-date+1);
+                dateRangesM.push_back(std::pair<int,int>(date, date2));
+                dateRangesizeM += (date2-date+1);
             }
             if (dt == IBPP::sdTime || dt == IBPP::sdTimestamp)
             {
-                timeRanges.push_back(std::pair<int,int>(time, time2));
-                timeRangesize += ((time2-time) / 10000 + 1);
+                timeRangesM.push_back(std::pair<int,int>(time, time2));
+                timeRangesizeM += ((time2-time) / 10000 + 1);
             }
         }
     }
+}
 
-    int dateToGet, timeToGet;
-    if (gs->randomValues)
-    {
-        dateToGet = (dateRangesize ? frRandom(dateRangesize) : 0);
-        timeToGet = (timeRangesize ? frRandom(timeRangesize) : 0);
-    }
-    else
-    {
-        dateToGet = (dateRangesize ? recNo % dateRangesize : 0);
-        timeToGet = (timeRangesize ? recNo % timeRangesize : 0);
-    }
+void DatetimeGenerator::generateValue(Isaac& random, size_t recNo,
+    GeneratedValue& value) const
+{
+    int dateToGet = (dateRangesizeM ?
+        (int)getIndex(random, dateRangesizeM, recNo) : 0);
+    int timeToGet = (timeRangesizeM ?
+        (int)getIndex(random, timeRangesizeM, recNo) : 0);
 
     int myDate = 0;
     int myTime = 0;
-    for (std::vector< std::pair<int,int> >::iterator it =
-        dateRanges.begin(); it != dateRanges.end(); ++it)
+    for (std::vector< std::pair<int,int> >::const_iterator it =
+        dateRangesM.begin(); it != dateRangesM.end(); ++it)
     {
         int sz = (*it).second - (*it).first + 1;
         if (sz > dateToGet)
@@ -1430,8 +1438,8 @@ void setDatetime(IBPP::Statement st, int param, GeneratorSettings* gs,
         }
         dateToGet -= sz;
     }
-    for (std::vector< std::pair<int,int> >::iterator it =
-        timeRanges.begin(); it != timeRanges.end(); ++it)
+    for (std::vector< std::pair<int,int> >::const_iterator it =
+        timeRangesM.begin(); it != timeRangesM.end(); ++it)
     {
         int sz = ((*it).second - (*it).first)/10000 + 1;
         if (sz > timeToGet)
@@ -1442,94 +1450,316 @@ void setDatetime(IBPP::Statement st, int param, GeneratorSettings* gs,
         timeToGet -= sz;
     }
 
-    if (dt == IBPP::sdDate)
-        st->Set(param, IBPP::Date(myDate));
-    if (dt == IBPP::sdTime)
-        st->Set(param, IBPP::Time(IBPP::Time::tmNone, myTime, IBPP::Time::TZ_NONE));
-    if (dt == IBPP::sdTimestamp)
+    if (typeM == IBPP::sdDate)
+    {
+        value.type = GeneratedValue::gvDate;
+        value.date = IBPP::Date(myDate);
+    }
+    if (typeM == IBPP::sdTime)
+    {
+        value.type = GeneratedValue::gvTime;
+        value.time = IBPP::Time(IBPP::Time::tmNone, myTime,
+            IBPP::Time::TZ_NONE);
+    }
+    if (typeM == IBPP::sdTimestamp)
     {
         int y, mo, d, h, mi, s, t;
         IBPP::dtoi(myDate, &y, &mo, &d);
         IBPP::ttoi(myTime, &h, &mi, &s, &t);
-        st->Set(param, IBPP::Timestamp(y, mo, d, IBPP::Time::tmNone, h, mi, s, t, IBPP::Time::TZ_NONE, NULL));
+        value.type = GeneratedValue::gvTimestamp;
+        value.timestamp = IBPP::Timestamp(y, mo, d, IBPP::Time::tmNone,
+            h, mi, s, t, IBPP::Time::TZ_NONE, NULL);
     }
 }
 
-void DataGeneratorFrame::setParam(IBPP::Statement st, int param,
-    GeneratorSettings* gs, int recNo)
+// values read once from a file or another table, shared by all records
+class ValuePoolGenerator: public ColumnGenerator
 {
-    if (gs->nullPercent > frRandom(100))
-    {
-        st->SetNull(param);
-        return;
-    }
+private:
+    std::vector<GeneratedValue> valuesM;
+protected:
+    virtual void generateValue(Isaac& random, size_t recNo,
+        GeneratedValue& value) const;
+public:
+    ValuePoolGenerator(GeneratorSettings* gs);
+    void loadFromFile(GeneratorSettings* gs, IBPP::SDT dt);
+    void loadFromOther(GeneratorSettings* gs, IBPP::Statement& st,
+        IBPP::SDT dt, size_t records);
+};
 
-    if (gs->valueType == GeneratorSettings::vtColumn)   // copy from column
+ValuePoolGenerator::ValuePoolGenerator(GeneratorSettings* gs)
+    : ColumnGenerator(gs)
+{
+}
+
+void ValuePoolGenerator::generateValue(Isaac& random, size_t recNo,
+    GeneratedValue& value) const
+{
+    if (valuesM.empty())
+        value.type = GeneratedValue::gvNull;
+    else
+        value = valuesM[getIndex(random, valuesM.size(), recNo)];
+}
+
+void ValuePoolGenerator::loadFromFile(GeneratorSettings* gs, IBPP::SDT dt)
+{
+    // load strings from file to vector
+    wxFileInputStream stream(gs->fileName);
+    if (!stream.Ok())
+        throw FRError(_("Cannot open file: ")+gs->fileName);
+    wxTextInputStream text(stream);
+
+    // convert strings to datatype
+    while (true)
     {
-        switch (st->ParameterType(param))
+        wxString selected = text.ReadLine();
+        if (selected.IsEmpty())
+            break;
+
+        GeneratedValue value;
+        int mydate, mytime;
+        switch (dt)
         {
             case IBPP::sdBoolean: // Firebird v3
-                setFromOther<std::string>(st, param, gs, recNo);  break;
             case IBPP::sdString:
-                setFromOther<std::string>(st, param, gs, recNo);  break;
+                value.type = GeneratedValue::gvString;
+                value.str = wx2std(selected);
+                break;
             case IBPP::sdSmallint:
-                setFromOther<int16_t>(st, param, gs, recNo);      break;
-            case IBPP::sdInteger:
-                setFromOther<int32_t>(st, param, gs, recNo);      break;
+            {
+                long l;
+                if (!selected.ToLong(&l))
+                    throw FRError(_("Invalid long (smallint) value: ")+selected);
+                value.type = GeneratedValue::gvSmallint;
+                value.integer = (int16_t)l;
+                break;
+            }
             case IBPP::sdLargeint:
-                setFromOther<int64_t>(st, param, gs, recNo);      break;
+            {
+                wxLongLong_t ll;
+                if (!selected.ToLongLong(&ll))
+                    throw FRError(_("Invalid long long numeric value: ")+selected);
+                value.type = GeneratedValue::gvLargeint;
+                value.integer = ll;
+                break;
+            }
+            case IBPP::sdInteger:
+            {
+                long l;
+                if (!selected.ToLong(&l))
+                    throw FRError(_("Invalid long numeric value: ")+selected);
+                value.type = GeneratedValue::gvInteger;
+                value.integer = (int32_t)l;
+                break;
+            }
             case IBPP::sdFloat:
-                setFromOther<float>(st, param, gs, recNo);        break;
+            {
+                double d;
+                if (!selected.ToDouble(&d))
+                    throw FRError(_("Invalid float value: ")+selected);
+                value.type = GeneratedValue::gvFloat;
+                value.number = d;
+                break;
+            }
             case IBPP::sdDouble:
-                setFromOther<double>(st, param, gs, recNo);       break;
-            case IBPP::sdDate:
-                setFromOther<IBPP::Date>(st, param, gs, recNo);   break;
+            {
+                double d;
+                if (!selected.ToDouble(&d))
+                    throw FRError(_("Invalid double numeric value: ")+selected);
+                value.type = GeneratedValue::gvDouble;
+                value.number = d;
+                break;
+            }
             case IBPP::sdTime:
-                setFromOther<IBPP::Time>(st, param, gs, recNo);   break;
+                str2time(selected, mytime);
+                value.type = GeneratedValue::gvTime;
+                value.time = IBPP::Time(IBPP::Time::tmNone, mytime, IBPP::Time::TZ_NONE);
+                break;
+            case IBPP::sdDate:
+                str2date(selected, mydate);
+                value.type = GeneratedValue::gvDate;
+                value.date = IBPP::Date(mydate);
+                break;
             case IBPP::sdTimestamp:
-                setFromOther<IBPP::Timestamp>(st, param, gs, recNo);  break;
+            {
+                str2date(selected, mydate);
+                str2time(selected.Mid(11), mytime);
+                int y, mo, d, h, mi, s, t;
+                IBPP::dtoi(mydate, &y, &mo, &d);
+                IBPP::ttoi(mytime, &h, &mi, &s, &t);
+                value.type = GeneratedValue::gvTimestamp;
+                value.timestamp = IBPP::Timestamp(y, mo, d, IBPP::Time::tmNone, h, mi, s, t, IBPP::Time::TZ_NONE, NULL);
+                break;
+            }
             case IBPP::sdBlob:
                 throw FRError(_("Blob datatype not supported"));
             case IBPP::sdArray:
                 throw FRError(_("Array datatype not supported"));
+            default:
+                break;
         };
-        return;
+        valuesM.push_back(value);
     }
+}
+
+void ValuePoolGenerator::loadFromOther(GeneratorSettings* gs,
+    IBPP::Statement& st, IBPP::SDT dt, size_t records)
+{
+    IBPP::Statement st2 =
+        IBPP::StatementFactory(st->DatabasePtr(), st->TransactionPtr());
 
-    if (gs->valueType == GeneratorSettings::vtRange)
+    wxString sql = "SELECT " + gs->sourceColumn + " FROM "
+        + gs->sourceTable + " WHERE " + gs->sourceColumn
+        + " IS NOT NULL";
+    if (!isRandom())
+        sql += " ORDER BY 1";
+    st2->Prepare(wx2std(sql));
+    st2->Execute();
+    while (st2->Fetch())
     {
-        switch (st->ParameterType(param))
+        GeneratedValue value;
+        switch (dt)
         {
             case IBPP::sdBoolean: // Firebird v3
-                setString(st, param, gs, recNo);          break;
             case IBPP::sdString:
-                setString(st, param, gs, recNo);          break;
+                value.type = GeneratedValue::gvString;
+                st2->Get(1, value.str);
+                break;
             case IBPP::sdSmallint:
-                setNumber<int16_t>(st, param, gs, recNo); break;
+            {
+                int16_t i;
+                st2->Get(1, i);
+                value.type = GeneratedValue::gvSmallint;
+                value.integer = i;
+                break;
+            }
             case IBPP::sdInteger:
-                setNumber<int32_t>(st, param, gs, recNo); break;
+            {
+                int32_t i;
+                st2->Get(1, i);
+                value.type = GeneratedValue::gvInteger;
+                value.integer = i;
+                break;
+            }
             case IBPP::sdLargeint:
-                setNumber<int64_t>(st, param, gs, recNo); break;
+                value.type = GeneratedValue::gvLargeint;
+                st2->Get(1, value.integer);
+                break;
             case IBPP::sdFloat:
-                setNumber<float>  (st, param, gs, recNo); break;
+            {
+                float f;
+                st2->Get(1, f);
+                value.type = GeneratedValue::gvFloat;
+                value.number = f;
+                break;
+            }
             case IBPP::sdDouble:
-                setNumber<double> (st, param, gs, recNo); break;
+                value.type = GeneratedValue::gvDouble;
+                st2->Get(1, value.number);
+                break;
             case IBPP::sdDate:
+                value.type = GeneratedValue::gvDate;
+                st2->Get(1, value.date);
+                break;
             case IBPP::sdTime:
+                value.type = GeneratedValue::gvTime;
+                st2->Get(1, value.time);
+                break;
             case IBPP::sdTimestamp:
-                setDatetime(st, param, gs, recNo);
+                value.type = GeneratedValue::gvTimestamp;
+                st2->Get(1, value.timestamp);
                 break;
             case IBPP::sdBlob:
                 throw FRError(_("Blob datatype not supported"));
             case IBPP::sdArray:
                 throw FRError(_("Array datatype not supported"));
             default:
-                st->SetNull(param);
+                break;
         };
+        valuesM.push_back(value);
+        // sequential values beyond the number of records aren't used,
+        // random values are taken from the first 100 ones
+        if (valuesM.size() >= records && !isRandom())
+            break;
+        if (valuesM.size() > 99 && isRandom())
+            break;
+    }
+    if (valuesM.empty() && gs->nullPercent == 0)
+        throw FRError(_("No records found in table: ") + gs->sourceTable);
+}
+
+// creates the generator for the param-th parameter of the insert statement
+static ColumnGenerator* createGenerator(IBPP::Statement& st, int param,
+    GeneratorSettings* gs, size_t records, wxMBConv* conv)
+{
+    IBPP::SDT dt = st->ParameterType(param);
+    if (gs->valueType == GeneratorSettings::vtColumn)   // copy from column
+    {
+        std::unique_ptr<ValuePoolGenerator> g(new ValuePoolGenerator(gs));
+        g->loadFromOther(gs, st, dt, records);
+        return g.release();
     }
 
     if (gs->valueType == GeneratorSettings::vtFile)
-        setFromFile(st, param, gs, recNo);
+    {
+        if (st->ParameterScale(param))
+            dt = IBPP::sdDouble;
+        std::unique_ptr<ValuePoolGenerator> g(new ValuePoolGenerator(gs));
+        g->loadFromFile(gs, dt);
+        return g.release();
+    }
+
+    switch (dt)
+    {
+        case IBPP::sdBoolean: // Firebird v3
+        case IBPP::sdString:
+            return new StringGenerator(gs, conv);
+        case IBPP::sdSmallint:
+            return new NumberGenerator(gs, GeneratedValue::gvSmallint);
+        case IBPP::sdInteger:
+            return new NumberGenerator(gs, GeneratedValue::gvInteger);
+        case IBPP::sdLargeint:
+            return new NumberGenerator(gs, GeneratedValue::gvLargeint);
+        case IBPP::sdFloat:
+            return new NumberGenerator(gs, GeneratedValue::gvFloat);
+        case IBPP::sdDouble:
+            return new NumberGenerator(gs, GeneratedValue::gvDouble);
+        case IBPP::sdDate:
+        case IBPP::sdTime:
+        case IBPP::sdTimestamp:
+            return new DatetimeGenerator(gs, dt);
+        case IBPP::sdBlob:
+            throw FRError(_("Blob datatype not supported"));
+        case IBPP::sdArray:
+            throw FRError(_("Array datatype not supported"));
+        default:
+            // always NULL
+            return new ValuePoolGenerator(gs);
+    };
+}
+
+// values for a block of consecutive records of one table, each block uses
+// its own random number stream depending only on the seed, the table and
+// the block number, so the result doesn't depend on the number of threads
+static std::vector<GeneratedValue> generateBlock(
+    const std::vector<ColumnGenerator*>& generators, unsigned long seed,
+    unsigned long tableNo, size_t firstRecord, size_t records)
+{
+    unsigned long streamSeed[3] = { seed, tableNo,
+        (unsigned long)firstRecord };
+    Isaac random(streamSeed, 3);
+
+    std::vector<GeneratedValue> values(records * generators.size());
+    std::vector<GeneratedValue>::iterator value = values.begin();
+    for (size_t i = firstRecord; i < firstRecord + records; ++i)
+    {
+        for (std::vector<ColumnGenerator*>::const_iterator it =
+            generators.begin(); it != generators.end(); ++it)
+        {
+            (*it)->generate(random, i, *value++);
+        }
+    }
+    return values;
 }
 
 void DataGeneratorFrame::generateData(std::list<Table *>& order)
@@ -1538,13 +1768,21 @@ void DataGeneratorFrame::generateData(std::list<Table *>& order)
     pd.doShow();
     pd.initProgress(_("Inserting into tables"), order.size());
 
+    // values are generated by worker threads in blocks, the inserts are
+    // done in this thread in the order of the records
+    const size_t blockSize = 1000;
+    size_t maxBlocksQueued = 2 * std::max(1u,
+        std::thread::hardware_concurrency());
+    unsigned long seed = (unsigned long)seedSpin->GetValue();
+
     // one big transaction (perhaps this should be configurable)
     IBPP::Transaction tr =
         IBPP::TransactionFactory(databaseM->getIBPPDatabase());
     tr->Start();
 
+    unsigned long tableNo = 0;
     for (std::list<Table *>::iterator it = order.begin();
-        it != order.end(); ++it)
+        it != order.end(); ++it, ++tableNo)
     {
         pd.setProgressMessage((*it)->getName_(), 1);
         pd.stepProgress();
@@ -1552,6 +1790,7 @@ void DataGeneratorFrame::generateData(std::list<Table *>& order)
         std::map<wxString, int>::iterator i2 =
             tableRecordsM.find((*it)->getQuotedName());
         int records = (*i2).second;
+        size_t recordCount = (records > 0 ? records : 0);
 
         pd.initProgress(wxString::Format(_("Inserting %d records."), records),
             records, 0, 2);
@@ -1588,17 +1827,45 @@ void DataGeneratorFrame::generateData(std::list<Table *>& order)
             IBPP::StatementFactory(databaseM->getIBPPDatabase(), tr);
         st->Prepare(wx2std(ins + params + ")"));
 
-        for (int i = 0; i < records; i++)
+        // the worker threads must be done before the generators are deleted
+        std::vector<std::unique_ptr<ColumnGenerator> > generatorsOwner;
+        std::vector<ColumnGenerator*> generators;
+        for (int p = 0; p < st->Parameters(); ++p)
         {
-            if (pd.isCanceled())
-                return;
-            pd.stepProgress(1, 2);
-            for (int p = 0; p < st->Parameters(); ++p)
-                setParam(st, p+1, colSet[p], i);
-            st->Execute();
+            generatorsOwner.push_back(std::unique_ptr<ColumnGenerator>(
+                createGenerator(st, p+1, colSet[p], recordCount,
+                    databaseM->getCharsetConverter())));
+            generators.push_back(generatorsOwner.back().get());
+        }
+        std::deque<std::future<std::vector<GeneratedValue> > > blocks;
+
+        size_t nextBlock = 0;
+        while (nextBlock < recordCount || !blocks.empty())
+        {
+            while (blocks.size() < maxBlocksQueued && nextBlock < recordCount)
+            {
+                size_t count = std::min(blockSize, recordCount - nextBlock);
+                blocks.push_back(std::async(std::launch::async,
+                    generateBlock, std::cref(generators), seed, tableNo,
+                    nextBlock, count));
+                nextBlock += count;
+            }
+
+            std::vector<GeneratedValue> values(blocks.front().get());
+            blocks.pop_front();
+            std::vector<GeneratedValue>::const_iterator value =
+                values.begin();
+            while (value != values.end())
+            {
+                if (pd.isCanceled())
+                    return;
+                pd.stepProgress(1, 2);
+                for (int p = 0; p < st->Parameters(); ++p)
+                    (*value++).setToStatement(st, p+1);
+                st->Execute();
+            }
         }
     }
 
     tr->Commit();
 }
-
@@ -59,11 +59,6 @@ protected:
     bool sortTables(std::list<Table *>& order);
     void generateData(std::list<Table *>& order);
 
-    void setParam( IBPP::Statement st, int param, GeneratorSettings* gs,
-        int recNo);
-    void setString(IBPP::Statement st, int param, GeneratorSettings* gs,
-        int recNo);
-
     enum
     {
         ID_button_file = 1000,
@@ -110,6 +105,8 @@ protected:
     wxChoice* copyChoice;
     wxChoice* copyColumnChoice;
     wxButton* copyButton;
+    wxStaticText* seedLabel;
+    wxSpinCtrl* seedSpin;
     wxButton* saveButton;
     wxButton* loadButton;
     wxButton* generateButton;
@@ -31,11 +31,19 @@
 #endif
 
 #include <wx/stream.h>
+#include <wx/utils.h>
 #include <wx/wfstream.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+
 #include "AdvancedMessageDialog.h"
+#include "config/Config.h"
 #include "core/FRError.h"
 #include "core/StringUtils.h"
+#include "engine/BlobReader.h"
 #include "gui/CommandIds.h"
 #include "gui/CommandManager.h"
 #include "gui/controls/ControlUtils.h"
@@ -395,6 +403,7 @@ EditBlobDialog::EditBlobDialog(wxWindow* parent, wxMBConv* converterM)
     loadingM = false;
     statementM = 0;
     readonlyM = false;
+    shownBytesM = 0;
 
     this->converterM = converterM;
 
@@ -408,6 +417,8 @@ EditBlobDialog::EditBlobDialog(wxWindow* parent, wxMBConv* converterM)
     // dialog "menu" buttons
     button_menu_blob = new wxButton(getControlsPanel(),
         Cmds::BlobEditor_Menu_BLOB, _("&BLOB"));
+    button_more = new wxButton(getControlsPanel(), wxID_MORE,
+        _("Load &More"));
 
     // dialog buttons
     button_reset = new wxButton(getControlsPanel(), wxID_RESET, _("&Reset"));
@@ -566,6 +577,8 @@ bool EditBlobDialog::loadBlob()
     // if the user changes data and switches the notebook-page
     // the cach will be created again
     cacheDelete();
+    blobReaderM.reset();
+    blobDataM.clear();
     dataUpdateGUI();
 
     if (isBlob)
@@ -577,18 +590,36 @@ bool EditBlobDialog::loadBlob()
         else
             blobM = 0;
 
-        FRInputBlobStream inpblob(blobM);
-
-        if (!isTextual)
+        // large blobs are loaded page by page
+        bool loaded = true;
+        if (blobM != 0)
         {
-            res = loadFromStreamAsBinary(inpblob, blobM == 0, _("Loading BLOB into editor."));
-            editorModeM = binary;
+            blobReaderM.reset(new BlobReader(blobM));
+            loaded = loadBlobPage();
+            if (!loaded)
+            {
+                blobReaderM.reset();
+                blobDataM.clear();
+                dataUpdateGUI();
+            }
         }
-        else
+
+        if (loaded)
         {
-            res = loadFromStreamAsText(inpblob, blobM == 0, _("Loading BLOB into editor."));
-            editorModeM = text;
+            wxMemoryInputStream inpblob(blobDataM.data(), blobDataM.size());
+            if (!isTextual)
+            {
+                res = loadFromStreamAsBinary(inpblob, blobM == 0, _("Loading BLOB into editor."));
+                editorModeM = binary;
+            }
+            else
+            {
+                res = loadFromStreamAsText(inpblob, blobM == 0, _("Loading BLOB into editor."));
+                editorModeM = text;
+            }
         }
+        else
+            editorModeM = isTextual ? text : binary;
 
         dataValidM.insert(editorModeM);
     }
@@ -642,6 +673,67 @@ bool EditBlobDialog::loadBlob()
     return res;
 }
 
+bool EditBlobDialog::isBlobComplete() const
+{
+    return blobReaderM.get() == 0;
+}
+
+bool EditBlobDialog::loadBlobPage()
+{
+    wxCHECK_MSG(blobReaderM.get(), false, "No partially loaded BLOB");
+
+    int pageSize = 1024 * std::max(64,
+        config().get("BlobEditorPageSize", 4096));
+    int start = blobReaderM->getBytesRead();
+    progressBegin(_("Loading BLOB into editor."),
+        std::min(pageSize, blobReaderM->getSize() - start), true);
+    button_more->Enable(false);
+    button_reset->Enable(false);
+    button_save->Enable(false);
+    {
+        // the grid must not change the blob while it is being read
+        wxWindowDisabler disabler(this);
+
+        // read on a worker thread, so the dialog stays responsive and the
+        // loading can be canceled
+        std::atomic<bool> canceled(false);
+        BlobReader* reader = blobReaderM.get();
+        std::string& data = blobDataM;
+        std::future<int> future = std::async(std::launch::async,
+            [reader, &data, pageSize, &canceled]()
+            {
+                return reader->read(data, pageSize, &canceled);
+            });
+        int shown = start;
+        while (future.wait_for(std::chrono::milliseconds(50))
+            == std::future_status::timeout)
+        {
+            int position = reader->getBytesRead();
+            progress->stepProgress(position - shown);
+            shown = position;
+            if (progress->isCanceled())
+                canceled = true;
+        }
+        try
+        {
+            future.get();
+        }
+        catch (...)
+        {
+            progressEnd();
+            dataUpdateGUI();
+            throw;
+        }
+    }
+    bool canceled = progress->isCanceled();
+    progressEnd();
+
+    if (blobReaderM->isEof())
+        blobReaderM.reset();
+    dataUpdateGUI();
+    return !canceled;
+}
+
 bool EditBlobDialog::loadFromStreamAsText(wxInputStream& stream, bool isNull, const wxString& progressTitle)
 {
     if (isNull)
@@ -651,6 +743,7 @@ bool EditBlobDialog::loadFromStreamAsText(wxInputStream& stream, bool isNull, co
         blob_text->setIsNull(true);
         blob_text->SetReadOnly(readonlyM);
         loadingM = false;
+        shownBytesM = 0;
         dataSetModified(false, text);
         return true;
     }
@@ -691,14 +784,27 @@ bool EditBlobDialog::loadFromStreamAsText(wxInputStream& stream, bool isNull, co
     }
     buffer[readed] = '\0';
 
+    shownBytesM = 0;
     if (!progress->isCanceled())
     {
-        blob_text->SetText(std2wxIdentifier(buffer, converterM));
+        wxString text(std2wxIdentifier(buffer, converterM));
+        // a partially loaded blob may end with an incomplete character
+        while (text.empty() && readed > 0 && !isBlobComplete())
+        {
+            buffer[--readed] = '\0';
+            text = std2wxIdentifier(buffer, converterM);
+        }
+        blob_text->SetText(text);
+        // trailing spaces are not shown
+        std::string shown(buffer, readed);
+        size_t last = shown.find_last_not_of(' ');
+        shownBytesM = (last == std::string::npos) ? 0 : last + 1;
     }
 
     free(buffer);
     progressEnd();
-    blob_textSetReadonly(readonlyM);
+    // only the complete blob can be changed
+    blob_textSetReadonly(readonlyM || !isBlobComplete());
 
     // enable OnDataModified event
     loadingM = false;
@@ -716,6 +822,7 @@ bool EditBlobDialog::loadFromStreamAsBinary(wxInputStream& stream, bool isNull,
         blob_binary->setIsNull(true);
         blob_binary->SetReadOnly(true);
         loadingM = false;
+        shownBytesM = 0;
         dataSetModified(false, binary);
         return true;
     }
@@ -730,9 +837,9 @@ bool EditBlobDialog::loadFromStreamAsBinary(wxInputStream& stream, bool isNull,
     // set the wxStyledTextControl to ReadOnly = false to modify the text
     blob_binary->SetReadOnly(false);
     blob_binary->ClearAll();
-    int col  = 0;
-    int line = 0;
-    wxString txtLine;
+    unsigned lineBytes = 0;
+    std::string hex;
+    shownBytesM = 0;
 
     while (!progress->isCanceled())
     {
@@ -741,34 +848,29 @@ bool EditBlobDialog::loadFromStreamAsBinary(wxInputStream& stream, bool isNull,
         int size = stream.LastRead();
         if (size < 1)
             break;
-        buffer[size] = '\0';
 
-        int bufpos = 0;
-        while (bufpos < size)
-        {
-            txtLine += wxString::Format( "%02X", (unsigned char)(buffer[bufpos]) );
-            bufpos++;
-            col++;
-
-            if ((col % 8) == 0)
-                txtLine += " ";
-            if (col >= 32)
-            {
-                blob_binary->AddText(txtLine + "\n");
-                txtLine = "";
-                col = 0;
-                line++;
-            }
-        }
+        hex.clear();
+        appendHexDump(hex, buffer, size, lineBytes);
+        blob_binary->AddText(wxString::FromAscii(hex.c_str()));
+        shownBytesM += size;
         progress->stepProgress(size);
     }
-    // add the last line if col > 0
-    if (!progress->isCanceled())
-    {
-        if (col > 0)
-            blob_binary->AddText(txtLine);
-    }
 
+    setBinaryStyling(0);
+    progressEnd();
+    blob_binary->SetReadOnly(true);
+
+    blob_binary->Thaw();
+
+    // enable OnDataModified event
+    loadingM = false;
+    dataSetModified(false, binary);
+
+    return !progress->isCanceled();
+}
+
+void EditBlobDialog::setBinaryStyling(int firstLine)
+{
     // Prepare text styling data
     const int Columns = 4;
     const int BytesPerColumn = 8;
@@ -787,19 +889,72 @@ bool EditBlobDialog::loadFromStreamAsBinary(wxInputStream& stream, bool isNull,
         }
     }
     // Set text styling
-    blob_binary->StartStyling(0);
-    for (int i = 0; i < blob_binary->GetLineCount(); i++)
+    blob_binary->StartStyling(blob_binary->PositionFromLine(firstLine));
+    for (int i = firstLine; i < blob_binary->GetLineCount(); i++)
         blob_binary->SetStyleBytes(CharsPerLine, &styleBytes[0]);
-    progressEnd();
-    blob_binary->SetReadOnly(true);
+}
 
-    blob_binary->Thaw();
+void EditBlobDialog::appendBlobDataAsBinary()
+{
+    if (shownBytesM >= blobDataM.size())
+        return;
+
+    // disable OnDataModified event
+    loadingM = true;
+    blob_binary->Freeze();
+    blob_binary->SetReadOnly(false);
 
+    // the last line may be incomplete, it is continued and styled again
+    int firstLine = std::max(0, blob_binary->GetLineCount() - 1);
+    unsigned lineBytes = unsigned(shownBytesM % 32);
+    std::string hex;
+    appendHexDump(hex, blobDataM.data() + shownBytesM,
+        blobDataM.size() - shownBytesM, lineBytes);
+    blob_binary->AppendText(wxString::FromAscii(hex.c_str()));
+    shownBytesM = blobDataM.size();
+    setBinaryStyling(firstLine);
+
+    blob_binary->SetReadOnly(true);
+    blob_binary->Thaw();
     // enable OnDataModified event
     loadingM = false;
     dataSetModified(false, binary);
+}
 
-    return !progress->isCanceled();
+void EditBlobDialog::appendBlobDataAsText()
+{
+    if (shownBytesM >= blobDataM.size())
+        return;
+
+    std::string data(blobDataM, shownBytesM);
+    wxMBConv* conv = converterM ? converterM : wxConvCurrent;
+    wxString str(data.c_str(), *conv, data.size());
+    // the new data may end with an incomplete character
+    while (str.empty() && !data.empty() && !isBlobComplete())
+    {
+        data.erase(data.size() - 1);
+        str = wxString(data.c_str(), *conv, data.size());
+    }
+    // like loadFromStreamAsText(), trailing spaces are not shown
+    if (isBlobComplete())
+        shownBytesM += data.size();
+    else
+    {
+        size_t last = data.find_last_not_of(' ');
+        size_t shown = (last == std::string::npos) ? 0 : last + 1;
+        str = wxString(data.c_str(), *conv, shown);
+        shownBytesM += shown;
+    }
+
+    // disable OnDataModified event
+    loadingM = true;
+    blob_text->SetReadOnly(false);
+    blob_text->AppendText(str);
+    // only the complete blob can be changed
+    blob_textSetReadonly(readonlyM || !isBlobComplete());
+    // enable OnDataModified event
+    loadingM = false;
+    dataSetModified(false, text);
 }
 
 bool EditBlobDialog::saveToStream(wxOutputStream& stream, bool* isNull, const wxString& progressTitle)
@@ -906,6 +1061,7 @@ void EditBlobDialog::set_properties()
 
     button_reset->Enable(false);
     button_save->Enable(false);
+    button_more->Hide();
 }
 
 void EditBlobDialog::do_layout()
@@ -965,6 +1121,8 @@ void EditBlobDialog::do_layout()
 
     wxBoxSizer* sizerTop = new wxBoxSizer(wxHORIZONTAL);
     sizerTop->Add(button_menu_blob, 0, wxALIGN_LEFT);
+    sizerTop->AddSpacer(styleguide().getRelatedControlMargin(wxHORIZONTAL));
+    sizerTop->Add(button_more, 0, wxALIGN_LEFT);
     sizerTop->AddSpacer(styleguide().getUnrelatedControlMargin(wxVERTICAL));
     sizerTop->Add(progress, 1, wxEXPAND);
     
@@ -1139,6 +1297,12 @@ void EditBlobDialog::OnNotebookPageChanged(wxNotebookEvent& event)
             inBuf = new wxMemoryInputStream(*cacheM);
             isNull = cacheIsNullM;
         }
+        else if (!isBlobComplete())
+        {
+            inBuf = new wxMemoryInputStream(blobDataM.data(),
+                blobDataM.size());
+            isNull = false;
+        }
         else
         {
             inBuf = new FRInputBlobStream(blobM);
@@ -1200,7 +1364,10 @@ void EditBlobDialog::OnMenuBLOBLoadFromFile(wxCommandEvent& WXUNUSED(event))
         return;
 
     cacheDelete();
-    
+    // the file replaces the partially loaded blob
+    blobReaderM.reset();
+    blobDataM.clear();
+
     bool res;
     wxFileInputStream fs(filename);
     if (editorModeM == binary)
@@ -1236,6 +1403,23 @@ void EditBlobDialog::OnMenuBLOBSaveToFile(wxCommandEvent& WXUNUSED(event))
     saveToStream(fs, &dummy, _("Importing BLOB from file"));
 }
 
+void EditBlobDialog::OnMoreButtonClick(wxCommandEvent& WXUNUSED(event))
+{
+    if (isBlobComplete())
+        return;
+
+    // show what has been loaded, even if loading was canceled
+    loadBlobPage();
+    runningM = false;
+    if (editorModeM == binary)
+        appendBlobDataAsBinary();
+    else
+        appendBlobDataAsText();
+    dataValidM.clear();
+    dataValidM.insert(editorModeM);
+    runningM = true;
+}
+
 void EditBlobDialog::dataUpdateGUI()
 {
     wxString status;
@@ -1251,9 +1435,21 @@ void EditBlobDialog::dataUpdateGUI()
         canSave = false;
     }
 
+    if (!isBlobComplete())
+    {
+        status += wxString::Format(_(" (%d of %d KB loaded)"),
+            blobReaderM->getBytesRead() / 1024, blobReaderM->getSize() / 1024);
+    }
+
     SetTitle(dialogCaptionM+status);
     button_reset->Enable(canSave);
     button_save->Enable(canSave);
+    button_more->Enable(!isBlobComplete());
+    if (button_more->IsShown() == isBlobComplete())
+    {
+        button_more->Show(!isBlobComplete());
+        Layout();
+    }
 }
 
 void EditBlobDialog::dataSetModified(bool value, EditorMode editorMode)
@@ -1334,6 +1530,7 @@ BEGIN_EVENT_TABLE(EditBlobDialog, BaseDialog)
     
     // Menu events
     EVT_BUTTON(Cmds::BlobEditor_Menu_BLOB, EditBlobDialog::OnMenuBLOBButtonClick)
+    EVT_BUTTON(wxID_MORE, EditBlobDialog::OnMoreButtonClick)
     EVT_MENU(Cmds::BlobEditor_Menu_BLOBLoadFromFile, EditBlobDialog::OnMenuBLOBLoadFromFile)
     EVT_MENU(Cmds::BlobEditor_Menu_BLOBSaveToFile, EditBlobDialog::OnMenuBLOBSaveToFile)
 
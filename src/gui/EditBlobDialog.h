@@ -29,13 +29,16 @@
 #include <wx/stc/stc.h>
 #include <wx/wx.h>
 
+#include <memory>
 #include <set>
+#include <string>
 
 #include "controls/DataGrid.h"
 #include "gui/BaseDialog.h"
 #include "gui/CommandManager.h"
 
 
+class BlobReader;
 class EditBlobDialogProgressSizer; // declared in cpp
 class EditBlobDialogSTCText; // declared in cpp
 class EditBlobDialogSTC;     // declared in cpp
@@ -57,6 +60,12 @@ private:
                       text = wxID_HIGHEST+3 };
 
     IBPP::Blob blobM;
+    // set while a large blob is only partially loaded into the editor,
+    // blobDataM holds the data loaded so far
+    std::unique_ptr<BlobReader> blobReaderM;
+    std::string blobDataM;
+    // number of bytes shown in the editor of the current mode
+    size_t shownBytesM;
     DataGridTable* dataGridTableM;
     DataGrid* dataGridM;
     wxString dialogCaptionM;
@@ -109,9 +118,16 @@ private:
     void notebookSelectPageById(int pageId);
     // Loading - (calls LoadFromStreamAsXXXX)
     bool loadBlob();
+    // reads the next page of the blob on a worker thread
+    bool loadBlobPage();
+    bool isBlobComplete() const;
     // Loading (Blob/Stream)
     bool loadFromStreamAsBinary(wxInputStream& stream, bool isNull, const wxString& progressTitle);
     bool loadFromStreamAsText(wxInputStream& stream, bool isNull, const wxString& progressTitle);
+    // add the part of blobDataM not shown yet to the editor
+    void appendBlobDataAsBinary();
+    void appendBlobDataAsText();
+    void setBinaryStyling(int firstLine);
     // Saving - (calls SaveToStream)
     void saveBlob();
     // Saving (Blob/Stream)
@@ -136,6 +152,7 @@ private:
     void OnMenuBLOBButtonClick(wxCommandEvent& WXUNUSED(event));
     void OnMenuBLOBLoadFromFile(wxCommandEvent& WXUNUSED(event));
     void OnMenuBLOBSaveToFile(wxCommandEvent& WXUNUSED(event));
+    void OnMoreButtonClick(wxCommandEvent& WXUNUSED(event));
     void OnNotebookPageChanged(wxNotebookEvent& WXUNUSED(event));
     void OnProgressCancel(wxCommandEvent& WXUNUSED(event));
     void OnResetButtonClick(wxCommandEvent& WXUNUSED(event));
@@ -150,6 +167,7 @@ protected:
     wxButton* button_reset;
     wxButton* button_save;
     wxButton* button_menu_blob;
+    wxButton* button_more;
     wxMenu* menu_blob;
     DECLARE_EVENT_TABLE()
 };
@@ -34,10 +34,13 @@
 #include <wx/ffile.h>
 #include <wx/file.h>
 
+#include <vector>
+
 #include "config/Config.h"
 #include "controls/LogTextControl.h"
 #include "core/FRError.h"
 #include "core/StringUtils.h"
+#include "engine/EventListener.h"
 #include "gui/EventWatcherFrame.h"
 #include "gui/MultilineEnterDialog.h"
 #include "gui/StyleGuide.h"
@@ -49,6 +52,7 @@ public:
     EventLogControl(wxWindow* parent, wxWindowID id = wxID_ANY);
     void logAction(const wxString& action);
     void logEvent(const wxString& name, int count);
+    void logError(const wxString& error);
 };
 
 EventLogControl::EventLogControl(wxWindow* parent, wxWindowID id)
@@ -71,8 +75,15 @@ void EventLogControl::logEvent(const wxString& name, int count)
     addStyledText(wxString::Format(" (%d)\n", count), logStyleError);
 }
 
+void EventLogControl::logError(const wxString& error)
+{
+    wxString now(wxDateTime::Now().Format("%H:%M:%S  "));
+    addStyledText(now, logStyleImportant);
+    addStyledText(error + "\n", logStyleError);
+}
+
 EventWatcherFrame::EventWatcherFrame(wxWindow* parent, DatabasePtr db)
-    : BaseFrame(parent, -1, wxEmptyString), databaseM(db), eventsM(0)
+    : BaseFrame(parent, -1, wxEmptyString), databaseM(db)
 {
     wxASSERT(db);
     timerM.SetOwner(this, ID_timer);
@@ -108,6 +119,15 @@ void EventWatcherFrame::createControls()
         wxDefaultPosition, wxDefaultSize, 0, 0, wxLB_EXTENDED);
     eventlog_received = new EventLogControl(panel_controls,
         ID_log_received);
+    static_text_statistics = new wxStaticText(panel_controls, wxID_ANY,
+        _("Event statistics"));
+    listctrl_statistics = new wxListCtrl(panel_controls,
+        ID_listctrl_statistics, wxDefaultPosition, wxDefaultSize,
+        wxLC_REPORT | wxLC_VRULES | wxBORDER_THEME);
+    listctrl_statistics->InsertColumn(0, _("Event"));
+    listctrl_statistics->InsertColumn(1, _("Total"), wxLIST_FORMAT_RIGHT);
+    listctrl_statistics->InsertColumn(2, _("Per second"),
+        wxLIST_FORMAT_RIGHT);
     button_add = new wxButton(panel_controls, ID_button_add, _("&Add Events"));
     button_remove = new wxButton(panel_controls, ID_button_remove,
         _("&Remove Selected"));
@@ -127,7 +147,11 @@ void EventWatcherFrame::layoutControls()
     wxBoxSizer* sizerLog = new wxBoxSizer(wxVERTICAL);
     sizerLog->Add(static_text_received);
     sizerLog->AddSpacer(styleguide().getControlLabelMargin());
-    sizerLog->Add(eventlog_received, 1, wxEXPAND);
+    sizerLog->Add(eventlog_received, 2, wxEXPAND);
+    sizerLog->AddSpacer(styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerLog->Add(static_text_statistics);
+    sizerLog->AddSpacer(styleguide().getControlLabelMargin());
+    sizerLog->Add(listctrl_statistics, 1, wxEXPAND);
 
     wxBoxSizer* sizerTop = new wxBoxSizer(wxHORIZONTAL);
     sizerTop->Add(sizerList, 2, wxEXPAND);
@@ -177,7 +201,7 @@ void EventWatcherFrame::updateControls()
     }
     button_remove->Enable(isSelected);
     button_save->Enable(hasEvents);
-    button_monitor->Enable(hasEvents || timerM.IsRunning());
+    button_monitor->Enable(hasEvents || isMonitoring());
 }
 
 void EventWatcherFrame::addEvents(wxString& s)
@@ -210,29 +234,16 @@ void EventWatcherFrame::addEvents(wxString& s)
 
 void EventWatcherFrame::defineMonitoredEvents()
 {
-    if (eventsM != 0)
+    if (isMonitoring())
     {
-        // prevent timer from messing our business
-        bool timerRunning = timerM.IsRunning();
-        setTimerActive(false);
-
-        // get a list of events to be monitored
+        // get a list of events to be monitored, the listener thread
+        // picks it up and registers the events on its attachment
         std::vector<std::string> events;
         for (int i = 0; i < (int)listbox_monitored->GetCount(); i++)
             events.push_back(wx2std(listbox_monitored->GetString(i)));
-
-        eventsM->Clear();
-        std::vector<std::string>::const_iterator it;
-        for (it = events.begin(); it != events.end(); it++)
-        {
-            eventsM->Add(*it, this);
-            // make IBPP::Events pick up the initial event count
-            eventsM->Dispatch();
-        }
+        listenerM->listen(events);
 
         updateControls();
-        if (timerRunning)
-            setTimerActive(true);
     }
 }
 
@@ -241,9 +252,14 @@ DatabasePtr EventWatcherFrame::getDatabase() const
     return databaseM.lock();
 }
 
+bool EventWatcherFrame::isMonitoring() const
+{
+    return listenerM != 0;
+}
+
 bool EventWatcherFrame::setTimerActive(bool active)
 {
-    if (active && !timerM.Start(100))
+    if (active && !timerM.Start(1000))
         wxMessageBox(_("Can not start timer"), _("Error"), wxOK | wxICON_ERROR);
         
     if (!active && timerM.IsRunning())
@@ -256,8 +272,9 @@ bool EventWatcherFrame::setTimerActive(bool active)
 
 void EventWatcherFrame::updateMonitoringActive()
 {
-    if (eventsM != 0)
+    if (isMonitoring())
     {
+        lastRateUpdateM = wxGetLocalTimeMillis();
         setTimerActive(true);
         button_monitor->SetLabel(_("Stop &Monitoring"));
         eventlog_received->logAction(_("Monitoring started"));
@@ -265,16 +282,89 @@ void EventWatcherFrame::updateMonitoringActive()
     else
     {
         timerM.Stop();
+        updateRates();
         button_monitor->SetLabel(_("Start &Monitoring"));
         eventlog_received->logAction(_("Monitoring stopped"));
     }
     updateControls();
 }
 
-void EventWatcherFrame::ibppEventHandler(IBPP::Events events,
-    const std::string& name, int count)
+void EventWatcherFrame::processDeliveries()
+{
+    if (!isMonitoring())
+        return;
+
+    std::vector<EventListener::Delivery> deliveries;
+    listenerM->takeDeliveries(deliveries);
+
+    // one log line per event and batch, to keep the log readable and the
+    // GUI responsive when events are posted thousands of times per second
+    std::vector<wxString> names;
+    std::map<wxString, int> counts;
+    for (std::vector<EventListener::Delivery>::const_iterator it =
+        deliveries.begin(); it != deliveries.end(); ++it)
+    {
+        wxString name((*it).name.c_str(), *wxConvCurrent);
+        std::map<wxString, int>::iterator c = counts.find(name);
+        if (c == counts.end())
+        {
+            names.push_back(name);
+            counts[name] = (*it).count;
+        }
+        else
+            (*c).second += (*it).count;
+    }
+
+    for (std::vector<wxString>::const_iterator it = names.begin();
+        it != names.end(); ++it)
+    {
+        int count = counts[*it];
+        eventlog_received->logEvent(*it, count);
+
+        std::map<wxString, EventStatistics>::iterator st =
+            statisticsM.find(*it);
+        if (st == statisticsM.end())
+        {
+            EventStatistics es;
+            es.index = listctrl_statistics->InsertItem(
+                listctrl_statistics->GetItemCount(), *it);
+            es.total = 0;
+            es.sinceRateUpdate = 0;
+            st = statisticsM.insert(std::make_pair(*it, es)).first;
+        }
+        (*st).second.total += count;
+        (*st).second.sinceRateUpdate += count;
+        listctrl_statistics->SetItem((*st).second.index, 1,
+            (*st).second.total.ToString());
+    }
+
+    wxString error(listenerM->takeError().c_str(), *wxConvCurrent);
+    if (!error.IsEmpty())
+    {
+        eventlog_received->logError(_("Error: ") + error);
+        listenerM.reset();
+        updateMonitoringActive();
+    }
+}
+
+void EventWatcherFrame::updateRates()
 {
-    eventlog_received->logEvent(name, count);
+    wxLongLong now = wxGetLocalTimeMillis();
+    wxLongLong elapsed = now - lastRateUpdateM;
+    lastRateUpdateM = now;
+    for (std::map<wxString, EventStatistics>::iterator it =
+        statisticsM.begin(); it != statisticsM.end(); ++it)
+    {
+        double rate = 0;
+        if (isMonitoring() && elapsed > 0)
+        {
+            rate = (*it).second.sinceRateUpdate.ToDouble() * 1000.0
+                / elapsed.ToDouble();
+        }
+        (*it).second.sinceRateUpdate = 0;
+        listctrl_statistics->SetItem((*it).second.index, 2,
+            wxString::Format("%.1f", rate));
+    }
 }
 
 //! closes window if database is removed (unregistered)
@@ -292,6 +382,12 @@ void EventWatcherFrame::update()
         Close();
 }
 
+void EventWatcherFrame::doBeforeDestroy()
+{
+    // stop the listener thread before the frame goes away
+    listenerM.reset();
+}
+
 void EventWatcherFrame::doReadConfigSettings(const wxString& prefix)
 {
     BaseFrame::doReadConfigSettings(prefix);
@@ -412,8 +508,13 @@ void EventWatcherFrame::OnButtonRemoveClick(wxCommandEvent& WXUNUSED(event))
 
 void EventWatcherFrame::OnButtonStartStopClick(wxCommandEvent& WXUNUSED(event))
 {
-    if (eventsM != 0)
-        eventsM.clear();
+    if (isMonitoring())
+    {
+        // show what was received before the listener stopped
+        listenerM->stop();
+        processDeliveries();
+        listenerM.reset();
+    }
     else
     {
         DatabasePtr database = getDatabase();
@@ -422,8 +523,10 @@ void EventWatcherFrame::OnButtonStartStopClick(wxCommandEvent& WXUNUSED(event))
             Close();
             return;
         }
-        IBPP::Database db(database->getIBPPDatabase());
-        eventsM = IBPP::EventsFactory(db);
+        // the listener thread waits on its own attachment, received events
+        // are handed over to the GUI thread in batches
+        listenerM.reset(new EventListener(database->getConnectionPool(),
+            [this]() { CallAfter(&EventWatcherFrame::processDeliveries); }));
         defineMonitoredEvents();
     }
     updateMonitoringActive();
@@ -436,8 +539,8 @@ void EventWatcherFrame::OnListBoxSelected(wxCommandEvent& WXUNUSED(event))
 
 void EventWatcherFrame::OnTimer(wxTimerEvent& WXUNUSED(event))
 {
-    if (eventsM != 0)
-        eventsM->Dispatch();
+    if (isMonitoring())
+        updateRates();
     else // stop timer, update UI
         updateMonitoringActive();
 }
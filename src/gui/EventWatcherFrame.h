@@ -28,33 +28,46 @@
 #include <wx/wx.h>
 #include <wx/button.h>
 #include <wx/listbox.h>
+#include <wx/listctrl.h>
 #include <wx/panel.h>
 
+#include <map>
+#include <memory>
 #include <string>
 
-#include <ibpp.h>
-
 #include "core/Observer.h"
 #include "controls/LogTextControl.h"
 #include "gui/BaseFrame.h"
 #include "metadata/database.h"
 #include "metadata/MetadataClasses.h"
 
+class EventListener;
 class EventLogControl;
 
-class EventWatcherFrame : public BaseFrame, public Observer,
-    public IBPP::EventInterface
+class EventWatcherFrame : public BaseFrame, public Observer
 {
 private:
     DatabaseWeakPtr databaseM;
+    // refreshes the event rates
     wxTimer timerM;
-    IBPP::Events eventsM;
+    wxLongLong lastRateUpdateM;
+    std::unique_ptr<EventListener> listenerM;
+
+    struct EventStatistics
+    {
+        long index;     // item in listctrl_statistics
+        wxLongLong total;
+        wxLongLong sinceRateUpdate;
+    };
+    std::map<wxString, EventStatistics> statisticsM;
 
     wxPanel* panel_controls;
     wxStaticText* static_text_monitored;
     wxStaticText* static_text_received;
     wxListBox* listbox_monitored;
     EventLogControl* eventlog_received;
+    wxStaticText* static_text_statistics;
+    wxListCtrl* listctrl_statistics;
     wxButton *button_add;
     wxButton *button_remove;
     wxButton *button_load;
@@ -69,17 +82,19 @@ private:
     void addEvents(wxString& s);    // multiline allowed
     void defineMonitoredEvents();
     DatabasePtr getDatabase() const;
+    bool isMonitoring() const;
     bool setTimerActive(bool active);
     void updateMonitoringActive();
-
-    virtual void ibppEventHandler(IBPP::Events events,
-        const std::string& name, int count);
+    // called in the GUI thread after the listener received events
+    void processDeliveries();
+    void updateRates();
 
     // observer stuff
     virtual void subjectRemoved(Subject* subject);
     virtual void update();
 
 protected:
+    virtual void doBeforeDestroy();
     virtual void doReadConfigSettings(const wxString& prefix);
     virtual void doWriteConfigSettings(const wxString& prefix) const;
     virtual const wxString getName() const;
@@ -93,6 +108,7 @@ private:
     {
         ID_listbox_monitored = 101,
         ID_log_received,
+        ID_listctrl_statistics,
         ID_button_add,
         ID_button_remove,
         ID_button_load,
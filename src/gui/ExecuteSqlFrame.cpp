@@ -36,8 +36,10 @@
 #include <wx/fontdlg.h>
 #include <wx/stopwatch.h>
 #include <wx/tokenzr.h>
+#include <wx/wfstream.h>
 
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <vector>
 
@@ -54,6 +56,7 @@
 #include "gui/controls/ControlUtils.h"
 #include "gui/controls/DataGrid.h"
 #include "gui/controls/DataGridTable.h"
+#include "gui/controls/PlanDiagram.h"
 #include "gui/GUIURIHandlerHelper.h"
 #include "gui/MetadataItemPropertiesFrame.h"
 #include "gui/ProgressDialog.h"
@@ -578,6 +581,16 @@ ExecuteSqlFrame::ExecuteSqlFrame(wxWindow* WXUNUSED(parent), int id,
     grid_data = new DataGrid(notebook_pane_2, ID_grid_data);
     notebook_1->AddPage(notebook_pane_2, _("Data"));
 
+    notebook_pane_3 = new wxPanel(notebook_1, -1);
+    listctrl_profile = new wxListCtrl(notebook_pane_3, wxID_ANY,
+        wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_SINGLE_SEL);
+    notebook_1->AddPage(notebook_pane_3, _("Profile"));
+
+    notebook_pane_4 = new wxPanel(notebook_1, -1);
+    choice_plans = new wxChoice(notebook_pane_4, ID_choice_plans);
+    plan_diagram = new PlanDiagram(notebook_pane_4);
+    notebook_1->AddPage(notebook_pane_4, _("Plan"));
+
     statusbar_1 = CreateStatusBar(4);
     SetStatusBarPane(-1);
 
@@ -590,6 +603,7 @@ ExecuteSqlFrame::ExecuteSqlFrame(wxWindow* WXUNUSED(parent), int id,
     if (!db->getIsVolative()) databaseM->attachObserver(this, false);
 
     executedStatementsM.clear();
+    profileFetchingM = false;
     inTransaction(false);    // enable/disable controls
     if (!db->getIsVolative()) setKeywords();           // set words for autocomplete feature
 
@@ -818,6 +832,19 @@ void ExecuteSqlFrame::set_properties()
     statusbar_1->SetStatusText("Transaction status", 3);
 
     grid_data->SetTable(new DataGridTable(statementM, databaseM), true);
+
+    listctrl_profile->InsertColumn(0, _("Started"));
+    listctrl_profile->InsertColumn(1, _("Statement"), wxLIST_FORMAT_LEFT, 200);
+    listctrl_profile->InsertColumn(2, _("Prepare"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(3, _("Execute"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(4, _("First row"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(5, _("Fetch"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(6, _("Buffering"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(7, _("Grid"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(8, _("Other"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(9, _("Total"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(10, _("Rows"), wxLIST_FORMAT_RIGHT);
+    listctrl_profile->InsertColumn(11, _("Records read / ins / upd / del"));
     grid_data->SetBackgroundColour(stylerManager().getDefaultStyle()->getbgColor());
     splitter_window_1->Initialize(styled_text_ctrl_sql);
     viewModeM = vmEditor;
@@ -840,6 +867,18 @@ void ExecuteSqlFrame::do_layout()
     sizerPane2->Add(grid_data, 1, wxEXPAND);
     notebook_pane_2->SetSizer(sizerPane2);
 
+    // statement profile notebook pane
+    wxBoxSizer* sizerPane3 = new wxBoxSizer(wxHORIZONTAL);
+    sizerPane3->Add(listctrl_profile, 1, wxEXPAND);
+    notebook_pane_3->SetSizer(sizerPane3);
+
+    // plan diagram notebook pane
+    wxBoxSizer* sizerPane4 = new wxBoxSizer(wxVERTICAL);
+    sizerPane4->Add(choice_plans, 0, wxEXPAND | wxBOTTOM,
+        styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerPane4->Add(plan_diagram, 1, wxEXPAND);
+    notebook_pane_4->SetSizer(sizerPane4);
+
     // splitter is only control in panel_contents
     wxBoxSizer* sizerContents = new wxBoxSizer(wxHORIZONTAL);
     sizerContents->Add(splitter_window_1, 1, wxEXPAND);
@@ -886,6 +925,8 @@ void ExecuteSqlFrame::doBeforeDestroy()
     // prevent editor from updating the invalid dataset
     if (grid_data->IsCellEditControlEnabled())
         grid_data->EnableCellEditControl(false);
+    // statements logged on commit are written in the background
+    Logger::flush();
     // make sure that further calls to update() will not call Close() again
     if (databaseM->getIsVolative() && databaseM->isConnected())
         databaseM->disconnect();
@@ -1023,6 +1064,8 @@ BEGIN_EVENT_TABLE(ExecuteSqlFrame, wxFrame)
         ExecuteSqlFrame::OnGridInvalidateAttributeCache)
     EVT_COMMAND(ExecuteSqlFrame::ID_grid_data, wxEVT_FRDG_SUM, \
         ExecuteSqlFrame::OnGridSum)
+    EVT_CHOICE(ExecuteSqlFrame::ID_choice_plans, ExecuteSqlFrame::OnPlanSelected)
+    EVT_NOTEBOOK_PAGE_CHANGED(wxID_ANY, ExecuteSqlFrame::OnNotebookPageChanged)
 
     EVT_GRID_CMD_SELECT_CELL(ExecuteSqlFrame::ID_grid_data, ExecuteSqlFrame::OnGridCellChange)
     EVT_GRID_CMD_LABEL_LEFT_DCLICK(ExecuteSqlFrame::ID_grid_data, ExecuteSqlFrame::OnGridLabelLeftDClick)
@@ -1845,12 +1888,22 @@ void ExecuteSqlFrame::OnMenuGridDeleteRow(wxCommandEvent& WXUNUSED(event))
     // Since we are not really removing the rows (only changing the color)
     // we can go from first to last. If we decide to revert to old code
     // we should go from last to first.
-    for (size_t i = 0; i < rows.GetCount(); i++)
+    // All rows are deleted with a single prepared statement, and if one
+    // of them fails none of them is deleted
+    bool deleted;
+    if (count > 1)
     {
-        if (grid_data->DeleteRows(rows[i], 1))
+        ProgressDialog pd(this, _("Deleting rows"));
+        pd.doShow();
+        deleted = grid_data->getDataGridTable()->deleteRows(rows, &pd);
+        pd.doHide();
+    }
+    else
+        deleted = grid_data->getDataGridTable()->deleteRows(rows);
+    if (deleted)
+    {
+        for (size_t i = 0; i < rows.GetCount(); i++)
             grid_data->DeselectRow(rows[i]);
-        else
-            break;
     }
 
     // grid_data->EndBatch();   // see comment for BeginBatch above
@@ -1913,19 +1966,33 @@ void ExecuteSqlFrame::OnMenuGridSetFieldToNULL(wxCommandEvent& WXUNUSED(event))
             AdvancedMessageDialogButtonsOk());
     }
 
-    // set fields to NULL
-    for (int i = 0; i < count; i++)
+    // do not set to null if field is not nullable or readonly
+    wxGridCellCoordsArray nullCells;
+    for (size_t i = 0; i < cells.size(); i++)
     {
-        int row = cells[i].GetRow();
-        int col = cells[i].GetCol();
-
-        // do not set to null if field is not nullable or readonly
-        if (colsReadonly.find(col) != colsReadonly.end())
-            continue;
+        if (colsReadonly.find(cells[i].GetCol()) == colsReadonly.end())
+            nullCells.push_back(cells[i]);
+    }
+    if (nullCells.empty())
+        return;
 
-        dgt->setValueToNull(row, col);
+    // set fields to NULL, all of them or none if one of them fails
+    bool changed;
+    if (nullCells.size() > 1)
+    {
+        ProgressDialog pd(this, _("Setting fields to NULL"));
+        pd.doShow();
+        changed = dgt->setValuesToNull(nullCells, &pd);
+        pd.doHide();
+    }
+    else
+        changed = dgt->setValuesToNull(nullCells);
 
-        // if visible, update BLOB editor
+    // if visible, update BLOB editor
+    for (size_t i = 0; changed && i < nullCells.size(); i++)
+    {
+        int row = nullCells[i].GetRow();
+        int col = nullCells[i].GetCol();
         if (editBlobDlgM && editBlobDlgM->IsShown()
             && grid_data->GetGridCursorCol() == col
             && grid_data->GetGridCursorRow() == row)
@@ -2133,6 +2200,7 @@ void ExecuteSqlFrame::prepareVolatileDatabase(wxString hostname, wxString port,
     ServerPtr serverPtrM = databaseM->getServer();
     if (!serverPtrM->getHostname().compare(hostname) || !serverPtrM->getPort().compare(port) || !databaseM->getPath().compare(path) || !databaseM->getUsername().compare(user) || !databaseM->getRawPassword().compare(password) || !databaseM->getRole().compare(role) || !databaseM->getDatabaseCharset().compare(charset))
     {
+        Logger::flush();
         databaseM->disconnect();
         transactionM = 0;
     }
@@ -2214,6 +2282,8 @@ bool ExecuteSqlFrame::parseStatements(const wxString& statements,
 {
     wxBusyCursor cr;
     MultiStatement ms(statements);
+    scriptCountsM.clear();
+    int executed = 0;
     while (true)
     {
         SingleStatement ss = ms.getNextStatement();
@@ -2252,18 +2322,22 @@ bool ExecuteSqlFrame::parseStatements(const wxString& statements,
                 return false;
             }
         }
-        else if (!ss.isEmptyStatement()
-            && !execute(ss.getSql(), ms.getTerminator(), prepareOnly))
+        else if (!ss.isEmptyStatement())
         {
-            int stmtStart = selectionOffset + ms.getStart();
-            // STC uses UTF-8 internally in Unicode build
-            // account for possible differences in string length
-            // if system charset != UTF-8
-            std::string stmt(wx2std(ss.getSql(), &wxConvUTF8));
-            int stmtEnd = stmtStart + stmt.size();
-            styled_text_ctrl_sql->markText(stmtStart, stmtEnd);
-            styled_text_ctrl_sql->SetFocus();
-            return false;
+            ++executed;
+            if (!execute(ss.getSql(), ms.getTerminator(), prepareOnly))
+            {
+                logScriptCounts(executed);
+                int stmtStart = selectionOffset + ms.getStart();
+                // STC uses UTF-8 internally in Unicode build
+                // account for possible differences in string length
+                // if system charset != UTF-8
+                std::string stmt(wx2std(ss.getSql(), &wxConvUTF8));
+                int stmtEnd = stmtStart + stmt.size();
+                styled_text_ctrl_sql->markText(stmtStart, stmtEnd);
+                styled_text_ctrl_sql->SetFocus();
+                return false;
+            }
         }
     }
 
@@ -2274,6 +2348,7 @@ bool ExecuteSqlFrame::parseStatements(const wxString& statements,
     }
 
     ScrollAtEnd sae(styled_text_ctrl_stats);
+    logScriptCounts(executed);
     log(_("Script execution finished."));
     return true;
 }
@@ -2283,56 +2358,87 @@ void ExecuteSqlFrame::OnMenuUpdateWhenExecutePossible(wxUpdateUIEvent& event)
     event.Enable(!closeWhenTransactionDoneM);
 }
 
+static wxString formatCounts(const IBPP::CountInfo& c)
+{
+    wxString str_log;
+    if (c.inserts > 0)
+        str_log += wxString::Format(_("%d inserts. "), c.inserts);
+    if (c.updates > 0)
+        str_log += wxString::Format(_("%d updates. "), c.updates);
+    if (c.deletes > 0)
+        str_log += wxString::Format(_("%d deletes. "), c.deletes);
+    if (c.readIndex > 0)
+        str_log += wxString::Format(_("%d reads index. "), c.readIndex);
+    if (c.readSequence > 0)
+        str_log += wxString::Format(_("%d reads sequence. "), c.readSequence);
+    return str_log;
+}
+
+wxString ExecuteSqlFrame::getRelationName(int relationId)
+{
+    wxString relName;
+    try
+    {
+        relName = databaseM->getRelationName(relationId);
+    }
+    catch (IBPP::Exception& e)
+    {
+        log(wxString(e.what(), *databaseM->getCharsetConverter()), ttError);
+    }
+    if (relName.IsEmpty())
+        relName = wxString::Format(_("Relation #%d"), relationId);
+    return relName;
+}
+
 void ExecuteSqlFrame::compareCounts(IBPP::DatabaseCounts& one,
     IBPP::DatabaseCounts& two)
 {
     for (IBPP::DatabaseCounts::iterator it = two.begin(); it != two.end();
         ++it)
     {
-        wxString str_log;
         IBPP::DatabaseCounts::iterator i2 = one.find((*it).first);
         IBPP::CountInfo c;
         IBPP::CountInfo& r1 = (*it).second;
         IBPP::CountInfo& r2 = c;
         if (i2 != one.end())
             r2 = (*i2).second;
-        if (r1.inserts > r2.inserts)
-            str_log += wxString::Format(_("%d inserts. "), r1.inserts - r2.inserts);
-        if (r1.updates > r2.updates)
-            str_log += wxString::Format(_("%d updates. "), r1.updates - r2.updates);
-        if (r1.deletes > r2.deletes)
-            str_log += wxString::Format(_("%d deletes. "), r1.deletes - r2.deletes);
-        if (r1.readIndex > r2.readIndex)
-            str_log += wxString::Format(_("%d reads index. "), r1.readIndex - r2.readIndex);
-        if (r1.readSequence > r2.readSequence)
-            str_log += wxString::Format(_("%d reads sequence. "), r1.readSequence - r2.readSequence);
-        if (!str_log.IsEmpty())
+
+        IBPP::CountInfo delta;
+        delta.inserts = std::max(0, r1.inserts - r2.inserts);
+        delta.updates = std::max(0, r1.updates - r2.updates);
+        delta.deletes = std::max(0, r1.deletes - r2.deletes);
+        delta.readIndex = std::max(0, r1.readIndex - r2.readIndex);
+        delta.readSequence = std::max(0, r1.readSequence - r2.readSequence);
+
+        wxString str_log(formatCounts(delta));
+        if (str_log.IsEmpty())
+            continue;
+        log(getRelationName((*it).first) + ": " + str_log, ttSql);
+
+        // sum up for the summary at the end of the script
+        IBPP::CountInfo& total = scriptCountsM[(*it).first];
+        total.inserts += delta.inserts;
+        total.updates += delta.updates;
+        total.deletes += delta.deletes;
+        total.readIndex += delta.readIndex;
+        total.readSequence += delta.readSequence;
+    }
+}
+
+void ExecuteSqlFrame::logScriptCounts(int statements)
+{
+    // a single statement has already logged the same numbers
+    if (statements > 1 && !scriptCountsM.empty())
+    {
+        log(wxString::Format(_("Table I/O of %d statements:"), statements));
+        for (IBPP::DatabaseCounts::iterator it = scriptCountsM.begin();
+            it != scriptCountsM.end(); ++it)
         {
-            wxString relName;
-            try
-            {
-                IBPP::Statement st = IBPP::StatementFactory(
-                    databaseM->getIBPPDatabase(), transactionM);
-                st->Prepare(
-                    "select rdb$relation_name "
-                    "from rdb$relations where rdb$relation_id = ?");
-                st->Set(1, (*it).first);
-                st->Execute();
-                if (st->Fetch())
-                {
-                    std::string s;
-                    st->Get(1, s);
-                    relName = std2wxIdentifier(s, databaseM->getCharsetConverter());
-                }
-            }
-            catch (...)
-            {
-            }
-            if (relName.IsEmpty())
-                relName.Format(_("Relation #%d"), (*it).first);
-            log(relName + ": " + str_log, ttSql);
+            log(getRelationName((*it).first) + ": "
+                + formatCounts((*it).second), ttSql);
         }
     }
+    scriptCountsM.clear();
 }
 
 wxString millisToTimeString(long millis)
@@ -2411,6 +2517,7 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
             splitScreen();
             return false;
         }
+        Logger::flush();
         databaseM->disconnect();
         transactionM = 0;
         return true;
@@ -2421,6 +2528,23 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
     wxStopWatch swTotal;
     bool retval = true;
     long waitForParameterInputTime = 0;
+
+    // all phases are measured with a monotonic clock for the profile page
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double, std::milli> millis;
+    clock::time_point profileStart = clock::now();
+    profileFetchingM = false;
+    StatementProfile profile;
+    profile.started = wxDateTime::Now();
+    profile.sql = sql.Strip(wxString::both);
+    profile.sql.Replace("\r", " ");
+    profile.sql.Replace("\n", " ");
+    profile.sql.Replace("\t", " ");
+    profile.hasResultSet = false;
+    profile.prepareMs = profile.executeMs = profile.firstRowMs = 0;
+    profile.fetchMs = profile.bufferMs = profile.gridMs = 0;
+    profile.rows = 0;
+    profile.selects = profile.inserts = profile.updates = profile.deletes = -1;
     try
     {
         if (transactionM == 0 || !transactionM->Started())
@@ -2468,12 +2592,15 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
             databaseM->getIBPPDatabase()->DetailedCounts(counts1);
         }
         grid_data->ClearGrid(); // statement object will be invalidated, so clear the grid
+        explainedPlanSqlM.clear();
         statementM = IBPP::StatementFactory(databaseM->getIBPPDatabase(), transactionM);
         log(_("Preparing statement: " + sql), ttSql);
         sae.scroll();
         {
             wxStopWatch sw;
+            clock::time_point start = clock::now();
             statementM->Prepare(wx2std(sql, databaseM->getCharsetConverter()));
+            profile.prepareMs = millis(clock::now() - start).count();
             log(wxString::Format(_("Statement prepared (elapsed time: %s)."),
                 millisToTimeString(sw.Time()).c_str()));
         }
@@ -2529,8 +2656,15 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
             log(_("Plan not available."));
         }
 
+        // reading the plan tree needs another request and the index
+        // statistics, so it is only done when the plan is shown
+        explainedPlanSqlM = sql;
         if (prepareOnly)
+        {
+            if (loadExplainedPlan())
+                notebook_1->SetSelection(3);
             return true;
+        }
 
         log(wxString::Format(_("Parameters: %zu"), statementM->ParametersByName().size() ));
         //Define parameters here:
@@ -2543,22 +2677,68 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
             waitForParameterInputTime = id->swWaitForParameterInputTime.Time();
         }
 
+        // keeps only pages of rows around the shown ones in memory, not
+        // used for SELECT ... FOR UPDATE, whose rows are to be changed
+        bool scrollableCursor = hasColumns
+            && statementM->Type() == IBPP::stSelect
+            && config().get("GridScrollableCursor", false);
+
         log(wxEmptyString);
         log(wxEmptyString);
         log(_("Executing statement..."));
         sae.scroll();
         {
             wxStopWatch sw;
-            statementM->Execute();
+            clock::time_point start = clock::now();
+            if (scrollableCursor)
+            {
+                try
+                {
+                    statementM->ExecuteScrollable();
+                }
+                catch (IBPP::Exception& e)
+                {
+                    // needs Firebird 5 and fbclient 4.0 or newer
+                    log(wxString(e.what(), *databaseM->getCharsetConverter()));
+                    log(_("Scrollable cursor not available, fetching all rows forward."));
+                    scrollableCursor = false;
+                }
+            }
+            if (!scrollableCursor)
+                statementM->Execute();
+            profile.executeMs = millis(clock::now() - start).count();
             log(wxString::Format(_("Statement executed (elapsed time: %s)."),
                 millisToTimeString(sw.Time()).c_str()));
         }
         IBPP::STT type = statementM->Type();
         if (hasColumns)            // for select statements: show data
         {
-            grid_data->fetchData(transactionAccessModeM == IBPP::amRead);
+            clock::time_point start = clock::now();
+            grid_data->fetchData(transactionAccessModeM == IBPP::amRead,
+                scrollableCursor);
+            double fetchDataMs = millis(clock::now() - start).count();
+
+            // whatever fetchData() didn't spend fetching and buffering rows
+            // was spent setting up the grid
+            const DataGridFetchTimes& times =
+                grid_data->getDataGridTable()->getFetchTimes();
+            profile.hasResultSet = true;
+            profile.firstRowMs = times.firstRowMs;
+            profile.fetchMs = times.fetchMs;
+            profile.bufferMs = times.bufferMs;
+            profile.gridMs = std::max(0.0,
+                fetchDataMs - times.fetchMs - times.bufferMs);
+            profile.rows = grid_data->GetNumberRows();
             setViewMode(vmGrid);
         }
+        try
+        {
+            statementM->RecordCounts(profile.selects, profile.inserts,
+                profile.updates, profile.deletes);
+        }
+        catch (IBPP::Exception&)
+        {
+        }
 
         if (doShowStats)
         {
@@ -2603,6 +2783,8 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
             }
             if (stm.isDDL())
                 type = IBPP::stDDL;
+            if (stm.isSetTimeZone())
+                databaseM->invalidateDefaultTimezone();
             executedStatementsM.push_back(stm);
             setViewMode(vmEditor);
             if (type == IBPP::stDDL && autoCommitM)
@@ -2635,9 +2817,167 @@ bool ExecuteSqlFrame::execute(wxString sql, const wxString& terminator,
 
     log(wxString::Format(_("Total execution time: %s"),
         millisToTimeString(swTotal.Time() - waitForParameterInputTime).c_str()));
+
+    profile.failed = !retval;
+    profile.totalMs = std::max(0.0, millis(clock::now() - profileStart).count()
+        - waitForParameterInputTime);
+    addStatementProfile(profile);
+    profileFetchingM = profile.hasResultSet;
     return retval;
 }
 
+static wxString formatProfileMillis(double ms)
+{
+    if (ms < 1000)
+        return wxString::Format("%.1f ms", ms);
+    return wxString::Format("%.3f s", 0.001 * ms);
+}
+
+void ExecuteSqlFrame::addStatementProfile(const StatementProfile& profile)
+{
+    // keep a limited history, the oldest entries are dropped first
+    const size_t maxProfiles = 100;
+    while (profilesM.size() >= maxProfiles)
+    {
+        profilesM.pop_front();
+        listctrl_profile->DeleteItem(0);
+    }
+    profilesM.push_back(profile);
+
+    long item = listctrl_profile->InsertItem(listctrl_profile->GetItemCount(),
+        profile.started.FormatTime());
+    wxString sql(profile.sql);
+    if (sql.length() > 100)
+        sql = sql.Left(100) + "...";
+    listctrl_profile->SetItem(item, 1, sql);
+    if (profile.failed)
+        listctrl_profile->SetItemTextColour(item, *wxRED);
+    showStatementProfile(item);
+    listctrl_profile->EnsureVisible(item);
+}
+
+void ExecuteSqlFrame::showStatementProfile(long item)
+{
+    if (item < 0 || item >= long(profilesM.size()))
+        return;
+    const StatementProfile& p = profilesM[item];
+
+    listctrl_profile->SetItem(item, 2, formatProfileMillis(p.prepareMs));
+    listctrl_profile->SetItem(item, 3, formatProfileMillis(p.executeMs));
+    if (p.hasResultSet)
+    {
+        listctrl_profile->SetItem(item, 4, formatProfileMillis(p.firstRowMs));
+        listctrl_profile->SetItem(item, 5, formatProfileMillis(p.fetchMs));
+        listctrl_profile->SetItem(item, 6, formatProfileMillis(p.bufferMs));
+        listctrl_profile->SetItem(item, 7, formatProfileMillis(p.gridMs));
+        listctrl_profile->SetItem(item, 10, wxString::Format("%ld", p.rows));
+    }
+    // transaction start, statistics, parameters and logging
+    double other = p.totalMs - p.prepareMs - p.executeMs - p.fetchMs
+        - p.bufferMs - p.gridMs;
+    listctrl_profile->SetItem(item, 8,
+        formatProfileMillis(std::max(0.0, other)));
+    listctrl_profile->SetItem(item, 9, formatProfileMillis(p.totalMs));
+    if (p.selects >= 0)
+    {
+        listctrl_profile->SetItem(item, 11, wxString::Format(
+            "%d / %d / %d / %d", p.selects, p.inserts, p.updates, p.deletes));
+    }
+}
+
+bool ExecuteSqlFrame::loadExplainedPlan()
+{
+    if (explainedPlanSqlM.empty() || statementM == 0)
+        return false;
+    wxString sql(explainedPlanSqlM);
+    explainedPlanSqlM.clear();
+
+    // only Firebird 3 and newer return the plan as a tree
+    try
+    {
+        std::string plan;
+        statementM->ExplainedPlan(plan);
+        showExplainedPlan(sql,
+            wxString(plan.c_str(), *databaseM->getCharsetConverter()));
+        return true;
+    }
+    catch(IBPP::Exception& e)
+    {
+        log(wxString::Format(_("Explained plan not available: %s"),
+            e.what()));
+    }
+    return false;
+}
+
+void ExecuteSqlFrame::showExplainedPlan(const wxString& sql,
+    const wxString& text)
+{
+    // a statement prepared again with an unchanged plan shows the cached
+    // one, which avoids reading the index statistics again
+    for (size_t i = plansM.size(); i > 0; --i)
+    {
+        if (plansM[i - 1].sql != sql)
+            continue;
+        if (plansM[i - 1].plan->getText() == text)
+        {
+            choice_plans->SetSelection(int(i - 1));
+            plan_diagram->setPlan(plansM[i - 1].plan);
+            return;
+        }
+        break;
+    }
+
+    CachedPlan cached;
+    cached.prepared = wxDateTime::Now();
+    cached.sql = sql;
+    cached.plan.reset(new ExplainedPlan(text));
+    try
+    {
+        cached.plan->loadEstimates(databaseM,
+            config().get("PlanLargeTableRows", 10000));
+    }
+    catch(IBPP::Exception& e)   // the plan is shown without estimates
+    {
+        log(wxString::Format(_("Record estimates not available: %s"),
+            e.what()));
+    }
+
+    // keep a limited history, the oldest entries are dropped first
+    const size_t maxPlans = 50;
+    while (plansM.size() >= maxPlans)
+    {
+        plansM.pop_front();
+        choice_plans->Delete(0);
+    }
+    plansM.push_back(cached);
+
+    wxString label(sql);
+    label.Replace("\r", " ");
+    label.Replace("\n", " ");
+    if (label.length() > 100)
+        label = label.Left(100) + "...";
+    choice_plans->Append(cached.prepared.FormatTime() + " " + label);
+    choice_plans->SetSelection(choice_plans->GetCount() - 1);
+    plan_diagram->setPlan(cached.plan);
+}
+
+void ExecuteSqlFrame::OnPlanSelected(wxCommandEvent& WXUNUSED(event))
+{
+    int item = choice_plans->GetSelection();
+    if (item >= 0 && item < int(plansM.size()))
+        plan_diagram->setPlan(plansM[item].plan);
+}
+
+void ExecuteSqlFrame::OnNotebookPageChanged(wxNotebookEvent& event)
+{
+    event.Skip();
+    if (event.GetEventObject() == notebook_1
+        && event.GetSelection() == notebook_1->FindPage(notebook_pane_4))
+    {
+        loadExplainedPlan();
+    }
+}
+
 void ExecuteSqlFrame::splitScreen()
 {
     if (!splitter_window_1->IsSplit()) // split screen if needed
@@ -2739,10 +3079,25 @@ bool ExecuteSqlFrame::commitTransaction()
         sae.scroll();
         {
             wxStopWatch sw;
+            // blobs can't be read anymore once the transaction has ended
+            DataGridTable* dgt = grid_data->getDataGridTable();
+            if (dgt)
+                dgt->cancelBlobPreviews();
+            // the plan can't be read from the closed statement any more
+            loadExplainedPlan();
             statementM->Close();
             transactionM->Commit();
             log(wxString::Format(_("Transaction committed (elapsed time: %s)."),
                 millisToTimeString(sw.Time()).c_str()));
+            // the rows of a scrollable cursor were read on demand, they
+            // can't be loaded any more
+            unsigned pagedRows = dgt ? dgt->clearScrollable() : 0;
+            if (pagedRows > 0)
+            {
+                log(wxString::Format(_("The %u rows of the scrollable cursor can't be read after the transaction has ended, the grid has been cleared."),
+                    pagedRows));
+                statusbar_1->SetStatusText(wxEmptyString, 1);
+            }
         }
         statusbar_1->SetStatusText(_("Transaction committed"), 3);
         inTransaction(false);
@@ -2834,10 +3189,25 @@ bool ExecuteSqlFrame::rollbackTransaction()
         sae.scroll();
         {
             wxStopWatch sw;
+            // blobs can't be read anymore once the transaction has ended
+            DataGridTable* dgt = grid_data->getDataGridTable();
+            if (dgt)
+                dgt->cancelBlobPreviews();
+            // the plan can't be read from the closed statement any more
+            loadExplainedPlan();
             statementM->Close();
             transactionM->Rollback();
             log(wxString::Format(_("Transaction rolled back (elapsed time: %s)."),
                 millisToTimeString(sw.Time()).c_str()));
+            // the rows of a scrollable cursor were read on demand, they
+            // can't be loaded any more
+            unsigned pagedRows = dgt ? dgt->clearScrollable() : 0;
+            if (pagedRows > 0)
+            {
+                log(wxString::Format(_("The %u rows of the scrollable cursor can't be read after the transaction has ended, the grid has been cleared."),
+                    pagedRows));
+                statusbar_1->SetStatusText(wxEmptyString, 1);
+            }
         }
         statusbar_1->SetStatusText(_("Transaction rolled back"), 3);
         inTransaction(false);
@@ -2931,6 +3301,19 @@ void ExecuteSqlFrame::OnGridRowCountChanged(wxCommandEvent& event)
     s.Printf(_("%ld row(s) fetched"), rowsFetched);
     statusbar_1->SetStatusText(s, 1);
 
+    // rows fetched on idle belong to the last executed statement
+    if (profileFetchingM && grid_data->getDataGridTable())
+    {
+        StatementProfile& p = profilesM.back();
+        const DataGridFetchTimes& times =
+            grid_data->getDataGridTable()->getFetchTimes();
+        p.totalMs += times.fetchMs + times.bufferMs - p.fetchMs - p.bufferMs;
+        p.fetchMs = times.fetchMs;
+        p.bufferMs = times.bufferMs;
+        p.rows = rowsFetched;
+        showStatementProfile(long(profilesM.size()) - 1);
+    }
+
     // TODO: we could make some bool flag, so that this happens only once per execute()
     //       to fix the problem when user does the select, unsplits the window
     //       and then browses the grid, which fetches more records and unsplits again
@@ -3477,6 +3860,81 @@ bool EditDDLHandler::handleURI(URI& uri)
     return true;
 }
 
+class SaveDDLHandler: public URIHandler,
+    private MetadataItemURIHandlerHelper, private GUIURIHandlerHelper
+{
+public:
+    SaveDDLHandler() {}
+    bool handleURI(URI& uri);
+private:
+    static const SaveDDLHandler handlerInstance;
+};
+
+const SaveDDLHandler SaveDDLHandler::handlerInstance;
+
+bool SaveDDLHandler::handleURI(URI& uri)
+{
+    if (uri.action != "save_ddl")
+        return false;
+
+    MetadataItem* m = extractMetadataItemFromURI<MetadataItem>(uri);
+    wxWindow* w = getParentWindow(uri);
+    if (!m || !w)
+        return true;
+
+    wxFileDialog fd(w, _("Save DDL As"), "", m->getName_() + ".sql",
+        _("SQL script files (*.sql)|*.sql|All files (*.*)|*.*"),
+        wxFD_SAVE | wxFD_CHANGE_DIR | wxFD_OVERWRITE_PROMPT);
+    if (wxID_OK != fd.ShowModal())
+        return true;
+    wxString fileName(fd.GetPath());
+
+    // use a single read-only transaction for metadata loading
+    DatabasePtr db = m->getDatabase();
+    MetadataLoaderTransaction tr(db->getMetadataLoader());
+
+    // the script is written to a temporary file next to the target, so
+    // an existing file is only replaced by a complete script
+    wxString tempFileName(fileName + ".tmp");
+    bool canceled;
+    try
+    {
+        wxFileOutputStream fos(tempFileName);
+        if (!fos.IsOk())
+            return true;
+
+        ProgressDialog pd(w, _("Extracting DDL Definitions"), 2);
+        pd.doShow();
+        // the DDL of a database is written to the file while it is
+        // extracted, all other objects are small enough to be returned
+        CreateDDLVisitor cdv(&pd);
+        cdv.setOutputStream(&fos);
+        m->acceptVisitor(&cdv);
+        canceled = pd.isCanceled();
+        if (!canceled && !dynamic_cast<Database*>(m))
+        {
+            const wxScopedCharBuffer buf(cdv.getSql().utf8_str());
+            fos.Write(buf.data(), buf.length());
+        }
+        if (!canceled && !fos.Close())
+            throw FRError(_("Could not write the DDL script."));
+        pd.doHide();
+    }
+    catch (...)
+    {
+        wxRemoveFile(tempFileName);
+        throw;
+    }
+    if (canceled)
+        wxRemoveFile(tempFileName);
+    else if (!wxRenameFile(tempFileName, fileName, true))
+    {
+        wxRemoveFile(tempFileName);
+        throw FRError(_("Could not write the DDL script."));
+    }
+    return true;
+}
+
 class EditProcedureHandler: public URIHandler,
     private MetadataItemURIHandlerHelper, private GUIURIHandlerHelper
 {
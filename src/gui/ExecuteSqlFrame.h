@@ -28,15 +28,19 @@
 #include <wx/filename.h>
 #include <wx/grid.h>
 #include <wx/image.h>
+#include <wx/listctrl.h>
 #include <wx/notebook.h>
 #include <wx/splitter.h>
 #include <wx/stc/stc.h>
 
+#include <deque>
+
 #include <ibpp.h>
 
 #include "core/Observer.h"
 #include "core/StringUtils.h"
 #include "controls/DataGridTable.h"
+#include "engine/ExplainedPlan.h"
 #include "gui/BaseFrame.h"
 #include "gui/EditBlobDialog.h"
 #include "gui/FindDialog.h"
@@ -48,6 +52,7 @@ class CommandManager;
 class Database;
 class DataGrid;
 class ExecuteSqlFrame;
+class PlanDiagram;
 
 class SqlEditor: public SearchableEditor
 {
@@ -104,6 +109,49 @@ private:
     wxDateTime filenameModificationTimeM;
 
     void compareCounts(IBPP::DatabaseCounts& one, IBPP::DatabaseCounts& two);
+    wxString getRelationName(int relationId);
+    // table I/O of all statements of the running script
+    IBPP::DatabaseCounts scriptCountsM;
+    void logScriptCounts(int statements);
+
+    // time spent in the phases of a single execute(), in milliseconds
+    struct StatementProfile
+    {
+        wxDateTime started;
+        wxString sql;
+        bool failed;
+        bool hasResultSet;
+        double prepareMs;
+        double executeMs;
+        double firstRowMs;
+        double fetchMs;
+        double bufferMs;
+        double gridMs;
+        double totalMs;
+        long rows;
+        // record counters of the statement, -1 if not available
+        int selects, inserts, updates, deletes;
+    };
+    std::deque<StatementProfile> profilesM;
+    // whether rows fetched by the grid still update the last profile
+    bool profileFetchingM;
+    void addStatementProfile(const StatementProfile& profile);
+    void showStatementProfile(long item);
+
+    // explained plans by statement text, a statement gets another entry
+    // only when its plan changed, so the previous plans can be compared
+    struct CachedPlan
+    {
+        wxDateTime prepared;
+        wxString sql;
+        ExplainedPlanPtr plan;
+    };
+    std::deque<CachedPlan> plansM;
+    // the explained plan of statementM is only read when the plan page is
+    // shown, this is the statement text until then
+    wxString explainedPlanSqlM;
+    bool loadExplainedPlan();
+    void showExplainedPlan(const wxString& sql, const wxString& text);
 
     void showProperties(wxString objectName);
 
@@ -176,6 +224,8 @@ private:
     void OnGridRowCountChanged(wxCommandEvent& event);
     void OnGridStatementExecuted(wxCommandEvent& event);
     void OnGridSum(wxCommandEvent& event);
+    void OnPlanSelected(wxCommandEvent& event);
+    void OnNotebookPageChanged(wxNotebookEvent& event);
     void OnGridLabelLeftDClick(wxGridEvent& event);
     void OnSplitterUnsplit(wxSplitterEvent& event);
     void OnIdle(wxIdleEvent& event);
@@ -267,7 +317,8 @@ private:
 protected:
     enum {
         ID_grid_data = 101,
-        ID_stc_sql
+        ID_stc_sql,
+        ID_choice_plans
     };
 
     bool closeWhenTransactionDoneM;
@@ -280,8 +331,13 @@ protected:
     wxNotebook* notebook_1;
     wxPanel* notebook_pane_1;
     wxPanel* notebook_pane_2;
+    wxPanel* notebook_pane_3;
+    wxPanel* notebook_pane_4;
     DataGrid* grid_data;
     wxStyledTextCtrl* styled_text_ctrl_stats;
+    wxListCtrl* listctrl_profile;
+    wxChoice* choice_plans;
+    PlanDiagram* plan_diagram;
 
     wxStatusBar* statusbar_1;
 
@@ -0,0 +1,424 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/tokenzr.h>
+#include <wx/wupdlock.h>
+
+#include <ibpp.h>
+
+#include "core/StringUtils.h"
+#include "gui/controls/LogTextControl.h"
+#include "gui/IndexStatisticsFrame.h"
+#include "gui/ProgressDialog.h"
+#include "gui/StyleGuide.h"
+#include "gui/UsernamePasswordDialog.h"
+#include "metadata/ConnectionPool.h"
+#include "metadata/database.h"
+#include "metadata/IndexStatistics.h"
+#include "metadata/server.h"
+#include "sql/Identifier.h"
+
+IndexStatisticsFrame::IndexStatisticsFrame(wxWindow* parent, DatabasePtr db)
+    : ServiceBaseFrame(parent, db)
+{
+    setIdString(this, getFrameId(db));
+
+    wxString databaseName(db->getName_());
+    wxString serverName(db->getServer()->getName_());
+    SetTitle(wxString::Format(_("Index Statistics \"%s:%s\""),
+        serverName.c_str(), databaseName.c_str()));
+
+    createControls();
+    layoutControls();
+    loadStatistics();
+    updateControls();
+}
+
+IndexStatisticsFrame::~IndexStatisticsFrame()
+{
+}
+
+//! implementation details
+void IndexStatisticsFrame::createControls()
+{
+    ServiceBaseFrame::createControls();
+
+    button_start->SetLabelText(_("&Analyze Index Pages"));
+    button_start->SetToolTip(
+        _("Reads all index pages on the server, like \"gstat -i\""));
+    button_refresh = new wxButton(panel_controls, ID_button_refresh,
+        _("Re&fresh"));
+    button_recompute = new wxButton(panel_controls, ID_button_recompute,
+        _("&Recompute Selected"));
+
+    listctrl_indices = new wxListCtrl(this, wxID_ANY, wxDefaultPosition,
+        wxDefaultSize, wxLC_REPORT | wxLC_VRULES | wxBORDER_THEME);
+    listctrl_indices->InsertColumn(0, _("Table"));
+    listctrl_indices->InsertColumn(1, _("Index"));
+    listctrl_indices->InsertColumn(2, _("Unique"), wxLIST_FORMAT_CENTER);
+    listctrl_indices->InsertColumn(3, _("Active"), wxLIST_FORMAT_CENTER);
+    listctrl_indices->InsertColumn(4, _("Segments"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(5, _("Selectivity"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(6, _("Distinct keys"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(7, _("Table rows"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(8, _("Depth"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(9, _("Leaf buckets"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(10, _("Nodes"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(11, _("Fill %"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(12, _("Dup %"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(13, _("Max dup"), wxLIST_FORMAT_RIGHT);
+    listctrl_indices->InsertColumn(14, _("Remarks"));
+}
+
+void IndexStatisticsFrame::layoutControls()
+{
+    ServiceBaseFrame::layoutControls();
+
+    sizerButtons->Insert(0, button_refresh);
+    sizerButtons->Insert(1, styleguide().getBetweenButtonsMargin(wxHORIZONTAL),
+        0);
+    sizerButtons->Insert(2, button_recompute);
+
+    wxBoxSizer* sizerPanelV = new wxBoxSizer(wxVERTICAL);
+    sizerPanelV->Add(0, styleguide().getFrameMargin(wxTOP));
+    sizerPanelV->Add(sizerButtons, 0, wxEXPAND);
+    sizerPanelV->Add(0, styleguide().getRelatedControlMargin(wxVERTICAL));
+
+    wxBoxSizer* sizerPanelH = new wxBoxSizer(wxHORIZONTAL);
+    sizerPanelH->Add(styleguide().getFrameMargin(wxLEFT), 0);
+    sizerPanelH->Add(sizerPanelV, 1, wxEXPAND);
+    sizerPanelH->Add(styleguide().getFrameMargin(wxRIGHT), 0);
+    panel_controls->SetSizerAndFit(sizerPanelH);
+
+    wxBoxSizer* sizerMain = new wxBoxSizer(wxVERTICAL);
+    sizerMain->Add(panel_controls, 0, wxEXPAND);
+    sizerMain->Add(listctrl_indices, 3, wxEXPAND);
+    sizerMain->Add(text_ctrl_log, 1, wxEXPAND);
+
+    SetSizerAndFit(sizerMain);
+}
+
+void IndexStatisticsFrame::updateControls()
+{
+    ServiceBaseFrame::updateControls();
+
+    bool running = getThreadRunning();
+    button_refresh->Enable(!running);
+    button_recompute->Enable(!running
+        && listctrl_indices->GetSelectedItemCount() > 0);
+}
+
+void IndexStatisticsFrame::loadStatistics()
+{
+    DatabasePtr db = getDatabase();
+    if (!db)
+        return;
+    statisticsM.reset(new IndexStatistics(*db));
+    updateList();
+}
+
+static wxString formatNumber(double value, const wxString& format = "%.0f")
+{
+    if (value < 0)
+        return wxEmptyString;
+    return wxString::Format(format, value);
+}
+
+void IndexStatisticsFrame::updateList()
+{
+    wxWindowUpdateLocker freeze(listctrl_indices);
+
+    size_t count = statisticsM ? statisticsM->getCount() : 0;
+    if (size_t(listctrl_indices->GetItemCount()) != count)
+        listctrl_indices->DeleteAllItems();
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const IndexStatistics::Entry& e = statisticsM->getEntry(i);
+        long item = long(i);
+        if (item >= listctrl_indices->GetItemCount())
+            listctrl_indices->InsertItem(item, e.relationName);
+        listctrl_indices->SetItem(item, 1, e.indexName);
+        listctrl_indices->SetItem(item, 2, e.unique ? _("Yes") : wxString());
+        listctrl_indices->SetItem(item, 3, e.active ? _("Yes") : _("No"));
+        listctrl_indices->SetItem(item, 4,
+            wxString::Format("%d", e.segments));
+        listctrl_indices->SetItem(item, 5,
+            formatNumber(e.selectivity, "%.6g"));
+        listctrl_indices->SetItem(item, 6, e.hasSelectivity()
+            ? formatNumber(e.getDistinctKeys()) : wxString());
+        double rows = statisticsM->getEstimatedRows(e.relationName);
+        listctrl_indices->SetItem(item, 7,
+            rows > 0 ? formatNumber(rows) : wxString());
+        listctrl_indices->SetItem(item, 8, formatNumber(e.depth));
+        listctrl_indices->SetItem(item, 9, formatNumber(e.leafBuckets));
+        listctrl_indices->SetItem(item, 10, formatNumber(e.nodes));
+        listctrl_indices->SetItem(item, 11, formatNumber(e.averageFill));
+        double dupRatio = e.getDuplicateRatio();
+        listctrl_indices->SetItem(item, 12,
+            dupRatio < 0 ? wxString() : formatNumber(100 * dupRatio, "%.1f"));
+        listctrl_indices->SetItem(item, 13, formatNumber(e.maxDup));
+
+        int flags = statisticsM->getFlags(i);
+        wxString remarks;
+        if (flags & IndexStatistics::flagNoStatistics)
+            remarks += _("no statistics") + ", ";
+        if (flags & IndexStatistics::flagStale)
+            remarks += _("stale") + ", ";
+        if (flags & IndexStatistics::flagLowSelectivity)
+            remarks += _("low selectivity") + ", ";
+        if (flags & IndexStatistics::flagNearlyUnique)
+            remarks += _("nearly unique") + ", ";
+        if (!remarks.empty())
+            remarks.RemoveLast(2);
+        listctrl_indices->SetItem(item, 14, remarks);
+        if (flags & (IndexStatistics::flagNoStatistics
+            | IndexStatistics::flagStale))
+        {
+            listctrl_indices->SetItemTextColour(item, *wxRED);
+        }
+        else
+        {
+            listctrl_indices->SetItemTextColour(item,
+                listctrl_indices->GetTextColour());
+        }
+    }
+    for (int col = 0; col < listctrl_indices->GetColumnCount(); ++col)
+        listctrl_indices->SetColumnWidth(col, wxLIST_AUTOSIZE_USEHEADER);
+}
+
+void IndexStatisticsFrame::selectIndex(const wxString& indexName)
+{
+    if (!statisticsM)
+        return;
+    int pos = statisticsM->findEntry(indexName);
+    if (pos < 0)
+        return;
+    for (long item = listctrl_indices->GetNextItem(-1, wxLIST_NEXT_ALL,
+        wxLIST_STATE_SELECTED); item != -1;
+        item = listctrl_indices->GetNextItem(item, wxLIST_NEXT_ALL,
+        wxLIST_STATE_SELECTED))
+    {
+        listctrl_indices->SetItemState(item, 0, wxLIST_STATE_SELECTED);
+    }
+    listctrl_indices->SetItemState(pos,
+        wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
+        wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+    listctrl_indices->EnsureVisible(pos);
+    updateControls();
+}
+
+void IndexStatisticsFrame::threadMsgsReceived(const std::vector<LogMsg>& msgs)
+{
+    if (!statisticsM)
+        return;
+    for (std::vector<LogMsg>::const_iterator it = msgs.begin();
+        it != msgs.end(); ++it)
+    {
+        if ((*it).kind != progress_message)
+            continue;
+        wxStringTokenizer tokenizer((*it).text, "\n", wxTOKEN_RET_EMPTY_ALL);
+        while (tokenizer.HasMoreTokens())
+            statisticsM->addAnalysisLine(tokenizer.GetNextToken());
+    }
+}
+
+void IndexStatisticsFrame::threadFinished()
+{
+    updateList();
+}
+
+const wxString IndexStatisticsFrame::getName() const
+{
+    return "IndexStatisticsFrame";
+}
+
+const wxRect IndexStatisticsFrame::getDefaultRect() const
+{
+    return wxRect(-1, -1, 900, 550);
+}
+
+/*static*/
+wxString IndexStatisticsFrame::getFrameId(DatabasePtr db)
+{
+    if (db)
+        return wxString("IndexStatisticsFrame/" + db->getItemPath());
+    else
+        return wxEmptyString;
+}
+
+IndexStatisticsFrame* IndexStatisticsFrame::findFrameFor(DatabasePtr db)
+{
+    BaseFrame* bf = frameFromIdString(getFrameId(db));
+    if (!bf)
+        return 0;
+    return dynamic_cast<IndexStatisticsFrame*>(bf);
+}
+
+//! event handlers
+BEGIN_EVENT_TABLE(IndexStatisticsFrame, ServiceBaseFrame)
+    EVT_BUTTON(IndexStatisticsFrame::ID_button_refresh, IndexStatisticsFrame::OnRefreshButtonClick)
+    EVT_BUTTON(IndexStatisticsFrame::ID_button_recompute, IndexStatisticsFrame::OnRecomputeButtonClick)
+    EVT_BUTTON(ServiceBaseFrame::ID_button_start, IndexStatisticsFrame::OnStartButtonClick)
+    EVT_LIST_ITEM_SELECTED(wxID_ANY, IndexStatisticsFrame::OnListSelectionChange)
+    EVT_LIST_ITEM_DESELECTED(wxID_ANY, IndexStatisticsFrame::OnListSelectionChange)
+END_EVENT_TABLE()
+
+void IndexStatisticsFrame::OnRefreshButtonClick(wxCommandEvent& WXUNUSED(event))
+{
+    loadStatistics();
+    updateControls();
+}
+
+void IndexStatisticsFrame::OnRecomputeButtonClick(
+    wxCommandEvent& WXUNUSED(event))
+{
+    DatabasePtr db = getDatabase();
+    if (!db || !statisticsM)
+        return;
+
+    std::vector<wxString> names;
+    for (long item = listctrl_indices->GetNextItem(-1, wxLIST_NEXT_ALL,
+        wxLIST_STATE_SELECTED); item != -1;
+        item = listctrl_indices->GetNextItem(item, wxLIST_NEXT_ALL,
+        wxLIST_STATE_SELECTED))
+    {
+        names.push_back(statisticsM->getEntry(item).indexName);
+    }
+    if (names.empty())
+        return;
+
+    ProgressDialog pd(this, _("Recomputing index statistics"));
+    pd.doShow();
+    pd.initProgress(wxEmptyString, names.size());
+
+    try
+    {
+        // use a secondary attachment, the main one stays free for the GUI
+        PooledConnection connection(db->getConnectionPool());
+        IBPP::Database& ibppdb = connection.get();
+        for (std::vector<wxString>::iterator it = names.begin();
+            it != names.end(); ++it)
+        {
+            if (pd.isCanceled())
+                break;
+            pd.setProgressMessage(*it);
+            pd.stepProgress();
+
+            // one transaction per index, so canceling keeps the finished ones
+            IBPP::Transaction tr = IBPP::TransactionFactory(ibppdb);
+            tr->Start();
+            try
+            {
+                IBPP::Statement st = IBPP::StatementFactory(ibppdb, tr);
+                st->Execute(wx2std("SET STATISTICS INDEX "
+                    + Identifier(*it).getQuoted(), db->getCharsetConverter()));
+                tr->Commit();
+            }
+            catch (...)
+            {
+                try
+                {
+                    if (tr->Started())
+                        tr->Rollback();
+                }
+                catch (...)
+                {
+                }
+                throw;
+            }
+
+            if (MetadataItem* mi = db->findByNameAndType(ntIndex, *it))
+                mi->invalidate();
+        }
+        pd.doHide();
+
+        // one statement for the new values of all indices
+        IndexStatistics fresh(*db);
+        statisticsM->updateSelectivities(fresh);
+        updateList();
+    }
+    // IBPP::Exception, or FRError if no attachment of the pool is free
+    catch (std::exception& e)
+    {
+        pd.doHide();
+        wxMessageBox(wxString(e.what(), *db->getCharsetConverter()),
+            _("Error"), wxOK | wxICON_ERROR);
+    }
+}
+
+void IndexStatisticsFrame::OnStartButtonClick(wxCommandEvent& WXUNUSED(event))
+{
+    verboseMsgsM = true;
+    clearLog();
+
+    DatabasePtr database = getDatabase();
+    wxCHECK_RET(database,
+        "Cannot analyze indices of unassigned database");
+    ServerPtr server = database->getServer();
+    wxCHECK_RET(server,
+        "Cannot analyze indices of database without assigned server");
+
+    wxString username;
+    wxString password;
+    if (!getConnectionCredentials(this, database, username, password))
+        return;
+
+    if (statisticsM)
+        statisticsM->startAnalysis();
+    updateList();
+
+    startThread(std::make_unique<IndexAnalysisThread>(this,
+        server->getConnectionString(), username, password,
+        database->getRole(), database->getConnectionCharset(),
+        database->getPath()));
+
+    updateControls();
+}
+
+void IndexStatisticsFrame::OnListSelectionChange(wxListEvent& WXUNUSED(event))
+{
+    updateControls();
+}
+
+IndexAnalysisThread::IndexAnalysisThread(IndexStatisticsFrame* frame,
+    wxString server, wxString username, wxString password,
+    wxString rolename, wxString charset, wxString dbfilename)
+    : ServiceThread(frame, server, username, password, rolename, charset),
+    dbfileM(dbfilename)
+{
+}
+
+void IndexAnalysisThread::Execute(IBPP::Service svc)
+{
+    svc->StartIndexStatistics(wx2std(dbfileM));
+}
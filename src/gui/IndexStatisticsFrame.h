@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_INDEXSTATISTICSFRAME_H
+#define FR_INDEXSTATISTICSFRAME_H
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+
+#include <memory>
+
+#include "gui/ServiceBaseFrame.h"
+
+class IndexStatistics;
+class IndexAnalysisThread;
+
+// Shows the selectivity of all user indices of a database, recomputes the
+// statistics of selected indices, and optionally runs an index page
+// analysis through the services API to show depth, fill and duplicates.
+class IndexStatisticsFrame: public ServiceBaseFrame {
+    friend class IndexAnalysisThread;
+private:
+    enum {
+        ID_button_refresh = 301,
+        ID_button_recompute
+    };
+
+    std::unique_ptr<IndexStatistics> statisticsM;
+
+    wxListCtrl* listctrl_indices;
+    wxButton* button_refresh;
+    wxButton* button_recompute;
+
+    virtual void createControls();
+    virtual void layoutControls();
+    virtual void updateControls();
+
+    void loadStatistics();
+    void updateList();
+
+    static wxString getFrameId(DatabasePtr db);
+protected:
+    virtual const wxString getName() const;
+    virtual const wxRect getDefaultRect() const;
+
+    virtual void threadMsgsReceived(const std::vector<LogMsg>& msgs);
+    virtual void threadFinished();
+public:
+    IndexStatisticsFrame(wxWindow* parent, DatabasePtr db);
+    ~IndexStatisticsFrame();
+
+    // selects and shows the given index in the list
+    void selectIndex(const wxString& indexName);
+
+    static IndexStatisticsFrame* findFrameFor(DatabasePtr db);
+private:
+    // event handling
+    void OnRefreshButtonClick(wxCommandEvent& event);
+    void OnRecomputeButtonClick(wxCommandEvent& event);
+    void OnStartButtonClick(wxCommandEvent& event);
+    void OnListSelectionChange(wxListEvent& event);
+
+    DECLARE_EVENT_TABLE()
+};
+
+class IndexAnalysisThread : public ServiceThread
+{
+public:
+    IndexAnalysisThread(IndexStatisticsFrame* frame, wxString server,
+        wxString username, wxString password, wxString rolename,
+        wxString charset, wxString dbfilename);
+protected:
+    virtual void Execute(IBPP::Service);
+private:
+    wxString dbfileM;
+};
+
+#endif // FR_INDEXSTATISTICSFRAME_H
@@ -54,8 +54,10 @@
 #include "gui/EventWatcherFrame.h"
 #include "gui/ExecuteSql.h"
 #include "gui/ExecuteSqlFrame.h"
+#include "gui/IndexStatisticsFrame.h"
 #include "gui/MainFrame.h"
 #include "gui/MetadataItemPropertiesFrame.h"
+#include "gui/MonitoringFrame.h"
 #include "gui/PreferencesDialog.h"
 #include "gui/ProgressDialog.h"
 #include "gui/RestoreFrame.h"
@@ -63,6 +65,7 @@
 #include "gui/SimpleHtmlFrame.h"
 #include "gui/ShutdownFrame.h"
 #include "gui/StartupFrame.h"
+#include "logger.h"
 #include "main.h"
 #include "metadata/column.h"
 #include "metadata/domain.h"
@@ -395,6 +398,8 @@ EVT_MENU(Cmds::Menu_GetServerVersion, MainFrame::OnMenuGetServerVersion)
 EVT_UPDATE_UI(Cmds::Menu_GetServerVersion, MainFrame::OnMenuUpdateIfServerSelected)
 EVT_MENU(Cmds::Menu_MonitorEvents, MainFrame::OnMenuMonitorEvents)
 EVT_UPDATE_UI(Cmds::Menu_MonitorEvents, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
+EVT_MENU(Cmds::Menu_MonitorActivity, MainFrame::OnMenuMonitorActivity)
+EVT_UPDATE_UI(Cmds::Menu_MonitorActivity, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
 EVT_MENU(Cmds::Menu_GenerateData, MainFrame::OnMenuGenerateData)
 EVT_UPDATE_UI(Cmds::Menu_GenerateData, MainFrame::OnMenuUpdateIfDatabaseConnectedOrAutoConnect)
 EVT_MENU(Cmds::Menu_CloneDatabase, MainFrame::OnMenuCloneDatabase)
@@ -860,10 +865,31 @@ void MainFrame::OnMenInactiveObject(wxCommandEvent& WXUNUSED(event))
 
 void MainFrame::OnMenuShowAllStatisticsValues(wxCommandEvent& WXUNUSED(event))
 {
+    DatabasePtr db = getDatabase(treeMainM->getSelectedMetadataItem());
+    if (!checkValidDatabase(db))
+        return;
+
+    IndexStatisticsFrame* isf = IndexStatisticsFrame::findFrameFor(db);
+    if (isf)
+    {
+        isf->Raise();
+        return;
+    }
+    isf = new IndexStatisticsFrame(this, db);
+    isf->Show();
 }
 
-void MainFrame::OnMenuShowStatisticsValue(wxCommandEvent& WXUNUSED(event))
+void MainFrame::OnMenuShowStatisticsValue(wxCommandEvent& event)
 {
+    Index* i = dynamic_cast<Index*>(treeMainM->getSelectedMetadataItem());
+    if (!i)
+        return;
+    OnMenuShowAllStatisticsValues(event);
+    if (IndexStatisticsFrame* isf =
+        IndexStatisticsFrame::findFrameFor(i->getDatabase()))
+    {
+        isf->selectIndex(i->getName_());
+    }
 }
 
 void MainFrame::OnMenuSetStatisticsValue(wxCommandEvent& WXUNUSED(event))
@@ -1217,6 +1243,24 @@ void MainFrame::OnMenuMonitorEvents(wxCommandEvent& WXUNUSED(event))
     ewf->Show();
 }
 
+void MainFrame::OnMenuMonitorActivity(wxCommandEvent& WXUNUSED(event))
+{
+    DatabasePtr db = getDatabase(treeMainM->getSelectedMetadataItem());
+    if (!checkValidDatabase(db))
+        return;
+    if (!tryAutoConnectDatabase(db))
+        return;
+
+    MonitoringFrame* mf = MonitoringFrame::findFrameFor(db);
+    if (mf)
+    {
+        mf->Raise();
+        return;
+    }
+    mf = new MonitoringFrame(this, db);
+    mf->Show();
+}
+
 void MainFrame::OnMenuBackup(wxCommandEvent& WXUNUSED(event))
 {
     DatabasePtr db = getDatabase(treeMainM->getSelectedMetadataItem());
@@ -1366,6 +1410,8 @@ void MainFrame::OnMenuDisconnect(wxCommandEvent& WXUNUSED(event))
     treeMainM->Freeze();
     try
     {
+        // statements logged on commit are written using the database
+        Logger::flush();
         db->disconnect();
     }
     catch (...)
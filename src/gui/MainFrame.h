@@ -71,6 +71,7 @@ public:
     void OnMenuUnRegisterDatabase(wxCommandEvent& event);
     void OnMenuGetServerVersion(wxCommandEvent& event);
     void OnMenuMonitorEvents(wxCommandEvent& event);
+    void OnMenuMonitorActivity(wxCommandEvent& event);
     void OnMenuGenerateData(wxCommandEvent& event);
     void OnMenuBackup(wxCommandEvent& event);
     void OnMenuExecuteStatements(wxCommandEvent& event);
@@ -0,0 +1,479 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/datetime.h>
+
+#include <algorithm>
+
+#include "config/Config.h"
+#include "core/StringUtils.h"
+#include "engine/MonitoringSampler.h"
+#include "gui/MonitoringFrame.h"
+#include "gui/StyleGuide.h"
+#include "metadata/database.h"
+
+static wxString formatDuration(int64_t millis)
+{
+    int64_t seconds = millis / 1000;
+    return wxString::Format("%d:%.2d:%.2d", int(seconds / 3600),
+        int(seconds / 60 % 60), int(seconds % 60));
+}
+
+static wxString formatState(int state)
+{
+    switch (state)
+    {
+        case 0:
+            return _("Idle");
+        case 1:
+            return _("Active");
+        case 2:
+            return _("Stalled");
+        default:
+            return wxString::Format("%d", state);
+    }
+}
+
+static void insertCounterColumns(wxListCtrl* list)
+{
+    int col = list->GetColumnCount();
+    list->InsertColumn(col, _("Reads"), wxLIST_FORMAT_RIGHT);
+    list->InsertColumn(col + 1, _("Writes"), wxLIST_FORMAT_RIGHT);
+    list->InsertColumn(col + 2, _("Fetches"), wxLIST_FORMAT_RIGHT);
+    list->InsertColumn(col + 3, _("Marks"), wxLIST_FORMAT_RIGHT);
+    list->InsertColumn(col + 4, _("Record reads"), wxLIST_FORMAT_RIGHT);
+}
+
+static int setCounterColumns(wxListCtrl* list, long item, int col,
+    const MonitoringCounters& counters)
+{
+    list->SetItem(item, col, wxLongLong(counters.reads).ToString());
+    list->SetItem(item, col + 1, wxLongLong(counters.writes).ToString());
+    list->SetItem(item, col + 2, wxLongLong(counters.fetches).ToString());
+    list->SetItem(item, col + 3, wxLongLong(counters.marks).ToString());
+    list->SetItem(item, col + 4, wxLongLong(counters.recordReads).ToString());
+    return col + 5;
+}
+
+MonitoringFrame::MonitoringFrame(wxWindow* parent, DatabasePtr db)
+    : BaseFrame(parent, -1, wxEmptyString), databaseM(db),
+        selectTransactionIdM(0)
+{
+    wxASSERT(db);
+
+    setIdString(this, getFrameId(db));
+    // observe database object to close on disconnect / destruction
+    db->attachObserver(this, false);
+    SetTitle(wxString::Format(_("Monitoring of Database: %s"),
+        db->getName_().c_str()));
+
+    createControls();
+    layoutControls();
+    updateControls();
+
+    #include "new.xpm"
+    wxBitmap bmp(new_xpm);
+    wxIcon icon;
+    icon.CopyFromBitmap(bmp);
+    SetIcon(icon);
+
+    startMonitoring();
+}
+
+void MonitoringFrame::createControls()
+{
+    panel_controls = new wxPanel(this, -1, wxDefaultPosition, wxDefaultSize,
+        wxTAB_TRAVERSAL | wxCLIP_CHILDREN);
+    static_text_interval = new wxStaticText(panel_controls, wxID_ANY,
+        _("Refresh every (seconds):"));
+    spinctrl_interval = new wxSpinCtrl(panel_controls, ID_spinctrl_interval,
+        wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS,
+        1, 3600, 5);
+    static_text_longrunning = new wxStaticText(panel_controls, wxID_ANY,
+        _("Highlight after (seconds):"));
+    spinctrl_longrunning = new wxSpinCtrl(panel_controls, wxID_ANY,
+        wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS,
+        1, 86400, 60);
+    static_text_status = new wxStaticText(panel_controls, wxID_ANY,
+        wxEmptyString);
+
+    notebook_tables = new wxNotebook(panel_controls, wxID_ANY);
+    listctrl_attachments = new wxListCtrl(notebook_tables, wxID_ANY,
+        wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VRULES);
+    listctrl_attachments->InsertColumn(0, _("Attachment"),
+        wxLIST_FORMAT_RIGHT);
+    listctrl_attachments->InsertColumn(1, _("State"));
+    listctrl_attachments->InsertColumn(2, _("User"));
+    listctrl_attachments->InsertColumn(3, _("Remote address"));
+    listctrl_attachments->InsertColumn(4, _("Remote process"),
+        wxLIST_FORMAT_LEFT, 200);
+    insertCounterColumns(listctrl_attachments);
+    notebook_tables->AddPage(listctrl_attachments, _("Attachments"));
+
+    listctrl_transactions = new wxListCtrl(notebook_tables, wxID_ANY,
+        wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VRULES);
+    listctrl_transactions->InsertColumn(0, _("Transaction"),
+        wxLIST_FORMAT_RIGHT);
+    listctrl_transactions->InsertColumn(1, _("Attachment"),
+        wxLIST_FORMAT_RIGHT);
+    listctrl_transactions->InsertColumn(2, _("State"));
+    listctrl_transactions->InsertColumn(3, _("Running"),
+        wxLIST_FORMAT_RIGHT);
+    insertCounterColumns(listctrl_transactions);
+    notebook_tables->AddPage(listctrl_transactions, _("Transactions"));
+
+    listctrl_statements = new wxListCtrl(notebook_tables, wxID_ANY,
+        wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VRULES);
+    listctrl_statements->InsertColumn(0, _("Statement"),
+        wxLIST_FORMAT_RIGHT);
+    listctrl_statements->InsertColumn(1, _("Attachment"),
+        wxLIST_FORMAT_RIGHT);
+    listctrl_statements->InsertColumn(2, _("Transaction"),
+        wxLIST_FORMAT_RIGHT);
+    listctrl_statements->InsertColumn(3, _("State"));
+    listctrl_statements->InsertColumn(4, _("Running"), wxLIST_FORMAT_RIGHT);
+    insertCounterColumns(listctrl_statements);
+    listctrl_statements->InsertColumn(listctrl_statements->GetColumnCount(),
+        _("SQL"), wxLIST_FORMAT_LEFT, 400);
+    notebook_tables->AddPage(listctrl_statements, _("Active statements"));
+
+    button_monitor = new wxButton(panel_controls, ID_button_monitor,
+        _("Stop &Monitoring"));
+}
+
+void MonitoringFrame::layoutControls()
+{
+    wxBoxSizer* sizerSettings = new wxBoxSizer(wxHORIZONTAL);
+    sizerSettings->Add(static_text_interval, 0, wxALIGN_CENTER_VERTICAL);
+    sizerSettings->AddSpacer(styleguide().getControlLabelMargin());
+    sizerSettings->Add(spinctrl_interval, 0, wxALIGN_CENTER_VERTICAL);
+    sizerSettings->AddSpacer(
+        styleguide().getUnrelatedControlMargin(wxHORIZONTAL));
+    sizerSettings->Add(static_text_longrunning, 0, wxALIGN_CENTER_VERTICAL);
+    sizerSettings->AddSpacer(styleguide().getControlLabelMargin());
+    sizerSettings->Add(spinctrl_longrunning, 0, wxALIGN_CENTER_VERTICAL);
+
+    wxBoxSizer* sizerButtons = new wxBoxSizer(wxHORIZONTAL);
+    sizerButtons->Add(static_text_status, 1, wxALIGN_CENTER_VERTICAL);
+    sizerButtons->AddSpacer(
+        styleguide().getUnrelatedControlMargin(wxHORIZONTAL));
+    sizerButtons->Add(button_monitor);
+
+    wxBoxSizer* sizerPanelV = new wxBoxSizer(wxVERTICAL);
+    sizerPanelV->AddSpacer(styleguide().getFrameMargin(wxTOP));
+    sizerPanelV->Add(sizerSettings, 0, wxEXPAND);
+    sizerPanelV->AddSpacer(styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(notebook_tables, 1, wxEXPAND);
+    sizerPanelV->AddSpacer(styleguide().getUnrelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(sizerButtons, 0, wxEXPAND);
+    sizerPanelV->AddSpacer(styleguide().getFrameMargin(wxBOTTOM));
+
+    wxBoxSizer* sizerPanelH = new wxBoxSizer(wxHORIZONTAL);
+    sizerPanelH->AddSpacer(styleguide().getFrameMargin(wxLEFT));
+    sizerPanelH->Add(sizerPanelV, 1, wxEXPAND);
+    sizerPanelH->AddSpacer(styleguide().getFrameMargin(wxRIGHT));
+
+    wxBoxSizer* sizerAll = new wxBoxSizer(wxHORIZONTAL);
+    sizerAll->Add(sizerPanelH, 1, wxEXPAND);
+
+    panel_controls->SetSizer(sizerAll);
+    sizerAll->Fit(this);
+    sizerAll->SetSizeHints(this);
+}
+
+void MonitoringFrame::updateControls()
+{
+    button_monitor->SetLabel(isMonitoring() ? _("Stop &Monitoring")
+        : _("Start &Monitoring"));
+}
+
+DatabasePtr MonitoringFrame::getDatabase() const
+{
+    return databaseM.lock();
+}
+
+bool MonitoringFrame::isMonitoring() const
+{
+    return samplerM != 0;
+}
+
+void MonitoringFrame::startMonitoring()
+{
+    DatabasePtr database = getDatabase();
+    if (!database)
+        return;
+    // the sampler reads the monitoring tables on its own attachment, the
+    // snapshots are handed over to the GUI thread
+    samplerM.reset(new MonitoringSampler(database->getConnectionPool(),
+        spinctrl_interval->GetValue() * 1000,
+        [this]() { CallAfter(&MonitoringFrame::processSnapshot); }));
+    samplerM->start();
+    updateControls();
+}
+
+void MonitoringFrame::stopMonitoring()
+{
+    samplerM.reset();
+    updateControls();
+}
+
+void MonitoringFrame::processSnapshot()
+{
+    if (!isMonitoring())
+        return;
+
+    std::shared_ptr<const MonitoringSnapshot> snapshot(
+        samplerM->takeSnapshot());
+    if (snapshot)
+        showSnapshot(*snapshot);
+
+    wxString error(samplerM->takeError().c_str(), *wxConvCurrent);
+    if (!error.IsEmpty())
+    {
+        stopMonitoring();
+        static_text_status->SetLabel(_("Error: ") + error);
+    }
+}
+
+void MonitoringFrame::showSnapshot(const MonitoringSnapshot& snapshot)
+{
+    showRows(listctrl_attachments, snapshot.attachments,
+        snapshot.hasDeltas(), false);
+    showRows(listctrl_transactions, snapshot.transactions,
+        snapshot.hasDeltas(), true);
+    if (selectTransactionIdM)
+    {
+        selectTransaction(selectTransactionIdM);
+        selectTransactionIdM = 0;
+    }
+    showRows(listctrl_statements, snapshot.statements,
+        snapshot.hasDeltas(), true);
+
+    wxString counters;
+    if (snapshot.hasDeltas())
+    {
+        counters = wxString::Format(_("counters of the last %.1f seconds"),
+            snapshot.intervalSeconds);
+    }
+    else
+        counters = _("counters since start");
+    static_text_status->SetLabel(wxString::Format(
+        _("%s: %d attachments, %d transactions, %d active statements, %s"),
+        wxDateTime::Now().FormatTime().c_str(),
+        int(snapshot.attachments.size()), int(snapshot.transactions.size()),
+        int(snapshot.statements.size()), counters.c_str()));
+}
+
+void MonitoringFrame::showRows(wxListCtrl* list,
+    const std::vector<MonitoringRow>& rows, bool hasDeltas,
+    bool highlightLongRunning)
+{
+    // what causes the most page fetches now comes first
+    std::vector<const MonitoringRow*> sorted;
+    for (std::vector<MonitoringRow>::const_iterator it = rows.begin();
+        it != rows.end(); ++it)
+    {
+        sorted.push_back(&(*it));
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [hasDeltas](const MonitoringRow* r1, const MonitoringRow* r2)
+        {
+            if (hasDeltas)
+                return r1->deltas.fetches > r2->deltas.fetches;
+            return r1->totals.fetches > r2->totals.fetches;
+        });
+
+    DatabasePtr database = getDatabase();
+    wxMBConv* conv = database ? database->getCharsetConverter()
+        : wxConvCurrent;
+    int64_t longRunningMs = int64_t(spinctrl_longrunning->GetValue()) * 1000;
+
+    list->Freeze();
+    list->DeleteAllItems();
+    for (std::vector<const MonitoringRow*>::const_iterator it =
+        sorted.begin(); it != sorted.end(); ++it)
+    {
+        const MonitoringRow& row = *(*it);
+        long item = list->InsertItem(list->GetItemCount(),
+            wxLongLong(row.id).ToString());
+        int col = 1;
+        if (list != listctrl_attachments)
+        {
+            list->SetItem(item, col++,
+                wxLongLong(row.attachmentId).ToString());
+        }
+        if (list == listctrl_statements)
+        {
+            list->SetItem(item, col++,
+                wxLongLong(row.transactionId).ToString());
+        }
+        list->SetItem(item, col++, formatState(row.state));
+        if (list == listctrl_attachments)
+        {
+            list->SetItem(item, col++, wxString(row.user.c_str(), *conv));
+            list->SetItem(item, col++,
+                wxString(row.remoteAddress.c_str(), *conv));
+            list->SetItem(item, col++,
+                wxString(row.remoteProcess.c_str(), *conv));
+        }
+        else
+            list->SetItem(item, col++, formatDuration(row.ageMs));
+        col = setCounterColumns(list, item, col,
+            hasDeltas ? row.deltas : row.totals);
+        if (list == listctrl_statements)
+        {
+            wxString sql(row.sqlText.c_str(), *conv);
+            sql.Replace("\r", " ");
+            sql.Replace("\n", " ");
+            sql.Replace("\t", " ");
+            if (sql.length() > 200)
+                sql = sql.Left(200) + "...";
+            list->SetItem(item, col++, sql);
+        }
+
+        if (highlightLongRunning && row.ageMs >= longRunningMs)
+            list->SetItemTextColour(item, *wxRED);
+    }
+    list->Thaw();
+}
+
+void MonitoringFrame::selectTransaction(int64_t id)
+{
+    long item = listctrl_transactions->FindItem(-1,
+        wxLongLong(id).ToString());
+    if (item == wxNOT_FOUND)
+        return;
+    listctrl_transactions->SetItemState(item,
+        wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
+        wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+    listctrl_transactions->EnsureVisible(item);
+}
+
+void MonitoringFrame::showTransaction(int64_t id)
+{
+    notebook_tables->SetSelection(1);
+    selectTransactionIdM = id;
+    if (!isMonitoring())
+        startMonitoring();
+}
+
+//! closes window if database is removed (unregistered)
+void MonitoringFrame::subjectRemoved(Subject* subject)
+{
+    DatabasePtr db = getDatabase();
+    if (!db || !db->isConnected() || subject == db.get())
+        Close();
+}
+
+void MonitoringFrame::update()
+{
+    DatabasePtr db = getDatabase();
+    if (!db || !db->isConnected())
+        Close();
+}
+
+void MonitoringFrame::doBeforeDestroy()
+{
+    // stop the sampler thread before the frame goes away
+    samplerM.reset();
+}
+
+void MonitoringFrame::doReadConfigSettings(const wxString& prefix)
+{
+    BaseFrame::doReadConfigSettings(prefix);
+    int value;
+    if (config().getValue(prefix + Config::pathSeparator + "interval", value))
+    {
+        spinctrl_interval->SetValue(value);
+        if (isMonitoring())
+            samplerM->setInterval(spinctrl_interval->GetValue() * 1000);
+    }
+    if (config().getValue(prefix + Config::pathSeparator + "longrunning",
+        value))
+    {
+        spinctrl_longrunning->SetValue(value);
+    }
+}
+
+void MonitoringFrame::doWriteConfigSettings(const wxString& prefix) const
+{
+    BaseFrame::doWriteConfigSettings(prefix);
+    config().setValue(prefix + Config::pathSeparator + "interval",
+        spinctrl_interval->GetValue());
+    config().setValue(prefix + Config::pathSeparator + "longrunning",
+        spinctrl_longrunning->GetValue());
+}
+
+const wxString MonitoringFrame::getName() const
+{
+    return "MonitoringFrame";
+}
+
+const wxRect MonitoringFrame::getDefaultRect() const
+{
+    return wxRect(-1, -1, 900, 550);
+}
+
+wxString MonitoringFrame::getFrameId(DatabasePtr db)
+{
+    if (db)
+        return wxString("MonitoringFrame/" + db->getItemPath());
+    else
+        return wxEmptyString;
+}
+
+MonitoringFrame* MonitoringFrame::findFrameFor(DatabasePtr db)
+{
+    BaseFrame* bf = frameFromIdString(getFrameId(db));
+    if (!bf)
+        return 0;
+    return dynamic_cast<MonitoringFrame*>(bf);
+}
+
+BEGIN_EVENT_TABLE(MonitoringFrame, wxFrame)
+    EVT_BUTTON(MonitoringFrame::ID_button_monitor, MonitoringFrame::OnButtonStartStopClick)
+    EVT_SPINCTRL(MonitoringFrame::ID_spinctrl_interval, MonitoringFrame::OnIntervalChange)
+END_EVENT_TABLE()
+
+void MonitoringFrame::OnButtonStartStopClick(wxCommandEvent& WXUNUSED(event))
+{
+    if (isMonitoring())
+        stopMonitoring();
+    else
+        startMonitoring();
+}
+
+void MonitoringFrame::OnIntervalChange(wxSpinEvent& WXUNUSED(event))
+{
+    if (isMonitoring())
+        samplerM->setInterval(spinctrl_interval->GetValue() * 1000);
+}
@@ -0,0 +1,117 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_MONITORINGFRAME_H
+#define FR_MONITORINGFRAME_H
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <wx/notebook.h>
+#include <wx/spinctrl.h>
+
+#include <memory>
+#include <vector>
+
+#include "core/Observer.h"
+#include "gui/BaseFrame.h"
+#include "metadata/database.h"
+#include "metadata/MetadataClasses.h"
+
+class MonitoringSampler;
+struct MonitoringRow;
+struct MonitoringSnapshot;
+
+// Shows the attachments, transactions and active statements of a database
+// as reported by the MON$ tables, refreshed at a configurable interval.
+// The page and record counters are shown as the difference to the previous
+// snapshot, the rows causing the most page fetches are listed first.
+// Transactions and statements that run longer than a configurable time are
+// highlighted.
+class MonitoringFrame : public BaseFrame, public Observer
+{
+private:
+    DatabaseWeakPtr databaseM;
+    std::unique_ptr<MonitoringSampler> samplerM;
+    // transaction to select when the next snapshot is shown, or 0
+    int64_t selectTransactionIdM;
+
+    wxPanel* panel_controls;
+    wxStaticText* static_text_interval;
+    wxSpinCtrl* spinctrl_interval;
+    wxStaticText* static_text_longrunning;
+    wxSpinCtrl* spinctrl_longrunning;
+    wxStaticText* static_text_status;
+    wxNotebook* notebook_tables;
+    wxListCtrl* listctrl_attachments;
+    wxListCtrl* listctrl_transactions;
+    wxListCtrl* listctrl_statements;
+    wxButton* button_monitor;
+    void createControls();
+    void layoutControls();
+    void updateControls();
+
+    static wxString getFrameId(DatabasePtr db);
+
+    DatabasePtr getDatabase() const;
+    bool isMonitoring() const;
+    void startMonitoring();
+    void stopMonitoring();
+    // called in the GUI thread after the sampler took a snapshot
+    void processSnapshot();
+    void showSnapshot(const MonitoringSnapshot& snapshot);
+    void showRows(wxListCtrl* list, const std::vector<MonitoringRow>& rows,
+        bool hasDeltas, bool highlightLongRunning);
+    void selectTransaction(int64_t id);
+
+    // observer stuff
+    virtual void subjectRemoved(Subject* subject);
+    virtual void update();
+
+protected:
+    virtual void doBeforeDestroy();
+    virtual void doReadConfigSettings(const wxString& prefix);
+    virtual void doWriteConfigSettings(const wxString& prefix) const;
+    virtual const wxString getName() const;
+    virtual const wxRect getDefaultRect() const;
+public:
+    MonitoringFrame(wxWindow* parent, DatabasePtr db);
+
+    static MonitoringFrame* findFrameFor(DatabasePtr db);
+    // shows the transactions page and selects the given transaction once
+    // it has been read from the monitoring tables
+    void showTransaction(int64_t id);
+private:
+    // event handling
+    enum
+    {
+        ID_spinctrl_interval = 101,
+        ID_button_monitor
+    };
+
+    void OnButtonStartStopClick(wxCommandEvent& event);
+    void OnIntervalChange(wxSpinEvent& event);
+
+    DECLARE_EVENT_TABLE()
+};
+
+#endif // FR_MONITORINGFRAME_H
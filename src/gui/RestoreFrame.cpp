@@ -185,6 +185,7 @@ void RestoreFrame::layoutControls()
 
     wxBoxSizer* sizerMain = new wxBoxSizer(wxVERTICAL);
     sizerMain->Add(panel_controls, 0, wxEXPAND);
+    sizerMain->Add(listctrl_statistics, 1, wxEXPAND);
     sizerMain->Add(text_ctrl_log, 1, wxEXPAND);
 
     // show at least 3 lines of text since it is default size too
@@ -339,6 +340,7 @@ void RestoreFrame::OnStartButtonClick(wxCommandEvent& WXUNUSED(event))
 {
     verboseMsgsM = checkbox_showlog->IsChecked() || spinctrl_showlogInterval->GetValue() > 0;
     clearLog();
+    startStatistics();
 
     DatabasePtr database = getDatabase();
     wxCHECK_RET(database,
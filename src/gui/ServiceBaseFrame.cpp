@@ -33,6 +33,8 @@
 #include <wx/timer.h>
 #include <wx/wupdlock.h>
 
+#include <algorithm>
+
 #include <ibpp.h>
 
 #include "config/Config.h"
@@ -48,13 +50,17 @@
 
 ServiceBaseFrame::ServiceBaseFrame(wxWindow* parent,
         DatabasePtr db)
-    : BaseFrame(parent, wxID_ANY, wxEmptyString), databaseM(db), threadM(0)
+    : BaseFrame(parent, wxID_ANY, wxEmptyString), databaseM(db), threadM(0),
+        msgsStartM(0)
 {
     wxASSERT(db);
     db->attachObserver(this, false);
 
     threadMsgTimeMillisM = 0;
     verboseMsgsM = true;
+    // verbose output of a restore can have millions of lines, so only the
+    // last lines are kept
+    maxMsgsM = std::max(100, config().get("ServiceLogMaxLines", 10000));
 
     SetIcon(wxArtProvider::GetIcon(ART_Backup, wxART_FRAME_ICON));
 
@@ -64,20 +70,67 @@ ServiceBaseFrame::ServiceBaseFrame(wxWindow* parent,
 void ServiceBaseFrame::addThreadMsg(const wxString msg,
     bool& notificationNeeded)
 {
-    notificationNeeded = false;
-    wxLongLong millisNow = ::wxGetLocalTimeMillis();
-
     wxCriticalSectionLocker locker(critsectM);
+    notificationNeeded = queueThreadMsg(msg);
+}
+
+// critsectM has to be locked by the caller
+bool ServiceBaseFrame::queueThreadMsg(const wxString& msg)
+{
+    // all messages are queued, the statistics parsers need every line;
+    // only the shown log is limited to the last maxMsgsM lines, and the
+    // thread waits while too many lines are queued
     threadMsgsM.Add(msg);
+
     // we post no more than 10 events per second to prevent flooding of
     // the message queue, and to keep the frame responsive for user interaction
+    wxLongLong millisNow = ::wxGetLocalTimeMillis();
     if ((millisNow - threadMsgTimeMillisM).GetLo() > 100)
     {
         threadMsgTimeMillisM = millisNow;
-        notificationNeeded = true;
+        return true;
+    }
+    return false;
+}
+
+size_t ServiceBaseFrame::getQueuedThreadMsgCount()
+{
+    wxCriticalSectionLocker locker(critsectM);
+    return threadMsgsM.GetCount();
+}
+
+void ServiceBaseFrame::threadMsgsReceived(
+    const std::vector<LogMsg>& WXUNUSED(msgs))
+{
+}
+
+void ServiceBaseFrame::threadFinished()
+{
+}
+
+void ServiceBaseFrame::addMsg(const wxString& text, MsgKind kind)
+{
+    LogMsg msg = { text, kind };
+    if (msgsM.size() < maxMsgsM)
+        msgsM.push_back(msg);
+    else
+    {
+        // buffer is full, overwrite the oldest message
+        msgsM[msgsStartM] = msg;
+        msgsStartM = (msgsStartM + 1) % msgsM.size();
     }
 }
 
+const ServiceBaseFrame::LogMsg& ServiceBaseFrame::getMsg(size_t index) const
+{
+    return msgsM[(msgsStartM + index) % msgsM.size()];
+}
+
+size_t ServiceBaseFrame::getMsgCount() const
+{
+    return msgsM.size();
+}
+
 void ServiceBaseFrame::cancelThread()
 {
     if (threadM != 0)
@@ -89,8 +142,8 @@ void ServiceBaseFrame::cancelThread()
 
 void ServiceBaseFrame::clearLog()
 {
-    msgKindsM.Clear();
-    msgsM.Clear();
+    msgsM.clear();
+    msgsStartM = 0;
     text_ctrl_log->ClearAll();
 }
 
@@ -138,26 +191,57 @@ bool ServiceBaseFrame::startThread(std::unique_ptr<wxThread> thread)
     return true;
 }
 
-void ServiceBaseFrame::threadOutputMsg(const wxString msg, MsgKind kind)
+static wxChar getMsgKindPrefix(ServiceBaseFrame::MsgKind kind)
 {
-    wxString s(msg);
     switch (kind)
     {
-    case error_message:
-        s.Prepend("e");
-        break;
-    case important_message:
-        s.Prepend("i");
-        break;
-    case progress_message:
-        s.Prepend("p");
-        break;
-    default:
+    case ServiceBaseFrame::error_message:
+        return 'e';
+    case ServiceBaseFrame::important_message:
+        return 'i';
+    case ServiceBaseFrame::progress_message:
+        return 'p';
+    }
+    return 0;
+}
+
+void ServiceBaseFrame::threadOutputMsg(const wxString msg, MsgKind kind)
+{
+    wxChar prefix = getMsgKindPrefix(kind);
+    if (!prefix)
+    {
         wxASSERT(false);
         return;
     }
     bool doPostMsg = false;
-    addThreadMsg(s, doPostMsg);
+    addThreadMsg(prefix + msg, doPostMsg);
+    if (doPostMsg)
+    {
+        wxCommandEvent event(wxEVT_COMMAND_MENU_SELECTED, ID_thread_output);
+        wxPostEvent(this, event);
+    }
+}
+
+void ServiceBaseFrame::threadOutputMsgs(const std::vector<std::string>& msgs,
+    MsgKind kind)
+{
+    wxChar prefix = getMsgKindPrefix(kind);
+    if (!prefix)
+    {
+        wxASSERT(false);
+        return;
+    }
+    bool doPostMsg = false;
+    {
+        // queue the whole batch with a single lock
+        wxCriticalSectionLocker locker(critsectM);
+        for (std::vector<std::string>::const_iterator it = msgs.begin();
+            it != msgs.end(); ++it)
+        {
+            if (queueThreadMsg(prefix + wxString(*it)))
+                doPostMsg = true;
+        }
+    }
     if (doPostMsg)
     {
         wxCommandEvent event(wxEVT_COMMAND_MENU_SELECTED, ID_thread_output);
@@ -174,6 +258,7 @@ void ServiceBaseFrame::createControls()
         _("&Start Backup"));
 
     text_ctrl_log = new LogTextControl(this, ID_text_ctrl_log);
+    text_ctrl_log->setMaxLines(maxMsgsM);
 
 }
 
@@ -212,24 +297,31 @@ void ServiceBaseFrame::updateControls()
 
 void ServiceBaseFrame::updateMessages(size_t firstmsg, size_t lastmsg)
 {
-    if (lastmsg > msgsM.GetCount())
-        lastmsg = msgsM.GetCount();
+    if (lastmsg > getMsgCount())
+        lastmsg = getMsgCount();
+    // consecutive progress messages are appended to the control in one go
+    wxString progress;
     for (size_t i = firstmsg; i < lastmsg; i++)
     {
-        switch ((MsgKind)msgKindsM[i])
+        const LogMsg& msg = getMsg(i);
+        if (msg.kind == progress_message)
         {
-            case progress_message:
-                if (verboseMsgsM)
-                    text_ctrl_log->logMsg(msgsM[i]);
-                break;
-            case important_message:
-                text_ctrl_log->logImportantMsg(msgsM[i]);
-                break;
-            case error_message:
-                text_ctrl_log->logErrorMsg(msgsM[i]);
-                break;
+            if (verboseMsgsM)
+                progress += msg.text;
+            continue;
         }
+        if (!progress.empty())
+        {
+            text_ctrl_log->logMsg(progress);
+            progress.clear();
+        }
+        if (msg.kind == important_message)
+            text_ctrl_log->logImportantMsg(msg.text);
+        else
+            text_ctrl_log->logErrorMsg(msg.text);
     }
+    if (!progress.empty())
+        text_ctrl_log->logMsg(progress);
 }
 
 
@@ -249,6 +341,7 @@ void ServiceBaseFrame::OnThreadFinished(wxCommandEvent& event)
 {
     threadM = 0;
     OnThreadOutput(event);
+    threadFinished();
     updateControls();
 }
 
@@ -257,32 +350,51 @@ void ServiceBaseFrame::OnThreadOutput(wxCommandEvent& WXUNUSED(event))
     wxCriticalSectionLocker locker(critsectM);
     threadMsgTimeMillisM = ::wxGetLocalTimeMillis();
 
-    size_t first = msgsM.GetCount();
+    std::vector<LogMsg> batch;
+    batch.reserve(threadMsgsM.GetCount());
     for (size_t i = 0; i < threadMsgsM.GetCount(); i++)
     {
         wxString s(threadMsgsM[i]);
         if (s.Length() == 0)
             continue;
+        MsgKind kind;
         switch ((wxChar)s[0])
         {
             case 'e':
-                msgKindsM.Add((int)error_message);
+                kind = error_message;
                 break;
             case 'i':
-                msgKindsM.Add((int)important_message);
+                kind = important_message;
                 break;
             case 'p':
-                msgKindsM.Add((int)progress_message);
+                kind = progress_message;
                 break;
+            default:
+                continue;
         }
         // this depends on server type, so just in case...
         if (s.Last() != '\n')
             s.Append('\n');
-        msgsM.Add(s.Mid(1));
+        LogMsg msg = { s.Mid(1), kind };
+        batch.push_back(msg);
     }
     threadMsgsM.Clear();
 
-    updateMessages(first, msgsM.GetCount());
+    threadMsgsReceived(batch);
+    // older messages of a large batch would be pushed out of the buffer
+    // by the newer ones anyway
+    std::vector<LogMsg>::const_iterator first = batch.begin();
+    if (batch.size() > maxMsgsM)
+        first += batch.size() - maxMsgsM;
+    for (std::vector<LogMsg>::const_iterator it = first;
+        it != batch.end(); ++it)
+    {
+        addMsg((*it).text, (*it).kind);
+    }
+
+    // older messages of this batch may already be gone from the buffer
+    size_t count = getMsgCount();
+    updateMessages(count - std::min(batch.size(), count), count);
 }
 
 ServiceThread::ServiceThread(ServiceBaseFrame* frame, wxString server,
@@ -314,6 +426,7 @@ void* ServiceThread::Entry()
         msg.Printf(_("Database restore started %s"), now.FormatTime().c_str());
         logImportant(msg);
         Execute(svc);
+        std::vector<std::string> lines;
         while (true)
         {
             if (TestDestroy())
@@ -324,8 +437,12 @@ void* ServiceThread::Entry()
                 logImportant(msg);
                 break;
             }
-            const char* c = svc->WaitMsg();
-            if (c == 0)
+            // fetch all available output at once instead of line by line
+            lines.clear();
+            bool running = svc->WaitMsgs(lines);
+            if (!lines.empty())
+                logProgress(lines);
+            if (!running)
             {
                 now = wxDateTime::Now();
                 msg.Printf(_("Database restore finished %s"),
@@ -333,8 +450,6 @@ void* ServiceThread::Entry()
                 logImportant(msg);
                 break;
             }
-            msg = c;
-            logProgress(msg);
         }
         svc->Disconnect();
     }
@@ -386,3 +501,25 @@ void ServiceThread::logProgress(wxString& msg)
 
 }
 
+void ServiceThread::logProgress(const std::vector<std::string>& msgs)
+{
+    if (frameM == 0)
+        return;
+    frameM->threadOutputMsgs(msgs, ServiceBaseFrame::progress_message);
+
+    // the statistics parsers need every line, so instead of dropping lines
+    // the thread waits while the frame is too busy to process them
+    const size_t maxQueuedMsgs = 10000;
+    if (frameM->getQueuedThreadMsgCount() > maxQueuedMsgs)
+    {
+        wxCommandEvent event(wxEVT_COMMAND_MENU_SELECTED,
+            ServiceBaseFrame::ID_thread_output);
+        wxPostEvent(frameM, event);
+        while (frameM->getQueuedThreadMsgCount() > maxQueuedMsgs
+            && !TestDestroy())
+        {
+            Sleep(10);
+        }
+    }
+}
+
@@ -29,6 +29,7 @@
 #include <wx/thread.h>
 
 #include <memory>
+#include <vector>
 
 #include "core/Observer.h"
 #include "gui/BaseFrame.h"
@@ -61,8 +62,12 @@ protected:
         ID_button_start
     };
 
-    wxArrayString msgsM;
-    wxArrayInt msgKindsM;
+    struct LogMsg
+    {
+        wxString text;
+        MsgKind kind;
+    };
+
     bool verboseMsgsM;
 
     DatabasePtr getDatabase() const;
@@ -75,12 +80,22 @@ protected:
     bool getThreadRunning() const;
 
     void threadOutputMsg(const wxString msg, MsgKind kind);
+    void threadOutputMsgs(const std::vector<std::string>& msgs,
+        MsgKind kind);
     virtual void createControls();
     virtual void layoutControls();
     virtual void updateControls();
 
     void addThreadMsg(const wxString msg, bool& notificationNeeded);
+    // messages are kept in a ring buffer holding at most the last
+    // maxMsgsM messages, index 0 is the oldest message still kept
+    size_t getMsgCount() const;
     void updateMessages(size_t firstmsg, size_t lastmsg);
+    // called for every batch of messages received from the thread, before
+    // they are added to the message buffer
+    virtual void threadMsgsReceived(const std::vector<LogMsg>& msgs);
+    // called after the thread has finished and its output was processed
+    virtual void threadFinished();
 
 
     ServiceBaseFrame(wxWindow* parent, DatabasePtr db);
@@ -88,9 +103,18 @@ private:
     DatabaseWeakPtr databaseM;
     wxThread* threadM;
 
+    std::vector<LogMsg> msgsM;
+    size_t msgsStartM;
+    size_t maxMsgsM;
+    void addMsg(const wxString& text, MsgKind kind);
+    const LogMsg& getMsg(size_t index) const;
+
     wxCriticalSection critsectM;
     wxArrayString threadMsgsM;
     wxLongLong threadMsgTimeMillisM;
+    bool queueThreadMsg(const wxString& msg);
+    // number of messages queued by the thread but not processed yet
+    size_t getQueuedThreadMsgCount();
 
     // observer stuff
     virtual void subjectRemoved(Subject* subject);
@@ -141,6 +165,7 @@ private:
     void logError(wxString& msg);
     void logImportant(wxString& msg);
     void logProgress(wxString& msg);
+    void logProgress(const std::vector<std::string>& msgs);
 };
 
 #endif // SERVICEBASEFRAME_H
@@ -174,7 +174,7 @@ void ShutdownStartupBaseFrame::OnVerboseLogChange(wxCommandEvent& WXUNUSED(event
     wxWindowUpdateLocker freeze(text_ctrl_log);
 
     text_ctrl_log->ClearAll();
-    updateMessages(0, msgsM.GetCount());
+    updateMessages(0, getMsgCount());
 }
 
 ShutdownStartupThread::ShutdownStartupThread(ShutdownStartupBaseFrame* frame, 
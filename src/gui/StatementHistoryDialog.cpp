@@ -30,6 +30,8 @@
 #include <wx/splitter.h>
 #include <wx/stc/stc.h>
 
+#include <vector>
+
 #include "statementHistory.h"
 #include "config/Config.h"
 #include "gui/StatementHistoryDialog.h"
@@ -206,12 +208,17 @@ void StatementHistoryDialog::OnButtonSearchClick(wxCommandEvent&
 
     // start the search
     listbox_search->Clear();
-    wxString searchString = textctrl_search->GetValue().Upper();
     setSearching(true);
-    StatementHistory::Position total = historyM->size();
-    gauge_progress->SetRange((int)total);
-    wxString last = wxEmptyString;
-    for (StatementHistory::Position p = total - 1; (int)p >= 0; --p)
+    std::vector<StatementHistory::Position> found;
+    {
+        wxBusyCursor bc;
+        found = historyM->search(textctrl_search->GetValue());
+    }
+
+    // add the found items in chunks, the list can become very long
+    const size_t chunkSize = 500;
+    gauge_progress->SetRange((int)found.size());
+    for (size_t i = 0; i < found.size(); i += chunkSize)
     {
         wxYield();
         if (!isSearchingM)
@@ -220,19 +227,20 @@ void StatementHistoryDialog::OnButtonSearchClick(wxCommandEvent&
             return;
         }
 
-        gauge_progress->SetValue((int)(total - p - 1));
-        wxString s(historyM->get(p));
-        if (s == last)  // ignore duplicates
-            continue;
-        last = s;
-        if (searchString.IsEmpty() || s.Upper().Contains(searchString))
+        gauge_progress->SetValue((int)i);
+        wxArrayString entries;
+        std::vector<void*> positions;
+        for (size_t j = i; j < found.size() && j < i + chunkSize; ++j)
         {
+            wxString s(historyM->get(found[j]));
             wxString entry;
             entry = (s.Length() > 200) ? s.Mid(0, 200) + "..." : s;
             entry.Replace("\n", " ");
             entry.Replace("\r", wxEmptyString);
-            listbox_search->Append(entry, (void *)p);
+            entries.Add(entry);
+            positions.push_back((void *)found[j]);
         }
+        listbox_search->Append(entries, &positions[0]);
     }
     setSearching(false);
     gauge_progress->SetValue(0);
@@ -0,0 +1,386 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/datetime.h>
+#include <wx/dcbuffer.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "config/Config.h"
+#include "core/URIProcessor.h"
+#include "engine/TransactionGapSampler.h"
+#include "gui/GUIURIHandlerHelper.h"
+#include "gui/MonitoringFrame.h"
+#include "gui/StyleGuide.h"
+#include "gui/TransactionGapFrame.h"
+#include "metadata/database.h"
+#include "metadata/MetadataItemURIHandlerHelper.h"
+
+// draws both transaction gaps over time, with the alert threshold
+class TransactionGapChart: public wxPanel
+{
+private:
+    const std::deque<TransactionGapSample>* samplesM;
+    int thresholdM;
+
+    void OnPaint(wxPaintEvent& event);
+public:
+    TransactionGapChart(wxWindow* parent);
+    void setSamples(const std::deque<TransactionGapSample>* samples,
+        int threshold);
+};
+
+TransactionGapChart::TransactionGapChart(wxWindow* parent)
+    : wxPanel(parent, wxID_ANY, wxDefaultPosition, wxSize(400, 200),
+        wxBORDER_THEME | wxFULL_REPAINT_ON_RESIZE),
+    samplesM(0), thresholdM(0)
+{
+    SetBackgroundStyle(wxBG_STYLE_PAINT);
+    Bind(wxEVT_PAINT, &TransactionGapChart::OnPaint, this);
+}
+
+void TransactionGapChart::setSamples(
+    const std::deque<TransactionGapSample>* samples, int threshold)
+{
+    samplesM = samples;
+    thresholdM = threshold;
+    Refresh();
+}
+
+void TransactionGapChart::OnPaint(wxPaintEvent& WXUNUSED(event))
+{
+    wxAutoBufferedPaintDC dc(this);
+    dc.SetBackground(*wxWHITE_BRUSH);
+    dc.Clear();
+    dc.SetFont(GetFont());
+
+    if (!samplesM || samplesM->empty())
+    {
+        dc.DrawText(_("No transaction counters recorded yet."), 10, 10);
+        return;
+    }
+
+    int maxValue = std::max(thresholdM, 1);
+    for (std::deque<TransactionGapSample>::const_iterator it =
+        samplesM->begin(); it != samplesM->end(); ++it)
+    {
+        maxValue = std::max(maxValue, (*it).getActiveGap());
+        maxValue = std::max(maxValue, (*it).getInterestingGap());
+    }
+    // leave some room above the highest value
+    double maxY = maxValue * 1.1;
+
+    wxSize size(GetClientSize());
+    wxCoord textWidth, textHeight;
+    dc.GetTextExtent(wxString::Format("%d", maxValue), &textWidth,
+        &textHeight);
+    wxRect plot(textWidth + 10, textHeight + 10,
+        size.GetWidth() - textWidth - 20,
+        size.GetHeight() - 2 * textHeight - 20);
+    if (plot.GetWidth() < 10 || plot.GetHeight() < 10)
+        return;
+
+    std::time_t first = samplesM->front().time;
+    std::time_t last = samplesM->back().time;
+    double span = std::max<double>(1.0, double(last - first));
+
+    dc.SetPen(*wxLIGHT_GREY_PEN);
+    dc.DrawRectangle(plot);
+    dc.SetTextForeground(*wxBLACK);
+    dc.DrawText(wxString::Format("%d", maxValue), 5,
+        plot.GetBottom() - int(plot.GetHeight() * maxValue / maxY)
+        - textHeight / 2);
+    dc.DrawText("0", 5, plot.GetBottom() - textHeight / 2);
+    dc.DrawText(wxDateTime(first).FormatTime(), plot.GetLeft(),
+        plot.GetBottom() + 5);
+    wxString lastTime(wxDateTime(last).FormatTime());
+    dc.GetTextExtent(lastTime, &textWidth, &textHeight);
+    dc.DrawText(lastTime, plot.GetRight() - textWidth, plot.GetBottom() + 5);
+
+    if (thresholdM > 0)
+    {
+        int y = plot.GetBottom() - int(plot.GetHeight() * thresholdM / maxY);
+        dc.SetPen(wxPen(*wxRED, 1, wxPENSTYLE_SHORT_DASH));
+        dc.DrawLine(plot.GetLeft(), y, plot.GetRight(), y);
+    }
+
+    std::vector<wxPoint> active, interesting;
+    for (std::deque<TransactionGapSample>::const_iterator it =
+        samplesM->begin(); it != samplesM->end(); ++it)
+    {
+        int x = plot.GetLeft()
+            + int(plot.GetWidth() * double((*it).time - first) / span);
+        active.push_back(wxPoint(x, plot.GetBottom()
+            - int(plot.GetHeight() * (*it).getActiveGap() / maxY)));
+        interesting.push_back(wxPoint(x, plot.GetBottom()
+            - int(plot.GetHeight() * (*it).getInterestingGap() / maxY)));
+    }
+    wxColour activeColour(0, 0, 192), interestingColour(0, 128, 0);
+    dc.SetPen(wxPen(activeColour, 2));
+    dc.DrawLines(int(active.size()), &active[0]);
+    dc.SetPen(wxPen(interestingColour, 2));
+    dc.DrawLines(int(interesting.size()), &interesting[0]);
+
+    // legend
+    dc.SetTextForeground(activeColour);
+    wxString legend(_("Next - oldest active"));
+    dc.DrawText(legend, plot.GetLeft(), 5);
+    dc.GetTextExtent(legend, &textWidth, &textHeight);
+    dc.SetTextForeground(interestingColour);
+    dc.DrawText(_("Oldest active - oldest interesting"),
+        plot.GetLeft() + textWidth + 20, 5);
+}
+
+TransactionGapFrame::TransactionGapFrame(wxWindow* parent, DatabasePtr db)
+    : BaseFrame(parent, -1, wxEmptyString), databaseM(db),
+        samplerM(db->getTransactionGapSampler())
+{
+    setIdString(this, getFrameId(db));
+    // observe database object to close when it is removed, and the
+    // sampler for new samples
+    db->attachObserver(this, false);
+    samplerM->attachObserver(this, false);
+    SetTitle(wxString::Format(_("Transaction Gaps of Database: %s"),
+        db->getName_().c_str()));
+
+    createControls();
+    layoutControls();
+    updateControls();
+
+    #include "new.xpm"
+    wxBitmap bmp(new_xpm);
+    wxIcon icon;
+    icon.CopyFromBitmap(bmp);
+    SetIcon(icon);
+}
+
+void TransactionGapFrame::createControls()
+{
+    panel_controls = new wxPanel(this, -1, wxDefaultPosition, wxDefaultSize,
+        wxTAB_TRAVERSAL | wxCLIP_CHILDREN);
+    static_text_counters = new wxStaticText(panel_controls, wxID_ANY,
+        wxEmptyString);
+    static_text_gaps = new wxStaticText(panel_controls, wxID_ANY,
+        wxEmptyString);
+    static_text_alert = new wxStaticText(panel_controls, wxID_ANY,
+        wxEmptyString);
+    static_text_alert->SetForegroundColour(*wxRED);
+    chart_gaps = new TransactionGapChart(panel_controls);
+    button_oldest_active = new wxButton(panel_controls,
+        ID_button_oldest_active, _("Show Oldest Active &Transaction"));
+}
+
+void TransactionGapFrame::layoutControls()
+{
+    wxBoxSizer* sizerButtons = new wxBoxSizer(wxHORIZONTAL);
+    sizerButtons->Add(static_text_alert, 1, wxALIGN_CENTER_VERTICAL);
+    sizerButtons->AddSpacer(
+        styleguide().getUnrelatedControlMargin(wxHORIZONTAL));
+    sizerButtons->Add(button_oldest_active);
+
+    wxBoxSizer* sizerPanelV = new wxBoxSizer(wxVERTICAL);
+    sizerPanelV->AddSpacer(styleguide().getFrameMargin(wxTOP));
+    sizerPanelV->Add(static_text_counters, 0, wxEXPAND);
+    sizerPanelV->AddSpacer(styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(static_text_gaps, 0, wxEXPAND);
+    sizerPanelV->AddSpacer(styleguide().getRelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(chart_gaps, 1, wxEXPAND);
+    sizerPanelV->AddSpacer(styleguide().getUnrelatedControlMargin(wxVERTICAL));
+    sizerPanelV->Add(sizerButtons, 0, wxEXPAND);
+    sizerPanelV->AddSpacer(styleguide().getFrameMargin(wxBOTTOM));
+
+    wxBoxSizer* sizerPanelH = new wxBoxSizer(wxHORIZONTAL);
+    sizerPanelH->AddSpacer(styleguide().getFrameMargin(wxLEFT));
+    sizerPanelH->Add(sizerPanelV, 1, wxEXPAND);
+    sizerPanelH->AddSpacer(styleguide().getFrameMargin(wxRIGHT));
+
+    wxBoxSizer* sizerAll = new wxBoxSizer(wxHORIZONTAL);
+    sizerAll->Add(sizerPanelH, 1, wxEXPAND);
+
+    panel_controls->SetSizer(sizerAll);
+    sizerAll->Fit(this);
+    sizerAll->SetSizeHints(this);
+}
+
+void TransactionGapFrame::updateControls()
+{
+    DatabasePtr db = getDatabase();
+    const std::deque<TransactionGapSample>& samples = samplerM->getSamples();
+    int threshold = config().get("TransactionGapAlertThreshold", 10000);
+    chart_gaps->setSamples(&samples, threshold);
+
+    wxString alert;
+    if (samples.empty())
+    {
+        static_text_counters->SetLabel(wxEmptyString);
+        static_text_gaps->SetLabel(wxEmptyString);
+    }
+    else
+    {
+        const TransactionGapSample& last = samples.back();
+        static_text_counters->SetLabel(wxString::Format(
+            _("%s: oldest transaction %d, oldest active %d, oldest snapshot %d, next transaction %d"),
+            wxDateTime(last.time).FormatTime().c_str(), last.oldest,
+            last.oldestActive, last.oldestSnapshot, last.next));
+        static_text_gaps->SetLabel(wxString::Format(
+            _("Next - oldest active: %d, oldest active - oldest interesting: %d"),
+            last.getActiveGap(), last.getInterestingGap()));
+        if (threshold > 0 && (last.getActiveGap() > threshold
+            || last.getInterestingGap() > threshold))
+        {
+            alert = wxString::Format(
+                _("A transaction gap exceeds %d transactions."), threshold);
+        }
+    }
+
+    if (!errorM.IsEmpty())
+        alert = _("Recording stopped: ") + errorM;
+    else if (!db || !db->isConnected())
+        alert = _("Not recording, the database is not connected.");
+    else if (!samplerM->isRunning())
+        alert = _("Recording is turned off in the preferences.");
+    static_text_alert->SetLabel(alert);
+
+    button_oldest_active->Enable(db && db->isConnected() && !samples.empty());
+    panel_controls->Layout();
+}
+
+DatabasePtr TransactionGapFrame::getDatabase() const
+{
+    return databaseM.lock();
+}
+
+//! closes window if database is removed (unregistered)
+void TransactionGapFrame::subjectRemoved(Subject* subject)
+{
+    DatabasePtr db = getDatabase();
+    if (!db || subject == db.get() || subject == samplerM.get())
+        Close();
+}
+
+void TransactionGapFrame::update()
+{
+    std::string error(samplerM->takeError());
+    if (!error.empty())
+        errorM = wxString(error.c_str(), *wxConvCurrent);
+    else if (samplerM->isRunning())
+        errorM.clear();
+    updateControls();
+}
+
+const wxString TransactionGapFrame::getName() const
+{
+    return "TransactionGapFrame";
+}
+
+const wxRect TransactionGapFrame::getDefaultRect() const
+{
+    return wxRect(-1, -1, 700, 450);
+}
+
+wxString TransactionGapFrame::getFrameId(DatabasePtr db)
+{
+    if (db)
+        return wxString("TransactionGapFrame/" + db->getItemPath());
+    else
+        return wxEmptyString;
+}
+
+TransactionGapFrame* TransactionGapFrame::findFrameFor(DatabasePtr db)
+{
+    BaseFrame* bf = frameFromIdString(getFrameId(db));
+    if (!bf)
+        return 0;
+    return dynamic_cast<TransactionGapFrame*>(bf);
+}
+
+BEGIN_EVENT_TABLE(TransactionGapFrame, wxFrame)
+    EVT_BUTTON(TransactionGapFrame::ID_button_oldest_active, TransactionGapFrame::OnButtonOldestActiveClick)
+END_EVENT_TABLE()
+
+void TransactionGapFrame::OnButtonOldestActiveClick(
+    wxCommandEvent& WXUNUSED(event))
+{
+    DatabasePtr db = getDatabase();
+    const std::deque<TransactionGapSample>& samples = samplerM->getSamples();
+    if (!db || !db->isConnected() || samples.empty())
+        return;
+
+    MonitoringFrame* mf = MonitoringFrame::findFrameFor(db);
+    if (mf)
+        mf->Raise();
+    else
+    {
+        mf = new MonitoringFrame(GetParent(), db);
+        mf->Show();
+    }
+    mf->showTransaction(samples.back().oldestActive);
+}
+
+class TransactionGapsHandler: public URIHandler,
+    private MetadataItemURIHandlerHelper, private GUIURIHandlerHelper
+{
+public:
+    TransactionGapsHandler() {}
+    bool handleURI(URI& uri);
+private:
+    // singleton; registers itself on creation.
+    static const TransactionGapsHandler handlerInstance;
+};
+
+const TransactionGapsHandler TransactionGapsHandler::handlerInstance;
+
+bool TransactionGapsHandler::handleURI(URI& uri)
+{
+    if (uri.action != "transaction_gaps")
+        return false;
+
+    DatabasePtr db = extractMetadataItemPtrFromURI<Database>(uri);
+    wxWindow* w = getParentWindow(uri);
+    if (!db || !w)
+        return true;
+
+    TransactionGapFrame* f = TransactionGapFrame::findFrameFor(db);
+    if (f)
+        f->Raise();
+    else
+    {
+        f = new TransactionGapFrame(w, db);
+        f->Show();
+    }
+    // sent by the database when a gap exceeds the alert threshold
+    if (uri.getParam("alert") == "1")
+        f->RequestUserAttention();
+    return true;
+}
@@ -0,0 +1,86 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_TRANSACTIONGAPFRAME_H
+#define FR_TRANSACTIONGAPFRAME_H
+
+#include <wx/wx.h>
+
+#include <memory>
+
+#include "core/Observer.h"
+#include "gui/BaseFrame.h"
+#include "metadata/database.h"
+#include "metadata/MetadataClasses.h"
+
+class TransactionGapChart;
+class TransactionGapSampler;
+
+// Shows the recorded transaction counters of a database as a chart of the
+// gaps between next, oldest active and oldest interesting transaction, and
+// leads to the oldest active transaction in the monitoring frame.
+class TransactionGapFrame : public BaseFrame, public Observer
+{
+private:
+    DatabaseWeakPtr databaseM;
+    std::shared_ptr<TransactionGapSampler> samplerM;
+    wxString errorM;
+
+    wxPanel* panel_controls;
+    wxStaticText* static_text_counters;
+    wxStaticText* static_text_gaps;
+    wxStaticText* static_text_alert;
+    TransactionGapChart* chart_gaps;
+    wxButton* button_oldest_active;
+    void createControls();
+    void layoutControls();
+    void updateControls();
+
+    static wxString getFrameId(DatabasePtr db);
+
+    DatabasePtr getDatabase() const;
+
+    // observer stuff
+    virtual void subjectRemoved(Subject* subject);
+    virtual void update();
+
+protected:
+    virtual const wxString getName() const;
+    virtual const wxRect getDefaultRect() const;
+public:
+    TransactionGapFrame(wxWindow* parent, DatabasePtr db);
+
+    static TransactionGapFrame* findFrameFor(DatabasePtr db);
+private:
+    // event handling
+    enum
+    {
+        ID_button_oldest_active = 101
+    };
+
+    void OnButtonOldestActiveClick(wxCommandEvent& event);
+
+    DECLARE_EVENT_TABLE()
+};
+
+#endif // FR_TRANSACTIONGAPFRAME_H
@@ -124,7 +124,7 @@ void DataGrid::extendSelection(int direction)
     }
 }
 
-void DataGrid::fetchData(bool readonly)
+void DataGrid::fetchData(bool readonly, bool scrollable)
 {
     DataGridTable* table = getDataGridTable();
     if (!table)
@@ -132,7 +132,8 @@ void DataGrid::fetchData(bool readonly)
 
     wxBusyCursor bc;
     BeginBatch();
-    table->initialFetch(readonly);
+    table->setBlobPreviewHandler(this);
+    table->initialFetch(readonly, scrollable);
 
     for (int i = 0; i < table->GetNumberCols(); i++)
     {
@@ -140,7 +141,7 @@ void DataGrid::fetchData(bool readonly)
         ca->SetAlignment(
             (table->isNumericColumn(i)) ? wxALIGN_RIGHT : wxALIGN_LEFT,
             wxALIGN_TOP);
-        if (readonly || table->isReadonlyColumn(i) || table->isBlobColumn(i))
+        if (table->isReadonlyColumn(i) || table->isBlobColumn(i))
         {
             ca->SetReadOnly(true);
             ca->SetBackgroundColour(frlayoutconfig().getReadonlyColour());
@@ -965,6 +966,7 @@ wxGridCellCoordsArray DataGrid::getSelectedCells()
 }
 
 BEGIN_EVENT_TABLE(DataGrid, wxGrid)
+    EVT_COMMAND(wxID_ANY, wxEVT_FRDG_BLOBPREVIEWS, DataGrid::OnBlobPreviews)
     EVT_CONTEXT_MENU(DataGrid::OnContextMenu)
     EVT_GRID_CELL_RIGHT_CLICK(DataGrid::OnGridCellRightClick)
     EVT_GRID_LABEL_RIGHT_CLICK(DataGrid::OnGridLabelRightClick)
@@ -1080,6 +1082,13 @@ void DataGrid::OnEditorKeyDown(wxKeyEvent& event)
     event.Skip();
 }
 
+void DataGrid::OnBlobPreviews(wxCommandEvent& WXUNUSED(event))
+{
+    DataGridTable* table = getDataGridTable();
+    if (table && table->applyBlobPreviews())
+        ForceRefresh();
+}
+
 void DataGrid::OnContextMenu(wxContextMenuEvent& event)
 {
     if (IsCellEditControlEnabled())
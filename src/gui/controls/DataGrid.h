@@ -54,8 +54,9 @@ public:
     ~DataGrid();
 
     DataGridTable* getDataGridTable();
-    void fetchData(bool readonly);
+    void fetchData(bool readonly, bool scrollable = false);
 private:
+    void OnBlobPreviews(wxCommandEvent& event);
     void OnContextMenu(wxContextMenuEvent& event);
     void OnGridCellRightClick(wxGridEvent& event);
     void OnGridCellSelected(wxGridEvent& event);
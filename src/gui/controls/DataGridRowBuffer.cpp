@@ -30,6 +30,8 @@
     #include "wx/wx.h"
 #endif
 
+#include <cstring>
+
 #include "gui/controls/DataGridRowBuffer.h"
 
 // Time + timestamp internal struct
@@ -292,6 +294,111 @@ bool DataGridRowBuffer::isInserted()
     return false;
 }
 
+static void appendUInt32(std::string& dest, uint32_t value)
+{
+    dest.append((const char*)&value, sizeof(value));
+}
+
+static uint32_t readUInt32(const char*& source)
+{
+    uint32_t value;
+    memcpy(&value, source, sizeof(value));
+    source += sizeof(value);
+    return value;
+}
+
+size_t DataGridRowBuffer::getMemorySize()
+{
+    size_t size = sizeof(*this)
+        + fieldAttrM.capacity() * sizeof(DataGridRowBufferFieldAttr)
+        + dataM.capacity() + stringsM.capacity() * sizeof(wxString)
+        + blobsM.capacity() * sizeof(IBPP::Blob);
+    for (std::vector<wxString>::iterator it = stringsM.begin();
+        it != stringsM.end(); ++it)
+    {
+        size += ((*it).length() + 1) * sizeof(wxStringCharType);
+    }
+    return size;
+}
+
+void DataGridRowBuffer::save(std::string& dest,
+    std::vector<IBPP::Blob>& blobs)
+{
+    // the type is needed to create the buffer again
+    dest += char(isInserted() ? 1 : 0);
+    saveContents(dest, blobs);
+}
+
+DataGridRowBuffer* DataGridRowBuffer::load(const char*& source,
+    std::vector<IBPP::Blob>& blobs)
+{
+    DataGridRowBuffer* buffer;
+    if (*source++ == 1)
+        buffer = new InsertedGridRowBuffer(0u);
+    else
+        buffer = new DataGridRowBuffer(0u);
+    buffer->loadContents(source, blobs);
+    return buffer;
+}
+
+void DataGridRowBuffer::saveContents(std::string& dest,
+    std::vector<IBPP::Blob>& blobs)
+{
+    dest += char(isModifiedM | isDeletedM << 1 | isDeletableIsSetM << 2
+        | isDeletableM << 3);
+    appendUInt32(dest, fieldAttrM.size());
+    for (std::vector<DataGridRowBufferFieldAttr>::iterator it =
+        fieldAttrM.begin(); it != fieldAttrM.end(); ++it)
+    {
+        dest += char((*it).isNull | (*it).isStringLoaded << 1);
+    }
+    appendUInt32(dest, dataM.size());
+    dest.append((const char*)dataM.data(), dataM.size());
+    appendUInt32(dest, stringsM.size());
+    for (std::vector<wxString>::iterator it = stringsM.begin();
+        it != stringsM.end(); ++it)
+    {
+        wxScopedCharBuffer utf8((*it).utf8_str());
+        appendUInt32(dest, utf8.length());
+        dest.append(utf8.data(), utf8.length());
+    }
+    // blob handles belong to the open transaction
+    blobs.swap(blobsM);
+    blobsM.clear();
+}
+
+void DataGridRowBuffer::loadContents(const char*& source,
+    std::vector<IBPP::Blob>& blobs)
+{
+    char flags = *source++;
+    isModifiedM = (flags & 1) != 0;
+    isDeletedM = (flags & 2) != 0;
+    isDeletableIsSetM = (flags & 4) != 0;
+    isDeletableM = (flags & 8) != 0;
+    fieldAttrM.resize(readUInt32(source));
+    for (std::vector<DataGridRowBufferFieldAttr>::iterator it =
+        fieldAttrM.begin(); it != fieldAttrM.end(); ++it)
+    {
+        char attr = *source++;
+        (*it).isNull = (attr & 1) != 0;
+        (*it).isStringLoaded = (attr & 2) != 0;
+    }
+    dataM.resize(readUInt32(source));
+    if (!dataM.empty())
+        memcpy(&dataM[0], source, dataM.size());
+    source += dataM.size();
+    stringsM.resize(readUInt32(source));
+    for (std::vector<wxString>::iterator it = stringsM.begin();
+        it != stringsM.end(); ++it)
+    {
+        uint32_t length = readUInt32(source);
+        *it = wxString::FromUTF8(source, length);
+        source += length;
+    }
+    blobsM.swap(blobs);
+    blobs.clear();
+}
+
 bool DataGridRowBuffer::isFieldModified(unsigned /*num*/)
 {
     // TODO: maintain on a per-field basis
@@ -352,6 +459,35 @@ bool InsertedGridRowBuffer::isInserted()
     return true;
 }
 
+size_t InsertedGridRowBuffer::getMemorySize()
+{
+    return DataGridRowBuffer::getMemorySize() + naFieldsM.capacity() / 8;
+}
+
+void InsertedGridRowBuffer::saveContents(std::string& dest,
+    std::vector<IBPP::Blob>& blobs)
+{
+    DataGridRowBuffer::saveContents(dest, blobs);
+    appendUInt32(dest, naFieldsM.size());
+    for (std::vector<bool>::iterator it = naFieldsM.begin();
+        it != naFieldsM.end(); ++it)
+    {
+        dest += char(*it ? 1 : 0);
+    }
+}
+
+void InsertedGridRowBuffer::loadContents(const char*& source,
+    std::vector<IBPP::Blob>& blobs)
+{
+    DataGridRowBuffer::loadContents(source, blobs);
+    naFieldsM.resize(readUInt32(source));
+    for (std::vector<bool>::iterator it = naFieldsM.begin();
+        it != naFieldsM.end(); ++it)
+    {
+        *it = (*source++ != 0);
+    }
+}
+
 bool InsertedGridRowBuffer::isFieldNA(unsigned num)
 {
     return (num < naFieldsM.size() && naFieldsM[num]);
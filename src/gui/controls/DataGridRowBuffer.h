@@ -24,6 +24,9 @@
 #ifndef FR_DATAGRIDROWBUFFER_H
 #define FR_DATAGRIDROWBUFFER_H
 
+#include <string>
+#include <vector>
+
 #include <ibpp.h>
 #include <core/FRInt128.h>
 #include <core/FRDecimal.h>
@@ -57,11 +60,23 @@ protected:
     std::vector<IBPP::Blob> blobsM;
     void invalidateIsDeletable();
     void setIsModified(bool value);
+    virtual void saveContents(std::string& dest,
+        std::vector<IBPP::Blob>& blobs);
+    virtual void loadContents(const char*& source,
+        std::vector<IBPP::Blob>& blobs);
 public:
     DataGridRowBuffer(unsigned fieldCount);
     DataGridRowBuffer(const DataGridRowBuffer* other);
     virtual ~DataGridRowBuffer() {}
 
+    // approximate memory used by the buffer, in bytes
+    virtual size_t getMemorySize();
+    // appends the contents to dest and moves the blob handles, which
+    // can't be written, to blobs; load() creates the buffer again
+    void save(std::string& dest, std::vector<IBPP::Blob>& blobs);
+    static DataGridRowBuffer* load(const char*& source,
+        std::vector<IBPP::Blob>& blobs);
+
     wxString getString(unsigned index);
     IBPP::Blob *getBlob(unsigned index);
     bool getValue(unsigned offset, double& value);
@@ -106,10 +121,16 @@ class InsertedGridRowBuffer: public DataGridRowBuffer
 {
 protected:
     std::vector<bool> naFieldsM;
+    virtual void saveContents(std::string& dest,
+        std::vector<IBPP::Blob>& blobs);
+    virtual void loadContents(const char*& source,
+        std::vector<IBPP::Blob>& blobs);
 public:
     InsertedGridRowBuffer(unsigned fieldCount);
     InsertedGridRowBuffer(const InsertedGridRowBuffer* other);
 
+    virtual size_t getMemorySize();
+
     virtual bool isInserted();
     virtual bool isFieldNA(unsigned num);
     virtual void setFieldNA(unsigned num, bool isNA);
@@ -0,0 +1,279 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/filename.h>
+
+#include "core/FRError.h"
+#include "gui/controls/DataGridRowBuffer.h"
+#include "gui/controls/DataGridRowStore.h"
+
+// rows are spilled and read back in pages of this size
+static const unsigned pageRows = 256;
+// number of pages read back from the file that are kept in memory
+static const size_t maxHotPages = 8;
+
+DataGridRowStore::Page::Page()
+    : rowCount(0), memorySize(0), hot(false), written(false), dirty(false),
+        offset(0), length(0), capacity(0)
+{
+}
+
+DataGridRowStore::DataGridRowStore()
+    : countM(0), nextSpillM(0), memoryM(0), budgetM(0),
+        spillingFailedM(false), fileEndM(0)
+{
+}
+
+DataGridRowStore::~DataGridRowStore()
+{
+    clear();
+}
+
+void DataGridRowStore::setMemoryBudget(size_t bytes)
+{
+    budgetM = bytes;
+}
+
+bool DataGridRowStore::empty()
+{
+    return countM == 0;
+}
+
+unsigned DataGridRowStore::size()
+{
+    return countM;
+}
+
+void DataGridRowStore::push_back(DataGridRowBuffer* buffer)
+{
+    if (pagesM.empty() || pagesM.back().rowCount == pageRows)
+    {
+        if (pagesM.size() == pagesM.capacity())
+            pagesM.reserve(pagesM.capacity() + 1024);
+        pagesM.push_back(Page());
+    }
+    Page& page = pagesM.back();
+    page.rows.push_back(buffer);
+    ++page.rowCount;
+    ++countM;
+    size_t bufferSize = buffer->getMemorySize();
+    page.memorySize += bufferSize;
+    memoryM += bufferSize;
+
+    // complete pages are spilled in the order they were fetched, the
+    // last one still gets new rows
+    while (budgetM && !spillingFailedM && memoryM > budgetM
+        && nextSpillM + 1 < pagesM.size())
+    {
+        if (!pagesM[nextSpillM].rows.empty() && !spillPage(nextSpillM))
+            break;
+        ++nextSpillM;
+    }
+}
+
+void DataGridRowStore::clear()
+{
+    for (std::vector<Page>::iterator it = pagesM.begin();
+        it != pagesM.end(); ++it)
+    {
+        freePage(*it);
+    }
+    pagesM.clear();
+    hotPagesM.clear();
+    countM = 0;
+    nextSpillM = 0;
+    memoryM = 0;
+    spillingFailedM = false;
+    if (fileM.IsOpened())
+    {
+        wxString fileName(fileM.GetName());
+        fileM.Close();
+        wxRemoveFile(fileName);
+    }
+    fileEndM = 0;
+}
+
+DataGridRowBuffer*& DataGridRowStore::operator[](unsigned row)
+{
+    wxASSERT(row < countM);
+    unsigned index = row / pageRows;
+    Page& page = pagesM[index];
+    if (page.rows.empty())
+        loadPage(index);
+    else if (page.hot)
+        touchPage(index);
+    page.dirty = true;
+    return page.rows[row % pageRows];
+}
+
+DataGridRowBuffer* DataGridRowStore::get(unsigned row)
+{
+    wxASSERT(row < countM);
+    unsigned index = row / pageRows;
+    Page& page = pagesM[index];
+    if (page.rows.empty())
+        loadPage(index);
+    else if (page.hot)
+        touchPage(index);
+    return page.rows[row % pageRows];
+}
+
+bool DataGridRowStore::isLoaded(unsigned row)
+{
+    return row < countM && !pagesM[row / pageRows].rows.empty();
+}
+
+void DataGridRowStore::freePage(Page& page)
+{
+    for (std::vector<DataGridRowBuffer*>::iterator it = page.rows.begin();
+        it != page.rows.end(); ++it)
+    {
+        delete (*it);
+    }
+    page.rows.clear();
+    page.blobs.clear();
+}
+
+void DataGridRowStore::loadPage(unsigned index)
+{
+    Page& page = pagesM[index];
+    std::string data(page.length, '\0');
+    if (!fileM.Seek(page.offset)
+        || fileM.Read(&data[0], page.length) != page.length)
+    {
+        throw FRError(_("Could not read the grid rows from the temporary file."));
+    }
+
+    const char* source = data.data();
+    page.rows.reserve(page.rowCount);
+    page.memorySize = 0;
+    for (unsigned i = 0; i < page.rowCount; ++i)
+    {
+        DataGridRowBuffer* buffer =
+            DataGridRowBuffer::load(source, page.blobs[i]);
+        page.rows.push_back(buffer);
+        page.memorySize += buffer->getMemorySize();
+    }
+    page.blobs.clear();
+    memoryM += page.memorySize;
+    page.dirty = false;
+
+    page.hot = true;
+    hotPagesM.push_front(index);
+    while (hotPagesM.size() > maxHotPages)
+    {
+        unsigned last = hotPagesM.back();
+        hotPagesM.pop_back();
+        spillPage(last);
+    }
+}
+
+bool DataGridRowStore::spillPage(unsigned index)
+{
+    Page& page = pagesM[index];
+    page.hot = false;
+
+    std::string data;
+    data.reserve(page.memorySize);
+    page.blobs.resize(page.rowCount);
+    for (unsigned i = 0; i < page.rowCount; ++i)
+        page.rows[i]->save(data, page.blobs[i]);
+
+    // pages read back are only written again if their rows were changed
+    if ((!page.written || page.dirty) && !writePage(page, data))
+    {
+        // keep the rows in memory from now on
+        spillingFailedM = true;
+        const char* source = data.data();
+        for (unsigned i = 0; i < page.rowCount; ++i)
+        {
+            DataGridRowBuffer* buffer =
+                DataGridRowBuffer::load(source, page.blobs[i]);
+            delete page.rows[i];
+            page.rows[i] = buffer;
+        }
+        page.blobs.clear();
+        return false;
+    }
+    page.dirty = false;
+
+    for (std::vector<DataGridRowBuffer*>::iterator it = page.rows.begin();
+        it != page.rows.end(); ++it)
+    {
+        delete (*it);
+    }
+    page.rows.clear();
+    memoryM -= page.memorySize;
+    return true;
+}
+
+bool DataGridRowStore::writePage(Page& page, const std::string& data)
+{
+    if (!fileM.IsOpened())
+    {
+        wxString fileName = wxFileName::CreateTempFileName("frgrid", &fileM);
+        if (fileName.empty() || !fileM.IsOpened())
+            return false;
+        fileEndM = 0;
+    }
+
+    // changed pages are written in place if they still fit
+    wxFileOffset offset = page.offset;
+    size_t capacity = page.capacity;
+    if (!page.written || data.size() > capacity)
+    {
+        offset = fileEndM;
+        capacity = data.size();
+    }
+    if (!fileM.Seek(offset)
+        || fileM.Write(data.data(), data.size()) != data.size())
+    {
+        return false;
+    }
+    if (offset == fileEndM)
+        fileEndM += capacity;
+
+    page.offset = offset;
+    page.capacity = capacity;
+    page.length = data.size();
+    page.written = true;
+    return true;
+}
+
+void DataGridRowStore::touchPage(unsigned index)
+{
+    if (hotPagesM.front() != index)
+    {
+        hotPagesM.remove(index);
+        hotPagesM.push_front(index);
+    }
+}
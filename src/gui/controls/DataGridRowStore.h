@@ -0,0 +1,99 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DATAGRIDROWSTORE_H
+#define FR_DATAGRIDROWSTORE_H
+
+#include <wx/ffile.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <ibpp.h>
+
+class DataGridRowBuffer;
+
+// DataGridRowStore class: owns the row buffers of a grid. Rows are kept in
+// pages, and once the memory used by them exceeds the budget the oldest
+// complete pages are written to a temporary file. Pages are read back on
+// access, a few recently used ones are kept in memory.
+class DataGridRowStore
+{
+private:
+    struct Page
+    {
+        std::vector<DataGridRowBuffer*> rows; // empty while spilled
+        // blob handles can't be written to the file
+        std::vector<std::vector<IBPP::Blob> > blobs;
+        unsigned rowCount;
+        size_t memorySize;
+        bool hot;
+        bool written;
+        // rows may have been changed since the page was last written
+        bool dirty;
+        wxFileOffset offset;
+        size_t length;
+        size_t capacity;
+        Page();
+    };
+    std::vector<Page> pagesM;
+    std::list<unsigned> hotPagesM;
+    unsigned countM;
+    unsigned nextSpillM;
+    size_t memoryM;
+    size_t budgetM;
+    bool spillingFailedM;
+    wxFFile fileM;
+    wxFileOffset fileEndM;
+
+    void freePage(Page& page);
+    void loadPage(unsigned index);
+    // writes the page to the file (if changed) and frees its rows
+    bool spillPage(unsigned index);
+    bool writePage(Page& page, const std::string& data);
+    void touchPage(unsigned index);
+public:
+    DataGridRowStore();
+    ~DataGridRowStore();
+
+    // sets the memory in bytes used before rows are spilled, 0 disables
+    // spilling
+    void setMemoryBudget(size_t bytes);
+
+    bool empty();
+    unsigned size();
+    void push_back(DataGridRowBuffer* buffer);
+    // deletes all buffers and the temporary file
+    void clear();
+    // loads the page of the row from the file if needed, the reference
+    // remains valid until another page is accessed; the page is written
+    // again when it is spilled
+    DataGridRowBuffer*& operator[](unsigned row);
+    // like operator[], for rows that are only read
+    DataGridRowBuffer* get(unsigned row);
+    // returns whether the row can be accessed without reading the file
+    bool isLoaded(unsigned row);
+};
+
+#endif // FR_DATAGRIDROWSTORE_H
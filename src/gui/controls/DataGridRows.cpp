@@ -37,6 +37,7 @@
 
 #include <algorithm>
 #include <bitset>
+#include <limits>
 #include <string>
 
 #include "config/LocalSettings.h"
@@ -45,6 +46,7 @@
 #include "core/Observer.h"
 #include "core/ProgressIndicator.h"
 #include "core/StringUtils.h"
+#include "engine/BlobReader.h"
 #include "gui/controls/DataGridRowBuffer.h"
 #include "gui/controls/DataGridRows.h"
 #include "metadata/CharacterSet.h"
@@ -375,12 +377,12 @@ void GridCellFormats::formatAppendTz(wxString &s, IBPP::Time &t, bool hasTz,
     }
     else
     {
-        wxString tzName;
+        s += " (";
         if (t.IsTimeZoneGmtFallback())
-            tzName = "GMT*";
+            s += "GMT*";
         else
-            tzName = db->getTimezoneName(timezone);
-        s += wxString::Format(" (%s)", tzName);
+            s += db->getTimezoneName(timezone);
+        s += ")";
     }
 }
 
@@ -1511,6 +1513,12 @@ public:
     virtual void setFromString(DataGridRowBuffer* buffer,
         const wxString& source);
     bool isTextual() { return textualM; };
+    // true if the contents are to be shown but haven't been read yet
+    bool needsPreview(DataGridRowBuffer* buffer);
+    // stores the first bytes of the blob as the string shown in the grid
+    wxString setPreview(DataGridRowBuffer* buffer, std::string& data,
+        bool complete);
+    void setPreviewError(DataGridRowBuffer* buffer);
 };
 
 BlobColumnDef::BlobColumnDef(const wxString& name, bool readOnly,
@@ -1544,51 +1552,47 @@ wxString BlobColumnDef::getAsString(DataGridRowBuffer* grid_buffer, Database*)
     IBPP::Blob *b0 = grid_buffer->getBlob(indexM);
     if (!b0)
         return "";
-    IBPP::Blob b = *b0;
+
+    std::string data;
+    bool complete;
     try
     {
-        b->Open();
+        BlobReader reader(*b0);
+        reader.read(data, GridCellFormats::get().maxBlobBytesToFetch());
+        complete = reader.isEof();
     }
     catch(...)
     {
         return _("[ERROR]");
     }
+    return setPreview(grid_buffer, data, complete);
+}
 
+bool BlobColumnDef::needsPreview(DataGridRowBuffer* buffer)
+{
+    wxASSERT(buffer);
+    if (buffer->isStringLoaded(stringIndexM))
+        return false;
+    if (!GridCellFormats::get().showBlobContent())
+        return false;
+    if (!textualM && !GridCellFormats::get().showBinaryBlobContent())
+        return false;
+    return buffer->getBlob(indexM) != 0;
+}
+
+wxString BlobColumnDef::setPreview(DataGridRowBuffer* buffer,
+    std::string& data, bool complete)
+{
     std::string result;
-    int bytesToFetch = GridCellFormats::get().maxBlobBytesToFetch();
-    while (bytesToFetch > 0)
+    if (textualM)
+        result.swap(data); // we don't convert here due to incomplete strings
+    else    // binary (show as hexadecimal)
     {
-        char buffer[1025];
-        int size = b->Read((void*)buffer, 1024);
-        if (size < 1)
-            break;
-        bytesToFetch -= size;
-        if (textualM)
-        {
-            std::string s(buffer, size);
-            result += s;    // we don't convert here due to incomplete strings
-        }
-        else    // binary (show as hexadecimal)
-        {
-            for (int i=0; i<size; i+=8)
-            {
-                int last = 8;
-                if (i+last >= size)
-                    last = size - i;
-                for (int j=0; j<last; j++)
-                {
-                    result += wx2std(wxString::Format("%02X",
-                        (unsigned char)(buffer[i+j])));
-                }
-                result += " ";
-                if (((i + 8) % 32) == 0)
-                    result += "\n";
-            }
-        }
+        unsigned lineBytes = 0;
+        appendHexDump(result, data.data(), data.size(), lineBytes);
     }
-    b->Close();
     wxString wxs(result.c_str(), *converterM);
-    if (bytesToFetch <= 0)    // there was more data to fetch
+    if (!complete)    // there was more data to fetch
     {               // incomplete strings might not get translated properly
         while (wxs.IsEmpty() && result.length() > 0)
         {
@@ -1596,10 +1600,17 @@ wxString BlobColumnDef::getAsString(DataGridRowBuffer* grid_buffer, Database*)
             wxs = wxString(result.c_str(), *converterM);   // try converting again
         }
     }
-    grid_buffer->setString(stringIndexM, wxs);
+    buffer->setString(stringIndexM, wxs);
     return wxs;
 }
 
+void BlobColumnDef::setPreviewError(DataGridRowBuffer* buffer)
+{
+    wxASSERT(buffer);
+    // stored, otherwise the blob would be requested again on every repaint
+    buffer->setString(stringIndexM, _("[ERROR]"));
+}
+
 void BlobColumnDef::setFromString(DataGridRowBuffer* /*buffer*/,
     const wxString& /*source*/)
 {
@@ -1698,10 +1709,9 @@ void StringColumnDef::setValue(DataGridRowBuffer* buffer, unsigned col,
     {
         std::string value;
         statement->Get(col, value);
-        wxString val;
-        for (std::string::size_type p = 0; p < value.length(); p++)
-            val += wxString::Format("%02x", uint8_t(value[p]));
-        buffer->setString(indexM, val);
+        std::string hex;
+        appendHex(hex, value.data(), value.size(), false);
+        buffer->setString(indexM, wxString::FromAscii(hex.c_str()));
     }
     else
     {
@@ -1740,7 +1750,9 @@ void BooleanColumnDef::setValue(DataGridRowBuffer* buffer, unsigned col,
 
 // DataGridRows class
 DataGridRows::DataGridRows(Database* db)
-    : bufferSizeM(0), databaseM(db), readOnlyM(false)
+    : bufferSizeM(0), databaseM(db), readOnlyM(false), batchLevelM(0),
+        batchSavepointM(false),
+        pagedM(false), pagedRowCountM(0), pageSizeM(0), maxPagesM(0)
 {
 }
 
@@ -1756,12 +1768,15 @@ ResultsetColumnDef* DataGridRows::getColumnDef(unsigned col)
 
 void DataGridRows::addRow(DataGridRowBuffer* buffer)
 {
-    if (buffersM.size() == buffersM.capacity())
-        buffersM.reserve(buffersM.capacity() + 1024);
     buffersM.push_back(buffer);
 }
 
 void DataGridRows::addRow(const IBPP::Statement& statement)
+{
+    addRow(createRow(statement));
+}
+
+DataGridRowBuffer* DataGridRows::createRow(const IBPP::Statement& statement)
 {
     DataGridRowBuffer* buffer = new DataGridRowBuffer(columnDefsM.size());
     // if anything fails, make sure we release the memory
@@ -1789,7 +1804,7 @@ void DataGridRows::addRow(const IBPP::Statement& statement)
         delete buffer;
         throw;
     }
-    addRow(buffer);
+    return buffer;
 }
 
     void freeBuffer(DataGridRowBuffer* buffer) { delete buffer; }
@@ -1798,11 +1813,16 @@ void DataGridRows::addRow(const IBPP::Statement& statement)
 
 void DataGridRows::clear()
 {
-    if (buffersM.size())
+    cancelBlobPreviews();
+    buffersM.clear();
+    for (std::map<unsigned, std::vector<DataGridRowBuffer*> >::iterator it =
+        pagesM.begin(); it != pagesM.end(); ++it)
     {
-        for_each(buffersM.begin(), buffersM.end(), freeBuffer);
-        buffersM.clear();
+        for_each((*it).second.begin(), (*it).second.end(), freeBuffer);
     }
+    pagesM.clear();
+    pagedM = false;
+    pagedRowCountM = 0;
     if (columnDefsM.size())
     {
         for_each(columnDefsM.begin(), columnDefsM.end(), freeColumnDef);
@@ -1810,13 +1830,23 @@ void DataGridRows::clear()
     }
     statementTablesM.clear();
     deleteFromM = statementTablesM.end();
+    changeStatementsM.clear();
+    for (std::map<unsigned, DataGridRowBuffer*>::iterator it =
+        batchBuffersM.begin(); it != batchBuffersM.end(); ++it)
+    {
+        delete (*it).second;
+    }
+    batchBuffersM.clear();
+    batchLevelM = 0;
+    batchSavepointM = false;
     dbKeysM.clear();
     bufferSizeM = 0;
 }
 
 bool DataGridRows::canRemoveRow(size_t row)
 {
-    if (row >= buffersM.size())
+    // rows of a scrollable cursor are read-only
+    if (pagedM || row >= buffersM.size())
         return false;
     // check that it is safe to call statementM->Columns()
     if (statementM->Type() == IBPP::stUnknown)
@@ -1859,7 +1889,16 @@ bool DataGridRows::canRemoveRow(size_t row)
 
 bool DataGridRows::removeRows(size_t from, size_t count, wxString& stm)
 {
-    if (statementTablesM.begin() == statementTablesM.end())
+    std::vector<size_t> rows;
+    for (size_t pos = 0; pos < count; ++pos)
+        rows.push_back(from + pos);
+    return removeRows(rows, stm);
+}
+
+bool DataGridRows::removeRows(const std::vector<size_t>& rows, wxString& stm,
+    ProgressIndicator* progress)
+{
+    if (pagedM || statementTablesM.begin() == statementTablesM.end())
         return false;
 
     if (deleteFromM == statementTablesM.end())  // only ask for the first time
@@ -1886,40 +1925,140 @@ bool DataGridRows::removeRows(size_t from, size_t count, wxString& stm)
         deleteFromM = statementTablesM.find(tab);
     }
 
-    for (size_t pos = 0; pos < count; ++pos)
+    if (progress)
+        progress->initProgress(_("Deleting rows"), rows.size());
+
+    // all rows are deleted, or none of them
+    beginBatch(rows.size());
+    try
     {
-        if (pos > 0)
-            stm += wxTextBuffer::GetEOL();
-        wxString s = "DELETE FROM "
+        wxString deleteFrom = "DELETE FROM "
             + Identifier((*deleteFromM).first).getQuoted() + " WHERE ";
-        IBPP::Statement st = addWhere((*deleteFromM).second, s,
-            (*deleteFromM).first, buffersM[from+pos]);
-        st->Execute();
-        stm += s + ";";
+        for (size_t pos = 0; pos < rows.size(); ++pos)
+        {
+            if (progress)
+            {
+                if (progress->isCanceled())
+                {
+                    rollbackBatch();
+                    return false;
+                }
+                progress->stepProgress();
+            }
+            if (pos > 0)
+                stm += wxTextBuffer::GetEOL();
+            wxString s(deleteFrom), sql(deleteFrom);
+            IBPP::Statement& st = addWhere((*deleteFromM).second, s, sql,
+                (*deleteFromM).first, buffersM[rows[pos]], 1);
+            st->Execute();
+            stm += s + ";";
+        }
     }
-
-    std::vector<DataGridRowBuffer*>::iterator i2, it = buffersM.begin();
-    from += count - 1;
-    while (from--)
+    catch (...)
     {
-        if (++it == buffersM.end())     // should never happen
-            return false;
+        // don't let a failed rollback hide the original error
+        try
+        {
+            rollbackBatch();
+        }
+        catch (...)
+        {
+        }
+        throw;
     }
-    while (count--)
+    commitBatch();
+
+    for (std::vector<size_t>::const_iterator it = rows.begin();
+        it != rows.end(); ++it)
     {
-        i2 = it;
-        if (it != buffersM.begin ())//Prevents it from going before the first one
-          it--;
-        (*i2)->setIsDeleted(true);
+        buffersM[*it]->setIsDeleted(true);
     }
     return true;
 }
 
 unsigned DataGridRows::getRowCount()
 {
+    if (pagedM)
+        return pagedRowCountM;
     return buffersM.size();
 }
 
+void DataGridRows::setPaged(unsigned rowCount, unsigned pageSize,
+    unsigned maxPages)
+{
+    wxASSERT(buffersM.empty() && pageSize > 0 && maxPages > 0);
+    pagedM = true;
+    pagedRowCountM = rowCount;
+    pageSizeM = pageSize;
+    maxPagesM = maxPages;
+}
+
+void DataGridRows::setPagedRowCount(unsigned rowCount)
+{
+    wxASSERT(pagedM);
+    pagedRowCountM = rowCount;
+}
+
+bool DataGridRows::isPaged()
+{
+    return pagedM;
+}
+
+unsigned DataGridRows::getPageSize()
+{
+    return pageSizeM;
+}
+
+bool DataGridRows::isRowLoaded(unsigned row)
+{
+    return getLoadedBuffer(row) != 0;
+}
+
+bool DataGridRows::loadSpilledRow(unsigned row)
+{
+    return !pagedM && row < buffersM.size() && buffersM.get(row) != 0;
+}
+
+void DataGridRows::addPage(unsigned page,
+    const std::vector<DataGridRowBuffer*>& buffers)
+{
+    std::vector<DataGridRowBuffer*>& pageBuffers = pagesM[page];
+    for_each(pageBuffers.begin(), pageBuffers.end(), freeBuffer);
+    pageBuffers = buffers;
+
+    // pages are dropped from the end farther away from the new page, the
+    // ones around it are most likely to be shown next
+    while (pagesM.size() > maxPagesM)
+    {
+        std::map<unsigned, std::vector<DataGridRowBuffer*> >::iterator it =
+            pagesM.begin();
+        std::map<unsigned, std::vector<DataGridRowBuffer*> >::iterator last =
+            --pagesM.end();
+        if ((*last).first - page > page - (*it).first)
+            it = last;
+        for_each((*it).second.begin(), (*it).second.end(), freeBuffer);
+        pagesM.erase(it);
+    }
+}
+
+DataGridRowBuffer* DataGridRows::getBuffer(unsigned row)
+{
+    if (!pagedM)
+        return (row < buffersM.size()) ? buffersM.get(row) : 0;
+    std::map<unsigned, std::vector<DataGridRowBuffer*> >::iterator it =
+        pagesM.find(row / pageSizeM);
+    if (it == pagesM.end() || row % pageSizeM >= (*it).second.size())
+        return 0;
+    return (*it).second[row % pageSizeM];
+}
+
+DataGridRowBuffer* DataGridRows::getLoadedBuffer(unsigned row)
+{
+    if (!pagedM && !buffersM.isLoaded(row))
+        return 0;
+    return getBuffer(row);
+}
+
 unsigned DataGridRows::getRowFieldCount()
 {
     return columnDefsM.size();
@@ -2057,6 +2196,12 @@ bool DataGridRows::initialize(const IBPP::Statement& statement)
     statementM = statement;
 
     clear();
+    // rows over the budget (in MB, clamped to what size_t can hold) are
+    // kept in a temporary file
+    int memoryBudget = config().get("GridMemoryBudget", 1024);
+    wxUint64 budgetBytes = wxUint64(std::max(memoryBudget, 0)) * 1024 * 1024;
+    buffersM.setMemoryBudget(size_t(std::min(budgetBytes,
+        wxUint64(std::numeric_limits<size_t>::max()))));
     // column definitions may have an index into the string array,
     // an offset into the buffer, or use no data at all
     unsigned colCount = statement->Columns();
@@ -2191,16 +2336,17 @@ bool DataGridRows::isColumnReadonly(unsigned col)
 bool DataGridRows::getFieldInfo(unsigned row, unsigned col,
     DataGridFieldInfo& info)
 {
-    if (col >= columnDefsM.size() || row >= buffersM.size())
+    DataGridRowBuffer* buffer = getBuffer(row);
+    if (col >= columnDefsM.size() || !buffer)
         return false;
-    info.rowInserted = buffersM[row]->isInserted();
-    info.rowDeleted = buffersM[row]->isDeleted();
-    info.fieldReadOnly = readOnlyM || info.rowDeleted
+    info.rowInserted = buffer->isInserted();
+    info.rowDeleted = buffer->isDeleted();
+    info.fieldReadOnly = readOnlyM || pagedM || info.rowDeleted
         || isColumnReadonly(col) || isFieldReadonly(row, col);
     info.fieldModified = !info.rowDeleted
-        && buffersM[row]->isFieldModified(col);
-    info.fieldNull = buffersM[row]->isFieldNull(col);
-    info.fieldNA = buffersM[row]->isFieldNA(col);
+        && buffer->isFieldModified(col);
+    info.fieldNull = buffer->isFieldNull(col);
+    info.fieldNA = buffer->isFieldNA(col);
     info.fieldNumeric = isColumnNumeric(col);
     info.fieldBlob = isBlobColumn(col);
     return true;
@@ -2208,14 +2354,14 @@ bool DataGridRows::getFieldInfo(unsigned row, unsigned col,
 
 bool DataGridRows::isFieldReadonly(unsigned row, unsigned col)
 {
-    if (col >= columnDefsM.size() || row >= buffersM.size())
+    if (col >= columnDefsM.size() || row >= getRowCount())
         return false;
-    if (columnDefsM[col]->isReadOnly())
+    if (pagedM || columnDefsM[col]->isReadOnly())
         return true;
 
     // if row is loaded from the database and not inserted by user, we don't
     // need to check anything else
-    if (!buffersM[row]->isInserted())
+    if (!getBuffer(row)->isInserted())
         return false;
 
     // TODO: this needs to be cached too
@@ -2239,7 +2385,7 @@ bool DataGridRows::isFieldReadonly(unsigned row, unsigned col)
                 continue;
             wxString tn(std2wxIdentifier(statementM->ColumnTable(c2),
                 databaseM->getCharsetConverter()));
-            if (tn == table && buffersM[row]->isFieldNA(c2-1))
+            if (tn == table && getBuffer(row)->isFieldNA(c2-1))
                 return true;
         }
     }
@@ -2248,36 +2394,177 @@ bool DataGridRows::isFieldReadonly(unsigned row, unsigned col)
 
 wxString DataGridRows::getFieldValue(unsigned row, unsigned col)
 {
-    if (row >= buffersM.size() || col >= columnDefsM.size())
+    DataGridRowBuffer* buffer = getBuffer(row);
+    if (!buffer || col >= columnDefsM.size())
+        return wxEmptyString;
+    // the blob may be read by the background loader at the moment
+    BlobColumnDef* bcd = dynamic_cast<BlobColumnDef*>(columnDefsM[col]);
+    if (bcd && bcd->needsPreview(buffer))
+        cancelBlobPreviews();
+    return columnDefsM[col]->getAsString(buffer, databaseM);
+}
+
+wxString DataGridRows::getFieldPreview(unsigned row, unsigned col)
+{
+    DataGridRowBuffer* buffer = getBuffer(row);
+    if (!buffer || col >= columnDefsM.size())
         return wxEmptyString;
-    return columnDefsM[col]->getAsString(buffersM[row], databaseM);
+    BlobColumnDef* bcd = dynamic_cast<BlobColumnDef*>(columnDefsM[col]);
+    if (!bcd || !blobPreviewNotifyM || !bcd->needsPreview(buffer))
+        return columnDefsM[col]->getAsString(buffer, databaseM);
+
+    if (!blobPreviewLoaderM)
+        blobPreviewLoaderM.reset(new BlobPreviewLoader(blobPreviewNotifyM));
+    // rows below the requested one are likely to be shown next, so they
+    // are prefetched as well (unless they have to be read back from the
+    // temporary file); the loader serves the newest request first, so the
+    // requested row has to be queued last
+    const unsigned lookahead = 20;
+    int maxBytes = GridCellFormats::get().maxBlobBytesToFetch();
+    unsigned r = std::min(row + lookahead + 1, getRowCount());
+    while (r-- > row)
+    {
+        DataGridRowBuffer* next = getLoadedBuffer(r);
+        if (next && bcd->needsPreview(next))
+        {
+            IBPP::Blob* b = next->getBlob(bcd->getIndex());
+            blobPreviewLoaderM->request(r, col, *b, maxBytes);
+        }
+    }
+    return _("[LOADING]");
 }
 
 bool DataGridRows::isFieldNull(unsigned row, unsigned col)
 {
-    if (row >= buffersM.size())
+    DataGridRowBuffer* buffer = getBuffer(row);
+    if (!buffer)
         return false;
-    return buffersM[row]->isFieldNull(col);
+    return buffer->isFieldNull(col);
 }
 
 bool DataGridRows::isFieldNA(unsigned row, unsigned col)
 {
-    if (row >= buffersM.size())
+    DataGridRowBuffer* buffer = getBuffer(row);
+    if (!buffer)
         return false;
-    return buffersM[row]->isFieldNA(col);
+    return buffer->isFieldNA(col);
+}
+
+IBPP::Statement& DataGridRows::getChangeStatement(const wxString& sql)
+{
+    // statements are prepared once per table and column set, subsequent
+    // changes only set the parameters
+    std::map<wxString, IBPP::Statement>::iterator it =
+        changeStatementsM.find(sql);
+    if (it != changeStatementsM.end())
+        return (*it).second;
+
+    IBPP::Statement st = IBPP::StatementFactory(statementM->DatabasePtr(),
+        statementM->TransactionPtr());
+    st->Prepare(wx2std(sql, databaseM->getCharsetConverter()));
+    return changeStatementsM[sql] = st;
 }
 
-IBPP::Statement DataGridRows::addWhere(UniqueConstraint* uq, wxString& stm,
-    const wxString& table, DataGridRowBuffer *buffer)
+wxString DataGridRows::getParameterCast(unsigned col)
 {
-    bool have_dbkey = false;
+    // values are passed as strings, the same text that is used for the
+    // literals in the logged statements, and converted by the server
+    if (statementM->ColumnType(col) == IBPP::sdString
+        && statementM->ColumnSubtype(col) == 1) // OCTETS
+    {
+        return wxString::Format("CAST(? AS VARCHAR(%d) CHARACTER SET OCTETS)",
+            statementM->ColumnSize(col));
+    }
+
+    wxString charset(databaseM->getConnectionCharset());
+    if (charset.empty())
+        charset = "NONE";
+    // maximum VARCHAR length for a 4 byte per character set
+    int maxLength = charset.CmpNoCase("NONE") == 0 ? 32765 : 8191;
+    int length = 255;
+    if (statementM->ColumnType(col) == IBPP::sdString)
+        length = std::max(length, statementM->ColumnSize(col));
+    else if (statementM->ColumnType(col) == IBPP::sdBlob)
+        length = maxLength;
+    length = std::min(length, maxLength);
+    return wxString::Format("CAST(? AS VARCHAR(%d) CHARACTER SET %s)",
+        length, charset);
+}
+
+void DataGridRows::setParameter(IBPP::Statement& st, int param, unsigned col,
+    DataGridRowBuffer* buffer)
+{
+    if (buffer->isFieldNull(col))
+    {
+        st->SetNull(param);
+        return;
+    }
+
+    ResultsetColumnDef* columnDef = columnDefsM[col];
+    if (DBKeyColumnDef* dbk = dynamic_cast<DBKeyColumnDef*>(columnDef))
+    {
+        IBPP::DBKey dbkey;
+        dbk->getDBKey(dbkey, buffer);
+        st->Set(param, dbkey);
+        return;
+    }
+
+    wxString value;
+    if (dynamic_cast<StringColumnDef*>(columnDef))
+        value = columnDef->getAsString(buffer, databaseM);
+    else
+    {
+        value = columnDef->getAsFirebirdString(buffer);
+        // fix locale problem for "," as decimal separator
+        if (IBPP::isRationalNumber(statementM->ColumnType(col + 1)))
+            value.Replace(",", ".");
+    }
+
+    if (statementM->ColumnType(col + 1) == IBPP::sdString
+        && statementM->ColumnSubtype(col + 1) == 1) // OCTETS, stored as hex
+    {
+        std::string bytes;
+        for (size_t i = 0; i + 1 < value.length(); i += 2)
+        {
+            unsigned long byte;
+            if (!value.Mid(i, 2).ToULong(&byte, 16))
+                throw FRError(_("Invalid hexadecimal value."));
+            bytes += char(byte);
+        }
+        st->Set(param, bytes);
+    }
+    else
+        st->Set(param, wx2std(value, databaseM->getCharsetConverter()));
+}
+
+IBPP::Statement& DataGridRows::addWhere(UniqueConstraint* uq, wxString& stm,
+    wxString& sql, const wxString& table, DataGridRowBuffer *buffer,
+    int firstParam)
+{
+    std::vector<unsigned> keyCols;
     for (ColumnConstraint::const_iterator ci = uq->begin(); ci !=
         uq->end(); ++ci)
     {
         if ((*ci) == "DB_KEY")
         {
+            // find the column to set the parameter from
+            for (int c2 = 1; c2 <= statementM->Columns(); ++c2)
+            {
+                wxString cn(std2wxIdentifier(statementM->ColumnName(c2),
+                    databaseM->getCharsetConverter()));
+                wxString tn(std2wxIdentifier(statementM->ColumnTable(c2),
+                    databaseM->getCharsetConverter()));
+                if (cn == "DB_KEY" && tn == table)
+                {
+                    if (!dynamic_cast<DBKeyColumnDef *>(columnDefsM[c2-1]))
+                        throw FRError(_("Invalid Column"));
+                    if (buffer->isFieldNA(c2-1))
+                        throw FRError(_("N/A value in DB_KEY column."));
+                    keyCols.push_back(c2-1);
+                }
+            }
             stm += " RDB$DB_KEY = ?";
-            have_dbkey = true;
+            sql += " RDB$DB_KEY = ?";
             break;
         }
         for (int c2 = 1; c2 <= statementM->Columns(); ++c2)
@@ -2291,7 +2578,10 @@ IBPP::Statement DataGridRows::addWhere(UniqueConstraint* uq, wxString& stm,
                 if (buffer->isFieldNA(c2-1))
                     throw FRError(_("N/A value in key column."));
                 if (ci != uq->begin())
+                {
                     stm += " AND ";
+                    sql += " AND ";
+                }
                 if ((statementM->ColumnType(c2) == IBPP::SDT::sdString) && (statementM->ColumnSubtype(c2) == 1) ) //OCTET
                     stm += Identifier(cn).getQuoted() + " = x'";
                 else
@@ -2299,38 +2589,94 @@ IBPP::Statement DataGridRows::addWhere(UniqueConstraint* uq, wxString& stm,
 
                 stm += columnDefsM[c2-1]->getAsFirebirdString(buffer);
                 stm += "'";
+
+                sql += Identifier(cn).getQuoted() + " = "
+                    + getParameterCast(c2);
+                keyCols.push_back(c2-1);
                 break;
             }
         }
     }
 
+    IBPP::Statement& st = getChangeStatement(sql);
+    for (size_t i = 0; i < keyCols.size(); ++i)
+        setParameter(st, firstParam + int(i), keyCols[i], buffer);
+    return st;
+}
+
+DataGridRowBuffer* DataGridRows::copyBuffer(DataGridRowBuffer* buffer)
+{
+    // we create a copy of appropriate type
+    InsertedGridRowBuffer *test =
+        dynamic_cast<InsertedGridRowBuffer *>(buffer);
+    if (test)
+        return new InsertedGridRowBuffer(test);
+    return new DataGridRowBuffer(buffer);
+}
+
+void DataGridRows::keepBatchBuffer(unsigned row, DataGridRowBuffer* oldBuffer)
+{
+    // only the state before the first change of a row needs to be restored
+    if (batchLevelM == 0 || batchBuffersM.find(row) != batchBuffersM.end())
+        delete oldBuffer;
+    else
+        batchBuffersM[row] = oldBuffer;
+}
+
+void DataGridRows::executeBatchCommand(const wxString& sql)
+{
     IBPP::Statement st = IBPP::StatementFactory(statementM->DatabasePtr(),
         statementM->TransactionPtr());
-    st->Prepare(wx2std(stm, databaseM->getCharsetConverter()));
-    if (have_dbkey)  // find the column and set the parameter
+    st->ExecuteImmediate(wx2std(sql));
+}
+
+void DataGridRows::beginBatch(size_t statementCount)
+{
+    if (batchLevelM++ > 0)
+        return;
+    // a single failed statement has no effect anyway
+    batchSavepointM = (statementCount > 1);
+    if (batchSavepointM)
+        executeBatchCommand("SAVEPOINT FR_GRID_CHANGES");
+}
+
+void DataGridRows::commitBatch()
+{
+    wxASSERT(batchLevelM > 0);
+    if (--batchLevelM > 0)
+        return;
+    for (std::map<unsigned, DataGridRowBuffer*>::iterator it =
+        batchBuffersM.begin(); it != batchBuffersM.end(); ++it)
     {
-        for (int c2 = 1; c2 <= statementM->Columns(); ++c2)
-        {
-            wxString cn(std2wxIdentifier(statementM->ColumnName(c2),
-                databaseM->getCharsetConverter()));
-            wxString tn(std2wxIdentifier(statementM->ColumnTable(c2),
-                databaseM->getCharsetConverter()));
-            if (cn == "DB_KEY" && tn == table)
-            {
-                DBKeyColumnDef *dbk =
-                    dynamic_cast<DBKeyColumnDef *>(columnDefsM[c2-1]);
-                if (!dbk)
-                    throw FRError(_("Invalid Column"));
-                if (buffer->isFieldNA(c2-1))
-                    throw FRError(_("N/A value in DB_KEY column."));
-                IBPP::DBKey dbkey;
-                dbk->getDBKey(dbkey, buffer);
-                // if updating BLOB, param = 2, else param = 1
-                st->Set(st->Parameters(), dbkey);
-            }
-        }
+        delete (*it).second;
+    }
+    batchBuffersM.clear();
+    if (batchSavepointM)
+    {
+        batchSavepointM = false;
+        executeBatchCommand("RELEASE SAVEPOINT FR_GRID_CHANGES ONLY");
+    }
+}
+
+void DataGridRows::rollbackBatch()
+{
+    wxASSERT(batchLevelM > 0);
+    if (--batchLevelM > 0)
+        return;
+    // restore the rows to their state before the batch
+    for (std::map<unsigned, DataGridRowBuffer*>::iterator it =
+        batchBuffersM.begin(); it != batchBuffersM.end(); ++it)
+    {
+        delete buffersM[(*it).first];
+        buffersM[(*it).first] = (*it).second;
+    }
+    batchBuffersM.clear();
+    if (batchSavepointM)
+    {
+        batchSavepointM = false;
+        executeBatchCommand("ROLLBACK TO SAVEPOINT FR_GRID_CHANGES");
+        executeBatchCommand("RELEASE SAVEPOINT FR_GRID_CHANGES ONLY");
     }
-    return st;
 }
 
 bool DataGridRows::isBlobColumn(unsigned col, bool* pIsTextual)
@@ -2343,11 +2689,14 @@ bool DataGridRows::isBlobColumn(unsigned col, bool* pIsTextual)
 
 IBPP::Blob* DataGridRows::getBlob(unsigned row, unsigned col, bool validateBlob)
 {
-    if (row >= buffersM.size())
+    // the caller will use the blob, it must not be read in the background
+    cancelBlobPreviews();
+    DataGridRowBuffer* buffer = getBuffer(row);
+    if (!buffer)
       throw FRError(_("Invalid row index."));
     if (col >= columnDefsM.size())
       throw FRError(_("Invalid col index."));
-    IBPP::Blob* b0 = buffersM[row]->getBlob(columnDefsM[col]->getIndex());
+    IBPP::Blob* b0 = buffer->getBlob(columnDefsM[col]->getIndex());
     if ((validateBlob) && (!b0))
         throw FRError(_("BLOB data not valid"));
     return b0;
@@ -2357,6 +2706,8 @@ IBPP::Blob* DataGridRows::getBlob(unsigned row, unsigned col, bool validateBlob)
 // Finally the BLOB will be set with setBlob(...)
 DataGridRowsBlob DataGridRows::setBlobPrepare(unsigned row, unsigned col)
 {
+    if (pagedM)
+        throw FRError(_("The rows of a scrollable cursor are read-only."));
     wxString tn(std2wxIdentifier(statementM->ColumnTable(col + 1),
         databaseM->getCharsetConverter()));
     wxString cn(std2wxIdentifier(statementM->ColumnName(col + 1),
@@ -2368,6 +2719,7 @@ DataGridRowsBlob DataGridRows::setBlobPrepare(unsigned row, unsigned col)
     wxString stm = "UPDATE " + iTn.getQuoted()
         + " SET " + iCn.getQuoted()
         + " = ? WHERE ";
+    wxString sql(stm);
     std::map<wxString, UniqueConstraint *>::iterator it =
         statementTablesM.find(tn);
     if (it == statementTablesM.end() || (*it).second == 0)
@@ -2376,13 +2728,15 @@ DataGridRowsBlob DataGridRows::setBlobPrepare(unsigned row, unsigned col)
     DataGridRowsBlob b;
     b.row = row;
     b.col = col;
-    b.st = addWhere((*it).second, stm, tn, buffersM[row]);
+    b.st = addWhere((*it).second, stm, sql, tn, buffersM[row], 2);
     b.blob = IBPP::BlobFactory(b.st->DatabasePtr(), b.st->TransactionPtr());
     return b;
 }
 
 void DataGridRows::setBlob(DataGridRowsBlob &b)
 {
+    if (pagedM)
+        throw FRError(_("The rows of a scrollable cursor are read-only."));
     if (b.blob != 0) // b.blob is 0 if the blob is null
     {   
         b.st->Set(1, b.blob);
@@ -2398,6 +2752,52 @@ void DataGridRows::setBlob(DataGridRowsBlob &b)
     bcd->reset(buffersM[b.row]);  // reset cached blob data
 }
 
+void DataGridRows::setBlobPreviewNotify(
+    BlobPreviewLoader::NotifyFunction notify)
+{
+    blobPreviewLoaderM.reset();
+    blobPreviewNotifyM = notify;
+}
+
+bool DataGridRows::applyBlobPreviews()
+{
+    if (!blobPreviewLoaderM)
+        return false;
+    std::vector<BlobPreviewLoader::Preview> previews;
+    blobPreviewLoaderM->takePreviews(previews);
+
+    bool applied = false;
+    for (std::vector<BlobPreviewLoader::Preview>::iterator it =
+        previews.begin(); it != previews.end(); ++it)
+    {
+        // rows may have been removed or dropped with their page, or blobs
+        // replaced in the meantime
+        DataGridRowBuffer* buffer = getLoadedBuffer((*it).row);
+        if (!buffer || (*it).col >= columnDefsM.size())
+            continue;
+        BlobColumnDef* bcd =
+            dynamic_cast<BlobColumnDef*>(columnDefsM[(*it).col]);
+        if (!bcd || !bcd->needsPreview(buffer))
+            continue;
+        IBPP::Blob* b = buffer->getBlob(bcd->getIndex());
+        if (*b != (*it).blob)
+            continue;
+
+        if ((*it).error)
+            bcd->setPreviewError(buffer);
+        else
+            bcd->setPreview(buffer, (*it).data, (*it).complete);
+        applied = true;
+    }
+    return applied;
+}
+
+void DataGridRows::cancelBlobPreviews()
+{
+    if (blobPreviewLoaderM)
+        blobPreviewLoaderM->cancel();
+}
+
 void DataGridRows::exportBlobFile(const wxString& filename, unsigned row,
     unsigned col, ProgressIndicator *pi)
 {
@@ -2405,27 +2805,22 @@ void DataGridRows::exportBlobFile(const wxString& filename, unsigned row,
     if (!fl.IsOpened())
         throw FRError(_("Cannot open destination file."));
     IBPP::Blob *b0 = getBlob(row,col,true);
-    IBPP::Blob b = *b0;
 
-    b->Open();
+    BlobReader reader(*b0);
     if (pi)
-    {
-        int size;
-        b->Info(&size, 0, 0);
-        pi->initProgress(_("Saving..."), size);
-    }
+        pi->initProgress(_("Saving..."), reader.getSize());
+    std::string data;
     while (!pi || !pi->isCanceled())
     {
-        uint8_t buffer[32768];
-        int size = b->Read((void*)buffer, 32767);
+        data.clear();
+        int size = reader.read(data, BlobReader::MaxSegmentSize);
         if (size < 1)
             break;
-        fl.Write(buffer, size);
+        fl.Write(data.data(), size);
         if (pi)
             pi->stepProgress(size);
     }
     fl.Close();
-    b->Close();
 }
 
 void DataGridRows::importBlobFile(const wxString& filename, unsigned row,
@@ -2461,6 +2856,8 @@ void DataGridRows::importBlobFile(const wxString& filename, unsigned row,
 wxString DataGridRows::setFieldValue(unsigned row, unsigned col,
     const wxString& value, bool setNull)
 {
+    if (pagedM)
+        throw FRError(_("The rows of a scrollable cursor are read-only."));
     LocalSettings localSet;
 
     wxString localValue = value;
@@ -2493,14 +2890,7 @@ wxString DataGridRows::setFieldValue(unsigned row, unsigned col,
     // to ensure atomicity, we create a temporary buffer, try to store value
     // in it and also in database. if anything fails, we revert to the values
     // from temp buffer
-    DataGridRowBuffer *oldRecord;
-    // we create a copy of appropriate type
-    InsertedGridRowBuffer *test =
-        dynamic_cast<InsertedGridRowBuffer *>(buffersM[row]);
-    if (test)
-        oldRecord = new InsertedGridRowBuffer(test);
-    else
-        oldRecord = new DataGridRowBuffer(buffersM[row]);
+    DataGridRowBuffer *oldRecord = copyBuffer(buffersM[row]);
     try
     {
         buffersM[row]->setFieldNA(col, false);
@@ -2523,6 +2913,8 @@ wxString DataGridRows::setFieldValue(unsigned row, unsigned col,
 
         wxString stm = "UPDATE " + iTn.getQuoted()
             + " SET " + iCn.getQuoted();
+        // executed statement, with parameters instead of literal values
+        wxString sql = stm + " = " + getParameterCast(col + 1) + " WHERE ";
         if (newIsNull)
             stm += " = NULL WHERE ";
         else
@@ -2546,9 +2938,11 @@ wxString DataGridRows::setFieldValue(unsigned row, unsigned col,
         if (it == statementTablesM.end() || (*it).second == 0)
             throw FRError(_("This column should not be editable"));
 
-        IBPP::Statement st = addWhere((*it).second, stm, tn, oldRecord);
+        IBPP::Statement& st = addWhere((*it).second, stm, sql, tn,
+            oldRecord, 2);
+        setParameter(st, 1, col, buffersM[row]);
         st->Execute();
-        delete oldRecord;
+        keepBatchBuffer(row, oldRecord);
 
         return stm;
 
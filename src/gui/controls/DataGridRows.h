@@ -27,11 +27,14 @@
 #include <vector>
 #include <map>
 #include <list>
+#include <memory>
 
 #include <ibpp.h>
 
 #include "metadata/constraints.h"
 #include "config/Config.h"
+#include "engine/BlobPreviewLoader.h"
+#include "gui/controls/DataGridRowStore.h"
 
 class Database;
 class DataGridRowBuffer;
@@ -140,27 +143,77 @@ private:
     const bool readOnlyM;
     IBPP::Statement statementM;
     std::vector<ResultsetColumnDef*> columnDefsM;
-    std::vector<DataGridRowBuffer*> buffersM;
+    DataGridRowStore buffersM;
     std::map<wxString, UniqueConstraint *> statementTablesM;
     std::map<wxString, UniqueConstraint *>::iterator deleteFromM;
     std::list<UniqueConstraint> dbKeysM;
     unsigned bufferSizeM;
+    // prepared UPDATE and DELETE statements, keyed by their SQL
+    std::map<wxString, IBPP::Statement> changeStatementsM;
+    // original contents of the rows changed in the current batch
+    std::map<unsigned, DataGridRowBuffer*> batchBuffersM;
+    unsigned batchLevelM;
+    // whether the outermost batch runs inside a savepoint
+    bool batchSavepointM;
+    // reads blob contents shown in the grid in the background
+    BlobPreviewLoader::NotifyFunction blobPreviewNotifyM;
+    std::unique_ptr<BlobPreviewLoader> blobPreviewLoaderM;
+    // rows of a scrollable cursor: all rows are counted, but only the pages
+    // closest to the last loaded one are kept in memory
+    bool pagedM;
+    unsigned pagedRowCountM;
+    unsigned pageSizeM;
+    unsigned maxPagesM;
+    std::map<unsigned, std::vector<DataGridRowBuffer*> > pagesM;
+
+    // returns 0 if the row is not loaded
+    DataGridRowBuffer* getBuffer(unsigned row);
+    // like getBuffer(), but returns 0 for rows in the temporary file too
+    DataGridRowBuffer* getLoadedBuffer(unsigned row);
 
     void getColumnInfo(Database* db, unsigned col, bool& readOnly,
         bool& nullable);
-    IBPP::Statement addWhere(UniqueConstraint* uq, wxString& stm,
-        const wxString& table, DataGridRowBuffer *buffer);
+    IBPP::Statement& getChangeStatement(const wxString& sql);
+    wxString getParameterCast(unsigned col);
+    void setParameter(IBPP::Statement& st, int param, unsigned col,
+        DataGridRowBuffer* buffer);
+    // appends the key condition to both the logged statement stm (literal
+    // values) and the executed statement sql (parameters), returns the
+    // prepared statement with key parameters set from firstParam on
+    IBPP::Statement& addWhere(UniqueConstraint* uq, wxString& stm,
+        wxString& sql, const wxString& table, DataGridRowBuffer *buffer,
+        int firstParam);
+    DataGridRowBuffer* copyBuffer(DataGridRowBuffer* buffer);
+    void keepBatchBuffer(unsigned row, DataGridRowBuffer* oldBuffer);
+    void executeBatchCommand(const wxString& sql);
 public:
     DataGridRows(Database* db);
     ~DataGridRows();
 
     void addRow(const IBPP::Statement& statement);
+    // returns a new buffer with the values of the current row
+    DataGridRowBuffer* createRow(const IBPP::Statement& statement);
     void clear();
     unsigned getRowCount();
     unsigned getRowFieldCount();
     wxString getRowFieldName(unsigned col);
     bool initialize(const IBPP::Statement& statement);
 
+    // switches to rowCount read-only rows that are loaded in pages, at
+    // most maxPages of them are kept
+    void setPaged(unsigned rowCount, unsigned pageSize, unsigned maxPages);
+    // changes the number of rows while they are still being counted
+    void setPagedRowCount(unsigned rowCount);
+    bool isPaged();
+    unsigned getPageSize();
+    // returns whether the row is in memory
+    bool isRowLoaded(unsigned row);
+    // reads a spilled row back from the temporary file, throws on errors
+    bool loadSpilledRow(unsigned row);
+    // takes ownership of the buffers, which hold the rows from
+    // page * getPageSize() on, and drops the pages farthest away from it
+    void addPage(unsigned page, const std::vector<DataGridRowBuffer*>& buffers);
+
     bool isColumnNullable(unsigned col);
     bool isColumnNumeric(unsigned col);
     bool isColumnReadonly(unsigned col);
@@ -171,6 +224,9 @@ public:
     bool isFieldNA(unsigned row, unsigned col);
 
     wxString getFieldValue(unsigned row, unsigned col);
+    // like getFieldValue(), but returns a placeholder for blob contents
+    // that are still being read in the background
+    wxString getFieldPreview(unsigned row, unsigned col);
     wxString setFieldValue(unsigned row, unsigned col,
         const wxString& value, bool setNull = false);
     void importBlobFile(const wxString& filename, unsigned row, unsigned col,
@@ -179,6 +235,16 @@ public:
         ProgressIndicator *pi);
     bool canRemoveRow(size_t row);
     bool removeRows(size_t from, size_t count, wxString& statement);
+    bool removeRows(const std::vector<size_t>& rows, wxString& statement,
+        ProgressIndicator* progress = 0);
+
+    // changes between beginBatch() and commitBatch() are applied to both
+    // the database and the grid as a whole, rollbackBatch() reverts them;
+    // statementCount is the number of statements the batch will execute,
+    // a savepoint is only needed if there is more than one of them
+    void beginBatch(size_t statementCount);
+    void commitBatch();
+    void rollbackBatch();
 
     ResultsetColumnDef* getColumnDef(unsigned col);
     void addRow(DataGridRowBuffer* buffer);
@@ -187,6 +253,11 @@ public:
     IBPP::Blob* getBlob(unsigned row, unsigned col, bool validateBlob);
     DataGridRowsBlob setBlobPrepare(unsigned row, unsigned col);
     void setBlob(DataGridRowsBlob &b);
+    // enables reading blob contents in the background, notify is called
+    // from the worker thread when applyBlobPreviews() has work to do
+    void setBlobPreviewNotify(BlobPreviewLoader::NotifyFunction notify);
+    bool applyBlobPreviews();
+    void cancelBlobPreviews();
 };
 
 #endif
@@ -31,12 +31,17 @@
 #endif
 
 #include <wx/grid.h>
+#include <wx/textbuf.h>
 
 #include <algorithm>
+#include <chrono>
+#include <climits>
 #include <set>
+#include <vector>
 
 #include "config/Config.h"
 #include "core/FRError.h"
+#include "core/ProgressIndicator.h"
 #include "core/StringUtils.h"
 #include "gui/controls/DataGridRows.h"
 #include "gui/controls/DataGridTable.h"
@@ -48,7 +53,7 @@
 
 DataGridTable::DataGridTable(IBPP::Statement& s, Database* db)
     : wxGridTableBase(), statementM(s), databaseM(db), nullFlagM(false),
-        rowsM(db)
+        pagingFailedM(false), scrollableMissingRowM(0), rowsM(db)
 {
     allRowsFetchedM = false;
     fetchAllRowsM = false;
@@ -58,8 +63,13 @@ DataGridTable::DataGridTable(IBPP::Statement& s, Database* db)
     config().getValue("GridFetchAllRecords", fetchAllRowsM);
     maxRowToFetchM = 100;
     cellAttriM = new wxGridCellAttr();
+    fetchTimesM.firstRowMs = fetchTimesM.fetchMs = fetchTimesM.bufferMs = 0;
 }
 
+// rows per page of a scrollable cursor, and pages kept in memory
+static const unsigned scrollablePageSize = 100;
+static const unsigned scrollableMaxPages = 20;
+
 DataGridTable::~DataGridTable()
 {
     Clear();
@@ -125,14 +135,22 @@ void DataGridTable::fetch()
 {
     if (!canFetchMoreRows())
         return;
+    if (rowsM.isPaged())
+    {
+        countScrollableRows();
+        return;
+    }
 
     // fetch the first 100 rows no matter how long it takes
     unsigned oldRows = rowsM.getRowCount();
     bool initial = oldRows == 0;
     // fetch more rows until maxRowToFetchM reached or 100 ms elapsed
     wxLongLong startms = ::wxGetLocalTimeMillis();
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double, std::milli> millis;
     do
     {
+        clock::time_point fetchStart = clock::now();
         try
         {
             if (!statementM->Fetch())
@@ -150,9 +168,17 @@ void DataGridTable::fetch()
             ::wxMessageBox(_("A system error occurred!"), _("Error"),
                 wxOK|wxICON_ERROR);
         }
+        clock::time_point bufferStart = clock::now();
+        fetchTimesM.fetchMs += millis(bufferStart - fetchStart).count();
         if (allRowsFetchedM)
             break;
         rowsM.addRow(statementM);
+        fetchTimesM.bufferMs += millis(clock::now() - bufferStart).count();
+        if (rowsM.getRowCount() == 1)
+        {
+            fetchTimesM.firstRowMs = millis(bufferStart
+                - initialFetchStartM).count();
+        }
 
         if (!initial && (::wxGetLocalTimeMillis() - startms > 100))
             break;
@@ -194,7 +220,7 @@ wxGridCellAttr* DataGridTable::GetAttr(int row, int col,
     wxGridCellAttr::wxAttrKind kind)
 {
     DataGridFieldInfo info;
-    if (!rowsM.getFieldInfo(row, col, info))
+    if (!ensureRowLoaded(row) || !rowsM.getFieldInfo(row, col, info))
         return wxGridTableBase::GetAttr(row, col, kind);
 
     bool useAttri = readOnlyM || info.rowInserted || info.rowDeleted
@@ -243,7 +269,7 @@ wxGridCellAttr* DataGridTable::GetAttr(int row, int col,
 
 wxString DataGridTable::getCellValue(int row, int col)
 {
-    if (!isValidCellPos(row, col))
+    if (!isValidCellPos(row, col) || !ensureRowLoaded(row))
         return wxEmptyString;
 
     if (rowsM.isFieldNA(row, col))
@@ -255,7 +281,8 @@ wxString DataGridTable::getCellValue(int row, int col)
 
 wxString DataGridTable::getCellValueForInsert(int row, int col)
 {
-    if (!isValidCellPos(row, col) || rowsM.isFieldNA(row, col))
+    if (!isValidCellPos(row, col) || !ensureRowLoaded(row)
+        || rowsM.isFieldNA(row, col))
         return wxEmptyString;
 
     if (rowsM.isFieldNull(row, col))
@@ -269,7 +296,8 @@ wxString DataGridTable::getCellValueForInsert(int row, int col)
 wxString DataGridTable::getCellValueForCSV(int row, int col,
     const wxChar& textDelimiter)
 {
-    if (!isValidCellPos(row, col) || rowsM.isFieldNA(row, col))
+    if (!isValidCellPos(row, col) || !ensureRowLoaded(row)
+        || rowsM.isFieldNA(row, col))
         return wxEmptyString;
 
     const wxString sTextDelim =
@@ -424,7 +452,7 @@ Database *DataGridTable::getDatabase()
 
 wxString DataGridTable::GetValue(int row, int col)
 {
-    if (!isValidCellPos(row, col))
+    if (!isValidCellPos(row, col) || !ensureRowLoaded(row))
         return wxEmptyString;
 
     // keep between 200 and 250 more rows fetched for better responsiveness
@@ -438,18 +466,27 @@ wxString DataGridTable::GetValue(int row, int col)
     if (rowsM.isFieldNull(row, col))
         return "[null]";
     // limit returned string to first line (speeds up output in grid)
-    wxString s(rowsM.getFieldValue(row, col));
+    wxString s(rowsM.getFieldPreview(row, col));
     size_t eol = s.find_first_of("\r\n");
     if (eol != wxString::npos)
         s.erase(eol);
     return s;
 }
 
-void DataGridTable::initialFetch(bool readonly)
+const DataGridFetchTimes& DataGridTable::getFetchTimes() const
+{
+    return fetchTimesM;
+}
+
+void DataGridTable::initialFetch(bool readonly, bool scrollable)
 {
+    initialFetchStartM = std::chrono::steady_clock::now();
+    fetchTimesM.firstRowMs = fetchTimesM.fetchMs = fetchTimesM.bufferMs = 0;
     Clear();
     allRowsFetchedM = false;
-    readOnlyM = readonly;
+    pagingFailedM = false;
+    // rows of a scrollable cursor can't be changed
+    readOnlyM = readonly || scrollable;
     canInsertRowsIsSetM = false;
     canInsertRowsM = false;
     maxRowToFetchM = 100;
@@ -478,10 +515,182 @@ void DataGridTable::initialFetch(bool readonly)
 
     if (statementM->Type() == IBPP::stExecProcedure)
         fetchOne();
+    else if (scrollable)
+        fetchScrollable();
     else
         fetch();
 }
 
+void DataGridTable::fetchScrollable()
+{
+    allRowsFetchedM = true;
+    if (rowsM.getRowFieldCount() == 0)
+        return;
+
+    // the first page is shown right away, the cursor can't tell the number
+    // of rows, so they are counted afterwards in countScrollableRows()
+    rowsM.setPaged(scrollablePageSize, scrollablePageSize,
+        scrollableMaxPages);
+    unsigned rows = loadPage(0);
+    rowsM.setPagedRowCount(rows);
+    scrollableMissingRowM = 0;
+    if (rows == 0)
+        return;
+    fetchTimesM.firstRowMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - initialFetchStartM).count();
+    if (rows == scrollablePageSize && !pagingFailedM)
+    {
+        // counting can be stopped like fetching all records
+        allRowsFetchedM = false;
+        fetchAllRowsM = true;
+    }
+
+    if (GetView())   // notify the grid
+    {
+        wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, rows);
+        GetView()->ProcessTableMessage(msg);
+        // used in frame to update status bar
+        wxCommandEvent evt(wxEVT_FRDG_ROWCOUNT_CHANGED, GetView()->GetId());
+        evt.SetExtraLong(rows);
+        wxPostEvent(GetView(), evt);
+    }
+}
+
+void DataGridTable::countScrollableRows()
+{
+    // the last row is looked for: the position is doubled until there is
+    // no row, then the gap between the last existing and the first missing
+    // row is halved; every existing row found is added to the grid
+    unsigned oldRows = rowsM.getRowCount();
+    unsigned rows = oldRows;
+    wxLongLong startms = ::wxGetLocalTimeMillis();
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double, std::milli> millis;
+    clock::time_point fetchStart = clock::now();
+    try
+    {
+        do
+        {
+            unsigned position;
+            if (scrollableMissingRowM == 0)
+            {
+                position = (rows > unsigned(INT_MAX) / 2) ? unsigned(INT_MAX)
+                    : rows * 2;
+            }
+            else
+                position = rows + (scrollableMissingRowM - rows) / 2;
+            if (statementM->FetchAbsolute(int(position)))
+                rows = position;
+            else
+                scrollableMissingRowM = position;
+            if (rows == unsigned(INT_MAX) || (scrollableMissingRowM != 0
+                && scrollableMissingRowM - rows <= 1))
+            {
+                allRowsFetchedM = true;
+            }
+        }
+        while (!allRowsFetchedM
+            && ::wxGetLocalTimeMillis() - startms <= 100);
+    }
+    catch (IBPP::Exception& e)
+    {
+        allRowsFetchedM = true;
+        ::wxMessageBox(e.what(),
+            _("An IBPP error occurred."), wxOK | wxICON_ERROR);
+    }
+    fetchTimesM.fetchMs += millis(clock::now() - fetchStart).count();
+
+    rowsM.setPagedRowCount(rows);
+    if (rows > oldRows && GetView())   // notify the grid
+    {
+        wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_APPENDED,
+            rows - oldRows);
+        GetView()->ProcessTableMessage(msg);
+        // used in frame to update status bar
+        wxCommandEvent evt(wxEVT_FRDG_ROWCOUNT_CHANGED, GetView()->GetId());
+        evt.SetExtraLong(rows);
+        wxPostEvent(GetView(), evt);
+    }
+}
+
+unsigned DataGridTable::clearScrollable()
+{
+    if (!rowsM.isPaged())
+        return 0;
+    unsigned rows = rowsM.getRowCount();
+    Clear();
+    return rows;
+}
+
+bool DataGridTable::ensureRowLoaded(int row)
+{
+    if (row < 0 || unsigned(row) >= rowsM.getRowCount())
+        return !rowsM.isPaged();
+    if (rowsM.isRowLoaded(row))
+        return true;
+    if (pagingFailedM)
+        return false;
+    if (rowsM.isPaged())
+    {
+        loadPage(row / rowsM.getPageSize());
+        return rowsM.isRowLoaded(row);
+    }
+    // rows spilled to the temporary file are read back
+    try
+    {
+        return rowsM.loadSpilledRow(row);
+    }
+    catch (std::exception& e)
+    {
+        pagingFailedM = true;
+        ::wxMessageBox(e.what(), _("Error"), wxOK | wxICON_ERROR);
+        return false;
+    }
+}
+
+unsigned DataGridTable::loadPage(unsigned page)
+{
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double, std::milli> millis;
+
+    unsigned first = page * rowsM.getPageSize();
+    unsigned count = std::min(rowsM.getPageSize(),
+        rowsM.getRowCount() - first);
+    std::vector<DataGridRowBuffer*> buffers;
+    buffers.reserve(count);
+    try
+    {
+        // positions of the cursor are 1-based
+        clock::time_point fetchStart = clock::now();
+        bool fetched = statementM->FetchAbsolute(int(first + 1));
+        while (fetched)
+        {
+            clock::time_point bufferStart = clock::now();
+            fetchTimesM.fetchMs += millis(bufferStart - fetchStart).count();
+            buffers.push_back(rowsM.createRow(statementM));
+            fetchTimesM.bufferMs += millis(clock::now() - bufferStart).count();
+            if (buffers.size() == count)
+                break;
+            fetchStart = clock::now();
+            fetched = statementM->Fetch();
+        }
+    }
+    catch (IBPP::Exception& e)
+    {
+        pagingFailedM = true;
+        ::wxMessageBox(e.what(),
+            _("An IBPP error occurred."), wxOK | wxICON_ERROR);
+    }
+    catch (...)
+    {
+        pagingFailedM = true;
+        ::wxMessageBox(_("A system error occurred!"), _("Error"),
+            wxOK | wxICON_ERROR);
+    }
+    rowsM.addPage(page, buffers);
+    return buffers.size();
+}
+
 bool DataGridTable::IsEmptyCell(int row, int col)
 {
     return !isValidCellPos(row, col);
@@ -515,6 +724,8 @@ bool DataGridTable::isValidCellPos(int row, int col)
 
 bool DataGridTable::canInsertRows()
 {
+    if (rowsM.isPaged())
+        return false;
     if (!canInsertRowsIsSetM)
     {
         wxArrayString tables;
@@ -559,6 +770,31 @@ void DataGridTable::setBlob(DataGridRowsBlob &b)
     rowsM.setBlob(b);
 }
 
+void DataGridTable::setBlobPreviewHandler(wxEvtHandler* handler)
+{
+    if (!handler)
+    {
+        rowsM.setBlobPreviewNotify(BlobPreviewLoader::NotifyFunction());
+        return;
+    }
+    // called from the worker thread, so the event has to be queued
+    rowsM.setBlobPreviewNotify([handler]()
+    {
+        wxQueueEvent(handler,
+            new wxCommandEvent(wxEVT_FRDG_BLOBPREVIEWS, wxID_ANY));
+    });
+}
+
+bool DataGridTable::applyBlobPreviews()
+{
+    return rowsM.applyBlobPreviews();
+}
+
+void DataGridTable::cancelBlobPreviews()
+{
+    rowsM.cancelBlobPreviews();
+}
+
 void DataGridTable::importBlobFile(const wxString& filename, int row, int col,
     ProgressIndicator *pi)
 {
@@ -680,7 +916,146 @@ bool DataGridTable::DeleteRows(size_t pos, size_t numRows)
     return false;
 }
 
+bool DataGridTable::deleteRows(const wxArrayInt& rows, ProgressIndicator* pi)
+{
+    // Needs explicit exception handling (see comment for SetValue)
+    try
+    {
+        std::vector<size_t> rowsToDelete(rows.begin(), rows.end());
+        wxString statement;
+        if (!rowsM.removeRows(rowsToDelete, statement, pi))
+            return false;
+
+        // used in frame to show executed statements
+        wxGrid* grid = GetView();
+        wxCommandEvent evt(wxEVT_FRDG_STATEMENT, grid->GetId());
+        evt.SetString(statement);
+        wxPostEvent(grid, evt);
+
+        grid->ForceRefresh();
+        return true;
+    }
+    catch (const FRError& err)
+    {
+        showErrorDialog(wxGetTopLevelParent(wxGetActiveWindow()),
+            _("Invalid data"), err.what(),
+            AdvancedMessageDialogButtonsOk());
+    }
+    catch (const IBPP::Exception& e)
+    {
+        showErrorDialog(wxGetTopLevelParent(wxGetActiveWindow()),
+            _("Database error"), e.what(),
+            AdvancedMessageDialogButtonsOk());
+    }
+    catch (...)
+    {
+        showErrorDialog(wxGetTopLevelParent(wxGetActiveWindow()),
+            _("System error"), _("Unhandled exception"),
+            AdvancedMessageDialogButtonsOk());
+    }
+    return false;
+}
+
+bool DataGridTable::setValuesToNull(const wxGridCellCoordsArray& cells,
+    ProgressIndicator* pi)
+{
+    // Needs explicit exception handling (see comment for SetValue)
+    try
+    {
+        if (pi)
+            pi->initProgress(_("Setting fields to NULL"), cells.size());
+
+        // blob columns need a second statement to clear the blob
+        size_t statementCount = cells.size();
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            if (isBlobColumn(cells[i].GetCol(), 0))
+                ++statementCount;
+        }
+
+        wxString statements;
+        rowsM.beginBatch(statementCount);
+        try
+        {
+            for (size_t i = 0; i < cells.size(); ++i)
+            {
+                if (pi)
+                {
+                    if (pi->isCanceled())
+                    {
+                        rowsM.rollbackBatch();
+                        return false;
+                    }
+                    pi->stepProgress();
+                }
+
+                int row = cells[i].GetRow();
+                int col = cells[i].GetCol();
+                if (!statements.empty())
+                    statements += wxTextBuffer::GetEOL();
+                statements += rowsM.setFieldValue(row, col, "[null]", true);
+                if (isBlobColumn(col, 0))
+                {
+                    // set blob to null
+                    DataGridRowsBlob b;
+                    b.blob = 0;
+                    b.col  = col;
+                    b.row  = row;
+                    b.st   = statementM;
+                    rowsM.setBlob(b);
+                }
+            }
+        }
+        catch (...)
+        {
+            // don't let a failed rollback hide the original error
+            try
+            {
+                rowsM.rollbackBatch();
+            }
+            catch (...)
+            {
+            }
+            throw;
+        }
+        rowsM.commitBatch();
+
+        if (wxGrid* grid = GetView())
+        {
+            // used in frame to show executed statements
+            wxCommandEvent evt(wxEVT_FRDG_STATEMENT, grid->GetId());
+            evt.SetString(statements);
+            wxPostEvent(grid, evt);
+
+            // used in frame to repaint cells (text color may have changed)
+            wxCommandEvent evt2(wxEVT_FRDG_INVALIDATEATTR, grid->GetId());
+            wxPostEvent(grid, evt2);
+        }
+        return true;
+    }
+    catch (const FRError& err)
+    {
+        showErrorDialog(wxGetTopLevelParent(wxGetActiveWindow()),
+            _("Invalid data"), err.what(),
+            AdvancedMessageDialogButtonsOk());
+    }
+    catch (const IBPP::Exception& e)
+    {
+        showErrorDialog(wxGetTopLevelParent(wxGetActiveWindow()),
+            _("Database error"), e.what(),
+            AdvancedMessageDialogButtonsOk());
+    }
+    catch (...)
+    {
+        showErrorDialog(wxGetTopLevelParent(wxGetActiveWindow()),
+            _("System error"), _("Unhandled exception"),
+            AdvancedMessageDialogButtonsOk());
+    }
+    return false;
+}
+
 DEFINE_EVENT_TYPE(wxEVT_FRDG_ROWCOUNT_CHANGED)
 DEFINE_EVENT_TYPE(wxEVT_FRDG_STATEMENT)
 DEFINE_EVENT_TYPE(wxEVT_FRDG_INVALIDATEATTR)
+DEFINE_EVENT_TYPE(wxEVT_FRDG_BLOBPREVIEWS)
 
@@ -27,6 +27,8 @@
 #include <wx/wx.h>
 #include <wx/grid.h>
 
+#include <chrono>
+
 #include <ibpp.h>
 
 #include "gui/controls/DataGridRows.h"
@@ -47,8 +49,21 @@ BEGIN_DECLARE_EVENT_TYPES()
     // this event is sent to cause the attribute cache to be invalidated
     // after a field value has changed
     DECLARE_LOCAL_EVENT_TYPE(wxEVT_FRDG_INVALIDATEATTR, 44)
+    // this event is sent when blob contents have been read in the background
+    DECLARE_LOCAL_EVENT_TYPE(wxEVT_FRDG_BLOBPREVIEWS, 45)
 END_DECLARE_EVENT_TYPES()
 
+// time spent fetching the rows of the current result set, in milliseconds
+struct DataGridFetchTimes
+{
+    // from the start of initialFetch() until the first row was returned
+    double firstRowMs;
+    // spent in IBPP::Statement::Fetch(), client library and server
+    double fetchMs;
+    // spent copying the fetched rows into the row buffers
+    double bufferMs;
+};
+
 class DataGridTable: public wxGridTableBase
 {
 private:
@@ -63,6 +78,14 @@ private:
     DataGridRows rowsM;
 
     bool nullFlagM;
+    // set when loading a page of a scrollable cursor or reading rows back
+    // from the temporary file failed, no further rows are loaded then
+    bool pagingFailedM;
+    // first position known to have no row while the rows of a scrollable
+    // cursor are counted, 0 if none has been found yet
+    unsigned scrollableMissingRowM;
+    DataGridFetchTimes fetchTimesM;
+    std::chrono::steady_clock::time_point initialFetchStartM;
 
     Database *databaseM;
     IBPP::Statement& statementM;
@@ -70,6 +93,14 @@ private:
 
     int getStatementColCount();
     bool isValidCellPos(int row, int col);
+    // loads the page containing the row if necessary, from the scrollable
+    // cursor or the temporary file of spilled rows; errors are shown here,
+    // as the callers are used while painting
+    bool ensureRowLoaded(int row);
+    // returns the number of rows loaded
+    unsigned loadPage(unsigned page);
+    void fetchScrollable();
+    void countScrollableRows();
 public:
     DataGridTable(IBPP::Statement& s, Database* db);
     ~DataGridTable();
@@ -82,6 +113,7 @@ public:
     wxString getCellValueForInsert(int row, int col);
     wxString getCellValueForCSV(int row, int col, const wxChar& textDelimiter);
     bool getFetchAllRows();
+    const DataGridFetchTimes& getFetchTimes() const;
 
     // TODO: these should be replaced with a better function that covers all
     wxString getTableName();
@@ -90,7 +122,12 @@ public:
     void getFields(const wxString& table, FieldSet& fields);
     Database *getDatabase();
 
-    void initialFetch(bool readonly);
+    // scrollable: the statement was executed with ExecuteScrollable(), the
+    // grid then shows all rows but keeps only pages of them in memory
+    void initialFetch(bool readonly, bool scrollable = false);
+    // removes the rows of a scrollable cursor, which can't be loaded any
+    // more once the statement is closed, returns the number of rows removed
+    unsigned clearScrollable();
     bool isNullableColumn(int col);
     bool isNullCell(int row, int col);
     bool isNumericColumn(int col);
@@ -120,7 +157,17 @@ public:
     IBPP::Blob* getBlob(unsigned row, unsigned col, bool validateBlob);
     DataGridRowsBlob setBlobPrepare(unsigned row, unsigned col);
     void setBlob(DataGridRowsBlob &b);
+    // blob contents shown in the grid are read in the background, handler
+    // receives wxEVT_FRDG_BLOBPREVIEWS when applyBlobPreviews() should be
+    // called
+    void setBlobPreviewHandler(wxEvtHandler* handler);
+    bool applyBlobPreviews();
+    void cancelBlobPreviews();
     void setValueToNull(int row, int col);
+    // change sets: all rows / fields are changed, or none of them
+    bool deleteRows(const wxArrayInt& rows, ProgressIndicator* pi = 0);
+    bool setValuesToNull(const wxGridCellCoordsArray& cells,
+        ProgressIndicator* pi = 0);
     // BLOBs can be huge, so we don't use SetValue for that
     void importBlobFile(const wxString& filename, int row, int col,
         ProgressIndicator *pi = 0);
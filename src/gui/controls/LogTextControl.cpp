@@ -35,7 +35,7 @@
 #include "gui/controls/LogTextControl.h"
 
 LogTextControl::LogTextControl(wxWindow *parent, wxWindowID id)
-    : TextControl(parent, id)
+    : TextControl(parent, id), maxLinesM(0)
 {
     SetReadOnly(true);
     setDefaultStyles();
@@ -58,8 +58,9 @@ void LogTextControl::addStyledText(const wxString& message, LogStyle style)
     int len = GetLength();
     StartStyling(lenBefore);
     SetStyling(len - lenBefore - 1, int(style));
+    trimToMaxLines();
     if (atEnd)
-        GotoPos(len);
+        GotoPos(GetLength());
     SetReadOnly(true);
 }
 
@@ -70,6 +71,25 @@ void LogTextControl::ClearAll()
     SetReadOnly(true);
 }
 
+void LogTextControl::setMaxLines(int maxLines)
+{
+    maxLinesM = maxLines;
+    SetReadOnly(false);
+    trimToMaxLines();
+    SetReadOnly(true);
+}
+
+void LogTextControl::trimToMaxLines()
+{
+    // last line is always empty since messages end with a line break
+    int lines = GetLineCount() - 1;
+    // remove in chunks, deleting from the start of the control is expensive
+    if (maxLinesM <= 0 || lines <= maxLinesM + maxLinesM / 10)
+        return;
+    int pos = PositionFromLine(lines - maxLinesM);
+    DeleteRange(0, pos);
+}
+
 void LogTextControl::logErrorMsg(const wxString& message)
 {
     addStyledText(message, logStyleError);
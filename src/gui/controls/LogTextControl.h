@@ -29,7 +29,9 @@
 class LogTextControl: public TextControl
 {
 private:
+    int maxLinesM;
     void setDefaultStyles();
+    void trimToMaxLines();
 protected:
     enum LogStyle { logStyleDefault, logStyleImportant, logStyleError };
     void addStyledText(const wxString& message, LogStyle style);
@@ -37,6 +39,8 @@ public:
     LogTextControl(wxWindow *parent, wxWindowID id = wxID_ANY);
 
     void ClearAll();
+    // keeps only the last maxLines lines, 0 for no limit
+    void setMaxLines(int maxLines);
 
     void logErrorMsg(const wxString& message);
     void logImportantMsg(const wxString& message);
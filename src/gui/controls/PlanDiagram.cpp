@@ -0,0 +1,219 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <wx/dcbuffer.h>
+#include <wx/numformatter.h>
+
+#include <algorithm>
+
+#include "gui/controls/PlanDiagram.h"
+
+static const int diagramMargin = 10;
+static const int diagramIndent = 30;
+static const int boxPadding = 6;
+static const int boxSpacing = 8;
+
+static bool hasLargeNaturalScan(const std::vector<PlanNode>& nodes)
+{
+    for (std::vector<PlanNode>::const_iterator it = nodes.begin();
+        it != nodes.end(); ++it)
+    {
+        if ((*it).largeNaturalScan || hasLargeNaturalScan((*it).children))
+            return true;
+    }
+    return false;
+}
+
+static wxColour getBoxColour(const PlanNode& node)
+{
+    switch (node.kind)
+    {
+        case PlanNode::pnStatement:
+            return wxColour(235, 235, 235);
+        case PlanNode::pnJoin:
+            return wxColour(220, 230, 250);
+        case PlanNode::pnIndexScan:
+            return wxColour(220, 245, 220);
+        case PlanNode::pnNaturalScan:
+            if (node.largeNaturalScan)
+                return wxColour(255, 215, 215);
+            return wxColour(255, 240, 210);
+        default:
+            return *wxWHITE;
+    }
+}
+
+PlanDiagram::PlanDiagram(wxWindow* parent, wxWindowID id)
+    : wxScrolledWindow(parent, id, wxDefaultPosition, wxDefaultSize,
+        wxBORDER_THEME | wxHSCROLL | wxVSCROLL)
+{
+    SetBackgroundStyle(wxBG_STYLE_PAINT);
+    SetScrollRate(10, 10);
+    Bind(wxEVT_PAINT, &PlanDiagram::OnPaint, this);
+    Bind(wxEVT_LEFT_DOWN, &PlanDiagram::OnLeftDown, this);
+}
+
+ExplainedPlanPtr PlanDiagram::getPlan()
+{
+    return planM;
+}
+
+void PlanDiagram::setPlan(ExplainedPlanPtr plan)
+{
+    if (plan != planM)
+    {
+        planM = plan;
+        collapsedM.clear();
+        Scroll(0, 0);
+    }
+    layout();
+    Refresh();
+}
+
+void PlanDiagram::addBoxes(wxDC& dc, const std::vector<PlanNode>& nodes,
+    int depth, int parent, int& y, int& width)
+{
+    for (std::vector<PlanNode>::const_iterator it = nodes.begin();
+        it != nodes.end(); ++it)
+    {
+        bool collapsed = collapsedM.count(&(*it)) > 0;
+        Box box;
+        box.node = &(*it);
+        box.parent = parent;
+        box.warning = (*it).largeNaturalScan;
+
+        if (!(*it).children.empty())
+            box.label = collapsed ? "[+] " : "[-] ";
+        box.label += (*it).text;
+        if ((*it).estimatedRows >= 0)
+        {
+            box.label += "\n" + wxString::Format(_("Estimated records: %s"),
+                wxNumberFormatter::ToString((*it).estimatedRows, 0));
+        }
+        if ((*it).largeNaturalScan)
+            box.label += "\n" + _("Natural scan of a large table");
+        else if (collapsed && hasLargeNaturalScan((*it).children))
+        {
+            box.label += "\n" + _("Contains natural scans of large tables");
+            box.warning = true;
+        }
+
+        wxCoord w, h;
+        dc.GetMultiLineTextExtent(box.label, &w, &h);
+        box.rect = wxRect(diagramMargin + depth * diagramIndent, y,
+            w + 2 * boxPadding, h + 2 * boxPadding);
+        y += box.rect.GetHeight() + boxSpacing;
+        width = std::max(width, box.rect.GetRight());
+
+        boxesM.push_back(box);
+        if (!collapsed)
+        {
+            addBoxes(dc, (*it).children, depth + 1, int(boxesM.size()) - 1, y,
+                width);
+        }
+    }
+}
+
+void PlanDiagram::layout()
+{
+    boxesM.clear();
+    int y = diagramMargin;
+    int width = 0;
+    if (planM)
+    {
+        wxClientDC dc(this);
+        dc.SetFont(GetFont());
+        addBoxes(dc, planM->getRoots(), 0, -1, y, width);
+    }
+    SetVirtualSize(width + diagramMargin, y + diagramMargin);
+}
+
+void PlanDiagram::OnLeftDown(wxMouseEvent& event)
+{
+    wxPoint pt(CalcUnscrolledPosition(event.GetPosition()));
+    for (std::vector<Box>::iterator it = boxesM.begin(); it != boxesM.end();
+        ++it)
+    {
+        if (!(*it).rect.Contains(pt) || (*it).node->children.empty())
+            continue;
+        if (collapsedM.erase((*it).node) == 0)
+            collapsedM.insert((*it).node);
+        layout();
+        Refresh();
+        return;
+    }
+    event.Skip();
+}
+
+void PlanDiagram::OnPaint(wxPaintEvent& WXUNUSED(event))
+{
+    wxAutoBufferedPaintDC dc(this);
+    DoPrepareDC(dc);
+    dc.SetBackground(*wxWHITE_BRUSH);
+    dc.Clear();
+    dc.SetFont(GetFont());
+    dc.SetTextForeground(*wxBLACK);
+
+    if (!planM)
+    {
+        dc.DrawText(_("No explained plan available. It needs Firebird 3 or newer."),
+            diagramMargin, diagramMargin);
+        return;
+    }
+
+    // connectors run down from the parent and right to the input
+    dc.SetPen(*wxGREY_PEN);
+    for (std::vector<Box>::iterator it = boxesM.begin(); it != boxesM.end();
+        ++it)
+    {
+        if ((*it).parent < 0)
+            continue;
+        const wxRect& parent = boxesM[(*it).parent].rect;
+        int x = parent.GetLeft() + diagramIndent / 2;
+        int y = (*it).rect.GetTop() + (*it).rect.GetHeight() / 2;
+        dc.DrawLine(x, parent.GetBottom(), x, y);
+        dc.DrawLine(x, y, (*it).rect.GetLeft(), y);
+    }
+
+    for (std::vector<Box>::iterator it = boxesM.begin(); it != boxesM.end();
+        ++it)
+    {
+        if ((*it).warning)
+            dc.SetPen(wxPen(*wxRED, 2));
+        else
+            dc.SetPen(*wxGREY_PEN);
+        dc.SetBrush(wxBrush(getBoxColour(*(*it).node)));
+        dc.DrawRectangle((*it).rect);
+        dc.DrawText((*it).label, (*it).rect.GetLeft() + boxPadding,
+            (*it).rect.GetTop() + boxPadding);
+    }
+}
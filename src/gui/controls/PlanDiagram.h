@@ -0,0 +1,66 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_PLANDIAGRAM_H
+#define FR_PLANDIAGRAM_H
+
+#include <wx/scrolwin.h>
+
+#include <set>
+#include <vector>
+
+#include "engine/ExplainedPlan.h"
+
+// Draws an explained plan as boxes below and right of the operations that
+// read from them.  Clicking a box collapses or expands its inputs, natural
+// scans of large tables are drawn in red.
+class PlanDiagram: public wxScrolledWindow
+{
+private:
+    struct Box
+    {
+        const PlanNode* node;
+        wxString label;
+        wxRect rect;
+        // index of the box of the parent node, -1 for statements
+        int parent;
+        bool warning;
+    };
+    ExplainedPlanPtr planM;
+    std::set<const PlanNode*> collapsedM;
+    std::vector<Box> boxesM;
+
+    void addBoxes(wxDC& dc, const std::vector<PlanNode>& nodes, int depth,
+        int parent, int& y, int& width);
+    void layout();
+
+    void OnLeftDown(wxMouseEvent& event);
+    void OnPaint(wxPaintEvent& event);
+public:
+    PlanDiagram(wxWindow* parent, wxWindowID id = wxID_ANY);
+
+    ExplainedPlanPtr getPlan();
+    void setPlan(ExplainedPlanPtr plan);
+};
+
+#endif // FR_PLANDIAGRAM_H
@@ -120,6 +120,11 @@ FBCLIENT* FBCLIENT::Call()
 	// The load is guaranteed to be done only once per application.
 	// Loading order : specifically defined path > local directory fbembed > local directory fbclient > PATH and System directories > Look at Win registry for Fb setup folder > gds32.dll
 
+	if (mReady)
+		return this;
+
+	// Concurrent first calls must not load the library more than once
+	std::lock_guard<std::mutex> guard(mLoadMutex);
 	if (! mReady)
 	{
 #ifdef IBPP_WINDOWS
@@ -356,6 +361,8 @@ FBCLIENT* FBCLIENT::Call()
 		IB_ENTRYPOINT(service_query);
 
 		FB_ENTRYPOINT_NOTHROW(get_master_interface);
+		FB_ENTRYPOINT_NOTHROW(get_transaction_interface);
+		FB_ENTRYPOINT_NOTHROW(get_statement_interface);
 
 		mReady = true;
 	}
@@ -51,7 +51,11 @@
 #include <windows.h>
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <limits>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -391,6 +395,14 @@ typedef void        ISC_EXPORT proto_encode_timestamp (void *,
 //
 typedef Firebird::IMaster* ISC_EXPORT proto_get_master_interface();
 
+//
+//  FB4+ / interfaces of legacy handles (fb_get_..._interface)
+//
+typedef ISC_STATUS ISC_EXPORT proto_get_transaction_interface(ISC_STATUS*,
+                    void*, isc_tr_handle*);
+typedef ISC_STATUS ISC_EXPORT proto_get_statement_interface(ISC_STATUS*,
+                    void*, isc_stmt_handle*);
+
 //
 //  Internal binding structure to the FBCLIENT DLL
 //
@@ -398,7 +410,8 @@ typedef Firebird::IMaster* ISC_EXPORT proto_get_master_interface();
 struct FBCLIENT
 {
     // Attributes
-    bool mReady;
+    std::atomic<bool> mReady;
+    std::mutex mLoadMutex;      // Serializes the loading of the library
     std::string mfbdll;
 
 #ifdef IBPP_WINDOWS
@@ -474,6 +487,8 @@ struct FBCLIENT
     //proto_encode_timestamp*           m_encode_timestamp;
 
     proto_get_master_interface*     m_get_master_interface;
+    proto_get_transaction_interface*    m_get_transaction_interface;
+    proto_get_statement_interface*  m_get_statement_interface;
 
     // Constructor (No need for a specific destructor)
     FBCLIENT()
@@ -755,12 +770,13 @@ class ServiceImpl : public IBPP::IService
     //  (((((((( OBJECT INTERNALS ))))))))
 
 private:
-    int mRefCount;              // Reference counter
+    std::atomic<int> mRefCount; // Reference counter
     isc_svc_handle mHandle;     // Firebird API Service Handle
     std::string mServerName;    // Server Name
     std::string mUserName;      // User Name
     std::string mUserPassword;  // User Password
     std::string mWaitMessage;   // Progress message returned by WaitMsg()
+    std::string mWaitBuffer;    // Incomplete output line kept by WaitMsgs()
     std::string mRoleName;      // Role used for the duration of the connection
     std::string mCharSet;       // Character Set used for the connection
 
@@ -786,7 +802,7 @@ public:
                 const std::string& CharSet
         );
     ~ServiceImpl();
-    FBCLIENT getGDS() const { return gds; };
+    FBCLIENT& getGDS() const { return gds; };
 
     //  (((((((( OBJECT INTERFACE ))))))))
 
@@ -814,6 +830,7 @@ public:
     void Restart(const std::string& dbfile, IBPP::DSM flags);
     void Sweep(const std::string& dbfile);
     void Repair(const std::string& dbfile, IBPP::RPF flags);
+    void StartIndexStatistics(const std::string& dbfile, bool systemRelations);
 
     void StartBackup(
         const std::string& dbfile, const std::string& bkfile, const std::string& outfile = "",
@@ -831,6 +848,7 @@ public:
     );
 
     const char* WaitMsg();
+    bool WaitMsgs(std::vector<std::string>& lines);
     void Wait();
 
     IBPP::IService* AddRef();
@@ -843,7 +861,7 @@ class DatabaseImpl : public IBPP::IDatabase
 
     FBCLIENT gdsM;	// Local GDS instance
 
-    int mRefCount;              // Reference counter
+    std::atomic<int> mRefCount; // Reference counter
     isc_db_handle mHandle;      // InterBase API Session Handle
     std::string mServerName;    // Server name
     std::string mDatabaseName;  // Database name (path/file)
@@ -859,6 +877,7 @@ class DatabaseImpl : public IBPP::IDatabase
     std::vector<BlobImpl*> mBlobs;          // Table of Blob*
     std::vector<ArrayImpl*> mArrays;        // Table of Array*
     std::vector<EventsImpl*> mEvents;       // Table of Events*
+    std::mutex mAttachMutex;                // Guards the tables above
 
 public:
     isc_db_handle* GetHandlePtr() { return &mHandle; }
@@ -880,7 +899,7 @@ public:
                 const std::string& RoleName, const std::string& CharSet,
                 const std::string& CreateParams);
     ~DatabaseImpl();
-    FBCLIENT getGDS() const { return gds; };
+    FBCLIENT& getGDS() const { return gds; };
 
     //  (((((((( OBJECT INTERFACE ))))))))
 
@@ -923,7 +942,7 @@ class TransactionImpl : public IBPP::ITransaction
     //  (((((((( OBJECT INTERNALS ))))))))
 
 private:
-    int mRefCount;                  // Reference counter
+    std::atomic<int> mRefCount;     // Reference counter
     isc_tr_handle mHandle;          // Transaction InterBase
 
     std::vector<DatabaseImpl*> mDatabases;      // Table of IDatabase*
@@ -931,6 +950,7 @@ private:
     std::vector<BlobImpl*> mBlobs;              // Table of IBlob*
     std::vector<ArrayImpl*> mArrays;            // Table of Array*
     std::vector<TPB*> mTPBs;                    // Table of TPB
+    std::mutex mAttachMutex;                    // Guards the tables above
 
     void Init();            // A usage exclusif des constructeurs
 
@@ -954,7 +974,7 @@ public:
         IBPP::TLR lr = IBPP::lrWait, IBPP::TFF flags = IBPP::TFF(0));
     ~TransactionImpl();
 
-    FBCLIENT getGDS() const { return gds; };
+    FBCLIENT& getGDS() const { return gds; };
 
     //  (((((((( OBJECT INTERFACE ))))))))
 
@@ -982,7 +1002,7 @@ class RowImpl : public IBPP::IRow
     //  (((((((( OBJECT INTERNALS ))))))))
 
 private:
-    int mRefCount;                  // Reference counter
+    std::atomic<int> mRefCount;     // Reference counter
 
     XSQLDA* mDescrArea;             // XSQLDA descriptor itself
     std::vector<double> mNumerics;  // Temporary storage for Numerics
@@ -1104,7 +1124,7 @@ class StatementImpl : public IBPP::IStatement
 private:
     friend class TransactionImpl;
 
-    int mRefCount;              // Reference counter
+    std::atomic<int> mRefCount; // Reference counter
     isc_stmt_handle mHandle;    // Statement Handle
 
     DatabaseImpl* mDatabase;        // Attached database
@@ -1117,8 +1137,16 @@ private:
     IBPP::STT mType;            // Type de requète
     std::string mSql;           // Last SQL statement prepared or executed
 
+    // Scrollable cursor opened by ExecuteScrollable(), the rows are fetched
+    // into mScrollBuffer (laid out by mScrollMetadata) and copied to mOutRow
+    Firebird::IResultSet* mScrollCursor;
+    Firebird::IMessageMetadata* mScrollMetadata;
+    std::vector<char> mScrollBuffer;
+
     // Internal Methods
     void CursorFree();
+    void ScrollCursorFree();
+    void ScrollRowFetched();
 
 public:
     // Properties and Attributes Access Methods
@@ -1131,7 +1159,7 @@ public:
 
     StatementImpl(DatabaseImpl*, TransactionImpl*);
     ~StatementImpl();
-    FBCLIENT getGDS() const { return mDatabase->getGDS(); };
+    FBCLIENT& getGDS() const { return mDatabase->getGDS(); };
 
     //  (((((((( OBJECT INTERFACE ))))))))
 
@@ -1145,7 +1173,10 @@ public:
     inline void CursorExecute(const std::string& cursor)    { CursorExecute(cursor, std::string()); }
     bool Fetch();
     bool Fetch(IBPP::Row&);
+    void ExecuteScrollable();
+    bool FetchAbsolute(int position);
     int AffectedRows();
+    void RecordCounts(int& selects, int& inserts, int& updates, int& deletes);
     void Close();   // Free resources, attachments maintained
     std::string& Sql() { return mSql; }
     IBPP::STT Type() { return mType; }
@@ -1263,6 +1294,7 @@ public:
     int Parameters();
 
     void Plan(std::string&);
+    void ExplainedPlan(std::string&);
 
     IBPP::Database DatabasePtr() const;
     IBPP::Transaction TransactionPtr() const;
@@ -1278,7 +1310,7 @@ class BlobImpl : public IBPP::IBlob
 private:
     friend class RowImpl;
 
-    int mRefCount;
+    std::atomic<int> mRefCount;
     bool                    mIdAssigned;
     ISC_QUAD                mId;
     isc_blob_handle         mHandle;
@@ -1299,7 +1331,7 @@ public:
     BlobImpl(const BlobImpl&);
     BlobImpl(DatabaseImpl*, TransactionImpl* = 0);
     ~BlobImpl();
-    FBCLIENT getGDS() const { return mDatabase->getGDS(); };
+    FBCLIENT& getGDS() const { return mDatabase->getGDS(); };
 
     //  (((((((( OBJECT INTERFACE ))))))))
 
@@ -1329,7 +1361,7 @@ class ArrayImpl : public IBPP::IArray
 private:
     friend class RowImpl;
 
-    int                 mRefCount;      // Reference counter
+    std::atomic<int>    mRefCount;      // Reference counter
     bool                mIdAssigned;
     ISC_QUAD            mId;
     bool                mDescribed;
@@ -1356,7 +1388,7 @@ public:
     ArrayImpl(const ArrayImpl&);
     ArrayImpl(DatabaseImpl*, TransactionImpl* = 0);
     ~ArrayImpl();
-    FBCLIENT getGDS() const { return mDatabase->getGDS(); };
+    FBCLIENT& getGDS() const { return mDatabase->getGDS(); };
 
     //  (((((((( OBJECT INTERFACE ))))))))
 
@@ -1425,12 +1457,15 @@ class EventsImpl : public IBPP::IEvents
     Buffer mEventBuffer;
     Buffer mResultsBuffer;
 
-    int mRefCount;      // Reference counter
+    std::atomic<int> mRefCount; // Reference counter
 
     DatabaseImpl* mDatabase;
     ISC_LONG mId;           // Firebird internal Id of these events
-    bool mQueued;           // Has isc_que_events() been called?
-    bool mTrapped;          // EventHandled() was called since last que_events()
+    // set on the Firebird client thread in EventHandler()
+    std::atomic<bool> mQueued;  // Has isc_que_events() been called?
+    std::atomic<bool> mTrapped; // EventHandled() was called since last que_events()
+    std::mutex mWaitMutex;
+    std::condition_variable mWaitCondition;
 
     void FireActions();
     void Queue();
@@ -1445,7 +1480,7 @@ public:
 
     EventsImpl(DatabaseImpl* dbi);
     ~EventsImpl();
-    FBCLIENT getGDS() const { return mDatabase->getGDS(); };
+    FBCLIENT& getGDS() const { return mDatabase->getGDS(); };
 
 
     //  (((((((( OBJECT INTERFACE ))))))))
@@ -1456,6 +1491,7 @@ public:
     void List(std::vector<std::string>&);
     void Clear();               // Drop all events
     void Dispatch();            // Dispatch NON async events
+    bool Wait(int timeout);
 
     IBPP::Database DatabasePtr() const;
 
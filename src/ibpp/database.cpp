@@ -411,8 +411,8 @@ void DatabaseImpl::Release()
 {
     // Release cannot throw, except in DEBUG builds on assertion
     ASSERTION(mRefCount >= 0);
-    --mRefCount;
-    try { if (mRefCount <= 0) delete this; }
+    int count = --mRefCount;
+    try { if (count <= 0) delete this; }
         catch (...) { }
 }
 
@@ -424,6 +424,7 @@ void DatabaseImpl::AttachTransactionImpl(TransactionImpl* tr)
         throw LogicExceptionImpl("Database::AttachTransaction",
                     _("Transaction object is null."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mTransactions.push_back(tr);
 }
 
@@ -433,6 +434,7 @@ void DatabaseImpl::DetachTransactionImpl(TransactionImpl* tr)
         throw LogicExceptionImpl("Database::DetachTransaction",
                 _("ITransaction object is null."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mTransactions.erase(std::find(mTransactions.begin(), mTransactions.end(), tr));
 }
 
@@ -442,6 +444,7 @@ void DatabaseImpl::AttachStatementImpl(StatementImpl* st)
         throw LogicExceptionImpl("Database::AttachStatement",
                     _("Can't attach a null Statement object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mStatements.push_back(st);
 }
 
@@ -451,6 +454,7 @@ void DatabaseImpl::DetachStatementImpl(StatementImpl* st)
         throw LogicExceptionImpl("Database::DetachStatement",
                 _("Can't detach a null Statement object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mStatements.erase(std::find(mStatements.begin(), mStatements.end(), st));
 }
 
@@ -460,6 +464,7 @@ void DatabaseImpl::AttachBlobImpl(BlobImpl* bb)
         throw LogicExceptionImpl("Database::AttachBlob",
                     _("Can't attach a null Blob object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mBlobs.push_back(bb);
 }
 
@@ -469,6 +474,7 @@ void DatabaseImpl::DetachBlobImpl(BlobImpl* bb)
         throw LogicExceptionImpl("Database::DetachBlob",
                 _("Can't detach a null Blob object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mBlobs.erase(std::find(mBlobs.begin(), mBlobs.end(), bb));
 }
 
@@ -478,6 +484,7 @@ void DatabaseImpl::AttachArrayImpl(ArrayImpl* ar)
         throw LogicExceptionImpl("Database::AttachArray",
                     _("Can't attach a null Array object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mArrays.push_back(ar);
 }
 
@@ -487,6 +494,7 @@ void DatabaseImpl::DetachArrayImpl(ArrayImpl* ar)
         throw LogicExceptionImpl("Database::DetachArray",
                 _("Can't detach a null Array object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mArrays.erase(std::find(mArrays.begin(), mArrays.end(), ar));
 }
 
@@ -496,6 +504,7 @@ void DatabaseImpl::AttachEventsImpl(EventsImpl* ev)
         throw LogicExceptionImpl("Database::AttachEventsImpl",
                     _("Can't attach a null Events object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mEvents.push_back(ev);
 }
 
@@ -505,6 +514,7 @@ void DatabaseImpl::DetachEventsImpl(EventsImpl* ev)
         throw LogicExceptionImpl("Database::DetachEventsImpl",
                 _("Can't detach a null Events object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mEvents.erase(std::find(mEvents.begin(), mEvents.end(), ev));
 }
 
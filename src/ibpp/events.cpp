@@ -172,6 +172,14 @@ void EventsImpl::Dispatch()
 	Queue();
 }
 
+bool EventsImpl::Wait(int timeout)
+{
+	// Without registered events nothing is queued, so this simply times out
+	std::unique_lock<std::mutex> lock(mWaitMutex);
+	return mWaitCondition.wait_for(lock, std::chrono::milliseconds(timeout),
+		[this] { return mTrapped.load(); });
+}
+
 IBPP::Database EventsImpl::DatabasePtr() const
 {
 	if (mDatabase == 0) throw LogicExceptionImpl("Events::DatabasePtr",
@@ -190,8 +198,8 @@ void EventsImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	int count = --mRefCount;
+	try { if (count <= 0) delete this; }
 		catch (...) { }
 }
 
@@ -316,8 +324,14 @@ void EventsImpl::EventHandler(const char* object, short size, const char* tmpbuf
 			if (evi->mEventBuffer.size() < (unsigned)size) size = (short)evi->mEventBuffer.size();
 			for (int i = 0; i < size; i++)
 				rb[i] = tmpbuffer[i];
-			evi->mTrapped = true;
 			evi->mQueued = false;
+			{
+				// wake up Wait(), the lock makes sure the waiting thread
+				// either sees mTrapped or is already waiting
+				std::lock_guard<std::mutex> lock(evi->mWaitMutex);
+				evi->mTrapped = true;
+			}
+			evi->mWaitCondition.notify_all();
 		}
 		catch (...) { }
 	}
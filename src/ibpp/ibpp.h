@@ -7,6 +7,20 @@
 //
 //  Select the platform:    IBPP_WINDOWS | IBPP_LINUX | IBPP_DARWIN
 //
+//  THREADING
+//  Reference counting of all IBPP objects is atomic, and the tables that
+//  link Database and Transaction objects to their Statement, Blob, Array
+//  and Events objects are guarded, so the smart pointers can be copied and
+//  released from any thread.
+//  Distinct Statement, Blob and Array objects may be used concurrently from
+//  different threads, even when they belong to the same Database or
+//  Transaction. A single object however must be used by one thread at a
+//  time, this includes starting, committing and rolling back a Transaction
+//  and connecting and disconnecting a Database. A Database must not be
+//  disconnected while other threads still use its Statements or
+//  Transactions. The Firebird client library serializes calls made on the
+//  same attachment, so parallel work needs separate Database objects.
+//
 
 /*
   (C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
@@ -644,6 +658,10 @@ public:
         virtual void Restart(const std::string& dbfile, DSM flags) = 0;
         virtual void Sweep(const std::string& dbfile) = 0;
         virtual void Repair(const std::string& dbfile, RPF flags) = 0;
+        // Starts the index page analysis ("gstat -i"), the report is
+        // returned by WaitMsg() / WaitMsgs()
+        virtual void StartIndexStatistics(const std::string& dbfile,
+            bool systemRelations = false) = 0;
 
         virtual void StartBackup(
             const std::string& dbfile,const std::string& bkfile, const std::string& outfile = "",
@@ -662,6 +680,9 @@ public:
         ) = 0;
 
         virtual const char* WaitMsg() = 0;  // With reporting (does not block)
+        // With reporting in bulk, appends all available output lines and
+        // returns false when the task has finished
+        virtual bool WaitMsgs(std::vector<std::string>& lines) = 0;
         virtual void Wait() = 0;            // Without reporting (does block)
 
         virtual IService* AddRef() = 0;
@@ -847,7 +868,7 @@ public:
      * Statement object is the work horse of IBPP. All your data manipulation
      * statements will be done through it. It is also used to access the result
      * set of a query (when the statement is such), one row at a time and in
-     * strict forward direction. */
+     * strict forward direction, or, with ExecuteScrollable(), at any position. */
 
     class IStatement
     {
@@ -860,7 +881,16 @@ public:
         virtual void CursorExecute(const std::string& cursor, const std::string&) = 0;
         virtual bool Fetch() = 0;
         virtual bool Fetch(Row&) = 0;
+        // Executes the prepared SELECT with a scrollable cursor (Firebird 4+
+        // client library, Firebird 5+ server for remote connections).
+        // FetchAbsolute() moves to the 1-based row position, Fetch() reads
+        // the row after the current one.  Both return false if there is no
+        // such row, the cursor stays open until the next Execute or Close.
+        virtual void ExecuteScrollable() = 0;
+        virtual bool FetchAbsolute(int position) = 0;
         virtual int AffectedRows() = 0;
+        virtual void RecordCounts(int& selects, int& inserts, int& updates,
+            int& deletes) = 0;
         virtual void Close() = 0;
         virtual std::string& Sql() = 0;
         virtual STT Type() = 0;
@@ -957,6 +987,8 @@ public:
         virtual int Parameters() = 0;
 
         virtual void Plan(std::string&) = 0;
+        // Indented plan tree, needs a Firebird 3 or newer server
+        virtual void ExplainedPlan(std::string&) = 0;
 
         virtual Database DatabasePtr() const = 0;
         virtual Transaction TransactionPtr() const = 0;
@@ -991,6 +1023,11 @@ public:
         virtual void List(std::vector<std::string>&) = 0;
         virtual void Clear() = 0;               // Drop all events
         virtual void Dispatch() = 0;            // Dispatch events (calls handlers)
+        // Blocks until events have been delivered or the timeout (ms) has
+        // elapsed, returns true if Dispatch() will call handlers.  Lets a
+        // dedicated thread own the Events object and dispatch as soon as
+        // Firebird delivers, instead of polling Dispatch() periodically.
+        virtual bool Wait(int) = 0;
 
         virtual Database DatabasePtr() const = 0;
 
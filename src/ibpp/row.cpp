@@ -864,8 +864,8 @@ void RowImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	int count = --mRefCount;
+	try { if (count <= 0) delete this; }
 		catch (...) { }
 }
 
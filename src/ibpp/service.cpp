@@ -599,6 +599,29 @@ void ServiceImpl::Repair(const std::string& dbfile, IBPP::RPF flags)
 	Wait();
 }
 
+void ServiceImpl::StartIndexStatistics(const std::string& dbfile,
+	bool systemRelations)
+{
+	if (mHandle	== 0)
+		throw LogicExceptionImpl("Service::IndexStatistics", _("Service is not connected."));
+	if (dbfile.empty())
+		throw LogicExceptionImpl("Service::IndexStatistics", _("Main database file must be specified."));
+
+	IBS status;
+	SPB spb;
+
+	spb.Insert(isc_action_svc_db_stats);
+	spb.InsertString(isc_spb_dbname, 2, dbfile.c_str());
+
+	unsigned int mask = isc_spb_sts_idx_pages;
+	if (systemRelations) mask |= isc_spb_sts_sys_relations;
+	spb.InsertQuad(isc_spb_options, mask);
+
+	(*getGDS().Call()->m_service_start)(status.Self(), &mHandle, 0, spb.Size(), spb.Self());
+	if (status.Errors())
+		throw SQLExceptionImpl(status, "Service::IndexStatistics", _("isc_service_start failed"));
+}
+
 void ServiceImpl::StartBackup(
     const std::string& dbfile,	const std::string& bkfile, const std::string& /*outfile*/,
     const int factor, IBPP::BRF flags,
@@ -810,6 +833,79 @@ const char* ServiceImpl::WaitMsg()
 	return mWaitMessage.c_str();
 }
 
+bool ServiceImpl::WaitMsgs(std::vector<std::string>& lines)
+{
+	// Servers older than 2.5 don't know isc_info_svc_to_eof, fall back to
+	// retrieving the output line by line
+	if (!versionIsHigherOrEqualTo(2, 5))
+	{
+		const char* msg = WaitMsg();
+		if (msg == 0) return false;
+		lines.push_back(msg);
+		return true;
+	}
+
+	IBS status;
+	SPB req;
+	RB result(32000);
+
+	req.Insert(isc_info_svc_to_eof);	// Request as much output as will fit
+
+	// Without a timeout the server waits until the buffer is full or the
+	// task has finished; wait at most a second, so that progress is shown
+	// and a cancel request is noticed while the task runs.  The value is
+	// preceded by its length (2 bytes), both in VAX byte order.
+	char send[] = { isc_info_svc_timeout, 4, 0, 1, 0, 0, 0 };
+
+	(*getGDS().Call()->m_service_query)(status.Self(), &mHandle, 0,
+		sizeof(send), send, req.Size(),	req.Self(), result.Size(), result.Self());
+	if (status.Errors())
+		throw SQLExceptionImpl(status, "ServiceImpl::WaitMsgs", _("isc_service_query failed"));
+
+	bool more = false;
+	char* p = result.Self();
+	while (*p != isc_info_end)
+	{
+		if (*p == isc_info_svc_to_eof)
+		{
+			int len = (*getGDS().Call()->m_vax_integer)(p+1, 2);
+			if (len > 0)
+			{
+				mWaitBuffer.append(p+3, len);
+				more = true;
+			}
+			p += (3 + len);
+		}
+		else if (*p == isc_info_truncated || *p == isc_info_svc_timeout
+			|| *p == isc_info_data_not_ready)
+		{
+			// Output did not fit into the buffer or is not ready yet
+			more = true;
+			p++;
+		}
+		else
+			throw LogicExceptionImpl("ServiceImpl::WaitMsgs",
+				_("isc_service_query returned unexpected answer"));
+	}
+
+	// Split the output into lines, an incomplete last line is kept for the
+	// next call (or returned when the task has finished)
+	std::string::size_type start = 0;
+	std::string::size_type eol;
+	while ((eol = mWaitBuffer.find('\n', start)) != std::string::npos)
+	{
+		lines.push_back(mWaitBuffer.substr(start, eol - start));
+		start = eol + 1;
+	}
+	mWaitBuffer.erase(0, start);
+	if (!more && !mWaitBuffer.empty())
+	{
+		lines.push_back(mWaitBuffer);
+		mWaitBuffer.clear();
+	}
+	return more;
+}
+
 void ServiceImpl::Wait()
 {
 	IBS status;
@@ -854,8 +950,8 @@ void ServiceImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	int count = --mRefCount;
+	try { if (count <= 0) delete this; }
 		catch (...) { }
 }
 
@@ -900,7 +996,8 @@ ServiceImpl::ServiceImpl(const std::string& ServerName,
             const std::string& RoleName, const std::string& CharSet)
 	:	mRefCount(0), mHandle(0),
 		mServerName(ServerName), mUserName(UserName), mUserPassword(UserPassword),
-        mRoleName(RoleName), mCharSet(CharSet)
+        mRoleName(RoleName), mCharSet(CharSet),
+        major_ver(0), minor_ver(0), rev_no(0), build_no(0)
 {
 }
 
@@ -35,6 +35,79 @@
 
 using namespace ibpp_internals;
 
+//	Status of the calls made through the object oriented API, for the
+//	scrollable cursors.  Errors are copied into an IBS to be reported like
+//	the errors of the ISC API.
+
+class OOStatus
+{
+	Firebird::IStatus* mStatus;
+	Firebird::CheckStatusWrapper mWrapper;
+
+public:
+	Firebird::CheckStatusWrapper* Self() { return &mWrapper; }
+	bool Errors()
+		{ return (mWrapper.getState() & Firebird::IStatus::STATE_ERRORS) != 0; }
+	void CopyTo(IBS& status);
+
+	OOStatus() : mStatus(fbIntfClass::getInstance()->mMaster->getStatus()),
+		mWrapper(mStatus) { }
+	~OOStatus() { mStatus->dispose(); }
+};
+
+void OOStatus::CopyTo(IBS& status)
+{
+	const intptr_t* errors = mWrapper.getErrors();
+	ISC_STATUS* vector = status.Self();
+	int i = 0;
+	while (errors[i] != isc_arg_end)
+	{
+		// isc_arg_cstring is followed by length and pointer
+		int count = (errors[i] == isc_arg_cstring) ? 3 : 2;
+		if (i + count >= 20)
+			break;
+		for (int j = 0; j < count; ++j, ++i)
+			vector[i] = (ISC_STATUS)errors[i];
+	}
+	vector[i] = isc_arg_end;
+}
+
+//	Message layout matching the variables of a descriptor, so the data can
+//	be copied between the descriptor and the message with memcpy()
+
+static Firebird::IMessageMetadata* DescriptorMetadata(OOStatus& status,
+	XSQLDA* descriptor)
+{
+	Firebird::IMetadataBuilder* builder = fbIntfClass::getInstance()->mMaster
+		->getMetadataBuilder(status.Self(), descriptor->sqld);
+	if (status.Errors())
+		return 0;
+	for (int i = 0; i < descriptor->sqld; i++)
+	{
+		XSQLVAR* var = &(descriptor->sqlvar[i]);
+		// everything nullable, so each field has a null indicator
+		builder->setType(status.Self(), i, var->sqltype | 1);
+		builder->setLength(status.Self(), i, var->sqllen);
+		builder->setScale(status.Self(), i, var->sqlscale);
+		if ((var->sqltype & ~1) == SQL_TEXT || (var->sqltype & ~1) == SQL_VARYING)
+			builder->setCharSet(status.Self(), i, var->sqlsubtype & 0xFF);
+		else
+			builder->setSubType(status.Self(), i, var->sqlsubtype);
+	}
+	Firebird::IMessageMetadata* metadata = 0;
+	if (! status.Errors())
+		metadata = builder->getMetadata(status.Self());
+	builder->release();
+	return status.Errors() ? 0 : metadata;
+}
+
+static unsigned DataLength(const XSQLVAR* var, const char* data)
+{
+	if ((var->sqltype & ~1) == SQL_VARYING)
+		return 2 + *(const unsigned short*)data;
+	return var->sqllen;
+}
+
 //	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
 
 void StatementImpl::Prepare(const std::string& sql)
@@ -256,6 +329,29 @@ void StatementImpl::Plan(std::string& plan)
 	if (plan[0] == '\n') plan.erase(0, 1);
 }
 
+void StatementImpl::ExplainedPlan(std::string& plan)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ExplainedPlan", _("No statement has been prepared."));
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Statement::ExplainedPlan", _("A Database must be attached."));
+	if (mDatabase->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::ExplainedPlan", _("Database must be connected."));
+
+	IBS status;
+	RB result(65535);
+	char itemsReq[] = {isc_info_sql_explain_plan};
+
+	(*getGDS().Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
+								   result.Size(), result.Self());
+	if (status.Errors()) throw SQLExceptionImpl(status,
+								"Statement::ExplainedPlan", _("isc_dsql_sql_info failed."));
+
+	// older servers don't know the item, GetString() throws then
+	result.GetString(isc_info_sql_explain_plan, plan);
+	if (plan[0] == '\n') plan.erase(0, 1);
+}
+
 void StatementImpl::Execute(const std::string& sql)
 {
 	if (! sql.empty()) Prepare(sql);
@@ -411,12 +507,56 @@ int StatementImpl::AffectedRows()
 	return count;
 }
 
+void StatementImpl::RecordCounts(int& selects, int& inserts, int& updates,
+	int& deletes)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::RecordCounts", _("No statement has been prepared."));
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Statement::RecordCounts", _("A Database must be attached."));
+	if (mDatabase->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::RecordCounts", _("Database must be connected."));
+
+	IBS status;
+	RB result;
+	char itemsReq[] = {isc_info_sql_records};
+
+	(*getGDS().Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
+		result.Size(), result.Self());
+	if (status.Errors()) throw SQLExceptionImpl(status,
+			"Statement::RecordCounts", _("isc_dsql_sql_info failed."));
+
+	// Unlike AffectedRows() all counters are returned, whatever the type
+	// of the statement (procedures and blocks may touch rows of any kind)
+	selects = result.GetValue(isc_info_sql_records, isc_info_req_select_count);
+	inserts = result.GetValue(isc_info_sql_records, isc_info_req_insert_count);
+	updates = result.GetValue(isc_info_sql_records, isc_info_req_update_count);
+	deletes = result.GetValue(isc_info_sql_records, isc_info_req_delete_count);
+}
+
 bool StatementImpl::Fetch()
 {
 	if (! mResultSetAvailable)
 		throw LogicExceptionImpl("Statement::Fetch",
 			_("No statement has been executed or no result set available."));
 
+	if (mScrollCursor != 0)
+	{
+		OOStatus ooStatus;
+		int code = mScrollCursor->fetchNext(ooStatus.Self(), &mScrollBuffer[0]);
+		if (ooStatus.Errors())
+		{
+			IBS status;
+			ooStatus.CopyTo(status);
+			throw SQLExceptionImpl(status, "Statement::Fetch",
+				_("IResultSet::fetchNext failed."));
+		}
+		if (code != Firebird::IStatus::RESULT_OK)
+			return false;
+		ScrollRowFetched();
+		return true;
+	}
+
 	IBS status;
 	ISC_STATUS code = (*getGDS().Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, mOutRow->Self());
 	if (code == 100)	// This special code means "no more rows"
@@ -447,6 +587,17 @@ bool StatementImpl::Fetch(IBPP::Row& row)
 		throw LogicExceptionImpl("Statement::Fetch(row)",
 			_("No statement has been executed or no result set available."));
 
+	if (mScrollCursor != 0)
+	{
+		if (! Fetch())
+		{
+			row.clear();
+			return false;
+		}
+		row = new RowImpl(*mOutRow);
+		return true;
+	}
+
 	RowImpl* rowimpl = new RowImpl(*mOutRow);
 	row = rowimpl;
 
@@ -474,11 +625,119 @@ bool StatementImpl::Fetch(IBPP::Row& row)
 	return true;
 }
 
+void StatementImpl::ExecuteScrollable()
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ExecuteScrollable",
+			_("No statement has been prepared."));
+	if (mType != IBPP::stSelect || mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ExecuteScrollable",
+			_("Statement must be a SELECT returning rows."));
+	if (getGDS().Call()->m_get_statement_interface == 0
+		|| getGDS().Call()->m_get_transaction_interface == 0)
+		throw LogicExceptionImpl("Statement::ExecuteScrollable",
+			_("Scrollable cursors need a fbclient 4.0+."));
+
+	// Check that a value has been set for each input parameter
+	if (mInRow != 0 && mInRow->MissingValues())
+		throw LogicExceptionImpl("Statement::ExecuteScrollable",
+			_("All parameters must be specified."));
+
+	CursorFree();	// Free a previous 'cursor' if any
+
+	// The cursor is opened on the interfaces of the prepared statement and
+	// the transaction, both only need to be referenced until it is opened
+	IBS status;
+	Firebird::IStatement* statement = 0;
+	Firebird::ITransaction* transaction = 0;
+	(*getGDS().Call()->m_get_statement_interface)(status.Self(), &statement,
+		&mHandle);
+	if (! status.Errors())
+		(*getGDS().Call()->m_get_transaction_interface)(status.Self(),
+			&transaction, mTransaction->GetHandlePtr());
+	if (status.Errors())
+	{
+		if (statement != 0) statement->release();
+		throw SQLExceptionImpl(status, "Statement::ExecuteScrollable",
+			_("fb_get_statement_interface failed"));
+	}
+
+	OOStatus ooStatus;
+	Firebird::IMessageMetadata* inMetadata = 0;
+	std::vector<char> inBuffer;
+	if (mInRow != 0)
+	{
+		inMetadata = DescriptorMetadata(ooStatus, mInRow->Self());
+		if (inMetadata != 0)
+			inBuffer.resize(inMetadata->getMessageLength(ooStatus.Self()));
+		for (int i = 0; ! ooStatus.Errors() && i < mInRow->Columns(); i++)
+		{
+			XSQLVAR* var = &(mInRow->Self()->sqlvar[i]);
+			short null = (var->sqlind != 0 && *var->sqlind < 0) ? -1 : 0;
+			memcpy(&inBuffer[inMetadata->getNullOffset(ooStatus.Self(), i)],
+				&null, sizeof(null));
+			if (null == 0)
+				memcpy(&inBuffer[inMetadata->getOffset(ooStatus.Self(), i)],
+					var->sqldata, DataLength(var, var->sqldata));
+		}
+	}
+	if (! ooStatus.Errors())
+		mScrollMetadata = DescriptorMetadata(ooStatus, mOutRow->Self());
+	if (! ooStatus.Errors())
+	{
+		mScrollBuffer.assign(
+			mScrollMetadata->getMessageLength(ooStatus.Self()), 0);
+	}
+	if (! ooStatus.Errors())
+	{
+		mScrollCursor = statement->openCursor(ooStatus.Self(), transaction,
+			inMetadata, inBuffer.empty() ? 0 : &inBuffer[0], mScrollMetadata,
+			Firebird::IStatement::CURSOR_TYPE_SCROLLABLE);
+	}
+
+	if (inMetadata != 0) inMetadata->release();
+	transaction->release();
+	statement->release();
+	if (ooStatus.Errors())
+	{
+		ScrollCursorFree();
+		ooStatus.CopyTo(status);
+		std::string context = "Statement::ExecuteScrollable( ";
+		context.append(mSql).append(" )");
+		throw SQLExceptionImpl(status, context.c_str(),
+			_("IStatement::openCursor failed"));
+	}
+	mResultSetAvailable = true;
+}
+
+bool StatementImpl::FetchAbsolute(int position)
+{
+	if (mScrollCursor == 0)
+		throw LogicExceptionImpl("Statement::FetchAbsolute",
+			_("No scrollable cursor has been opened."));
+
+	OOStatus ooStatus;
+	int code = mScrollCursor->fetchAbsolute(ooStatus.Self(), position,
+		&mScrollBuffer[0]);
+	if (ooStatus.Errors())
+	{
+		IBS status;
+		ooStatus.CopyTo(status);
+		throw SQLExceptionImpl(status, "Statement::FetchAbsolute",
+			_("IResultSet::fetchAbsolute failed."));
+	}
+	if (code != Firebird::IStatus::RESULT_OK)
+		return false;
+	ScrollRowFetched();
+	return true;
+}
+
 void StatementImpl::Close()
 {
 	// Free all statement resources.
 	// Used before preparing a new statement or from destructor.
 
+	ScrollCursorFree();
 	if (mInRow != 0) { mInRow->Release(); mInRow = 0; }
 	if (mOutRow != 0) { mOutRow->Release(); mOutRow = 0; }
 
@@ -1596,8 +1855,8 @@ void StatementImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	int count = --mRefCount;
+	try { if (count <= 0) delete this; }
 		catch (...) { }
 }
 
@@ -1643,8 +1902,48 @@ void StatementImpl::DetachTransactionImpl()
 	mTransaction = 0;
 }
 
+void StatementImpl::ScrollCursorFree()
+{
+	if (mScrollCursor != 0)
+	{
+		OOStatus status;
+		mScrollCursor->close(status.Self());
+		// close() releases the cursor only if it succeeds
+		if (status.Errors())
+			mScrollCursor->release();
+		mScrollCursor = 0;
+		mResultSetAvailable = false;
+	}
+	if (mScrollMetadata != 0)
+	{
+		mScrollMetadata->release();
+		mScrollMetadata = 0;
+	}
+	mScrollBuffer.clear();
+}
+
+void StatementImpl::ScrollRowFetched()
+{
+	// Copy the fetched message to the output descriptor, where Get() and
+	// IsNull() read the values of the current row
+	OOStatus status;
+	for (int i = 0; i < mOutRow->Columns(); i++)
+	{
+		XSQLVAR* var = &(mOutRow->Self()->sqlvar[i]);
+		const char* data =
+			&mScrollBuffer[mScrollMetadata->getOffset(status.Self(), i)];
+		short null = *(const short*)
+			&mScrollBuffer[mScrollMetadata->getNullOffset(status.Self(), i)];
+		if (var->sqlind != 0)
+			*var->sqlind = null;
+		if (null == 0)
+			memcpy(var->sqldata, data, DataLength(var, data));
+	}
+}
+
 void StatementImpl::CursorFree()
 {
+	ScrollCursorFree();
 	if (mCursorOpened)
 	{
 		mCursorOpened = false;
@@ -1662,7 +1961,8 @@ void StatementImpl::CursorFree()
 StatementImpl::StatementImpl(DatabaseImpl* database, TransactionImpl* transaction)
 	: mRefCount(0), mHandle(0), mDatabase(0), mTransaction(0),
 	mInRow(0), mOutRow(0),
-	mResultSetAvailable(false), mCursorOpened(false), mType(IBPP::stUnknown)
+	mResultSetAvailable(false), mCursorOpened(false), mType(IBPP::stUnknown),
+	mScrollCursor(0), mScrollMetadata(0)
 {
 	AttachDatabaseImpl(database);
 	if (transaction != 0) AttachTransactionImpl(transaction);
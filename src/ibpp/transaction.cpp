@@ -213,8 +213,8 @@ void TransactionImpl::Release()
 {
     // Release cannot throw, except in DEBUG builds on assertion
     ASSERTION(mRefCount >= 0);
-    --mRefCount;
-    try { if (mRefCount <= 0) delete this; }
+    int count = --mRefCount;
+    try { if (count <= 0) delete this; }
         catch (...) { }
 }
 
@@ -236,6 +236,7 @@ void TransactionImpl::AttachStatementImpl(StatementImpl* st)
         throw LogicExceptionImpl("Transaction::AttachStatement",
                     _("Can't attach a 0 Statement object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mStatements.push_back(st);
 }
 
@@ -245,6 +246,7 @@ void TransactionImpl::DetachStatementImpl(StatementImpl* st)
         throw LogicExceptionImpl("Transaction::DetachStatement",
                 _("Can't detach a 0 Statement object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mStatements.erase(std::find(mStatements.begin(), mStatements.end(), st));
 }
 
@@ -254,6 +256,7 @@ void TransactionImpl::AttachBlobImpl(BlobImpl* bb)
         throw LogicExceptionImpl("Transaction::AttachBlob",
                     _("Can't attach a 0 BlobImpl object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mBlobs.push_back(bb);
 }
 
@@ -263,6 +266,7 @@ void TransactionImpl::DetachBlobImpl(BlobImpl* bb)
         throw LogicExceptionImpl("Transaction::DetachBlob",
                 _("Can't detach a 0 BlobImpl object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mBlobs.erase(std::find(mBlobs.begin(), mBlobs.end(), bb));
 }
 
@@ -272,6 +276,7 @@ void TransactionImpl::AttachArrayImpl(ArrayImpl* ar)
         throw LogicExceptionImpl("Transaction::AttachArray",
                     _("Can't attach a 0 ArrayImpl object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mArrays.push_back(ar);
 }
 
@@ -281,6 +286,7 @@ void TransactionImpl::DetachArrayImpl(ArrayImpl* ar)
         throw LogicExceptionImpl("Transaction::DetachArray",
                 _("Can't detach a 0 ArrayImpl object."));
 
+    std::lock_guard<std::mutex> guard(mAttachMutex);
     mArrays.erase(std::find(mArrays.begin(), mArrays.end(), ar));
 }
 
@@ -294,8 +300,6 @@ void TransactionImpl::AttachDatabaseImpl(DatabaseImpl* dbi,
         throw LogicExceptionImpl("Transaction::AttachDatabase",
                 _("Can't attach a null Database."));
 
-    mDatabases.push_back(dbi);
-
     // Prepare a new TPB
     TPB* tpb = new TPB;
     if (am == IBPP::amRead) tpb->Insert(isc_tpb_read);
@@ -318,7 +322,11 @@ void TransactionImpl::AttachDatabaseImpl(DatabaseImpl* dbi,
     if (flags & IBPP::tfAutoCommit)     tpb->Insert(isc_tpb_autocommit);
     if (flags & IBPP::tfNoAutoUndo)     tpb->Insert(isc_tpb_no_auto_undo);
 
-    mTPBs.push_back(tpb);
+    {
+        std::lock_guard<std::mutex> guard(mAttachMutex);
+        mDatabases.push_back(dbi);
+        mTPBs.push_back(tpb);
+    }
 
     // Signals the Database object that it has been attached to the Transaction
     dbi->AttachTransactionImpl(this);
@@ -333,15 +341,18 @@ void TransactionImpl::DetachDatabaseImpl(DatabaseImpl* dbi)
         throw LogicExceptionImpl("Transaction::DetachDatabase",
                 _("Can't detach a null Database."));
 
-    std::vector<DatabaseImpl*>::iterator pos =
-        std::find(mDatabases.begin(), mDatabases.end(), dbi);
-    if (pos != mDatabases.end())
     {
-        size_t index = pos - mDatabases.begin();
-        TPB* tpb = mTPBs[index];
-        mDatabases.erase(pos);
-        mTPBs.erase(mTPBs.begin()+index);
-        delete tpb;
+        std::lock_guard<std::mutex> guard(mAttachMutex);
+        std::vector<DatabaseImpl*>::iterator pos =
+            std::find(mDatabases.begin(), mDatabases.end(), dbi);
+        if (pos != mDatabases.end())
+        {
+            size_t index = pos - mDatabases.begin();
+            TPB* tpb = mTPBs[index];
+            mDatabases.erase(pos);
+            mTPBs.erase(mTPBs.begin()+index);
+            delete tpb;
+        }
     }
 
     // Signals the Database object that it has been detached from the Transaction
@@ -33,66 +33,383 @@
 #include <wx/file.h>
 #include <wx/filename.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "config/DatabaseConfig.h"
 #include "core/StringUtils.h"
 #include "frversion.h"
 #include "gui/AdvancedMessageDialog.h"
 #include "logger.h"
 #include "sql/SqlStatement.h"
+#include "metadata/ConnectionPool.h"
 #include "metadata/database.h"
 
-bool Logger::log2database(Config *cfg, const SqlStatement& stm, Database* db)
+// Writes logged statements on a background thread, so that logging doesn't
+// slow down the execution of scripts.  Everything to be written is prepared
+// when a statement is queued, the thread only writes it: statements for one
+// database are inserted in one transaction with a single prepared statement
+// (using a secondary attachment), text for one log file is appended with a
+// single write.  Errors are shown in the GUI thread.
+class LogWriter
 {
-    wxMBConv* conv = db->getCharsetConverter();
+public:
+    struct DatabaseEntry
+    {
+        std::shared_ptr<ConnectionPool> pool;
+        // empty to use FLAMEROBIN$LOG_GEN
+        std::string idSelect;
+        bool isDDL;
+        std::string objectType;
+        std::string objectName;
+        std::string statement;
+    };
+    struct FileEntry
+    {
+        // UTF-8, so that no wxString is shared between threads
+        std::string filename;
+        bool multiFile;
+        int firstFileNumber;
+        std::string text;
+    };
 
-    IBPP::Transaction tr = IBPP::TransactionFactory(db->getIBPPDatabase());
-    try
+private:
+    enum { MaxTransactionSize = 1000 };
+    enum ErrorType { DatabaseError, FileError, MultiFileError };
+
+    std::thread threadM;
+    std::mutex mutexM;
+    std::condition_variable wakeM;
+    std::condition_variable idleM;
+    std::vector<DatabaseEntry> databaseEntriesM;
+    std::vector<FileEntry> fileEntriesM;
+    bool busyM;
+    bool stopM;
+    bool errorShownM;
+    // statements not written to the database since the last error shown
+    size_t lostStatementsM;
+
+    void run();
+    void start();
+    void showError(ErrorType type, const std::string& details = "",
+        size_t lostStatements = 0);
+    void writeToDatabase(std::vector<DatabaseEntry>::const_iterator begin,
+        std::vector<DatabaseEntry>::const_iterator end);
+    void writeToFiles(const std::vector<FileEntry>& entries);
+public:
+    LogWriter();
+    ~LogWriter();
+
+    static LogWriter& get();
+
+    void add(const DatabaseEntry& entry);
+    void add(const FileEntry& entry);
+    void flush();
+};
+
+LogWriter::LogWriter()
+    : busyM(false), stopM(false), errorShownM(false), lostStatementsM(0)
+{
+}
+
+LogWriter::~LogWriter()
+{
     {
-        tr->Start();
-        IBPP::Statement st = IBPP::StatementFactory(db->getIBPPDatabase(), tr);
+        std::lock_guard<std::mutex> lock(mutexM);
+        stopM = true;
+    }
+    wakeM.notify_all();
+    // queued statements are still written
+    if (threadM.joinable())
+        threadM.join();
+}
 
-        // find next id
-        wxString sql = "SELECT gen_id(FLAMEROBIN$LOG_GEN, 1) FROM rdb$database";
-        if (cfg->get("LoggingUsesCustomSelect", false))
+LogWriter& LogWriter::get()
+{
+    static LogWriter lw;
+    return lw;
+}
+
+void LogWriter::start()
+{
+    // must be called locked, the thread is started when it's needed first
+    if (!threadM.joinable())
+        threadM = std::thread(&LogWriter::run, this);
+}
+
+void LogWriter::add(const DatabaseEntry& entry)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        databaseEntriesM.push_back(entry);
+        start();
+    }
+    wakeM.notify_one();
+}
+
+void LogWriter::add(const FileEntry& entry)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        fileEntriesM.push_back(entry);
+        start();
+    }
+    wakeM.notify_one();
+}
+
+void LogWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutexM);
+    idleM.wait(lock, [this] {
+        return !busyM && databaseEntriesM.empty() && fileEntriesM.empty();
+    });
+}
+
+void LogWriter::showError(ErrorType type, const std::string& details,
+    size_t lostStatements)
+{
+    {
+        // one failing database or file would otherwise show an error for
+        // every batch, the statements lost meanwhile are reported with the
+        // next error
+        std::lock_guard<std::mutex> lock(mutexM);
+        lostStatementsM += lostStatements;
+        if (errorShownM || !wxTheApp)
+            return;
+        errorShownM = true;
+    }
+    wxTheApp->CallAfter([this, type, details]()
+    {
+        if (type == DatabaseError)
+        {
+            size_t lost;
+            {
+                std::lock_guard<std::mutex> lock(mutexM);
+                lost = lostStatementsM;
+                lostStatementsM = 0;
+            }
+            wxString message(details.empty() ? _("Unexpected C++ exception")
+                : wxString(details.c_str(), *wxConvCurrent));
+            message += "\n\n" + wxString::Format(
+                _("%lu logged statements could not be written to the database."),
+                (unsigned long)lost);
+            showWarningDialog(0, _("Logging to database failed"), message,
+                AdvancedMessageDialogButtonsOk());
+        }
+        else
+        {
+            showWarningDialog(0, _("Logging to file failed"),
+                type == MultiFileError ? _("Cannot open log file.")
+                    : _("Cannot open log file for writing."),
+                AdvancedMessageDialogButtonsOk());
+        }
+        std::lock_guard<std::mutex> lock(mutexM);
+        errorShownM = false;
+    });
+}
+
+void LogWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutexM);
+    while (true)
+    {
+        wakeM.wait(lock, [this] {
+            return stopM || !databaseEntriesM.empty() || !fileEntriesM.empty();
+        });
+        if (databaseEntriesM.empty() && fileEntriesM.empty())
+            break;  // stopped
+
+        // everything queued so far is written as one batch
+        std::vector<DatabaseEntry> databaseEntries;
+        std::vector<FileEntry> fileEntries;
+        databaseEntries.swap(databaseEntriesM);
+        fileEntries.swap(fileEntriesM);
+        busyM = true;
+        lock.unlock();
+
+        writeToFiles(fileEntries);
+        // one transaction for consecutive statements of the same database
+        std::vector<DatabaseEntry>::const_iterator begin =
+            databaseEntries.begin();
+        while (begin != databaseEntries.end())
         {
-            sql = cfg->get("LoggingCustomSelect",
-                wxString("SELECT 1+MAX(ID) FROM FLAMEROBIN$LOG"));
+            std::vector<DatabaseEntry>::const_iterator end = begin;
+            size_t count = 0;
+            while (end != databaseEntries.end() && count < MaxTransactionSize
+                && (*end).pool == (*begin).pool
+                && (*end).idSelect == (*begin).idSelect)
+            {
+                ++end;
+                ++count;
+            }
+            writeToDatabase(begin, end);
+            begin = end;
         }
-        st->Prepare(wx2std(sql, conv));
-        st->Execute();
-        int cnt = 1;
-        if (st->Fetch() && !st->IsNull(1))
-            st->Get(1, cnt);
 
+        lock.lock();
+        busyM = false;
+        idleM.notify_all();
+    }
+}
+
+void LogWriter::writeToDatabase(
+    std::vector<DatabaseEntry>::const_iterator begin,
+    std::vector<DatabaseEntry>::const_iterator end)
+{
+    try
+    {
+        PooledConnection connection((*begin).pool);
+        IBPP::Database& db = connection.get();
+        IBPP::Transaction tr = IBPP::TransactionFactory(db);
+        tr->Start();
+        IBPP::Statement idSt = IBPP::StatementFactory(db, tr);
+        IBPP::Statement st = IBPP::StatementFactory(db, tr);
         st->Prepare("INSERT INTO FLAMEROBIN$LOG (id, object_type, \
             object_name, sql_statement) values (?,?,?,?)");
-        st->Set(1, cnt);
-        if (stm.isDDL())
+
+        // the generator is incremented once for all statements, a custom
+        // select is executed for every statement
+        bool customSelect = !(*begin).idSelect.empty();
+        int id = 1;
+        if (customSelect)
+            idSt->Prepare((*begin).idSelect);
+        else
         {
-            st->Set(2, wx2std(getNameOfType(stm.getObjectType()), conv));
-            st->Set(3, wx2std(stm.getName(), conv));
+            int count = int(end - begin);
+            idSt->Prepare("SELECT gen_id(FLAMEROBIN$LOG_GEN, "
+                + std::to_string(count) + ") FROM rdb$database");
+            idSt->Execute();
+            if (idSt->Fetch() && !idSt->IsNull(1))
+                idSt->Get(1, id);
+            id -= count - 1;
         }
-        else
+
+        for (std::vector<DatabaseEntry>::const_iterator it = begin;
+            it != end; ++it)
         {
-            st->SetNull(2);
-            st->SetNull(3);
+            if (customSelect)
+            {
+                idSt->Execute();
+                id = 1;
+                if (idSt->Fetch() && !idSt->IsNull(1))
+                    idSt->Get(1, id);
+            }
+            st->Set(1, id++);
+            if ((*it).isDDL)
+            {
+                st->Set(2, (*it).objectType);
+                st->Set(3, (*it).objectName);
+            }
+            else
+            {
+                st->SetNull(2);
+                st->SetNull(3);
+            }
+            IBPP::Blob bl = IBPP::BlobFactory(db, tr);
+            bl->Save((*it).statement);
+            st->Set(4, bl);
+            st->Execute();
         }
-        IBPP::Blob bl = IBPP::BlobFactory(st->DatabasePtr(), tr);
-        bl->Save(wx2std(stm.getStatement(), conv));
-        st->Set(4, bl);
-        st->Execute();
         tr->Commit();
-        return true;
     }
-    catch (IBPP::Exception &e)
+    // the statements are lost, f.e. when the pool was closed because the
+    // connection to the database was lost
+    catch (std::exception &e)
     {
-        showWarningDialog(0, _("Logging to database failed"),
-            wxString(e.what(), *conv), AdvancedMessageDialogButtonsOk());
+        showError(DatabaseError, e.what(), end - begin);
     }
     catch (...)
+    {
+        showError(DatabaseError, "", end - begin);
+    }
+}
+
+void LogWriter::writeToFiles(const std::vector<FileEntry>& entries)
+{
+    // the text for a single log file is collected and written at once
+    std::vector<std::string> filenames;
+    std::vector<std::string> texts;
+    for (std::vector<FileEntry>::const_iterator it = entries.begin();
+        it != entries.end(); ++it)
+    {
+        if (!(*it).multiFile)
+        {
+            std::vector<std::string>::iterator fn = std::find(filenames.begin(),
+                filenames.end(), (*it).filename);
+            if (fn == filenames.end())
+            {
+                filenames.push_back((*it).filename);
+                texts.push_back((*it).text);
+            }
+            else
+                texts[fn - filenames.begin()] += (*it).text;
+            continue;
+        }
+
+        // filename should contain stuff like: %d, %02d, %05d, etc.
+        wxFile f;
+        wxString filename(wxString::FromUTF8((*it).filename.c_str()));
+        wxString test;
+        for (int i = (*it).firstFileNumber; i < 100000; ++i) // dummy test for 100000
+        {
+            test.Printf(filename, i);
+            if (!wxFileExists(test))
+            {
+                if (f.Open(test, wxFile::write))
+                    break;
+            }
+        }
+        if (!f.IsOpened()
+            || f.Write((*it).text.data(), (*it).text.size()) != (*it).text.size())
+        {
+            showError(MultiFileError);
+        }
+    }
+
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        wxFile f;
+        if (!f.Open(wxString::FromUTF8(filenames[i].c_str()),
+                wxFile::write_append)
+            || f.Write(texts[i].data(), texts[i].size()) != texts[i].size())
+        {
+            showError(FileError);
+        }
+    }
+}
+
+bool Logger::log2database(Config *cfg, const SqlStatement& stm, Database* db)
+{
+    wxMBConv* conv = db->getCharsetConverter();
+    try
+    {
+        LogWriter::DatabaseEntry entry;
+        entry.pool = db->getConnectionPool();
+        if (cfg->get("LoggingUsesCustomSelect", false))
+        {
+            entry.idSelect = wx2std(cfg->get("LoggingCustomSelect",
+                wxString("SELECT 1+MAX(ID) FROM FLAMEROBIN$LOG")), conv);
+        }
+        entry.isDDL = stm.isDDL();
+        if (entry.isDDL)
+        {
+            entry.objectType = wx2std(getNameOfType(stm.getObjectType()),
+                conv);
+            entry.objectName = wx2std(stm.getName(), conv);
+        }
+        entry.statement = wx2std(stm.getStatement(), conv);
+        LogWriter::get().add(entry);
+        return true;
+    }
+    catch (std::exception &e)
     {
         showWarningDialog(0, _("Logging to database failed"),
-            _("Unexpected C++ exception"), AdvancedMessageDialogButtonsOk());
+            e.what(), AdvancedMessageDialogButtonsOk());
     }
     return false;
 }
@@ -116,8 +433,11 @@ bool Logger::log2file(Config *cfg, const SqlStatement& st,
             sql += st.getTerminator();
     }
 
-    wxFile f;
-    if (logToFileType == multiFile)
+    LogWriter::FileEntry entry;
+    entry.filename = wx2std(filename, &wxConvUTF8);
+    entry.multiFile = (logToFileType == multiFile);
+    entry.firstFileNumber = 1;
+    if (entry.multiFile)
     {   // filename should contain stuff like: %d, %02d, %05d, etc.
         if (filename.find_last_of("%") == wxString::npos) // % not found
         {
@@ -126,64 +446,40 @@ bool Logger::log2file(Config *cfg, const SqlStatement& st,
                 AdvancedMessageDialogButtonsOk());
             return false;
         }
-        wxString test;
-        int start = 1;
-        cfg->getValue("IncrementalLogFileStart", start);
-        for (int i=start; i < 100000; ++i) // dummy test for 100000
-        {
-            test.Printf(filename, i);
-            wxFileName fn(test);
-
-            if (!wxDirExists(fn.GetPath()))  // directory doesn't exist
-            {
-                showWarningDialog(0, _("Logging to file failed"),
-                    wxString::Format(_("Directory %s does not exist"), fn.GetPath().c_str()),
-                    AdvancedMessageDialogButtonsOk());
-                return false;
-            }
-
-            if (!wxFileExists(test))
-            {
-                if (f.Open(test, wxFile::write))
-                    break;
-            }
-        }
-        if (!f.IsOpened())
-        {
-            showWarningDialog(0, _("Logging to file failed"),
-                _("Cannot open log file."), AdvancedMessageDialogButtonsOk());
-            return false;
-        }
+        cfg->getValue("IncrementalLogFileStart", entry.firstFileNumber);
     }
-    else if (!f.Open(filename, wxFile::write_append )) // cannot open
+    wxFileName fn(filename);
+    if (!fn.GetPath().IsEmpty() && !wxDirExists(fn.GetPath()))  // directory doesn't exist
     {
         showWarningDialog(0, _("Logging to file failed"),
-            _("Cannot open log file for writing."),
+            wxString::Format(_("Directory %s does not exist"), fn.GetPath().c_str()),
             AdvancedMessageDialogButtonsOk());
         return false;
     }
 
+    wxString text;
     bool loggingAddHeader = true;
     cfg->getValue("LoggingAddHeader", loggingAddHeader);
     if (loggingAddHeader)
     {
-        wxString header = wxString::Format(
+        text = wxString::Format(
             _("\n/* Logged by FlameRobin %d.%d.%d at %s\n   User: %s    Database: %s */\n"),
             FR_VERSION_MAJOR, FR_VERSION_MINOR, FR_VERSION_RLS,
             wxDateTime::Now().Format().c_str(),
             db->getUsername().c_str(),
             db->getPath().c_str()
         );
-        f.Write(header);
     }
     else
-        f.Write("\n");
+        text = "\n";
     if (logSetTerm && st.getTerminator() != ";")
-        f.Write("SET TERM " + st.getTerminator() + " ;\n");
-    f.Write(sql);
+        text += "SET TERM " + st.getTerminator() + " ;\n";
+    text += sql;
     if (logSetTerm && st.getTerminator() != ";")
-        f.Write("\nSET TERM ; " + st.getTerminator() + "\n");
-    f.Close();
+        text += "\nSET TERM ; " + st.getTerminator() + "\n";
+    // log files are written as UTF-8, like wxFile::Write() does
+    entry.text = wx2std(text, &wxConvUTF8);
+    LogWriter::get().add(entry);
     return true;
 }
 
@@ -199,6 +495,11 @@ bool Logger::logStatement(const SqlStatement& st, Database* db)
     return result;
 }
 
+void Logger::flush()
+{
+    LogWriter::get().flush();
+}
+
 bool Logger::prepareDatabase(Database *db)
 {
     IBPP::Transaction tr = IBPP::TransactionFactory(db->getIBPPDatabase());
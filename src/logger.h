@@ -40,7 +40,10 @@ private:
     static bool log2file(Config *, const SqlStatement& st, Database *db, const wxString& filename);
     static bool logStatementByConfig(Config *cfg, const SqlStatement& st, Database *db);
 public:
+    // statements are written in the background, flush() waits until all
+    // statements logged so far have been written
     static bool logStatement(const SqlStatement& st, Database *db);
+    static void flush();
 };
 
 #endif
@@ -0,0 +1,260 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+
+#include "config/Config.h"
+#include "core/FRError.h"
+#include "metadata/ConnectionPool.h"
+
+ConnectionPool::ConnectionPool(IBPP::Database& mainDatabase,
+        const std::string& clientLibrary)
+    : serverM(mainDatabase->ServerName()),
+        databaseM(mainDatabase->DatabaseName()),
+        userM(mainDatabase->Username()),
+        passwordM(mainDatabase->UserPassword()),
+        roleM(mainDatabase->RoleName()), charsetM(mainDatabase->CharSet()),
+        clientLibraryM(clientLibrary), borrowedM(0), dedicatedM(0),
+        closedM(false)
+{
+    maxSizeM = std::max(1, config().get("ConnectionPoolMaxSize", 4));
+    maxDedicatedM = std::max(1,
+        config().get("ConnectionPoolMaxDedicated", 8));
+    idleTimeoutM = std::chrono::seconds(
+        std::max(0, config().get("ConnectionPoolIdleTimeout", 300)));
+    waitTimeoutM = std::chrono::seconds(
+        std::max(1, config().get("ConnectionPoolWaitTimeout", 30)));
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    close();
+}
+
+IBPP::Database ConnectionPool::connect()
+{
+    IBPP::Database db = IBPP::DatabaseFactory(serverM, databaseM, userM,
+        passwordM, roleM, charsetM, "", clientLibraryM);
+    db->Connect();
+    return db;
+}
+
+void ConnectionPool::takeExpired(std::vector<IBPP::Database>& expired)
+{
+    Clock::time_point limit = Clock::now() - idleTimeoutM;
+    // the least recently returned attachments are at the front
+    while (!idleM.empty() && idleM.front().since <= limit)
+    {
+        expired.push_back(idleM.front().database);
+        idleM.pop_front();
+    }
+}
+
+void ConnectionPool::disconnect(std::vector<IBPP::Database>& databases)
+{
+    for (std::vector<IBPP::Database>::iterator it = databases.begin();
+        it != databases.end(); ++it)
+    {
+        try
+        {
+            (*it)->Disconnect();
+        }
+        catch (IBPP::Exception&)
+        {
+            // the attachment is gone anyway
+        }
+    }
+    databases.clear();
+}
+
+IBPP::Database ConnectionPool::acquire()
+{
+    std::vector<IBPP::Database> expired;
+    IBPP::Database db;
+    {
+        std::unique_lock<std::mutex> lock(mutexM);
+        takeExpired(expired);
+        Clock::time_point deadline = Clock::now() + waitTimeoutM;
+        while (db == 0)
+        {
+            if (closedM)
+                throw FRError(_("The database is not connected."));
+            if (!idleM.empty())
+            {
+                db = idleM.back().database;
+                idleM.pop_back();
+                ++borrowedM;
+            }
+            else if (borrowedM < maxSizeM)
+            {
+                // connecting may take a while, don't block the pool
+                ++borrowedM;
+                lock.unlock();
+                try
+                {
+                    db = connect();
+                }
+                catch (...)
+                {
+                    lock.lock();
+                    --borrowedM;
+                    availableM.notify_one();
+                    throw;
+                }
+                lock.lock();
+            }
+            else if (availableM.wait_until(lock, deadline)
+                == std::cv_status::timeout && !closedM && idleM.empty()
+                && borrowedM >= maxSizeM)
+            {
+                lock.unlock();
+                disconnect(expired);
+                throw FRError(_("All connections for background work are in use, try again later."));
+            }
+        }
+    }
+    disconnect(expired);
+    return db;
+}
+
+IBPP::Database ConnectionPool::acquireDedicated()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        if (closedM)
+            throw FRError(_("The database is not connected."));
+        if (dedicatedM >= maxDedicatedM)
+            throw FRError(_("Too many connections for listeners and monitoring are open."));
+        ++dedicatedM;
+    }
+    try
+    {
+        return connect();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        --dedicatedM;
+        throw;
+    }
+}
+
+void ConnectionPool::releaseDedicated(IBPP::Database database)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        --dedicatedM;
+    }
+    std::vector<IBPP::Database> databases(1, database);
+    disconnect(databases);
+}
+
+void ConnectionPool::release(IBPP::Database database)
+{
+    std::vector<IBPP::Database> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        --borrowedM;
+        if (closedM || !database->Connected())
+            expired.push_back(database);
+        else
+        {
+            IdleConnection idle;
+            idle.database = database;
+            idle.since = Clock::now();
+            idleM.push_back(idle);
+        }
+        takeExpired(expired);
+        availableM.notify_one();
+    }
+    disconnect(expired);
+}
+
+void ConnectionPool::pruneIdle()
+{
+    std::vector<IBPP::Database> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        takeExpired(expired);
+    }
+    disconnect(expired);
+}
+
+void ConnectionPool::close()
+{
+    std::vector<IBPP::Database> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutexM);
+        closedM = true;
+        for (std::list<IdleConnection>::iterator it = idleM.begin();
+            it != idleM.end(); ++it)
+        {
+            idle.push_back((*it).database);
+        }
+        idleM.clear();
+        // waiting threads will fail
+        availableM.notify_all();
+    }
+    disconnect(idle);
+}
+
+unsigned ConnectionPool::getBorrowedCount()
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    return borrowedM;
+}
+
+unsigned ConnectionPool::getIdleCount()
+{
+    std::lock_guard<std::mutex> lock(mutexM);
+    return idleM.size();
+}
+
+std::chrono::seconds ConnectionPool::getIdleTimeout() const
+{
+    return idleTimeoutM;
+}
+
+PooledConnection::PooledConnection(std::shared_ptr<ConnectionPool> pool,
+        bool dedicated)
+    : poolM(pool), dedicatedM(dedicated),
+        databaseM(dedicated ? pool->acquireDedicated() : pool->acquire())
+{
+}
+
+PooledConnection::~PooledConnection()
+{
+    if (dedicatedM)
+        poolM->releaseDedicated(databaseM);
+    else
+        poolM->release(databaseM);
+}
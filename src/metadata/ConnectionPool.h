@@ -0,0 +1,128 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_CONNECTIONPOOL_H
+#define FR_CONNECTIONPOOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <ibpp.h>
+
+// Secondary attachments to a database, using the server, credentials, role
+// and character set of its main connection.  Background work borrows an
+// attachment through PooledConnection, so that it doesn't serialize on the
+// attachment used by the GUI.  At most ConnectionPoolMaxSize attachments
+// are borrowed at the same time, attachments that are not borrowed again
+// within ConnectionPoolIdleTimeout seconds are disconnected.  Borrowers
+// that keep an attachment for their whole lifetime (event listeners,
+// monitoring) get a dedicated one instead, so they can't exhaust the pool;
+// at most ConnectionPoolMaxDedicated of those are open at the same time.
+// Attachments can be borrowed and returned on any thread, but each one is
+// used by one thread at a time (see the threading notes in ibpp.h).
+class ConnectionPool
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+    struct IdleConnection
+    {
+        IBPP::Database database;
+        Clock::time_point since;
+    };
+
+    std::string serverM;
+    std::string databaseM;
+    std::string userM;
+    std::string passwordM;
+    std::string roleM;
+    std::string charsetM;
+    std::string clientLibraryM;
+    unsigned maxSizeM;
+    unsigned maxDedicatedM;
+    std::chrono::seconds idleTimeoutM;
+    std::chrono::seconds waitTimeoutM;
+
+    std::mutex mutexM;
+    std::condition_variable availableM;
+    // most recently returned attachment last
+    std::list<IdleConnection> idleM;
+    unsigned borrowedM;
+    unsigned dedicatedM;
+    bool closedM;
+
+    IBPP::Database connect();
+    // moves expired attachments to the vector, must be called locked
+    void takeExpired(std::vector<IBPP::Database>& expired);
+    static void disconnect(std::vector<IBPP::Database>& databases);
+
+public:
+    ConnectionPool(IBPP::Database& mainDatabase,
+        const std::string& clientLibrary);
+    ~ConnectionPool();
+
+    // returns an idle or a new attachment, waits while the maximum number
+    // of attachments is borrowed and throws FRError if none is returned
+    // within ConnectionPoolWaitTimeout seconds
+    IBPP::Database acquire();
+    void release(IBPP::Database database);
+    // returns a new attachment that isn't counted against the pool size,
+    // throws FRError if too many dedicated attachments are open
+    IBPP::Database acquireDedicated();
+    // disconnects the attachment
+    void releaseDedicated(IBPP::Database database);
+    // disconnects attachments that have been idle for too long
+    void pruneIdle();
+    // disconnects idle attachments, borrowed attachments are disconnected
+    // when they are returned, acquire() fails from now on
+    void close();
+
+    unsigned getBorrowedCount();
+    unsigned getIdleCount();
+    std::chrono::seconds getIdleTimeout() const;
+};
+
+// Borrows an attachment from the pool for its lifetime.  Long-lived
+// borrowers ask for a dedicated attachment.
+class PooledConnection
+{
+private:
+    std::shared_ptr<ConnectionPool> poolM;
+    bool dedicatedM;
+    IBPP::Database databaseM;
+
+    PooledConnection(const PooledConnection&);
+    PooledConnection& operator=(const PooledConnection&);
+public:
+    PooledConnection(std::shared_ptr<ConnectionPool> pool,
+        bool dedicated = false);
+    ~PooledConnection();
+
+    IBPP::Database& get() { return databaseM; }
+};
+
+#endif // FR_CONNECTIONPOOL_H
@@ -31,14 +31,21 @@
     #include "wx/wx.h"
 #endif
 
+#include <wx/filename.h>
+#include <wx/stream.h>
+
+#include <algorithm>
 #include <vector>
 
+#include "core/FRError.h"
 #include "core/ProgressIndicator.h"
+#include "engine/MetadataLoader.h"
 #include "metadata/column.h"
 #include "metadata/Collation.h"
 #include "metadata/constraints.h"
 #include "metadata/CreateDDLVisitor.h"
 #include "metadata/database.h"
+#include "metadata/DependencyGraph.h"
 #include "metadata/domain.h"
 #include "metadata/exception.h"
 #include "metadata/function.h"
@@ -57,7 +64,7 @@ void addIndex(std::vector<Index> *ix, wxString& sql, ColumnConstraint *cc);
 wxString CreateDDLVisitor::getCommentOn(MetadataItem& object)
 {
     wxString comment = "";
-    wxString description = object.getDescription();
+    wxString description = getDescription(object);
     if (!description.empty())
     {
         comment << "COMMENT ON ";
@@ -99,14 +106,102 @@ wxString CreateDDLVisitor::getCommentOn(MetadataItem& object)
     return comment;
 }
 
+wxString CreateDDLVisitor::getDescription(MetadataItem& object)
+{
+    wxString description;
+    if (!descriptionsM.getDescription(object, description))
+        description = object.getDescription();
+    return description;
+}
+
 CreateDDLVisitor::CreateDDLVisitor(ProgressIndicator* progressIndicator)
-    : MetadataItemVisitor()
+    : MetadataItemVisitor(), outputM(0)
 {
     progressIndicatorM = progressIndicator;
 }
 
 CreateDDLVisitor::~CreateDDLVisitor()
 {
+    closeSpools();
+}
+
+void CreateDDLVisitor::setOutputStream(wxOutputStream* output)
+{
+    outputM = output;
+}
+
+void CreateDDLVisitor::openSpools()
+{
+    wxString fileName = wxFileName::CreateTempFileName("frddl", &postSpoolM);
+    if (fileName.empty() || !postSpoolM.IsOpened())
+        throw FRError(_("Could not create temporary file."));
+    fileName = wxFileName::CreateTempFileName("frddl", &grantSpoolM);
+    if (fileName.empty() || !grantSpoolM.IsOpened())
+        throw FRError(_("Could not create temporary file."));
+}
+
+void CreateDDLVisitor::closeSpools()
+{
+    wxFFile* spools[] = { &postSpoolM, &grantSpoolM };
+    for (size_t i = 0; i < sizeof(spools) / sizeof(spools[0]); ++i)
+    {
+        if (spools[i]->IsOpened())
+        {
+            wxString fileName(spools[i]->GetName());
+            spools[i]->Close();
+            wxRemoveFile(fileName);
+        }
+    }
+}
+
+bool CreateDDLVisitor::copySpool(wxFFile& spool)
+{
+    if (!spool.Flush() || !spool.Seek(0))
+        return false;
+    char buffer[65536];
+    while (!spool.Eof())
+    {
+        size_t len = spool.Read(buffer, sizeof(buffer));
+        if (spool.Error())
+            return false;
+        if (len && !outputM->Write(buffer, len).IsOk())
+            return false;
+    }
+    return true;
+}
+
+void CreateDDLVisitor::write(const wxString& sql)
+{
+    if (sql.empty())
+        return;
+    const wxScopedCharBuffer buf(sql.utf8_str());
+    if (!outputM->Write(buf.data(), buf.length()).IsOk())
+        throw FRError(_("Could not write the DDL script."));
+}
+
+// moves the statements of the last visited object out of the per-object
+// buffers, either into the script sections or into the output stream
+void CreateDDLVisitor::objectDone()
+{
+    if (outputM)
+    {
+        write(preSqlM);
+        if ((!postSqlM.empty() && !postSpoolM.Write(postSqlM, wxConvUTF8))
+            || (!grantSqlM.empty() && !grantSpoolM.Write(grantSqlM, wxConvUTF8)))
+        {
+            throw FRError(_("Could not write to temporary file."));
+        }
+    }
+    else
+    {
+        scriptPreSqlM += preSqlM;
+        scriptPostSqlM += postSqlM;
+        scriptGrantSqlM += grantSqlM;
+    }
+    preSqlM.clear();
+    postSqlM.clear();
+    grantSqlM.clear();
+    sqlM.clear();
 }
 
 wxString CreateDDLVisitor::getSql() const
@@ -185,9 +280,10 @@ void CreateDDLVisitor::visitColumn(Column& c)
 }
 
 template <class C, class M>
-void iterateit(CreateDDLVisitor* v, C mc, ProgressIndicator* pi)
+void CreateDDLVisitor::iterateCollection(C mc, DependencyGraph* graph)
 {
     wxASSERT(mc);
+    ProgressIndicator* pi = progressIndicatorM;
 
     if (pi)
     {
@@ -196,8 +292,20 @@ void iterateit(CreateDDLVisitor* v, C mc, ProgressIndicator* pi)
         pi->initProgress(wxEmptyString, mc->getChildrenCount(), 0, 2);
     }
 
+    std::vector<MetadataItem*> items;
+    items.reserve(mc->getChildrenCount());
     for (typename MetadataCollection<M>::iterator it = mc->begin();
         it != mc->end(); ++it)
+    {
+        items.push_back((*it).get());
+    }
+    // objects that are created with their body need to be created after
+    // all objects they depend on
+    if (graph)
+        graph->sortByDependencies(items);
+
+    for (std::vector<MetadataItem*>::iterator it = items.begin();
+        it != items.end(); ++it)
     {
         if (pi)
         {
@@ -205,7 +313,8 @@ void iterateit(CreateDDLVisitor* v, C mc, ProgressIndicator* pi)
             pi->setProgressMessage(_("Extracting ") + (*it)->getName_(), 2);
             pi->stepProgress(1, 2);
         }
-        (*it)->acceptVisitor(v);
+        (*it)->acceptVisitor(this);
+        objectDone();
     }
 }
 
@@ -215,80 +324,110 @@ void CreateDDLVisitor::visitDatabase(Database& d)
     if (progressIndicatorM)
         progressIndicatorM->initProgress(wxEmptyString, 10, 0, 1);
 
+    // all metadata is read in a single transaction, and with enough cached
+    // statements for every object type, so each of the per-object queries
+    // is prepared only once
+    MetadataLoader* loader = d.getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    unsigned maxStatements = loader->getMaximumConcurrentStatements();
+    if (maxStatements)
+        loader->setMaximumConcurrentStatements(std::max(maxStatements, 64U));
+
     try
     {
+        if (outputM)
+            openSpools();
+        descriptionsM.load(d);
+        DependencyGraph& graph = d.getDependencyGraph();
 
         preSqlM << "/********************* COLLATES **********************/\n\n";
-        iterateit<CollationsPtr, Collation>(this, d.getCollations(), progressIndicatorM);
+        iterateCollection<CollationsPtr, Collation>(d.getCollations());
 
         preSqlM << "/********************* ROLES **********************/\n\n";
-        iterateit<RolesPtr, Role>(this, d.getRoles(), progressIndicatorM);
+        iterateCollection<RolesPtr, Role>(d.getRoles());
 
         preSqlM << "/********************* UDFS ***********************/\n\n";
-        iterateit<UDFsPtr, UDF>(this, d.getUDFs(), progressIndicatorM);
+        iterateCollection<UDFsPtr, UDF>(d.getUDFs());
         
         if (d.getInfo().getODSVersionIsHigherOrEqualTo(12.0)) {
             preSqlM << "/********************* FUNCTIONS ***********************/\n\n";
-            iterateit<FunctionSQLsPtr, FunctionSQL>(this, d.getFunctionSQLs(),
-                progressIndicatorM);
+            iterateCollection<FunctionSQLsPtr, FunctionSQL>(d.getFunctionSQLs(),
+                &graph);
         }
 
         preSqlM << "/****************** SEQUENCES ********************/\n\n";
-        iterateit<GeneratorsPtr, Generator>(this, d.getGenerators(),
-            progressIndicatorM);
+        iterateCollection<GeneratorsPtr, Generator>(d.getGenerators());
 
         preSqlM << "/******************** DOMAINS *********************/\n\n";
-        iterateit<DomainsPtr, Domain>(this, d.getDomains(),
-            progressIndicatorM);
+        iterateCollection<DomainsPtr, Domain>(d.getDomains());
 
         preSqlM << "/******************* PROCEDURES ******************/\n\n";
-        iterateit<ProceduresPtr, Procedure>(this, d.getProcedures(),
-            progressIndicatorM);
+        iterateCollection<ProceduresPtr, Procedure>(d.getProcedures(),
+            &graph);
 
         if (d.getInfo().getODSVersionIsHigherOrEqualTo(12.0)) {
             preSqlM << "/******************* PACKAGES ******************/\n\n";
-            iterateit<PackagesPtr, Package>(this, d.getPackages(),
-                progressIndicatorM);
+            iterateCollection<PackagesPtr, Package>(d.getPackages());
         }
       
         preSqlM << "/******************** TABLES **********************/\n\n";
-        iterateit<TablesPtr, Table>(this, d.getTables(), progressIndicatorM);
+        iterateCollection<TablesPtr, Table>(d.getTables());
         if (d.getInfo().getODSVersionIsHigherOrEqualTo(11.1)) {
-            iterateit<GTTablesPtr, GTTable>(this, d.getGTTables(), progressIndicatorM);
+            iterateCollection<GTTablesPtr, GTTable>(d.getGTTables());
         }
 
         preSqlM << "/********************* VIEWS **********************/\n\n";
-        // TODO: build dependecy tree first, and order views by it
-        //       also include computed columns of tables?
-        iterateit<ViewsPtr, View>(this, d.getViews(), progressIndicatorM);
+        // TODO: computed columns of tables that depend on views?
+        iterateCollection<ViewsPtr, View>(d.getViews(), &graph);
 
         preSqlM << "/******************* EXCEPTIONS *******************/\n\n";
-        iterateit<ExceptionsPtr, Exception>(this, d.getExceptions(),
-            progressIndicatorM);
+        iterateCollection<ExceptionsPtr, Exception>(d.getExceptions());
 
         preSqlM << "/******************** TRIGGERS ********************/\n\n";
-        iterateit<DMLTriggersPtr, DMLTrigger>(this, d.getDMLTriggers(),
-            progressIndicatorM);
+        iterateCollection<DMLTriggersPtr, DMLTrigger>(d.getDMLTriggers());
 
         if (d.getInfo().getODSVersionIsHigherOrEqualTo(11.1)) {
             preSqlM << "/******************** DB TRIGGERS ********************/\n\n";
-            iterateit<DBTriggersPtr, DBTrigger>(this, d.getDBTriggers(),
-                progressIndicatorM);
+            iterateCollection<DBTriggersPtr, DBTrigger>(d.getDBTriggers());
         }
         if (d.getInfo().getODSVersionIsHigherOrEqualTo(12.0)) {
             preSqlM << "/******************** DDL TRIGGERS ********************/\n\n";
-            iterateit<DDLTriggersPtr, DDLTrigger>(this, d.getDDLTriggers(),
-                progressIndicatorM);
+            iterateCollection<DDLTriggersPtr, DDLTrigger>(d.getDDLTriggers());
         }
+        // flush the header of a trailing empty collection
+        objectDone();
     }
     catch (CancelProgressException&)
     {
         // this is expected if user cancels the extraction
+        loader->setMaximumConcurrentStatements(maxStatements);
+        closeSpools();
         sqlM = _("Extraction canceled");
         return;
     }
+    catch (...)
+    {
+        loader->setMaximumConcurrentStatements(maxStatements);
+        closeSpools();
+        throw;
+    }
+    loader->setMaximumConcurrentStatements(maxStatements);
 
-    sqlM = preSqlM + "\n" + postSqlM + grantSqlM;
+    if (outputM)
+    {
+        write("\n");
+        bool ok = copySpool(postSpoolM) && copySpool(grantSpoolM);
+        closeSpools();
+        if (!ok)
+            throw FRError(_("Could not write the DDL script."));
+    }
+    else
+    {
+        preSqlM.swap(scriptPreSqlM);
+        postSqlM.swap(scriptPostSqlM);
+        grantSqlM.swap(scriptGrantSqlM);
+        sqlM = preSqlM + "\n" + postSqlM + grantSqlM;
+    }
     if (progressIndicatorM)
     {
         progressIndicatorM->initProgress(_("Extraction complete."), 1, 1);
@@ -25,10 +25,15 @@
 #ifndef FR_CREATEDDLVISITOR_H
 #define FR_CREATEDDLVISITOR_H
 
+#include <wx/ffile.h>
+
 #include "sql/SqlTokenizer.h"
+#include "metadata/DescriptionCache.h"
 #include "metadata/MetadataItemVisitor.h"
 
+class DependencyGraph;
 class ProgressIndicator;
+class wxOutputStream;
 
 class CreateDDLVisitor: public MetadataItemVisitor
 {
@@ -41,12 +46,40 @@ private:
 
     ProgressIndicator* progressIndicatorM;
 
+    // whole database scripts: the statements of every visited object are
+    // moved out of preSqlM, postSqlM and grantSqlM once it is done, so that
+    // each visit only concatenates the statements of a single object
+    wxString scriptPreSqlM;
+    wxString scriptPostSqlM;
+    wxString scriptGrantSqlM;
+    // if set the script is written to this stream instead, with the post
+    // and grant sections spooled to temporary files until the end
+    wxOutputStream* outputM;
+    wxFFile postSpoolM;
+    wxFFile grantSpoolM;
+    void openSpools();
+    void closeSpools();
+    bool copySpool(wxFFile& spool);
+    void write(const wxString& sql);
+    void objectDone();
+
+    template <class C, class M>
+    void iterateCollection(C collection, DependencyGraph* graph = 0);
+
+    // descriptions loaded in bulk for whole database scripts
+    DescriptionCache descriptionsM;
+    wxString getDescription(MetadataItem& object);
+
 protected:
     wxString getCommentOn(MetadataItem& metadataitem);
 
 public:
     CreateDDLVisitor(ProgressIndicator* progressIndicator = 0);
     virtual ~CreateDDLVisitor();
+
+    // the DDL of the next database visited will be written to the stream
+    // (UTF-8 encoded) instead of being returned by getSql()
+    void setOutputStream(wxOutputStream* output);
     wxString getSql() const;
     wxString getPrefixSql() const;
     wxString getSuffixSql() const;
@@ -0,0 +1,269 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <set>
+
+#include "core/StringUtils.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/database.h"
+#include "metadata/DependencyGraph.h"
+#include "metadata/metadataitem.h"
+
+DependencyGraph::DependencyGraph(Database& database)
+    : databaseM(database)
+{
+    load();
+}
+
+int DependencyGraph::getObjectType(const MetadataItem& item)
+{
+    switch (item.getType())
+    {
+        case ntTable:
+        case ntSysTable:
+        case ntGTT:
+        case ntView:
+            return 0;
+        case ntTrigger:
+        case ntDMLTrigger:
+        case ntDBTrigger:
+        case ntDDLTrigger:
+            return 2;
+        case ntProcedure:
+            return 5;
+        case ntException:
+            return 7;
+        case ntGenerator:
+            return 14;
+        case ntFunctionSQL:
+        case ntUDF:
+            return 15;
+        case ntPackage:
+            return 19;
+        default:
+            return -1;
+    }
+}
+
+DependencyGraph::Node DependencyGraph::getNode(const MetadataItem& item)
+{
+    return Node(getObjectType(item), item.getName_());
+}
+
+void DependencyGraph::load()
+{
+    MetadataLoader* loader = databaseM.getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* converter = databaseM.getCharsetConverter();
+
+    // dependencies of computed columns are stored for their (system) domain,
+    // the join finds the relation the column belongs to
+    IBPP::Statement st = loader->createStatement(
+        "select d.RDB$DEPENDENT_TYPE, d.RDB$DEPENDENT_NAME,"
+        " d.RDB$DEPENDED_ON_TYPE, d.RDB$DEPENDED_ON_NAME, d.RDB$FIELD_NAME,"
+        " f.RDB$RELATION_NAME"
+        " from RDB$DEPENDENCIES d"
+        " left join RDB$RELATION_FIELDS f on d.RDB$DEPENDENT_TYPE = 3"
+        " and f.RDB$FIELD_SOURCE = d.RDB$DEPENDENT_NAME");
+    st->Execute();
+    while (st->Fetch())
+    {
+        int dependentType, dependedOnType;
+        std::string s;
+        st->Get(1, &dependentType);
+        st->Get(2, s);
+        wxString dependentName(std2wxIdentifier(s, converter));
+        st->Get(3, &dependedOnType);
+        st->Get(4, s);
+        wxString dependedOnName(std2wxIdentifier(s, converter));
+        wxString field;
+        if (!st->IsNull(5))
+        {
+            st->Get(5, s);
+            field = std2wxIdentifier(s, converter);
+        }
+
+        if (dependentType == 3)
+        {
+            if (st->IsNull(6))
+                continue;
+            st->Get(6, s);
+            dependentType = 0;
+            dependentName = std2wxIdentifier(s, converter);
+        }
+        // views are relations when other objects refer to them
+        if (dependentType == 1)
+            dependentType = 0;
+        if (dependedOnType == 1)
+            dependedOnType = 0;
+
+        Node dependent(dependentType, dependentName);
+        Node dependedOn(dependedOnType, dependedOnName);
+        if (dependent == dependedOn)
+            continue;
+
+        Edge e;
+        e.field = field;
+        e.type = dependedOnType;
+        e.name = dependedOnName;
+        dependedOnM[dependent].push_back(e);
+        e.type = dependentType;
+        e.name = dependentName;
+        dependentsM[dependedOn].push_back(e);
+    }
+}
+
+const DependencyGraph::Edges& DependencyGraph::getDependedOn(
+    const MetadataItem& item) const
+{
+    EdgeMap::const_iterator it = dependedOnM.find(getNode(item));
+    if (it == dependedOnM.end())
+        return emptyM;
+    return (*it).second;
+}
+
+const DependencyGraph::Edges& DependencyGraph::getDependents(
+    const MetadataItem& item) const
+{
+    EdgeMap::const_iterator it = dependentsM.find(getNode(item));
+    if (it == dependentsM.end())
+        return emptyM;
+    return (*it).second;
+}
+
+MetadataItem* DependencyGraph::findItem(int type,
+    const wxString& name) const
+{
+    MetadataItem* item = 0;
+    switch (type)
+    {
+        case 0:
+            if (!(item = databaseM.findByNameAndType(ntTable, name))
+                && !(item = databaseM.findByNameAndType(ntView, name))
+                && !(item = databaseM.findByNameAndType(ntGTT, name)))
+            {
+                item = databaseM.findByNameAndType(ntSysTable, name);
+            }
+            break;
+        case 2:
+            item = databaseM.findByNameAndType(ntDMLTrigger, name);
+            break;
+        case 5:
+            item = databaseM.findByNameAndType(ntProcedure, name);
+            break;
+        case 7:
+            item = databaseM.findByNameAndType(ntException, name);
+            break;
+        case 14:
+            item = databaseM.findByNameAndType(ntGenerator, name);
+            break;
+        case 15:
+            if (!(item = databaseM.findByNameAndType(ntFunctionSQL, name)))
+                item = databaseM.findByNameAndType(ntUDF, name);
+            break;
+        case 18:
+        case 19:
+            item = databaseM.findByNameAndType(ntPackage, name);
+            break;
+    }
+    return item;
+}
+
+void DependencyGraph::findItems(const Edges& edges,
+    std::vector<MetadataItem*>& items) const
+{
+    std::set<MetadataItem*> found(items.begin(), items.end());
+    for (Edges::const_iterator it = edges.begin(); it != edges.end(); ++it)
+    {
+        MetadataItem* item = findItem((*it).type, (*it).name);
+        if (item && found.insert(item).second)
+            items.push_back(item);
+    }
+}
+
+void DependencyGraph::sortByDependencies(
+    std::vector<MetadataItem*>& items) const
+{
+    const size_t count = items.size();
+    std::map<Node, size_t> indices;
+    for (size_t i = 0; i < count; ++i)
+        indices[getNode(*items[i])] = i;
+
+    // number of unsorted items every item still waits for, and the items
+    // waiting for it (edges are per field, so they may appear repeatedly)
+    std::vector<size_t> pending(count, 0);
+    std::vector<std::vector<size_t> > waiting(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Edges& edges = getDependedOn(*items[i]);
+        for (Edges::const_iterator it = edges.begin(); it != edges.end(); ++it)
+        {
+            std::map<Node, size_t>::const_iterator itIndex =
+                indices.find(Node((*it).type, (*it).name));
+            if (itIndex != indices.end() && (*itIndex).second != i)
+            {
+                waiting[(*itIndex).second].push_back(i);
+                ++pending[i];
+            }
+        }
+    }
+
+    // always take the first ready item to keep the original order
+    std::set<size_t> ready;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!pending[i])
+            ready.insert(i);
+    }
+    std::vector<bool> sorted(count, false);
+    std::vector<MetadataItem*> result;
+    result.reserve(count);
+    while (!ready.empty())
+    {
+        size_t i = *ready.begin();
+        ready.erase(ready.begin());
+        sorted[i] = true;
+        result.push_back(items[i]);
+        for (std::vector<size_t>::const_iterator it = waiting[i].begin();
+            it != waiting[i].end(); ++it)
+        {
+            if (--pending[*it] == 0)
+                ready.insert(*it);
+        }
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!sorted[i])
+            result.push_back(items[i]);
+    }
+    items.swap(result);
+}
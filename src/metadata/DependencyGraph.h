@@ -0,0 +1,83 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DEPENDENCYGRAPH_H
+#define FR_DEPENDENCYGRAPH_H
+
+#include <map>
+#include <vector>
+
+#include "metadata/MetadataClasses.h"
+
+class MetadataItem;
+
+// In-memory copy of the RDB$DEPENDENCIES table, loaded with one statement.
+// Nodes are identified by their RDB$DEPENDENCIES object type and name, with
+// views stored as relations (type 0) and computed columns (type 3) resolved
+// to the relation they belong to.
+class DependencyGraph
+{
+public:
+    struct Edge
+    {
+        int type;
+        wxString name;
+        wxString field;
+    };
+    typedef std::vector<Edge> Edges;
+
+    // loads the graph, uses the database's MetadataLoader transaction
+    DependencyGraph(Database& database);
+
+    // returns the RDB$DEPENDENCIES object type for the item, or -1
+    static int getObjectType(const MetadataItem& item);
+
+    // objects the given object depends on
+    const Edges& getDependedOn(const MetadataItem& item) const;
+    // objects that depend on the given object
+    const Edges& getDependents(const MetadataItem& item) const;
+    // fills items with the metadata objects of the edges, without duplicates
+    // and without edges that can not be resolved to a (non-system) object
+    void findItems(const Edges& edges,
+        std::vector<MetadataItem*>& items) const;
+
+    // reorders items so that every item comes after all items of the same
+    // vector it depends on, keeping the original order otherwise
+    // items that are part of a dependency cycle are appended unsorted
+    void sortByDependencies(std::vector<MetadataItem*>& items) const;
+
+private:
+    typedef std::pair<int, wxString> Node;
+    typedef std::map<Node, Edges> EdgeMap;
+
+    Database& databaseM;
+    EdgeMap dependedOnM;
+    EdgeMap dependentsM;
+    Edges emptyM;
+
+    static Node getNode(const MetadataItem& item);
+    MetadataItem* findItem(int type, const wxString& name) const;
+    void load();
+};
+
+#endif // FR_DEPENDENCYGRAPH_H
@@ -0,0 +1,159 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include "core/StringUtils.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/database.h"
+#include "metadata/DescriptionCache.h"
+#include "metadata/metadataitem.h"
+
+wxString DescriptionCache::getTypeKey(MetadataItem& object)
+{
+    switch (object.getType())
+    {
+        case ntTable:
+        case ntGTT:
+        case ntView:
+            return "R";
+        case ntColumn:
+            return "C";
+        case ntDomain:
+            return "D";
+        case ntException:
+            return "E";
+        case ntGenerator:
+            return "G";
+        case ntIndex:
+            return "I";
+        case ntProcedure:
+            return "P";
+        case ntDMLTrigger:
+        case ntDBTrigger:
+        case ntDDLTrigger:
+            return "T";
+        default:
+            return wxEmptyString;
+    }
+}
+
+bool DescriptionCache::getDescription(MetadataItem& object,
+    wxString& description) const
+{
+    wxString type(getTypeKey(object));
+    if (type.empty() || loadedTypesM.find(type) == loadedTypesM.end())
+        return false;
+
+    if (object.getType() == ntColumn && object.getParent())
+        type += object.getParent()->getName_();
+    DescriptionMap::const_iterator it = descriptionsM.find(
+        std::make_pair(type, object.getName_()));
+    if (it == descriptionsM.end())
+        description = wxEmptyString;
+    else
+        description = (*it).second;
+    return true;
+}
+
+void DescriptionCache::load(Database& database)
+{
+    struct DescriptionQuery
+    {
+        const char* type;
+        const char* sql;
+        bool hasParent;
+    };
+    static const DescriptionQuery queries[] = {
+        { "R", "select RDB$RELATION_NAME, RDB$DESCRIPTION from RDB$RELATIONS"
+            " where RDB$DESCRIPTION is not null", false },
+        { "C", "select RDB$FIELD_NAME, RDB$DESCRIPTION, RDB$RELATION_NAME"
+            " from RDB$RELATION_FIELDS where RDB$DESCRIPTION is not null",
+            true },
+        { "D", "select RDB$FIELD_NAME, RDB$DESCRIPTION from RDB$FIELDS"
+            " where RDB$DESCRIPTION is not null", false },
+        { "E", "select RDB$EXCEPTION_NAME, RDB$DESCRIPTION from RDB$EXCEPTIONS"
+            " where RDB$DESCRIPTION is not null", false },
+        { "G", "select RDB$GENERATOR_NAME, RDB$DESCRIPTION from RDB$GENERATORS"
+            " where RDB$DESCRIPTION is not null", false },
+        { "I", "select RDB$INDEX_NAME, RDB$DESCRIPTION from RDB$INDICES"
+            " where RDB$DESCRIPTION is not null", false },
+        { "P", "select RDB$PROCEDURE_NAME, RDB$DESCRIPTION from RDB$PROCEDURES"
+            " where RDB$DESCRIPTION is not null", false },
+        { "T", "select RDB$TRIGGER_NAME, RDB$DESCRIPTION from RDB$TRIGGERS"
+            " where RDB$DESCRIPTION is not null", false }
+    };
+
+    MetadataLoader* loader = database.getMetadataLoader();
+    wxMBConv* converter = database.getCharsetConverter();
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i)
+    {
+        std::string sql(queries[i].sql);
+        // packaged procedures are not part of the procedures collection
+        if (queries[i].type[0] == 'P'
+            && database.getInfo().getODSVersionIsHigherOrEqualTo(12.0))
+        {
+            sql += " and RDB$PACKAGE_NAME is null";
+        }
+        try
+        {
+            IBPP::Statement st = loader->createStatement(sql);
+            st->Execute();
+            while (st->Fetch())
+            {
+                std::string s;
+                st->Get(1, s);
+                wxString name(std2wxIdentifier(s, converter));
+                wxString type(queries[i].type);
+                if (queries[i].hasParent)
+                {
+                    st->Get(3, s);
+                    type += std2wxIdentifier(s, converter);
+                }
+
+                std::string value;
+                IBPP::Blob b = loader->createBlob();
+                st->Get(2, b);
+                b->Load(value);
+                descriptionsM[std::make_pair(type, name)] =
+                    wxString(value.c_str(), *converter);
+            }
+            loadedTypesM.insert(queries[i].type);
+        }
+        catch (IBPP::SQLException& e)
+        {
+            // older servers don't have descriptions for all object types,
+            // the descriptions will then be loaded for each object
+            if (e.SqlCode() != -206)
+                throw;
+        }
+    }
+}
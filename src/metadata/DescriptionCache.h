@@ -0,0 +1,50 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_DESCRIPTIONCACHE_H
+#define FR_DESCRIPTIONCACHE_H
+
+#include <map>
+#include <set>
+
+#include "metadata/MetadataClasses.h"
+
+// Descriptions of all objects of the most common types, loaded with one
+// statement per type instead of one statement per object (and column).
+// Used by operations that need the descriptions of a whole database.
+class DescriptionCache
+{
+private:
+    // keyed by (type key + parent name, name)
+    typedef std::map<std::pair<wxString, wxString>, wxString> DescriptionMap;
+    DescriptionMap descriptionsM;
+    std::set<wxString> loadedTypesM;
+    static wxString getTypeKey(MetadataItem& object);
+public:
+    // needs to be called inside a MetadataLoaderTransaction
+    void load(Database& database);
+    // returns false if the descriptions of the object type were not loaded
+    bool getDescription(MetadataItem& object, wxString& description) const;
+};
+
+#endif // FR_DESCRIPTIONCACHE_H
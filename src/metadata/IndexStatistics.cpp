@@ -0,0 +1,306 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include <algorithm>
+
+#include "core/StringUtils.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/database.h"
+#include "metadata/IndexStatistics.h"
+
+IndexStatistics::Entry::Entry()
+    : unique(false), active(true), segments(0), selectivity(-1), depth(-1),
+        leafBuckets(-1), nodes(-1), totalDup(-1), maxDup(-1), averageFill(-1)
+{
+}
+
+bool IndexStatistics::Entry::hasSelectivity() const
+{
+    // zero is stored for empty tables and for indices created inactive
+    return selectivity > 0;
+}
+
+bool IndexStatistics::Entry::hasAnalysis() const
+{
+    return nodes >= 0;
+}
+
+double IndexStatistics::Entry::getDistinctKeys() const
+{
+    if (!hasSelectivity())
+        return 0;
+    return 1.0 / selectivity;
+}
+
+double IndexStatistics::Entry::getDuplicateRatio() const
+{
+    if (nodes <= 0 || totalDup < 0)
+        return -1;
+    return double(totalDup) / double(nodes);
+}
+
+IndexStatistics::IndexStatistics(Database& database)
+    : analysisEntryM(-1), analysisFillCountM(0), analysisFillSumM(0)
+{
+    load(database);
+}
+
+void IndexStatistics::load(Database& database)
+{
+    MetadataLoader* loader = database.getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* converter = database.getCharsetConverter();
+
+    // do not use cached statements, the list is loaded only once
+    IBPP::Statement st = loader->createStatement(
+        "select i.RDB$INDEX_NAME, i.RDB$RELATION_NAME, i.RDB$UNIQUE_FLAG,"
+        " i.RDB$INDEX_INACTIVE, i.RDB$SEGMENT_COUNT, i.RDB$STATISTICS"
+        " from RDB$INDICES i"
+        " where coalesce(i.RDB$SYSTEM_FLAG, 0) = 0"
+        " order by i.RDB$RELATION_NAME, i.RDB$INDEX_NAME");
+    st->Execute();
+    while (st->Fetch())
+    {
+        Entry e;
+        std::string s;
+        st->Get(1, s);
+        e.indexName = std2wxIdentifier(s, converter);
+        st->Get(2, s);
+        e.relationName = std2wxIdentifier(s, converter);
+
+        short value;
+        if (!st->IsNull(3))
+        {
+            st->Get(3, value);
+            e.unique = value == 1;
+        }
+        if (!st->IsNull(4))
+        {
+            st->Get(4, value);
+            e.active = value == 0;
+        }
+        if (!st->IsNull(5))
+        {
+            st->Get(5, value);
+            e.segments = value;
+        }
+        if (!st->IsNull(6))
+            st->Get(6, e.selectivity);
+
+        positionsM[e.indexName] = entriesM.size();
+        entriesM.push_back(e);
+    }
+    updateRelationRows();
+}
+
+void IndexStatistics::updateRelationRows()
+{
+    relationRowsM.clear();
+    for (std::vector<Entry>::const_iterator it = entriesM.begin();
+        it != entriesM.end(); ++it)
+    {
+        if (!(*it).unique || !(*it).hasSelectivity())
+            continue;
+        double& rows = relationRowsM[(*it).relationName];
+        rows = std::max(rows, (*it).getDistinctKeys());
+    }
+}
+
+size_t IndexStatistics::getCount() const
+{
+    return entriesM.size();
+}
+
+const IndexStatistics::Entry& IndexStatistics::getEntry(size_t index) const
+{
+    return entriesM[index];
+}
+
+int IndexStatistics::findEntry(const wxString& indexName) const
+{
+    PositionMap::const_iterator it = positionsM.find(indexName);
+    if (it == positionsM.end())
+        return -1;
+    return int((*it).second);
+}
+
+double IndexStatistics::getEstimatedRows(const wxString& relationName) const
+{
+    std::map<wxString, double>::const_iterator it =
+        relationRowsM.find(relationName);
+    if (it == relationRowsM.end())
+        return 0;
+    return (*it).second;
+}
+
+int IndexStatistics::getFlags(size_t index) const
+{
+    const Entry& e = entriesM[index];
+    int flags = flagNone;
+    double distinctKeys = e.getDistinctKeys();
+
+    if (!e.hasSelectivity())
+        flags |= flagNoStatistics;
+
+    if (e.hasAnalysis() && e.nodes > 0)
+    {
+        // compare the stored selectivity with the real number of distinct
+        // keys found in the leaf pages
+        double actualKeys = double(e.nodes - std::max<int64_t>(0, e.totalDup));
+        if (distinctKeys <= 0 || distinctKeys > 2 * actualKeys
+            || 2 * distinctKeys < actualKeys)
+        {
+            flags |= flagStale;
+        }
+    }
+    else if (!e.unique && e.hasSelectivity())
+    {
+        // more distinct keys than rows in the table: one of them is outdated
+        double rows = getEstimatedRows(e.relationName);
+        if (rows > 0 && distinctKeys > 1.5 * rows)
+            flags |= flagStale;
+    }
+
+    if (!e.unique && e.hasSelectivity())
+    {
+        if (e.selectivity >= 0.1)
+            flags |= flagLowSelectivity;
+        double rows = getEstimatedRows(e.relationName);
+        if (rows > 0 && distinctKeys >= 0.9 * rows)
+            flags |= flagNearlyUnique;
+    }
+    return flags;
+}
+
+void IndexStatistics::updateSelectivities(const IndexStatistics& other)
+{
+    for (std::vector<Entry>::iterator it = entriesM.begin();
+        it != entriesM.end(); ++it)
+    {
+        int pos = other.findEntry((*it).indexName);
+        if (pos >= 0)
+            (*it).selectivity = other.getEntry(pos).selectivity;
+    }
+    updateRelationRows();
+}
+
+void IndexStatistics::startAnalysis()
+{
+    for (std::vector<Entry>::iterator it = entriesM.begin();
+        it != entriesM.end(); ++it)
+    {
+        (*it).depth = -1;
+        (*it).leafBuckets = -1;
+        (*it).nodes = -1;
+        (*it).totalDup = -1;
+        (*it).maxDup = -1;
+        (*it).averageFill = -1;
+    }
+    analysisEntryM = -1;
+}
+
+// reads the number following key in line
+static bool getNumberAfter(const wxString& line, const wxString& key,
+    double& value)
+{
+    size_t pos = line.find(key);
+    if (pos == wxString::npos)
+        return false;
+    pos += key.length();
+    while (pos < line.length() && line[pos] == ' ')
+        ++pos;
+    size_t end = pos;
+    while (end < line.length() && (wxIsdigit(line[end]) || line[end] == '.'))
+        ++end;
+    return end > pos && line.substr(pos, end - pos).ToCDouble(&value);
+}
+
+void IndexStatistics::addAnalysisLine(const wxString& line)
+{
+    wxString trimmed(line);
+    trimmed.Trim(true).Trim(false);
+    if (trimmed.empty())
+        return;
+
+    // relation headers start in the first column, everything belonging to
+    // an index is indented
+    if (line[0] != ' ' && line[0] != '\t')
+    {
+        analysisEntryM = -1;
+        return;
+    }
+    if (trimmed.StartsWith("Index "))
+    {
+        wxString name(trimmed.Mid(6));
+        size_t pos = name.rfind(" (");
+        if (pos != wxString::npos)
+            name.Truncate(pos);
+        analysisEntryM = findEntry(name);
+        analysisFillCountM = 0;
+        analysisFillSumM = 0;
+        return;
+    }
+    if (analysisEntryM < 0)
+        return;
+
+    Entry& e = entriesM[analysisEntryM];
+    wxString lower(trimmed.Lower());
+    double value;
+    if (getNumberAfter(lower, "depth:", value))
+        e.depth = int(value);
+    if (getNumberAfter(lower, "leaf buckets:", value))
+        e.leafBuckets = int64_t(value);
+    if (getNumberAfter(lower, "nodes:", value))
+        e.nodes = int64_t(value);
+    if (getNumberAfter(lower, "total dup:", value))
+        e.totalDup = int64_t(value);
+    if (getNumberAfter(lower, "max dup:", value))
+        e.maxDup = int64_t(value);
+
+    // fill distribution lines look like "20 - 39% = 4"
+    size_t percent = lower.find('%');
+    size_t dash = lower.find('-');
+    if (percent != wxString::npos && dash != wxString::npos && dash < percent)
+    {
+        double low, high, count;
+        if (lower.substr(0, dash).Trim().ToCDouble(&low)
+            && lower.substr(dash + 1, percent - dash - 1).Trim(false)
+                .ToCDouble(&high)
+            && getNumberAfter(lower, "=", count))
+        {
+            analysisFillCountM += int(count);
+            analysisFillSumM += count * (low + high + 1) / 2;
+            if (analysisFillCountM > 0)
+                e.averageFill = analysisFillSumM / analysisFillCountM;
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_INDEXSTATISTICS_H
+#define FR_INDEXSTATISTICS_H
+
+#include <map>
+#include <vector>
+
+#include "metadata/MetadataClasses.h"
+
+// Selectivity and structure information of all user indices, loaded from
+// RDB$INDICES with one statement.  The results of an index page analysis
+// ("gstat -i" output from the services API) can be added line by line.
+class IndexStatistics
+{
+public:
+    struct Entry
+    {
+        Entry();
+
+        wxString indexName;
+        wxString relationName;
+        bool unique;
+        bool active;
+        int segments;
+        // RDB$STATISTICS, -1 if it has never been computed
+        double selectivity;
+
+        // index page analysis, -1 if not available
+        int depth;
+        int64_t leafBuckets;
+        int64_t nodes;
+        int64_t totalDup;
+        int64_t maxDup;
+        double averageFill;
+
+        bool hasSelectivity() const;
+        bool hasAnalysis() const;
+        // estimated number of distinct keys, 0 if unknown
+        double getDistinctKeys() const;
+        // share of duplicate keys from the page analysis, -1 if unknown
+        double getDuplicateRatio() const;
+    };
+
+    // loads the statistics, uses the database's MetadataLoader transaction
+    IndexStatistics(Database& database);
+
+    size_t getCount() const;
+    const Entry& getEntry(size_t index) const;
+    // returns the position of the index in the list, or -1
+    int findEntry(const wxString& indexName) const;
+
+    // estimated row count of a relation from the selectivity of its unique
+    // indices, 0 if the relation has no unique index with statistics
+    double getEstimatedRows(const wxString& relationName) const;
+
+    enum Flag { flagNone = 0, flagNoStatistics = 1, flagStale = 2,
+        flagLowSelectivity = 4, flagNearlyUnique = 8 };
+    // returns a combination of the flags above
+    int getFlags(size_t index) const;
+
+    // takes the selectivities from a freshly loaded instance, used after
+    // statistics have been recomputed (keeps the analysis results)
+    void updateSelectivities(const IndexStatistics& other);
+
+    // clears previous analysis results
+    void startAnalysis();
+    // parses one line of the index page analysis
+    void addAnalysisLine(const wxString& line);
+
+private:
+    typedef std::map<wxString, size_t> PositionMap;
+
+    std::vector<Entry> entriesM;
+    PositionMap positionsM;
+    std::map<wxString, double> relationRowsM;
+
+    // state of the analysis parser
+    int analysisEntryM;
+    int analysisFillCountM;
+    double analysisFillSumM;
+
+    void load(Database& database);
+    void updateRelationRows();
+};
+
+#endif // FR_INDEXSTATISTICS_H
@@ -0,0 +1,187 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "wx/wxprec.h"
+
+// for all others, include the necessary headers (this file is usually all you
+// need because it includes almost all "standard" wxWindows headers
+#ifndef WX_PRECOMP
+    #include "wx/wx.h"
+#endif
+
+#include "core/StringUtils.h"
+#include "engine/MetadataLoader.h"
+#include "metadata/column.h"
+#include "metadata/CreateDDLVisitor.h"
+#include "metadata/database.h"
+#include "metadata/parameter.h"
+#include "metadata/procedure.h"
+#include "metadata/relation.h"
+#include "metadata/SchemaSearchIndex.h"
+
+SchemaSearchIndex::SchemaSearchIndex(Database& database)
+    : databaseM(database), loadedM(false)
+{
+}
+
+SchemaSearchIndex::Key SchemaSearchIndex::getKey(NodeType type,
+    const wxString& name)
+{
+    // tables and views share the same namespace
+    if (type == ntGTT || type == ntView || type == ntSysTable)
+        type = ntTable;
+    return Key(type, name);
+}
+
+SchemaSearchIndex::Key SchemaSearchIndex::getKey(const MetadataItem& item)
+{
+    return getKey(item.getType(), item.getName_());
+}
+
+void SchemaSearchIndex::ensureLoaded()
+{
+    if (loadedM)
+        return;
+
+    MetadataLoader* loader = databaseM.getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    descriptionsM.load(databaseM);
+
+    // every relation and procedure gets an entry, also those without fields
+    std::vector<MetadataItem*> collections;
+    databaseM.getCollections(collections, false);
+    for (std::vector<MetadataItem*>::iterator itc = collections.begin();
+        itc != collections.end(); ++itc)
+    {
+        std::vector<MetadataItem*> items;
+        (*itc)->getChildren(items);
+        for (std::vector<MetadataItem*>::iterator it = items.begin();
+            it != items.end(); ++it)
+        {
+            NodeType type = (*it)->getType();
+            if (type == ntTable || type == ntGTT || type == ntView
+                || type == ntProcedure)
+            {
+                fieldsM[getKey(*(*it))];
+            }
+        }
+    }
+
+    loadFields("select RDB$RELATION_NAME, RDB$FIELD_NAME"
+        " from RDB$RELATION_FIELDS order by RDB$FIELD_POSITION", ntTable);
+    std::string sql("select RDB$PROCEDURE_NAME, RDB$PARAMETER_NAME"
+        " from RDB$PROCEDURE_PARAMETERS");
+    // packaged procedures are not part of the procedures collection
+    if (databaseM.getInfo().getODSVersionIsHigherOrEqualTo(12.0))
+        sql += " where RDB$PACKAGE_NAME is null";
+    loadFields(sql, ntProcedure);
+
+    loadedM = true;
+}
+
+void SchemaSearchIndex::loadFields(const std::string& sql, NodeType type)
+{
+    MetadataLoader* loader = databaseM.getMetadataLoader();
+    wxMBConv* converter = databaseM.getCharsetConverter();
+
+    IBPP::Statement st = loader->createStatement(sql);
+    st->Execute();
+    while (st->Fetch())
+    {
+        std::string s;
+        st->Get(1, s);
+        std::map<Key, std::vector<wxString> >::iterator it =
+            fieldsM.find(getKey(type, std2wxIdentifier(s, converter)));
+        // system objects are not indexed
+        if (it == fieldsM.end())
+            continue;
+        st->Get(2, s);
+        (*it).second.push_back(std2wxIdentifier(s, converter));
+    }
+}
+
+void SchemaSearchIndex::clear()
+{
+    loadedM = false;
+    descriptionsM = DescriptionCache();
+    fieldsM.clear();
+    ddlM.clear();
+}
+
+bool SchemaSearchIndex::getDescription(MetadataItem& item,
+    wxString& description)
+{
+    ensureLoaded();
+    if (descriptionsM.getDescription(item, description))
+        return true;
+    return item.getDescription(description);
+}
+
+bool SchemaSearchIndex::getFields(MetadataItem& item,
+    std::vector<wxString>& fields)
+{
+    Relation* r = dynamic_cast<Relation*>(&item);
+    Procedure* p = dynamic_cast<Procedure*>(&item);
+    if (!r && !p)
+        return false;
+
+    ensureLoaded();
+    Key key(getKey(item));
+    std::map<Key, std::vector<wxString> >::iterator it = fieldsM.find(key);
+    if (it == fieldsM.end())
+    {
+        // not part of the collections when the index was loaded
+        std::vector<wxString> names;
+        item.ensureChildrenLoaded();
+        if (r)
+        {
+            for (ColumnPtrs::iterator itc = r->begin(); itc != r->end(); ++itc)
+                names.push_back((*itc)->getName_());
+        }
+        else
+        {
+            for (ParameterPtrs::iterator itp = p->begin(); itp != p->end();
+                ++itp)
+            {
+                names.push_back((*itp)->getName_());
+            }
+        }
+        it = fieldsM.insert(std::make_pair(key, names)).first;
+    }
+    fields = (*it).second;
+    return true;
+}
+
+wxString SchemaSearchIndex::getDDL(MetadataItem& item)
+{
+    Key key(getKey(item));
+    std::map<Key, wxString>::iterator it = ddlM.find(key);
+    if (it == ddlM.end())
+    {
+        CreateDDLVisitor cdv;
+        item.acceptVisitor(&cdv);
+        it = ddlM.insert(std::make_pair(key, cdv.getSql())).first;
+    }
+    return (*it).second;
+}
@@ -0,0 +1,71 @@
+/*
+  Copyright (c) 2004-2022 The FlameRobin Development Team
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the
+  "Software"), to deal in the Software without restriction, including
+  without limitation the rights to use, copy, modify, merge, publish,
+  distribute, sublicense, and/or sell copies of the Software, and to
+  permit persons to whom the Software is furnished to do so, subject to
+  the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+  TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FR_SCHEMASEARCHINDEX_H
+#define FR_SCHEMASEARCHINDEX_H
+
+#include <map>
+#include <vector>
+
+#include "metadata/DescriptionCache.h"
+#include "metadata/MetadataClasses.h"
+
+class MetadataItem;
+
+// Searchable texts of the user objects of a database, as used by the
+// advanced search.  Descriptions and column / parameter names are loaded
+// for the whole database with a few statements on first use, DDL is
+// created for each object on demand and then kept until the next
+// committed DDL statement clears the whole index.
+class SchemaSearchIndex
+{
+private:
+    typedef std::pair<int, wxString> Key;
+
+    Database& databaseM;
+    bool loadedM;
+    DescriptionCache descriptionsM;
+    std::map<Key, std::vector<wxString> > fieldsM;
+    std::map<Key, wxString> ddlM;
+
+    static Key getKey(NodeType type, const wxString& name);
+    static Key getKey(const MetadataItem& item);
+    void ensureLoaded();
+    void loadFields(const std::string& sql, NodeType type);
+
+public:
+    SchemaSearchIndex(Database& database);
+
+    // called for every committed DDL statement, as even statements not
+    // naming an object (like GRANT or COMMENT ON COLUMN) change its texts
+    void clear();
+
+    // same as MetadataItem::getDescription()
+    bool getDescription(MetadataItem& item, wxString& description);
+    // column names of relations, parameter names of procedures
+    // returns false for all other objects
+    bool getFields(MetadataItem& item, std::vector<wxString>& fields);
+    wxString getDDL(MetadataItem& item);
+};
+
+#endif // FR_SCHEMASEARCHINDEX_H
@@ -32,6 +32,7 @@
 
 #include <wx/encconv.h>
 #include <wx/fontmap.h>
+#include <wx/timer.h>
 
 #include <algorithm>
 #include <functional>
@@ -45,11 +46,16 @@
 #include "core/FRError.h"
 #include "core/ProgressIndicator.h"
 #include "core/StringUtils.h"
+#include "core/URIProcessor.h"
 #include "engine/MetadataLoader.h"
+#include "engine/TransactionGapSampler.h"
+#include "logger.h"
 #include "MasterPassword.h"
 #include "metadata/CharacterSet.h"
 #include "metadata/column.h"
+#include "metadata/ConnectionPool.h"
 #include "metadata/database.h"
+#include "metadata/DependencyGraph.h"
 #include "metadata/domain.h"
 #include "metadata/exception.h"
 #include "metadata/function.h"
@@ -61,6 +67,7 @@
 #include "metadata/procedure.h"
 #include "metadata/role.h"
 #include "metadata/root.h"
+#include "metadata/SchemaSearchIndex.h"
 #include "metadata/server.h"
 #include "metadata/table.h"
 #include "metadata/trigger.h"
@@ -288,10 +295,29 @@ bool DatabaseAuthenticationMode::getUseEncryptedPassword() const
     return modeM == UseSavedEncryptedPwd;
 }
 
+class ConnectionPoolPruneTimer: public wxTimer
+{
+private:
+    std::weak_ptr<ConnectionPool> poolM;
+public:
+    ConnectionPoolPruneTimer(std::shared_ptr<ConnectionPool> pool)
+        : wxTimer(), poolM(pool)
+    {
+    }
+
+    virtual void Notify()
+    {
+        if (std::shared_ptr<ConnectionPool> pool = poolM.lock())
+            pool->pruneIdle();
+    }
+};
+
 // Database class
 Database::Database()
     : MetadataItem(ntDatabase), metadataLoaderM(0), connectedM(false),
-        connectionCredentialsM(0), dialectM(3), idM(0), volatileM(false)
+        connectionCredentialsM(0), dialectM(3), idM(0), volatileM(false),
+        timezoneBaseIdM(0), defaultTimezoneLoadedM(false),
+        transactionGapAlertM(false), relationNamesLoadedM(false)
 {
     defaultTimezoneM.name = "";
     defaultTimezoneM.id = 0;
@@ -518,13 +544,7 @@ void Database::loadGeneratorValues()
     MetadataLoaderTransaction tr(loader);
     SubjectLocker lock(this);
 
-    for (Generators::iterator it = generatorsM->begin();
-        it != generatorsM->end(); ++it)
-    {
-        // make sure generator value is reloaded from database
-        (*it)->invalidate();
-        (*it)->ensurePropertiesLoaded();
-    }
+    generatorsM->loadValues();
 }
 
 DatabasePtr Database::getDatabase() const
@@ -836,6 +856,11 @@ void Database::parseCommitedSql(const SqlStatement& stm)
     if (!stm.isDDL())
         return;    // return false only on IBPP exception
 
+    dependencyGraphM.reset();
+    invalidateRelationNames();
+    if (searchIndexM)
+        searchIndexM->clear();
+
     if (stm.actionIs(actGRANT))
     {
         MetadataItem *obj = stm.getObject();
@@ -1232,6 +1257,8 @@ void Database::connect(const wxString& password, ProgressIndicator* indicator)
                 setChildrenLoaded(true);
                 if (indicator)
                     indicator->initProgress(_("Complete"), 1, 1);
+
+                startTransactionGapSampler();
             }
             catch (CancelProgressException&)
             {
@@ -1441,6 +1468,28 @@ void Database::setDisconnected()
 {
     delete metadataLoaderM;
     metadataLoaderM = 0;
+    dependencyGraphM.reset();
+    searchIndexM.reset();
+    connectionPoolTimerM.reset();
+    if (connectionPoolM)
+    {
+        // statements logged to the database are written with attachments
+        // of the pool, so the queued ones need to be written first
+        Logger::flush();
+        // borrowed attachments are disconnected when they are returned,
+        // threads waiting for an attachment fail
+        connectionPoolM->close();
+        connectionPoolM.reset();
+    }
+    // the sampler may have waited for an attachment, closing the pool first
+    // makes sure it doesn't block the join
+    if (transactionGapSamplerM)
+        transactionGapSamplerM->stop();
+    timezoneNamesM.clear();
+    timezoneBaseIdM = 0;
+    defaultTimezoneM = TimezoneInfo();
+    defaultTimezoneLoadedM = false;
+    invalidateRelationNames();
     resetCredentials();     // "forget" temporary username/password
     connectedM = false;
     resetPendingLoadData();
@@ -1486,6 +1535,37 @@ MetadataLoader* Database::getMetadataLoader()
     return metadataLoaderM;
 }
 
+DependencyGraph& Database::getDependencyGraph()
+{
+    if (!dependencyGraphM)
+        dependencyGraphM.reset(new DependencyGraph(*this));
+    return *dependencyGraphM;
+}
+
+SchemaSearchIndex& Database::getSearchIndex()
+{
+    if (!searchIndexM)
+        searchIndexM.reset(new SchemaSearchIndex(*this));
+    return *searchIndexM;
+}
+
+std::shared_ptr<ConnectionPool> Database::getConnectionPool()
+{
+    if (!connectedM)
+        throw FRError(_("The database is not connected."));
+    if (!connectionPoolM)
+    {
+        connectionPoolM.reset(new ConnectionPool(databaseM,
+            wx2std(getClientLibrary())));
+        // attachments are pruned at most half a timeout late
+        long interval = 500 * long(connectionPoolM->getIdleTimeout().count());
+        connectionPoolTimerM.reset(
+            new ConnectionPoolPruneTimer(connectionPoolM));
+        connectionPoolTimerM->Start(std::max(interval, 1000L));
+    }
+    return connectionPoolM;
+}
+
 bool Database::getChildren(std::vector<MetadataItem*>& temp)
 {
     if (!connectedM)
@@ -2236,15 +2316,17 @@ void Database::checkConnected(const wxString& operation) const
 
 void Database::loadDefaultTimezone()
 {
-    MetadataLoader* loader = getMetadataLoader();
-    wxMBConv* converter = getCharsetConverter();
-    std::string tzName;
-    int tzId;
+    defaultTimezoneLoadedM = true;
+    defaultTimezoneM = TimezoneInfo();
 
     // RDB$TIME_ZONES is available on Firebird 4 (ODS Ver 13) or higher
     if (!getInfo().getODSVersionIsHigherOrEqualTo(13, 0))
         return;
 
+    MetadataLoader* loader = getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* converter = getCharsetConverter();
+
     IBPP::Statement& st1 = loader->getStatement(
         "select z.RDB$TIME_ZONE_ID, "
         "       z.RDB$TIME_ZONE_NAME "
@@ -2252,7 +2334,11 @@ void Database::loadDefaultTimezone()
         "where z.RDB$TIME_ZONE_NAME = RDB$GET_CONTEXT('SYSTEM', 'SESSION_TIMEZONE');");
 
     st1->Execute();
-    st1->Fetch();
+    if (!st1->Fetch())
+        return;
+
+    std::string tzName;
+    int tzId;
     st1->Get(1, tzId);
     st1->Get(2, tzName);
 
@@ -2262,16 +2348,17 @@ void Database::loadDefaultTimezone()
 
 void Database::loadTimezones()
 {
-    MetadataLoader* loader = getMetadataLoader();
-    wxMBConv* converter = getCharsetConverter();
-    std::string tzName;
-    int tzId;
-    TimezoneInfo* tzItm;
+    timezoneNamesM.clear();
+    timezoneBaseIdM = 0;
 
     // RDB$TIME_ZONES is available on Firebird 4 (ODS Ver 13) or higher
     if (!getInfo().getODSVersionIsHigherOrEqualTo(13, 0))
         return;
 
+    MetadataLoader* loader = getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* converter = getCharsetConverter();
+
     IBPP::Statement& st1 = loader->getStatement(
         "select z.RDB$TIME_ZONE_ID, "
         "       z.RDB$TIME_ZONE_NAME "
@@ -2279,33 +2366,209 @@ void Database::loadTimezones()
 
     st1->Execute();
 
+    // the ids form a dense range at the top of the 16 bit range, so a
+    // vector from the lowest id on allows for direct lookup
+    std::vector<std::pair<int, wxString> > zones;
+    int minId = 0, maxId = -1;
     while (st1->Fetch())
     {
+        std::string tzName;
+        int tzId;
         st1->Get(1, tzId);
         st1->Get(2, tzName);
 
-        tzItm = new TimezoneInfo;
-        tzItm->id = tzId;
-        tzItm->name = std2wxIdentifier(tzName, converter);
-        timezonesM.push_back(tzItm);
+        if (zones.empty() || tzId < minId)
+            minId = tzId;
+        if (zones.empty() || tzId > maxId)
+            maxId = tzId;
+        zones.push_back(std::make_pair(tzId,
+            std2wxIdentifier(tzName, converter)));
+    }
+    if (zones.empty())
+        return;
+
+    timezoneBaseIdM = minId;
+    timezoneNamesM.resize(maxId - minId + 1);
+    for (std::vector<std::pair<int, wxString> >::iterator it = zones.begin();
+        it != zones.end(); ++it)
+    {
+        timezoneNamesM[(*it).first - minId] = (*it).second;
     }
 }
 
 TimezoneInfo Database::getDefaultTimezone()
 {
-    loadDefaultTimezone();
+    if (!defaultTimezoneLoadedM)
+        loadDefaultTimezone();
     return defaultTimezoneM;
 }
 
-wxString Database::getTimezoneName(int timezone)
+void Database::invalidateDefaultTimezone()
+{
+    defaultTimezoneLoadedM = false;
+}
+
+std::shared_ptr<TransactionGapSampler> Database::getTransactionGapSampler()
+{
+    if (!transactionGapSamplerM)
+    {
+        // one day of samples at one sample per minute
+        transactionGapSamplerM.reset(new TransactionGapSampler(1440));
+    }
+    return transactionGapSamplerM;
+}
+
+void Database::startTransactionGapSampler()
+{
+    // recording keeps a second attachment busy, so it is opt-in
+    int interval = config().get("TransactionGapSampleInterval", 0);
+    if (interval <= 0)
+        return;
+
+    DatabaseWeakPtr database(shared_from_this());
+    getTransactionGapSampler()->start(getConnectionPool(), interval * 1000,
+        [database]()
+        {
+            // hand the samples over to the GUI thread
+            wxTheApp->CallAfter([database]()
+            {
+                if (DatabasePtr db = database.lock())
+                    db->processTransactionGapSamples();
+            });
+        });
+}
+
+void Database::processTransactionGapSamples()
 {
-    std::vector<TimezoneInfo*>::iterator it;
-    for (it = timezonesM.begin(); it != timezonesM.end(); it++)
+    if (!transactionGapSamplerM || !transactionGapSamplerM->processSamples())
+        return;
+    const std::deque<TransactionGapSample>& samples =
+        transactionGapSamplerM->getSamples();
+    if (samples.empty())
+        return;
+
+    // alert once when a gap grows past the threshold, and again only
+    // after it has been below the threshold
+    int threshold = config().get("TransactionGapAlertThreshold", 10000);
+    const TransactionGapSample& last = samples.back();
+    bool exceeded = threshold > 0 && (last.getActiveGap() > threshold
+        || last.getInterestingGap() > threshold);
+    if (exceeded && !transactionGapAlertM)
+    {
+        URI uri("fr://transaction_gaps");
+        uri.addParam(wxString::Format("parent_window=%p",
+            wxTheApp->GetTopWindow()));
+        uri.addParam(wxString::Format("object_handle=%lu", getHandle()));
+        uri.addParam("alert=1");
+        getURIProcessor().handleURI(uri);
+    }
+    transactionGapAlertM = exceeded;
+}
+
+void Database::loadRelationNames()
+{
+    MetadataLoader* loader = getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* converter = getCharsetConverter();
+
+    // all relations, including system and monitoring tables, which are
+    // not part of the loaded collections
+    IBPP::Statement& st1 = loader->getStatement(
+        "select r.RDB$RELATION_ID, r.RDB$RELATION_NAME "
+        "from RDB$RELATIONS r");
+
+    std::map<int, wxString> names;
+    st1->Execute();
+    while (st1->Fetch())
     {
-        if ((*it)->id != timezone)
+        if (st1->IsNull(1))
             continue;
-        return (*it)->name;
+        int relationId;
+        std::string relationName;
+        st1->Get(1, relationId);
+        st1->Get(2, relationName);
+        names[relationId] = std2wxIdentifier(relationName, converter);
+    }
+    // only a complete list is used, a failed load is retried
+    relationNamesM.swap(names);
+    relationNamesLoadedM = true;
+}
+
+wxString Database::getRelationName(int relationId)
+{
+    bool reloaded = false;
+    if (!relationNamesLoadedM)
+    {
+        loadRelationNames();
+        reloaded = true;
+    }
+    std::map<int, wxString>::const_iterator it =
+        relationNamesM.find(relationId);
+    if (it != relationNamesM.end())
+        return (*it).second;
+    if (missingRelationIdsM.find(relationId) != missingRelationIdsM.end())
+        return wxEmptyString;
+    // created by another attachment since the names were loaded
+    if (!reloaded)
+    {
+        loadRelationNames();
+        it = relationNamesM.find(relationId);
+        if (it != relationNamesM.end())
+            return (*it).second;
+    }
+    missingRelationIdsM.insert(relationId);
+    return wxEmptyString;
+}
+
+void Database::invalidateRelationNames()
+{
+    relationNamesLoadedM = false;
+    relationNamesM.clear();
+    missingRelationIdsM.clear();
+}
+
+wxString Database::getTimezoneName(int timezone) const
+{
+    if (timezone >= timezoneBaseIdM)
+    {
+        size_t index = size_t(timezone - timezoneBaseIdM);
+        if (index < timezoneNamesM.size() && !timezoneNamesM[index].empty())
+            return timezoneNamesM[index];
     }
     // not found
     return wxString::Format("TZ %d", timezone);
 }
+
+wxString IBPPtype2string(Database* db, IBPP::SDT t, int subtype, int size,
+    int scale)
+{
+    if (scale > 0)
+        return wxString::Format("NUMERIC(%d,%d)", size == 4 ? 9 : 18, scale);
+    if (t == IBPP::sdString)
+    {
+        int bpc = db->getCharsetById(subtype)->getBytesPerChar();
+        if (subtype == 1) // charset OCTETS
+            return wxString::Format("OCTETS(%d)", bpc ? size / bpc : size);
+        return wxString::Format("STRING(%d)", bpc ? size / bpc : size);
+    }
+    switch (t)
+    {
+    case IBPP::sdArray:     return "ARRAY";
+    case IBPP::sdBlob:      return wxString::Format("BLOB SUB_TYPE %d", subtype);
+    case IBPP::sdDate:      return "DATE";
+    case IBPP::sdTime:      return "TIME";
+    case IBPP::sdTimestamp: return "TIMESTAMP";
+    case IBPP::sdSmallint:  return "SMALLINT";
+    case IBPP::sdInteger:   return "INTEGER";
+    case IBPP::sdLargeint:  return "BIGINT";
+    case IBPP::sdFloat:     return "FLOAT";
+    case IBPP::sdDouble:    return "DOUBLE PRECISION";
+    case IBPP::sdBoolean:   return "BOOLEAN";
+    case IBPP::sdTimeTz:    return "TIME WITH TIMEZONE";
+    case IBPP::sdTimestampTz: return "TIMESTAMP WITH TIMEZONE";
+    case IBPP::sdInt128:    return "INT128";
+    case IBPP::sdDec16:     return "DECFLOAT(16)";
+    case IBPP::sdDec34:     return "DECFLOAT(34)";
+    default:                return "UNKNOWN";
+    }
+}
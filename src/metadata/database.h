@@ -27,15 +27,21 @@
 #include <wx/strconv.h>
 
 #include <map>
+#include <set>
 
 #include <ibpp.h>
 
 #include "metadata/MetadataClasses.h"
 #include "metadata/metadataitem.h"
 
+class ConnectionPool;
+class DependencyGraph;
 class MetadataLoader;
 class ProgressIndicator;
+class SchemaSearchIndex;
 class SqlStatement;
+class TransactionGapSampler;
+class wxTimer;
 
 
 /*
@@ -162,6 +168,12 @@ private:
     ServerWeakPtr serverM;
     IBPP::Database databaseM;
     MetadataLoader* metadataLoaderM;
+    std::unique_ptr<DependencyGraph> dependencyGraphM;
+    std::unique_ptr<SchemaSearchIndex> searchIndexM;
+    std::shared_ptr<ConnectionPool> connectionPoolM;
+    // disconnects idle pooled attachments when no attachments are borrowed
+    // or returned for a while
+    std::unique_ptr<wxTimer> connectionPoolTimerM;
 
     bool connectedM;
     bool volatileM;
@@ -178,8 +190,22 @@ private:
     Credentials credentialsM;
     Credentials* connectionCredentialsM;
     DatabaseAuthenticationMode authenticationModeM;
-    std::vector<TimezoneInfo*> timezonesM;
+    // time zone names indexed by (id - timezoneBaseIdM), loaded once
+    std::vector<wxString> timezoneNamesM;
+    int timezoneBaseIdM;
     TimezoneInfo defaultTimezoneM;
+    bool defaultTimezoneLoadedM;
+    // records the transaction counters while connected, kept on disconnect
+    std::shared_ptr<TransactionGapSampler> transactionGapSamplerM;
+    bool transactionGapAlertM;
+    void startTransactionGapSampler();
+
+    // relation names indexed by rdb$relation_id, loaded once per connection
+    std::map<int, wxString> relationNamesM;
+    bool relationNamesLoadedM;
+    // ids not found even after reloading the names, like dropped tables,
+    // which aren't looked up again
+    std::set<int> missingRelationIdsM;
 
     std::unique_ptr<wxMBConv> charsetConverterM;
     void createCharsetConverter();
@@ -226,6 +252,7 @@ private:
 
     void loadDefaultTimezone();
     void loadTimezones();
+    void loadRelationNames();
 
     // small help for parser
     wxString getTableForIndex(const wxString& indexName);
@@ -288,6 +315,13 @@ public:
     void drop();
 
     MetadataLoader* getMetadataLoader();
+    // loaded on first use, reset whenever DDL statements are committed
+    DependencyGraph& getDependencyGraph();
+    // kept while connected, updated when DDL statements are committed
+    SchemaSearchIndex& getSearchIndex();
+    // secondary attachments for background work, created on first use
+    // and closed on disconnect
+    std::shared_ptr<ConnectionPool> getConnectionPool();
 
     wxArrayString loadIdentifiers(const wxString& loadStatement,
         ProgressIndicator* progressIndicator = 0);
@@ -315,7 +349,20 @@ public:
     bool isDefaultCollation(const wxString& charset, const wxString& collate);
 
     TimezoneInfo getDefaultTimezone();
-    wxString getTimezoneName(int timezone);
+    // reloads the session time zone on next use, after "SET TIME ZONE"
+    void invalidateDefaultTimezone();
+    wxString getTimezoneName(int timezone) const;
+
+    std::shared_ptr<TransactionGapSampler> getTransactionGapSampler();
+    // called in the GUI thread when the sampler has new samples, raises
+    // the alert when a transaction gap exceeds the configured threshold
+    void processTransactionGapSamples();
+
+    // returns the name of the relation with the given rdb$relation_id,
+    // or an empty string for ids still unknown after reloading the names
+    wxString getRelationName(int relationId);
+    // reloads the relation names on next use, after DDL
+    void invalidateRelationNames();
 
     //! fill vector with names of all tables, views, etc.
     void getIdentifiers(std::vector<Identifier>& temp);
@@ -375,4 +422,8 @@ public:
     wxMBConv* getCharsetConverter() const;
 };
 
+// returns the name of a parameter or column type as reported by IBPP
+wxString IBPPtype2string(Database* db, IBPP::SDT t, int subtype, int size,
+    int scale);
+
 #endif
@@ -31,6 +31,9 @@
 #endif
 
 
+#include <algorithm>
+#include <map>
+
 #include <ibpp.h>
 
 #include "core/FRError.h"
@@ -53,6 +56,16 @@ int64_t Generator::getValue()
     return valueM;
 }
 
+void Generator::setValues(int64_t value, int64_t initialValue,
+    int64_t increment)
+{
+    valueM = value;
+    initialValueM = initialValue;
+    incrementalValueM = increment;
+    setPropertiesLoaded(true);
+    notifyObservers();
+}
+
 void Generator::loadProperties()
 {
     setPropertiesLoaded(false);
@@ -77,7 +90,7 @@ void Generator::loadProperties()
         std::string sql("select RDB$INITIAL_VALUE, RDB$GENERATOR_INCREMENT from RDB$GENERATORS "
             "where RDB$GENERATOR_NAME = ? "
         );
-        IBPP::Statement st2 = loader->createStatement(sql);
+        IBPP::Statement& st2 = loader->getStatement(sql);
         st2->Set(1, wx2std(getName_(), converter));
         st2->Execute();
         if (st2->Fetch()) {
@@ -195,6 +208,81 @@ void Generators::loadChildren()
     load(0);
 }
 
+void Generators::loadValues()
+{
+    DatabasePtr db = getDatabase();
+    MetadataLoader* loader = db->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
+    wxMBConv* converter = db->getCharsetConverter();
+
+    // initial values and increments of all generators in one statement
+    typedef std::map<wxString, std::pair<int64_t, int64_t> > SettingsMap;
+    SettingsMap settings;
+    if (db->getInfo().getODSVersionIsHigherOrEqualTo(12, 0))
+    {
+        IBPP::Statement st = loader->createStatement(
+            "select RDB$GENERATOR_NAME, RDB$INITIAL_VALUE,"
+            " RDB$GENERATOR_INCREMENT from RDB$GENERATORS");
+        st->Execute();
+        while (st->Fetch())
+        {
+            std::string s;
+            st->Get(1, s);
+            int64_t initialValue = 0, increment = 0;
+            if (!st->IsNull(2))
+                st->Get(2, initialValue);
+            if (!st->IsNull(3))
+                st->Get(3, increment);
+            settings[std2wxIdentifier(s, converter)] =
+                std::make_pair(initialValue, increment);
+        }
+    }
+
+    std::vector<Generator*> generators;
+    for (iterator it = begin(); it != end(); ++it)
+        generators.push_back((*it).get());
+
+    // current values of many generators in one statement, the batch size
+    // keeps the statement text well below the length limit of old servers
+    const size_t batchSize = 200;
+    for (size_t start = 0; start < generators.size(); start += batchSize)
+    {
+        size_t count = std::min(batchSize, generators.size() - start);
+        // IMPORTANT: for all other loading where the name of the db object
+        // is Set() into a parameter getName_() is used, but for dynamically
+        // building the SQL statement getQuotedName() must be used!
+        std::string sql("select ");
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i)
+                sql += ", ";
+            sql += "gen_id(" + wx2std(generators[start + i]->getQuotedName(),
+                converter) + ", 0)";
+        }
+        sql += " from rdb$database";
+
+        // do not use cached statements, because this can not be reused
+        IBPP::Statement st = loader->createStatement(sql);
+        st->Execute();
+        if (!st->Fetch())
+            continue;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Generator* g = generators[start + i];
+            int64_t value;
+            st->Get(int(i + 1), value);
+            int64_t initialValue = 0, increment = 0;
+            SettingsMap::const_iterator its = settings.find(g->getName_());
+            if (its != settings.end())
+            {
+                initialValue = (*its).second.first;
+                increment = (*its).second.second;
+            }
+            g->setValues(value, initialValue, increment);
+        }
+    }
+}
+
 const wxString Generators::getTypeName() const
 {
     return "GENERATOR_COLLECTION";
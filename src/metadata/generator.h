@@ -37,13 +37,14 @@ private:
     int64_t initialValueM;
     int64_t incrementalValueM;
     std::vector<Privilege> privilegesM;
-    void setValue(int64_t value);
 protected:
     virtual void loadProperties();
 public:
     Generator(DatabasePtr database, const wxString& name);
 
     int64_t getValue();
+    // used by Generators::loadValues() to set the loaded properties
+    void setValues(int64_t value, int64_t initialValue, int64_t increment);
 
     virtual const wxString getTypeName() const;
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
@@ -60,6 +61,8 @@ public:
 
     virtual void acceptVisitor(MetadataItemVisitor* visitor);
     void load(ProgressIndicator* progressIndicator);
+    // reloads the values of all generators with a few statements
+    void loadValues();
     virtual const wxString getTypeName() const;
 };
 
@@ -355,10 +355,10 @@ void MetadataItem::getDependencies(std::vector<Dependency>& list,
 
     if (typeM == ntUnknown || mytype == -1)
         throw FRError(_("Unsupported type"));
-    IBPP::Database& db = d->getIBPPDatabase();
-    IBPP::Transaction tr1 = IBPP::TransactionFactory(db, IBPP::amRead);
-    tr1->Start();
-    IBPP::Statement st1 = IBPP::StatementFactory(db, tr1);
+    // use the metadata loader transaction and its prepared statements, the
+    // statement texts only depend on the object type
+    MetadataLoader* loader = d->getMetadataLoader();
+    MetadataLoaderTransaction tr(loader);
 
     wxString o1 = (ofObject ? "DEPENDENT" : "DEPENDED_ON");
     wxString o2 = (ofObject ? "DEPENDED_ON" : "DEPENDENT");
@@ -418,7 +418,8 @@ void MetadataItem::getDependencies(std::vector<Dependency>& list,
     params++;
 
     sql += " order by 1, 2, 3";
-    st1->Prepare(wx2std(sql, d->getCharsetConverter()));
+    IBPP::Statement st1 =
+        loader->getStatement(wx2std(sql, d->getCharsetConverter()));
     st1->Set(1, mytype);
     st1->Set(2, mytype2);
     for (int i = 0; i < params; i++)
@@ -456,8 +457,7 @@ void MetadataItem::getDependencies(std::vector<Dependency>& list,
                 // system trigger dependent of this object indicates possible check constraint on a table
                 // that references this object. So, let's check if this trigger is used for check constraint
                 // and get that table's name
-                IBPP::Statement st2 = IBPP::StatementFactory(db, tr1);
-                st2->Prepare(
+                IBPP::Statement& st2 = loader->getStatement(
                     "select r.rdb$relation_name from rdb$relation_constraints r "
                     " join rdb$check_constraints c on r.rdb$constraint_name=c.rdb$constraint_name "
                     " and r.rdb$constraint_type = 'CHECK' where c.rdb$trigger_name = ? "
@@ -520,7 +520,7 @@ void MetadataItem::getDependencies(std::vector<Dependency>& list,
         // Algorithm: 1.find all system triggers bound to that CHECK constraint
         //            2.find dependencies for those system triggers
         //            3.display those dependencies as deps. of this table
-        st1->Prepare("select distinct c.rdb$trigger_name from rdb$relation_constraints r "
+        st1 = loader->getStatement("select distinct c.rdb$trigger_name from rdb$relation_constraints r "
             " join rdb$check_constraints c on r.rdb$constraint_name=c.rdb$constraint_name "
             " and r.rdb$constraint_type = 'CHECK' where r.rdb$relation_name= ? "
         );
@@ -562,7 +562,7 @@ void MetadataItem::getDependencies(std::vector<Dependency>& list,
     // TODO: perhaps this could be moved to Table?
     if ((typeM == ntTable || typeM == ntSysTable) && !ofObject)  // foreign keys of other tables
     {
-        st1->Prepare(
+        st1 = loader->getStatement(
             "select r1.rdb$relation_name, i.rdb$field_name, i.RDB$FIELD_POSITION, R1.RDB$CONSTRAINT_NAME, i2.RDB$FIELD_NAME "
             " from rdb$relation_constraints r1 "
             " join rdb$ref_constraints c on r1.rdb$constraint_name = c.rdb$constraint_name "
@@ -610,8 +610,6 @@ void MetadataItem::getDependencies(std::vector<Dependency>& list,
             dep->addField(DependencyField(field_name, pos));
         }
     }
-
-    tr1->Commit();
 }
 
 void MetadataItem::ensureDescriptionLoaded()
@@ -40,6 +40,7 @@
 #include "metadata/column.h"
 #include "metadata/CreateDDLVisitor.h"
 #include "metadata/database.h"
+#include "metadata/DependencyGraph.h"
 #include "metadata/procedure.h"
 #include "metadata/table.h"
 #include "metadata/view.h"
@@ -277,17 +278,31 @@ void Relation::loadChildren()
 void Relation::getDependentViews(std::vector<Relation *>& views,
     const wxString& forColumn)
 {
-    std::vector<Dependency> list;
     if (forColumn.IsEmpty())
-        getDependencies(list, false);
+    {
+        // walk the whole tree of dependent views without further queries
+        DependencyGraph& graph = getDatabase()->getDependencyGraph();
+        std::vector<MetadataItem*> dependents;
+        graph.findItems(graph.getDependents(*this), dependents);
+        for (std::vector<MetadataItem*>::iterator it = dependents.begin();
+            it != dependents.end(); ++it)
+        {
+            View *v = dynamic_cast<View *>(*it);
+            if (v && views.end() == std::find(views.begin(), views.end(), v))
+                v->getDependentViews(views);
+        }
+    }
     else
-        getDependencies(list, false, forColumn);
-    for (std::vector<Dependency>::iterator it = list.begin();
-        it != list.end(); ++it)
     {
-        View *v = dynamic_cast<View *>((*it).getDependentObject());
-        if (v && views.end() == std::find(views.begin(), views.end(), v))
-            v->getDependentViews(views);
+        std::vector<Dependency> list;
+        getDependencies(list, false, forColumn);
+        for (std::vector<Dependency>::iterator it = list.begin();
+            it != list.end(); ++it)
+        {
+            View *v = dynamic_cast<View *>((*it).getDependentObject());
+            if (v && views.end() == std::find(views.begin(), views.end(), v))
+                v->getDependentViews(views);
+        }
     }
 
     // add self
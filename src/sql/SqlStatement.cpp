@@ -578,6 +578,12 @@ bool SqlStatement::isDatatype() const
     return isDatatypeM;
 }
 
+// "SET TIME ZONE ..." changes the session time zone of the attachment
+bool SqlStatement::isSetTimeZone() const
+{
+    return actionM == actSET && tokensM[1] == kwTIME && tokensM[2] == kwZONE;
+}
+
 MetadataItem* SqlStatement::getObject() const
 {
     return objectM;
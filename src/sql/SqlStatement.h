@@ -70,6 +70,7 @@ public:
     wxString getStatement() const;
     bool isAlterColumn() const;
     bool isDatatype() const;
+    bool isSetTimeZone() const;
     Relation* getCreateTriggerRelation() const;
 
 protected:
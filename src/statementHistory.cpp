@@ -31,14 +31,141 @@
 #endif
 
 #include <wx/ffile.h>
+#include <wx/file.h>
 #include <wx/filefn.h>
+
+#include <algorithm>
+#include <cstring>
 #include <map>
 
 #include "config/Config.h"
 #include "metadata/database.h"
 #include "statementHistory.h"
 
-wxString StatementHistory::getFilename(StatementHistory::Position item)
+// The history file starts with a signature, followed by records of
+//   uint32 size of data, char kind, int64 time, uint64 hash, data
+// The first record is of kind 'G', its hash is a new random number every
+// time the file is rewritten.  Records of kind 'S' hold the UTF-8 text of a
+// statement not stored before, records of kind 'R' repeat an earlier text,
+// their data is the uint32 number of that text.  All numbers are stored
+// little-endian.
+static const char historySignature[8] =
+    { 'F', 'R', 'H', 'I', 'S', 'T', '0', '1' };
+static const size_t historyRecordHeaderSize = 21;
+
+static void putUInt(char* dest, wxUint64 value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i, value >>= 8)
+        dest[i] = char(value & 0xFF);
+}
+
+static wxUint64 getUInt(const char* src, size_t bytes)
+{
+    wxUint64 value = 0;
+    for (size_t i = bytes; i > 0; --i)
+        value = (value << 8) | (unsigned char)src[i - 1];
+    return value;
+}
+
+// 64 bit FNV-1a
+static wxUint64 getTextHash(const char* data, size_t size)
+{
+    wxUint64 hash = wxULL(14695981039346656037);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= wxULL(1099511628211);
+    }
+    return hash;
+}
+
+// splits an upper case text into the words used for the search index
+static void getTokens(const wxString& str, std::vector<wxString>& tokens)
+{
+    wxString token;
+    for (wxString::const_iterator it = str.begin(); it != str.end(); ++it)
+    {
+        wxUniChar c(*it);
+        if (wxIsalnum(c) || c == '_' || c == '$')
+            token += c;
+        else if (!token.empty())
+        {
+            tokens.push_back(token);
+            token.clear();
+        }
+    }
+    if (!token.empty())
+        tokens.push_back(token);
+}
+
+// Only one instance at a time may change the history file, the others wait
+// until the lock file has been removed.  Lock files of crashed instances are
+// removed after a minute.
+class HistoryLock
+{
+private:
+    wxString fileNameM;
+    bool lockedM;
+public:
+    HistoryLock(const wxString& fileName);
+    ~HistoryLock();
+    bool isLocked() const { return lockedM; }
+};
+
+HistoryLock::HistoryLock(const wxString& fileName)
+    : fileNameM(fileName + ".lock"), lockedM(false)
+{
+    // creating the lock file fails while it exists
+    wxLogNull noLog;
+    for (int i = 0; i < 250; ++i)
+    {
+        wxFile file;
+        lockedM = file.Create(fileNameM, false);
+        if (lockedM)
+            break;
+        if (wxFileExists(fileNameM) && wxDateTime::Now().GetTicks()
+            - wxFileModificationTime(fileNameM) > 60)
+        {
+            wxRemoveFile(fileNameM);
+        }
+        else
+            wxMilliSleep(20);
+    }
+}
+
+HistoryLock::~HistoryLock()
+{
+    if (lockedM)
+        wxRemoveFile(fileNameM);
+}
+
+static wxUint64 createGeneration()
+{
+    return wxUint64(wxDateTime::UNow().GetValue().GetValue())
+        ^ (wxUint64(wxGetProcessId()) << 40);
+}
+
+// returns false if fileName isn't a history file, generation is 0 for
+// files written without a 'G' record
+static bool readGeneration(const wxString& fileName, wxUint64& generation)
+{
+    if (!wxFileExists(fileName))
+        return false;
+    wxFFile file(fileName, "rb");
+    char data[sizeof(historySignature) + historyRecordHeaderSize];
+    size_t count = file.IsOpened() ? file.Read(data, sizeof(data)) : 0;
+    if (count < sizeof(historySignature)
+        || memcmp(data, historySignature, sizeof(historySignature)) != 0)
+    {
+        return false;
+    }
+    generation = 0;
+    if (count == sizeof(data) && data[sizeof(historySignature) + 4] == 'G')
+        generation = getUInt(data + sizeof(historySignature) + 13, 8);
+    return true;
+}
+
+wxString StatementHistory::getFilenamePrefix()
 {
     wxString fn = config().getUserHomePath() + "history/";
     if (!wxDirExists(fn))
@@ -46,26 +173,38 @@ wxString StatementHistory::getFilename(StatementHistory::Position item)
 
     for (Position i=0; i<storageNameM.Length(); ++i)
         fn += wxString::Format("%04x", storageNameM[i]);
+    return fn;
+}
+
+// name of the item files used by older versions
+wxString StatementHistory::getFilename(StatementHistory::Position item)
+{
+    wxString fn(getFilenamePrefix());
     fn << "_ITEM_" << (item);
     return fn;
 }
 
+wxString StatementHistory::getStorageFilename()
+{
+    return getFilenamePrefix() + "_HISTORY";
+}
+
 StatementHistory::StatementHistory(const wxString& storageName)
+    : storageNameM(storageName), loadedM(false), endM(0), generationM(0),
+        tokensIndexedM(false)
 {
-    storageNameM = storageName;
-    sizeM = 0;
-    while (true)    // load history
-    {
-        if (!wxFileExists(getFilename(sizeM)))
-            break;
-        sizeM++;
-    }
 }
 
 StatementHistory::StatementHistory(const StatementHistory& source)
+    : storageNameM(source.storageNameM), loadedM(false), endM(0),
+        generationM(0), tokensIndexedM(false)
+{
+}
+
+StatementHistory::~StatementHistory()
 {
-    storageNameM = source.storageNameM;
-    sizeM = source.sizeM;
+    if (fileM.IsOpened())
+        fileM.Close();
 }
 
 //! reads granularity from config() and gives pointer to appropriate history object
@@ -102,29 +241,344 @@ StatementHistory& StatementHistory::get(Database* db)
     }
 }
 
-wxDateTime StatementHistory::getDateTime(StatementHistory::Position pos)
+bool StatementHistory::openStorage()
 {
-    if (pos < sizeM)
+    // reading is possible anywhere, writing always appends
+    if (!fileM.Open(getStorageFilename(), "a+b"))
+        return false;
+    if (fileM.Length() == 0)
     {
-        return wxDateTime(::wxFileModificationTime(getFilename(pos)));
+        generationM = createGeneration();
+        if (fileM.Write(historySignature, sizeof(historySignature))
+                != sizeof(historySignature)
+            || writeRecord(fileM, 'G', wxDateTime::Now().GetTicks(),
+                generationM, "", 0) == wxInvalidOffset)
+        {
+            fileM.Close();
+            return false;
+        }
+        endM = fileM.Length();
     }
-    return wxInvalidDateTime;
+    return fileM.Seek(0);
 }
 
-wxString StatementHistory::get(StatementHistory::Position pos)
+void StatementHistory::load()
+{
+    if (loadedM)
+        return;
+    // the history stays empty while another instance holds the lock
+    HistoryLock lock(getStorageFilename());
+    if (lock.isLocked())
+        loadStorage();
+}
+
+void StatementHistory::loadStorage()
+{
+    loadedM = true;
+    if (fileM.IsOpened())
+        fileM.Close();
+    itemsM.clear();
+    textsM.clear();
+    textHashesM.clear();
+    tokensM.clear();
+    tokensIndexedM = false;
+    generationM = 0;
+
+    wxString fn(getStorageFilename());
+    if (!wxFileExists(fn))
+    {
+        importItemFiles();
+        return;
+    }
+    if (!openStorage())
+        return;
+
+    char signature[sizeof(historySignature)];
+    if (fileM.Read(signature, sizeof(signature)) != sizeof(signature)
+        || memcmp(signature, historySignature, sizeof(signature)) != 0)
+    {
+        // keep the unknown file and start a new history
+        fileM.Close();
+        wxRenameFile(fn, fn + ".bak", true);
+        openStorage();
+        return;
+    }
+
+    endM = sizeof(historySignature);
+    // drop a damaged end of the file, f.e. after a crash while writing
+    if (!readRecords())
+        rewrite();
+}
+
+// reads the records from endM on, returns false if the end of the file
+// is damaged
+bool StatementHistory::readRecords()
+{
+    // only the record headers are read, the texts are read when needed
+    wxFileOffset end = fileM.Length();
+    wxFileOffset pos = endM;
+    unsigned firstText = textsM.size();
+    char header[historyRecordHeaderSize];
+    if (!fileM.Seek(pos))
+        return false;
+    while (pos < end)
+    {
+        if (end - pos < wxFileOffset(historyRecordHeaderSize) ||
+            fileM.Read(header, sizeof(header)) != sizeof(header))
+        {
+            break;
+        }
+        wxUint32 size = wxUint32(getUInt(header, 4));
+        char kind = header[4];
+        wxFileOffset data = pos + historyRecordHeaderSize;
+        if (data + size > end)
+            break;
+
+        Item item;
+        item.time = wxInt64(getUInt(header + 5, 8));
+        if (kind == 'G')
+        {
+            generationM = getUInt(header + 13, 8);
+            if (!fileM.Seek(data + size))
+                break;
+            pos = data + size;
+            continue;
+        }
+        if (kind == 'S')
+        {
+            Text text = { data, size, getUInt(header + 13, 8) };
+            item.text = textsM.size();
+            textHashesM.insert(std::make_pair(text.hash, item.text));
+            textsM.push_back(text);
+            if (!fileM.Seek(data + size))
+                break;
+        }
+        else if (kind == 'R' && size == 4)
+        {
+            char ref[4];
+            if (fileM.Read(ref, sizeof(ref)) != sizeof(ref))
+                break;
+            item.text = unsigned(getUInt(ref, 4));
+            if (item.text >= textsM.size())
+                break;
+        }
+        else
+            break;
+        itemsM.push_back(item);
+        pos = data + size;
+    }
+    endM = pos;
+
+    // texts written by other instances
+    if (tokensIndexedM)
+    {
+        for (unsigned text = firstText; text < textsM.size(); ++text)
+            indexTokens(text, getText(text));
+    }
+    return pos == end;
+}
+
+bool StatementHistory::refresh()
 {
-    if (pos < sizeM)
+    wxUint64 generation;
+    if (loadedM && fileM.IsOpened()
+        && readGeneration(getStorageFilename(), generation)
+        && generation == generationM)
     {
-        wxFFile f(getFilename(pos), "rb");
-        if (!f.IsOpened())
-            return wxEmptyString;
-        wxString retval;
-        if (f.ReadAll(&retval))
+        if (fileM.Length() > endM && !readRecords())
+            rewrite();
+        return true;
+    }
+    loadStorage();
+    return false;
+}
+
+// converts the one-file-per-item history of older versions
+void StatementHistory::importItemFiles()
+{
+    if (!openStorage())
+        return;
+    bool ok = true;
+    Position count = 0;
+    while (wxFileExists(getFilename(count)))
+    {
+        wxString fn(getFilename(count++));
+        wxFFile f(fn, "rb");
+        wxString str;
+        if (!f.IsOpened() || !f.ReadAll(&str))
+            continue;
+        if (!append(str, wxFileModificationTime(fn)))
         {
-            f.Close();
-            return retval;
+            ok = false;
+            break;
         }
     }
+    if (ok)
+    {
+        for (Position item = 0; item < count; ++item)
+            wxRemoveFile(getFilename(item));
+    }
+}
+
+wxFileOffset StatementHistory::writeRecord(wxFFile& file, char kind,
+    wxInt64 time, wxUint64 hash, const char* data, wxUint32 size)
+{
+    char header[historyRecordHeaderSize];
+    putUInt(header, size, 4);
+    header[4] = kind;
+    putUInt(header + 5, wxUint64(time), 8);
+    putUInt(header + 13, hash, 8);
+
+    // also needed when switching from reading to writing
+    if (!file.Seek(0, wxFromEnd))
+        return wxInvalidOffset;
+    wxFileOffset pos = file.Tell();
+    if (pos == wxInvalidOffset
+        || file.Write(header, sizeof(header)) != sizeof(header)
+        || file.Write(data, size) != size || !file.Flush())
+    {
+        return wxInvalidOffset;
+    }
+    return pos + historyRecordHeaderSize;
+}
+
+bool StatementHistory::append(const wxString& str, wxInt64 time)
+{
+    wxScopedCharBuffer utf8(str.utf8_str());
+    wxUint64 hash = getTextHash(utf8.data(), utf8.length());
+    Item item;
+    item.time = time;
+
+    // a statement executed before is only referenced
+    typedef std::multimap<wxUint64, unsigned>::const_iterator HashIterator;
+    std::pair<HashIterator, HashIterator> range(
+        textHashesM.equal_range(hash));
+    for (HashIterator it = range.first; it != range.second; ++it)
+    {
+        if (getText((*it).second) != str)
+            continue;
+        char ref[4];
+        putUInt(ref, (*it).second, 4);
+        wxFileOffset offset = writeRecord(fileM, 'R', time, 0, ref, 4);
+        if (offset == wxInvalidOffset)
+            return false;
+        endM = offset + 4;
+        item.text = (*it).second;
+        itemsM.push_back(item);
+        return true;
+    }
+
+    Text text;
+    text.offset = writeRecord(fileM, 'S', time, hash, utf8.data(),
+        wxUint32(utf8.length()));
+    if (text.offset == wxInvalidOffset)
+        return false;
+    text.size = wxUint32(utf8.length());
+    endM = text.offset + text.size;
+    text.hash = hash;
+    item.text = textsM.size();
+    textHashesM.insert(std::make_pair(hash, item.text));
+    textsM.push_back(text);
+    itemsM.push_back(item);
+    if (tokensIndexedM)
+        indexTokens(item.text, str);
+    return true;
+}
+
+// writes the items to a new file, dropping texts no longer referenced
+bool StatementHistory::rewrite()
+{
+    wxString fn(getStorageFilename());
+    wxString tempFn(fn + ".tmp");
+    bool ok = true;
+    wxUint64 generation = createGeneration();
+    std::vector<Item> items;
+    std::vector<Text> texts;
+    std::multimap<wxUint64, unsigned> hashes;
+    {
+        wxFFile temp(tempFn, "w+b");
+        ok = temp.IsOpened() && temp.Write(historySignature,
+            sizeof(historySignature)) == sizeof(historySignature)
+            && writeRecord(temp, 'G', wxDateTime::Now().GetTicks(),
+                generation, "", 0) != wxInvalidOffset;
+
+        std::vector<unsigned> numbers(textsM.size(), unsigned(-1));
+        for (std::vector<Item>::const_iterator it = itemsM.begin();
+            ok && it != itemsM.end(); ++it)
+        {
+            Item item(*it);
+            unsigned& number = numbers[item.text];
+            if (number == unsigned(-1))
+            {
+                Text text(textsM[item.text]);
+                wxCharBuffer data(text.size);
+                ok = fileM.Seek(text.offset)
+                    && fileM.Read(data.data(), text.size) == text.size;
+                if (ok)
+                {
+                    text.offset = writeRecord(temp, 'S', item.time,
+                        text.hash, data.data(), text.size);
+                    ok = text.offset != wxInvalidOffset;
+                }
+                number = texts.size();
+                hashes.insert(std::make_pair(text.hash, number));
+                texts.push_back(text);
+            }
+            else
+            {
+                char ref[4];
+                putUInt(ref, number, 4);
+                ok = writeRecord(temp, 'R', item.time, 0, ref, 4)
+                    != wxInvalidOffset;
+            }
+            item.text = number;
+            items.push_back(item);
+        }
+    }
+
+    fileM.Close();
+    if (ok)
+        ok = wxRenameFile(tempFn, fn, true);
+    if (!ok)
+    {
+        wxRemoveFile(tempFn);
+        openStorage();
+        return false;
+    }
+    itemsM.swap(items);
+    textsM.swap(texts);
+    textHashesM.swap(hashes);
+    tokensM.clear();
+    tokensIndexedM = false;
+    generationM = generation;
+    if (!openStorage())
+        return false;
+    endM = fileM.Length();
+    return true;
+}
+
+wxString StatementHistory::getText(unsigned text)
+{
+    const Text& t = textsM[text];
+    wxCharBuffer data(t.size);
+    if (!fileM.Seek(t.offset) || fileM.Read(data.data(), t.size) != t.size)
+        return wxEmptyString;
+    return wxString::FromUTF8(data.data(), t.size);
+}
+
+wxDateTime StatementHistory::getDateTime(StatementHistory::Position pos)
+{
+    load();
+    if (pos < itemsM.size())
+        return wxDateTime(time_t(itemsM[pos].time));
+    return wxInvalidDateTime;
+}
+
+wxString StatementHistory::get(StatementHistory::Position pos)
+{
+    load();
+    if (pos < itemsM.size())
+        return getText(itemsM[pos].text);
     return wxEmptyString;
 }
 
@@ -137,47 +591,132 @@ void StatementHistory::add(const wxString& str)
         return;
     }
 
-    if (sizeM == 0 || get(sizeM-1) != str)
-    {
-        wxFFile f(getFilename(sizeM), "wb+");
-        if (f.IsOpened())
-        {
-            f.Write(str);
-            f.Close();
-            sizeM++;
-        }
-    }
+    HistoryLock lock(getStorageFilename());
+    if (!lock.isLocked())
+        return;
+    refresh();
+    if (!fileM.IsOpened())
+        return;
+    if (itemsM.empty() || getText(itemsM.back().text) != str)
+        append(str, wxDateTime::Now().GetTicks());
 }
 
 StatementHistory::Position StatementHistory::size()
 {
-    return sizeM;
+    // also picks up the statements executed in other instances
+    HistoryLock lock(getStorageFilename());
+    if (lock.isLocked())
+        refresh();
+    return itemsM.size();
 }
 
 void StatementHistory::deleteItems(
     const std::vector<StatementHistory::Position>& items)
 {
-    // remove the files (remembering the "lowest" deleted)
-    Position start = size();
+    HistoryLock lock(getStorageFilename());
+    // the positions are meaningless if another instance rewrote the file
+    if (!lock.isLocked() || !refresh())
+        return;
+    std::vector<bool> deleted(itemsM.size(), false);
     for (std::vector<Position>::const_iterator ci = items.begin();
         ci != items.end(); ++ci)
     {
-        wxRemoveFile(getFilename(*ci));
-        if ((*ci) < start)
-            start = (*ci);
+        if ((*ci) < deleted.size())
+            deleted[*ci] = true;
     }
 
-    // move existing files
-    for (Position currentpos = start; currentpos < size(); currentpos++)
+    std::vector<Item> remaining;
+    for (Position pos = 0; pos < itemsM.size(); ++pos)
     {
-        if (!wxFileExists(getFilename(currentpos)))
-            continue;
-        if (currentpos != start)
-            wxRenameFile(getFilename(currentpos), getFilename(start));
-        start++;
+        if (!deleted[pos])
+            remaining.push_back(itemsM[pos]);
+    }
+    if (remaining.size() == itemsM.size())
+        return;
+    itemsM.swap(remaining);
+    if (!rewrite())
+    {
+        // the file is unchanged, so keep showing all items
+        itemsM.swap(remaining);
     }
+}
 
-    // set new size
-    sizeM = start;
+void StatementHistory::indexTokens(unsigned text, const wxString& str)
+{
+    std::vector<wxString> tokens;
+    getTokens(str.Upper(), tokens);
+    for (std::vector<wxString>::const_iterator it = tokens.begin();
+        it != tokens.end(); ++it)
+    {
+        // texts are indexed in ascending order, so duplicates are adjacent
+        std::vector<unsigned>& texts = tokensM[*it];
+        if (texts.empty() || texts.back() != text)
+            texts.push_back(text);
+    }
 }
 
+void StatementHistory::buildTokenIndex()
+{
+    if (tokensIndexedM)
+        return;
+    // texts are stored in ascending order, so the file is read sequentially
+    for (unsigned text = 0; text < textsM.size(); ++text)
+        indexTokens(text, getText(text));
+    tokensIndexedM = true;
+}
+
+std::vector<StatementHistory::Position> StatementHistory::search(
+    const wxString& searchString)
+{
+    {
+        HistoryLock lock(getStorageFilename());
+        if (lock.isLocked())
+            refresh();
+    }
+    wxString upper(searchString.Upper());
+    std::vector<wxString> tokens;
+    getTokens(upper, tokens);
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+
+    // every word of the search string is part of a word of all statements
+    // containing it, so only statements having such words for all of them
+    // need to be checked
+    std::vector<bool> candidates(textsM.size(), tokens.empty());
+    if (!tokens.empty())
+    {
+        buildTokenIndex();
+        std::vector<size_t> matches(textsM.size(), 0);
+        for (size_t i = 0; i < tokens.size(); ++i)
+        {
+            for (std::map<wxString, std::vector<unsigned> >::const_iterator
+                it = tokensM.begin(); it != tokensM.end(); ++it)
+            {
+                if ((*it).first.find(tokens[i]) == wxString::npos)
+                    continue;
+                for (std::vector<unsigned>::const_iterator ti =
+                    (*it).second.begin(); ti != (*it).second.end(); ++ti)
+                {
+                    // count every search word only once per statement
+                    if (matches[*ti] == i)
+                        matches[*ti] = i + 1;
+                }
+            }
+        }
+        for (unsigned text = 0; text < textsM.size(); ++text)
+            candidates[text] = (matches[text] == tokens.size());
+    }
+
+    std::vector<Position> result;
+    std::vector<bool> listed(textsM.size(), false);
+    for (Position pos = itemsM.size(); pos > 0; --pos)
+    {
+        unsigned text = itemsM[pos - 1].text;
+        if (listed[text] || !candidates[text])
+            continue;
+        listed[text] = true;
+        if (upper.IsEmpty() || getText(text).Upper().Contains(upper))
+            result.push_back(pos - 1);
+    }
+    return result;
+}
@@ -25,24 +25,77 @@
 #define FR_HISTORY_H
 
 #include <wx/wx.h>
+#include <wx/ffile.h>
+
+#include <map>
 #include <vector>
 
 class Database;
 
+// All statements of one history are stored in a single file, which is only
+// ever appended to (except when items are deleted).  Every distinct text is
+// stored once, executing the same statement again only appends a reference
+// to it.  The file is scanned once on first use to build an in-memory index
+// of all items, the texts are read when they are needed.  A token index for
+// searching is built on the first search.
+// Several instances of FlameRobin may share the file, so it is only changed
+// while holding a lock file, after reading what the others have written.
 class StatementHistory
 {
 public:
     typedef size_t Position;
 
 private:
+    struct Item
+    {
+        unsigned text;
+        wxInt64 time;
+    };
+    struct Text
+    {
+        wxFileOffset offset;
+        wxUint32 size;
+        wxUint64 hash;
+    };
+
     StatementHistory(const wxString& storageName);
+    wxString getFilenamePrefix();
     wxString getFilename(Position item);
+    wxString getStorageFilename();
     wxString storageNameM;
-    Position sizeM;
+    bool loadedM;
+    wxFFile fileM;
+    // end of the records read so far
+    wxFileOffset endM;
+    // changes whenever the file is rewritten
+    wxUint64 generationM;
+    std::vector<Item> itemsM;
+    std::vector<Text> textsM;
+    std::multimap<wxUint64, unsigned> textHashesM;
+    bool tokensIndexedM;
+    std::map<wxString, std::vector<unsigned> > tokensM;
+
+    void load();
+    wxString getText(unsigned text);
+    wxFileOffset writeRecord(wxFFile& file, char kind, wxInt64 time,
+        wxUint64 hash, const char* data, wxUint32 size);
+    // the following need the lock file to be held
+    void loadStorage();
+    bool readRecords();
+    // reads the records written by other instances, returns false if the
+    // file was rewritten by one of them and has been reloaded
+    bool refresh();
+    bool openStorage();
+    void importItemFiles();
+    bool append(const wxString& str, wxInt64 time);
+    bool rewrite();
+    void indexTokens(unsigned text, const wxString& str);
+    void buildTokenIndex();
 
 public:
-    // copy ctor needed for std:: containers
+    // copy ctor needed for std:: containers, copies are loaded separately
     StatementHistory(const StatementHistory& source);
+    ~StatementHistory();
 
     //! reads granularity from config() and gives pointer to appropriate history object
     static StatementHistory& get(Database *db);
@@ -52,6 +105,9 @@ public:
     void add(const wxString&);
     void deleteItems(const std::vector<Position>& items);
     Position size();
+    // returns the most recent position of every distinct statement that
+    // contains searchString (case-insensitive), newest first
+    std::vector<Position> search(const wxString& searchString);
 };
 
 #endif